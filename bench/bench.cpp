@@ -0,0 +1,833 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+/*
+ * Benchmark harness.
+ *
+ * Usage: bench [--reps N] [--quick] [--trace FILE] [filter ...]
+ *
+ * Every benchmark prints one JSON object per line:
+ *
+ *   {"bench": "ode/lorenz", "reps": 5, "min": ..., "median": ..., "mean": ..., "max": ..., ...}
+ *
+ * Times are seconds per repetition. Inputs are deterministic (fixed seeds),
+ * so results of two builds can be compared line by line. Only benchmarks
+ * whose name contains one of the filters are run. With --trace the solver
+ * timeline of all runs is written to FILE in Chrome trace format.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "iNumerics.h"
+#include "inmatrix.h"
+#include "invector.h"
+#include "inprofiler.h"
+#include "intracer.h"
+
+#include "problems.h"
+
+using namespace std;
+using namespace iNumerics;
+
+namespace {
+
+    struct Options {
+        size_t reps;
+        bool quick;
+        string trace;
+        vector<string> filters;
+    };
+
+    Options options;
+
+    bool selected(const string& name) {
+        if (options.filters.empty()) {
+            return true;
+        }
+
+        for (size_t i = 0; i < options.filters.size(); i++) {
+            if (name.find(options.filters[i]) != string::npos) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Deterministic pseudo random numbers in [-1,1] (xorshift64).
+     */
+    class Random {
+    public:
+
+        Random(inULong seed) : _state(seed) {
+        }
+
+        double next() {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return (double) (_state >> 11) / (double) (1ULL << 52) - 1.0;
+        }
+
+    private:
+        inULong _state;
+    };
+
+    /**
+     * Runs f reps times (after one warm-up run) and prints the timing
+     * summary plus the extra JSON fields f reports through its argument.
+     */
+    template <class F>
+    void run(const string& name, F f) {
+        if (!selected(name)) {
+            return;
+        }
+
+        stringstream extra;
+        extra.precision(17);
+
+        f(extra);
+
+        vector<double> times;
+
+        for (size_t i = 0; i < options.reps; i++) {
+            stringstream ignored;
+            inULong start = MonotonicClock::now();
+            f(ignored);
+            times.push_back((MonotonicClock::now() - start) * 1.e-9);
+        }
+
+        sort(times.begin(), times.end());
+
+        double sum = 0;
+
+        for (size_t i = 0; i < times.size(); i++) {
+            sum += times[i];
+        }
+
+        cout.precision(9);
+        cout << "{\"bench\": \"" << name << "\""
+                << ", \"reps\": " << times.size()
+                << ", \"min\": " << times.front()
+                << ", \"median\": " << times[times.size() / 2]
+                << ", \"mean\": " << sum / times.size()
+                << ", \"max\": " << times.back()
+                << extra.str()
+                << "}" << endl;
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       ODE problems                                                         *
+     *                                                                            *
+     ******************************************************************************/
+
+    void reportSolve(ostream& os, const SolveStats& stats, const Trajectory& t) {
+        os << ", \"stats\": ";
+        stats.writeJSON(os);
+
+        const DVec& last = t.getState(t.size() - 1);
+
+        os << ", \"final\": [";
+
+        for (size_t i = 0; i < last.size() && i < 4; i++) {
+            os << (i > 0 ? ", " : "") << last[i];
+        }
+
+        os << "]";
+    }
+
+    void benchExplicit(BenchModel& model, double absError, double relError) {
+        run("ode/" + model.name() + "/explicit", [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-6);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchImplicit(BenchModel& model, double absError, double relError) {
+        run("ode/" + model.name() + "/implicit", [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-6).
+                    setAlgebraicErrorControl(false);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve_implicit(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchBdf(BenchModel& model, double absError, double relError) {
+        run("ode/" + model.name() + "/bdf", [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-6);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve_bdf(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchImex(BenchModel& model, double absError, double relError) {
+        run("ode/" + model.name() + "/imex", [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-6);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve_imex(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchAuto(BenchModel& model, double absError, double relError) {
+        run("ode/" + model.name() + "/auto", [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-6);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve_auto(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchKrylov(BenchModel& model, Preconditioner* preconditioner, double absError, double relError) {
+        run("ode/" + model.name() + (preconditioner != NULL ? "/krylov_precond" : "/krylov"), [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-6).
+                    setPreconditioner(preconditioner);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve_krylov(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchDelay(MackeyGlass& model, double absError, double relError) {
+        run("ode/" + model.name() + "/delay", [&](ostream & os) {
+            Problem p(model);
+            p.setInitialValue(model.initialValue()).
+                    setTimeRange(0.0, model.endTime()).
+                    setPrecision(absError, relError, 1.e-2);
+
+            ODESolver solver;
+            Trajectory t;
+
+            SolveStats stats = solver.solve_delay(p, t);
+
+            reportSolve(os, stats, t);
+        });
+    }
+
+    void benchOde() {
+        HarmonicOscillator harmonic;
+        benchExplicit(harmonic, 1.e-10, 1.e-8);
+
+        Lorenz lorenz;
+        benchExplicit(lorenz, 1.e-10, 1.e-8);
+
+        double mus[] = {1.0, 10.0, 100.0};
+
+        for (size_t i = 0; i < 3; i++) {
+            VanDerPol vdp(mus[i]);
+            benchExplicit(vdp, 1.e-8, 1.e-6);
+        }
+
+        // Explicit methods are limited by stability on this one, so only a
+        // short interval is integrated.
+        Robertson robertson(options.quick ? 0.1 : 1.0);
+        benchExplicit(robertson, 1.e-10, 1.e-6);
+
+        Heat1D heat(options.quick ? 100 : 1000, options.quick ? 0.01 : 0.001);
+        benchExplicit(heat, 1.e-8, 1.e-6);
+
+        // the same circuit with the node equations solved inside rhs() and
+        // as the algebraic part of a DAE (without algebraic error control,
+        // like the nested form)
+        DiodeChain nested(20, false);
+        benchImplicit(nested, 1.e-8, 1.e-6);
+        benchBdf(nested, 1.e-8, 1.e-6);
+
+        DiodeChain dae(20, true);
+        benchImplicit(dae, 1.e-8, 1.e-6);
+
+        // a stiff method-of-lines system with its Jacobian declared dense,
+        // banded and sparse; dense only at the smaller size
+        size_t cells[] = {200, options.quick ? (size_t) 1000 : (size_t) 5000};
+
+        for (size_t i = 0; i < 2; i++) {
+            if (i == 0) {
+                Brusselator dense(cells[i], JacobianStructure::DENSE);
+                benchImplicit(dense, 1.e-6, 1.e-6);
+            }
+
+            Brusselator banded(cells[i], JacobianStructure::BANDED);
+            benchImplicit(banded, 1.e-6, 1.e-6);
+            benchBdf(banded, 1.e-6, 1.e-6);
+
+            Brusselator sparse(cells[i], JacobianStructure::SPARSE);
+            benchImplicit(sparse, 1.e-6, 1.e-6);
+
+            // matrix-free; without the preconditioner GMRES stalls on the
+            // diffusion of the larger grid
+            BrusselatorPreconditioner lines(cells[i]);
+
+            if (i == 0) {
+                benchKrylov(banded, NULL, 1.e-6, 1.e-6);
+            }
+
+            benchKrylov(banded, &lines, 1.e-6, 1.e-6);
+        }
+
+        // stiff local reaction with explicit transport, split and whole
+        AdvectionReaction advection(options.quick ? 100 : 200);
+        benchExplicit(advection, 1.e-6, 1.e-6);
+        benchImplicit(advection, 1.e-6, 1.e-6);
+        benchImex(advection, 1.e-6, 1.e-6);
+
+        // long stiff runs: one LU per step (Rosenbrock) against LU reuse
+        // (BDF)
+        Robertson longRobertson(options.quick ? 1.e3 : 1.e5);
+        benchImplicit(longRobertson, 1.e-10, 1.e-6);
+        benchBdf(longRobertson, 1.e-10, 1.e-6);
+
+        VanDerPol stiffVdp(1000);
+        benchImplicit(stiffVdp, 1.e-8, 1.e-6);
+        benchBdf(stiffVdp, 1.e-8, 1.e-6);
+
+        // the delay equation against its approximation by a linear chain
+        MackeyGlass mackeyGlass;
+        benchDelay(mackeyGlass, 1.e-8, 1.e-6);
+
+        MackeyGlassChain chain(50);
+        benchExplicit(chain, 1.e-8, 1.e-6);
+
+        // automatic method selection: stays explicit on non-stiff problems,
+        // goes stiff on Robertson and alternates with the relaxation
+        // oscillation
+        benchAuto(lorenz, 1.e-10, 1.e-8);
+        benchAuto(longRobertson, 1.e-10, 1.e-6);
+        benchAuto(stiffVdp, 1.e-8, 1.e-6);
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Linear algebra                                                       *
+     *                                                                            *
+     ******************************************************************************/
+
+    void fill(Vector<inDouble>& v, Random& r) {
+        for (inULong i = 0; i < v.size(); i++) {
+            v(i) = r.next();
+        }
+    }
+
+    void fill(Matrix<inDouble>& m, Random& r, bool diagonallyDominant) {
+        for (inULong j = 0; j < m.nCols(); j++) {
+            for (inULong i = 0; i < m.nRows(); i++) {
+                m(i, j) = r.next();
+            }
+        }
+
+        if (diagonallyDominant) {
+            for (inULong i = 0; i < m.nRows(); i++) {
+                m(i, i) += m.nRows();
+            }
+        }
+    }
+
+    void benchMatrix() {
+        size_t sizes[] = {16, 64, 256};
+
+        for (size_t s = 0; s < 3; s++) {
+            size_t n = sizes[s];
+
+            if (options.quick && n > 64) {
+                continue;
+            }
+
+            stringstream suffix;
+            suffix << "/n" << n;
+
+            Random r(42 + n);
+
+            Matrix<inDouble> A(n, n, true);
+            Matrix<inDouble> B(n, n, true);
+            Vector<inDouble> b(n, true);
+
+            fill(A, r, true);
+            fill(B, r, false);
+            fill(b, r);
+
+            run("matrix/gemm" + suffix.str(), [&](ostream & os) {
+                Matrix<inDouble> C = A * B;
+                os << ", \"n\": " << n << ", \"checksum\": " << C.frobNorm();
+            });
+
+            run("matrix/lu" + suffix.str(), [&](ostream & os) {
+                Matrix<inDouble> LU = A.copy(true);
+                LU.LUdecomposition();
+                os << ", \"n\": " << n << ", \"checksum\": " << LU(n - 1, n - 1);
+            });
+
+            run("matrix/solve" + suffix.str(), [&](ostream & os) {
+                Matrix<inDouble> M = A.copy(true);
+                Vector<inDouble> x = M | b;
+                os << ", \"n\": " << n << ", \"checksum\": " << x.norm2();
+            });
+        }
+    }
+
+    void benchVector() {
+        size_t sizes[] = {1000, 100000};
+
+        for (size_t s = 0; s < 2; s++) {
+            size_t n = sizes[s];
+
+            stringstream suffix;
+            suffix << "/n" << n;
+
+            Random r(7 + n);
+
+            Vector<inDouble> x(n, true);
+            Vector<inDouble> y(n, true);
+
+            fill(x, r);
+            fill(y, r);
+
+            // repeat the cheap kernels so that timings are well above the
+            // clock resolution
+            const size_t inner = 1000000 / n + 1;
+
+            run("vector/dot" + suffix.str(), [&](ostream & os) {
+                double sum = 0;
+                for (size_t k = 0; k < inner; k++) {
+                    sum += x.dotprod(y);
+                }
+                os << ", \"n\": " << n << ", \"inner\": " << inner << ", \"checksum\": " << sum;
+            });
+
+            run("vector/axpy" + suffix.str(), [&](ostream & os) {
+                Vector<inDouble> z = y.copy(true);
+                for (size_t k = 0; k < inner; k++) {
+                    z += x;
+                }
+                os << ", \"n\": " << n << ", \"inner\": " << inner << ", \"checksum\": " << z.norm2();
+            });
+
+            run("vector/scal" + suffix.str(), [&](ostream & os) {
+                Vector<inDouble> z = y.copy(true);
+                for (size_t k = 0; k < inner; k++) {
+                    z *= 1.0000001;
+                }
+                os << ", \"n\": " << n << ", \"inner\": " << inner << ", \"checksum\": " << z.norm2();
+            });
+
+            run("vector/norm2" + suffix.str(), [&](ostream & os) {
+                double sum = 0;
+                for (size_t k = 0; k < inner; k++) {
+                    sum += x.norm2();
+                }
+                os << ", \"n\": " << n << ", \"inner\": " << inner << ", \"checksum\": " << sum;
+            });
+        }
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Interpolation and memory management                                  *
+     *                                                                            *
+     ******************************************************************************/
+
+    void benchInterpolation() {
+        size_t sizes[] = {100, 100000};
+
+        for (size_t s = 0; s < 2; s++) {
+            size_t n = sizes[s];
+
+            TimeSeries data;
+
+            for (size_t i = 0; i < n; i++) {
+                double t = (double) i / n;
+                data.push_back(TimeValue(t, std::sin(6.0 * t)));
+            }
+
+            Interpolation interpolation(data);
+
+            const size_t lookups = options.quick ? 100000 : 1000000;
+
+            stringstream name;
+            name << "interpolation/lookup/n" << n;
+
+            run(name.str(), [&](ostream & os) {
+                Random r(3);
+                double sum = 0;
+                for (size_t k = 0; k < lookups; k++) {
+                    sum += interpolation(0.5 + 0.5 * r.next());
+                }
+                os << ", \"n\": " << n << ", \"lookups\": " << lookups << ", \"checksum\": " << sum;
+            });
+        }
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Trajectory storage                                                   *
+     *                                                                            *
+     ******************************************************************************/
+
+    void benchTrajectory() {
+        Lorenz lorenz;
+        Problem problem(lorenz);
+        problem.setInitialValue(lorenz.initialValue())
+                .setTimeRange(0, options.quick ? 20 : 200)
+                .setPrecision(1e-10, 1e-10);
+
+        ODESolver solver;
+        CompressedTrajectory compressed;
+        solver.solve(problem, compressed);
+
+        size_t chunks = compressed.getChunkCount();
+        vector<double> column(compressed.getChunkSize());
+
+        run("trajectory/compressed/decode", [&](ostream & os) {
+            double sum = 0;
+            size_t values = 0;
+
+            for (size_t c = 0; c < chunks; c++) {
+                for (size_t col = 0; col <= compressed.getDimension(); col++) {
+                    size_t n = compressed.decodeColumn(c, col, column.data());
+                    sum += column[n - 1];
+                    values += n;
+                }
+            }
+
+            os << ", \"values\": " << values
+                    << ", \"ratio\": " << compressed.getCompressionRatio()
+                    << ", \"checksum\": " << sum;
+        });
+    }
+
+    /**
+     * Scratch directory of the file benchmarks, removed again by
+     * removeScratch().
+     */
+    string makeScratch() {
+        char path[] = "/tmp/inumerics-bench-XXXXXX";
+
+        if (mkdtemp(path) == NULL) {
+            cerr << "bench: cannot create a scratch directory" << endl;
+            exit(1);
+        }
+
+        return path;
+    }
+
+    void removeScratch(const string& dir, const vector<string>& files) {
+        for (size_t i = 0; i < files.size(); i++) {
+            unlink((dir + "/" + files[i]).c_str());
+        }
+
+        rmdir(dir.c_str());
+    }
+
+    /**
+     * Deterministic trajectory with "noisy" full-precision values, the
+     * worst case for text formatting.
+     */
+    void fill(Trajectory& t, size_t steps, size_t dimension, Random& r) {
+        DVec x(dimension);
+
+        for (size_t i = 0; i < steps; i++) {
+            for (size_t j = 0; j < dimension; j++) {
+                x[j] = r.next() * 100.0;
+            }
+            t(x, 1.e-3 * i);
+        }
+    }
+
+    /**
+     * Keeps a checksum instead of the steps, so that the read benchmarks
+     * measure parsing rather than Trajectory storage.
+     */
+    class ChecksumTrajectory : public Trajectory {
+    public:
+
+        ChecksumTrajectory() : steps(0), checksum(0) {
+        }
+
+        virtual void operator()(const DVec& x, const double t) {
+            steps++;
+            checksum += t + x.back();
+        }
+
+        size_t steps;
+        double checksum;
+    };
+
+    /**
+     * TrajectoryWriter/Reader against formatting and parsing the same table
+     * with iostreams (17 significant digits, i.e. round trip as well).
+     */
+    void benchTrajectoryIO() {
+        const size_t steps = options.quick ? 30000 : 300000;
+        const size_t dimension = 6;
+
+        Random r(5);
+        Trajectory source;
+        fill(source, steps, dimension, r);
+
+        // the readers parse these, the writers write to out*
+        string dir = makeScratch();
+        string csv = dir + "/t.csv";
+        string binary = dir + "/t.traj";
+        TrajectoryWriter::writeText(csv, source);
+        TrajectoryWriter::writeBinary(binary, source);
+
+        run("io/text/write", [&](ostream & os) {
+            TrajectoryWriter::writeText(dir + "/out.csv", source);
+            os << ", \"steps\": " << steps << ", \"columns\": " << dimension + 1;
+        });
+
+        run("io/text/write_iostream", [&](ostream & os) {
+            ofstream file((dir + "/out_iostream.csv").c_str());
+            file.precision(17);
+            file << "t";
+            for (size_t j = 0; j < dimension; j++) {
+                file << ",x" << j;
+            }
+            file << "\n";
+            for (size_t i = 0; i < source.size(); i++) {
+                const DVec& x = source.getState(i);
+                file << source.getTime(i);
+                for (size_t j = 0; j < dimension; j++) {
+                    file << ',' << x[j];
+                }
+                file << '\n';
+            }
+            os << ", \"steps\": " << steps << ", \"columns\": " << dimension + 1;
+        });
+
+        run("io/text/read", [&](ostream & os) {
+            ChecksumTrajectory t;
+            TrajectoryReader::readText(csv, t);
+            os << ", \"steps\": " << t.steps << ", \"checksum\": " << t.checksum;
+        });
+
+        run("io/text/read_iostream", [&](ostream & os) {
+            ChecksumTrajectory t;
+            ifstream file(csv.c_str());
+            string header;
+            getline(file, header);
+            DVec x(dimension);
+            double time;
+            char delimiter;
+            while (file >> time) {
+                for (size_t j = 0; j < dimension; j++) {
+                    file >> delimiter >> x[j];
+                }
+                t(x, time);
+            }
+            os << ", \"steps\": " << t.steps << ", \"checksum\": " << t.checksum;
+        });
+
+        run("io/binary/write", [&](ostream & os) {
+            TrajectoryWriter::writeBinary(dir + "/out.traj", source);
+            os << ", \"steps\": " << steps;
+        });
+
+        run("io/binary/read", [&](ostream & os) {
+            ChecksumTrajectory t;
+            TrajectoryReader::readBinary(binary, t);
+            os << ", \"steps\": " << t.steps << ", \"checksum\": " << t.checksum;
+        });
+
+        removeScratch(dir, {"t.csv", "t.traj", "out.csv", "out_iostream.csv", "out.traj"});
+    }
+
+    /**
+     * Ensemble export, many small files and one container. The stats of
+     * the first run report trajectories per minute and the queue waits.
+     */
+    void benchExport() {
+        const size_t members = options.quick ? 200 : 2000;
+
+        Random r(9);
+        vector<shared_ptr<const Trajectory> > ensemble;
+        vector<string> names;
+        vector<string> files;
+
+        for (size_t m = 0; m < members; m++) {
+            shared_ptr<Trajectory> t(new Trajectory());
+            fill(*t, 500, 3, r);
+            ensemble.push_back(t);
+
+            stringstream name;
+            name << "m" << m;
+            names.push_back(name.str());
+            files.push_back(name.str() + ".traj");
+        }
+
+        string dir = makeScratch();
+
+        files.push_back("ensemble.000");
+        files.push_back("ensemble.index");
+
+        for (int container = 0; container < 2; container++) {
+            run(container ? "export/container" : "export/files", [&](ostream & os) {
+                ExportOptions o;
+                o.path = container ? dir + "/ensemble" : dir;
+                o.container = container != 0;
+
+                ExportPipeline pipeline(o);
+
+                for (size_t m = 0; m < members; m++) {
+                    pipeline.submit(names[m], ensemble[m]);
+                }
+
+                ExportStats stats = pipeline.finish();
+
+                os << ", \"members\": " << members << ", \"stats\": ";
+                stats.writeJSON(os);
+            });
+        }
+
+        removeScratch(dir, files);
+    }
+
+    void benchMemCollect() {
+        const size_t rounds = options.quick ? 10000 : 100000;
+
+        run("memcollect/churn", [&](ostream & os) {
+            Random r(11);
+            double sum = 0;
+
+            for (size_t k = 0; k < rounds; k++) {
+                // a handful of recurring sizes, like temporaries in a solver
+                inULong n = 8 << (size_t) (4.0 * (0.5 + 0.5 * r.next()));
+                Vector<inDouble> a(n, true);
+                Vector<inDouble> b(n, true);
+                a(0) = 1.0;
+                b = a + a;
+                sum += b(0);
+            }
+
+            os << ", \"rounds\": " << rounds << ", \"checksum\": " << sum;
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+
+    options.reps = 5;
+    options.quick = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            options.reps = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            options.quick = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.trace = argv[++i];
+        } else {
+            options.filters.push_back(argv[i]);
+        }
+    }
+
+    cout << "{\"bench\": \"meta\", \"build\": \"" << INUMERICS_BUILD_TYPE
+            << "\", \"compiler\": \"" << __VERSION__
+            << "\", \"reps\": " << options.reps
+            << ", \"quick\": " << (options.quick ? "true" : "false") << "}" << endl;
+
+    // large enough that MemCollect never trims its list during a benchmark
+    Matrix<inDouble>::memCheck.initialize(MByte(256.0), Byte(0));
+
+    if (!options.trace.empty()) {
+        Tracer::start(1 << 20);
+    }
+
+    benchOde();
+    benchMatrix();
+    benchVector();
+    benchInterpolation();
+    benchTrajectory();
+    benchTrajectoryIO();
+    benchExport();
+    benchMemCollect();
+
+    if (!options.trace.empty()) {
+        Tracer::stop();
+        ofstream file(options.trace.c_str());
+        Tracer::writeChromeTrace(file);
+    }
+
+    return 0;
+}
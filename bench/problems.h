@@ -0,0 +1,716 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef BENCH_PROBLEMS_H
+#define	BENCH_PROBLEMS_H
+
+#include <cmath>
+#include <string>
+#include <sstream>
+
+#include "iNumerics.h"
+
+namespace iNumerics {
+
+    /**
+     * Benchmark model with a name and a default initial value and time range.
+     */
+    class BenchModel : public Model {
+    public:
+
+        virtual std::string name() const = 0;
+
+        virtual DVec initialValue() const = 0;
+
+        virtual double endTime() const = 0;
+
+        void step(const DVec &x, double t) {
+            //
+        }
+    };
+
+    /**
+     * Damped harmonic oscillator (same as examples/test02).
+     */
+    class HarmonicOscillator : public BenchModel {
+    public:
+
+        std::string name() const {
+            return "harmonic";
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            dydt[0] = y[1];
+            dydt[1] = -y[0] - 0.15 * y[1];
+        }
+
+        DVec initialValue() const {
+            DVec x(2);
+            x[0] = 1.0;
+            x[1] = 0.0;
+            return x;
+        }
+
+        double endTime() const {
+            return 100.0;
+        }
+    };
+
+    /**
+     * Lorenz system with the classic chaotic parameters.
+     */
+    class Lorenz : public BenchModel {
+    public:
+
+        std::string name() const {
+            return "lorenz";
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            const double sigma = 10.0;
+            const double R = 28.0;
+            const double b = 8.0 / 3.0;
+
+            dydt[0] = sigma * (y[1] - y[0]);
+            dydt[1] = R * y[0] - y[1] - y[0] * y[2];
+            dydt[2] = -b * y[2] + y[0] * y[1];
+        }
+
+        DVec initialValue() const {
+            DVec x(3);
+            x[0] = 10.0;
+            x[1] = 1.0;
+            x[2] = 1.0;
+            return x;
+        }
+
+        double endTime() const {
+            return 25.0;
+        }
+    };
+
+    /**
+     * Van der Pol oscillator, stiffness grows with mu.
+     */
+    class VanDerPol : public BenchModel {
+    public:
+
+        VanDerPol(double mu) : _mu(mu) {
+        }
+
+        std::string name() const {
+            std::stringstream ss;
+            ss << "vanderpol_mu" << _mu;
+            return ss.str();
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            dydt[0] = y[1];
+            dydt[1] = _mu * (1.0 - y[0] * y[0]) * y[1] - y[0];
+        }
+
+        DVec initialValue() const {
+            DVec x(2);
+            x[0] = 2.0;
+            x[1] = 0.0;
+            return x;
+        }
+
+        double endTime() const {
+            // about two relaxation periods for large mu
+            return 2.0 * (3.0 - 2.0 * std::log(2.0)) * std::max(_mu, 1.0);
+        }
+
+    private:
+        double _mu;
+    };
+
+    /**
+     * Robertson's chemical kinetics, the standard stiff test problem.
+     */
+    class Robertson : public BenchModel {
+    public:
+
+        Robertson(double tn = 1.0) : _tn(tn) {
+        }
+
+        std::string name() const {
+            return "robertson";
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            dydt[0] = -0.04 * y[0] + 1.e4 * y[1] * y[2];
+            dydt[1] = 0.04 * y[0] - 1.e4 * y[1] * y[2] - 3.e7 * y[1] * y[1];
+            dydt[2] = 3.e7 * y[1] * y[1];
+        }
+
+        DVec initialValue() const {
+            DVec x(3, 0.0);
+            x[0] = 1.0;
+            return x;
+        }
+
+        double endTime() const {
+            return _tn;
+        }
+
+    private:
+        double _tn;
+    };
+
+    /**
+     * Method-of-lines discretization of u_t = u_xx on [0,1] with
+     * homogeneous Dirichlet boundaries and n interior points.
+     */
+    class Heat1D : public BenchModel {
+    public:
+
+        Heat1D(size_t n, double tn = 0.01) : _n(n), _tn(tn) {
+        }
+
+        std::string name() const {
+            std::stringstream ss;
+            ss << "heat1d_n" << _n;
+            return ss.str();
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            const double dx = 1.0 / (_n + 1);
+            const double c = 1.0 / (dx * dx);
+
+            for (size_t i = 0; i < _n; i++) {
+                double left = i > 0 ? y[i - 1] : 0.0;
+                double right = i + 1 < _n ? y[i + 1] : 0.0;
+                dydt[i] = c * (left - 2.0 * y[i] + right);
+            }
+        }
+
+        DVec initialValue() const {
+            DVec x(_n);
+            const double dx = 1.0 / (_n + 1);
+
+            for (size_t i = 0; i < _n; i++) {
+                x[i] = std::sin(M_PI * (i + 1) * dx);
+            }
+
+            return x;
+        }
+
+        double endTime() const {
+            return _tn;
+        }
+
+        size_t size() const {
+            return _n;
+        }
+
+    private:
+        size_t _n;
+        double _tn;
+    };
+
+    /**
+     * Chain of n RC stages behind a 50 Hz source, every stage clipped by a
+     * diode. The diode node voltages d_k follow from the nonlinear node
+     * equations
+     *
+     *     (in_k - d_k) / R - Is (exp(d_k / Vt) - 1) - d_k / R3 - (d_k - c_k) / R = 0
+     *
+     * with in_k = c_{k-1} (the source for k = 0) and drive the capacitor
+     * voltages c_k' = (d_k - c_k) / (R C).
+     *
+     * As a DAE (dae = true) the state is (c, d) with the mass matrix
+     * diag(1, 0); otherwise the state is c and rhs() solves every node
+     * equation by Newton's method.
+     */
+    class DiodeChain : public BenchModel {
+    public:
+
+        DiodeChain(size_t n, bool dae) : _n(n), _dae(dae) {
+        }
+
+        std::string name() const {
+            std::stringstream ss;
+            ss << "diodechain_n" << _n << (_dae ? "_dae" : "_nested");
+            return ss.str();
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            for (size_t k = 0; k < _n; k++) {
+                double in = k > 0 ? y[k - 1] : source(t);
+                double d = _dae ? y[_n + k] : node(in, y[k]);
+
+                dydt[k] = (d - y[k]) / (R * C);
+
+                if (_dae) {
+                    dydt[_n + k] = R * residual(in, d, y[k]);
+                }
+            }
+        }
+
+        /**
+         * Only the DAE form has a Jacobian in closed form.
+         */
+        bool jacobian(const DVec &y, DVec &J, const double t) {
+            if (!_dae) {
+                return false;
+            }
+
+            const size_t n = 2 * _n;
+
+            for (size_t k = 0; k < _n; k++) {
+                const size_t d = _n + k;
+
+                J[k * n + k] = -1 / (R * C);
+                J[d * n + k] = 1 / (R * C);
+
+                if (k > 0) {
+                    J[(k - 1) * n + d] = 1;
+                }
+
+                J[k * n + d] = 1;
+                J[d * n + d] = -2 - R * Is / Vt * std::exp(y[d] / Vt) - R / R3;
+            }
+
+            return true;
+        }
+
+        bool hasMassMatrix() const {
+            return _dae;
+        }
+
+        bool massMatrix(DVec &M) {
+            if (!_dae) {
+                return false;
+            }
+
+            const size_t n = 2 * _n;
+
+            for (size_t k = 0; k < _n; k++) {
+                M[k * n + k] = 1;
+            }
+
+            return true;
+        }
+
+        DVec initialValue() const {
+            return DVec(_dae ? 2 * _n : _n, 0.0);
+        }
+
+        double endTime() const {
+            return 0.04;
+        }
+
+    private:
+        static constexpr double R = 1.e3;
+        static constexpr double R3 = 1.e4;
+        static constexpr double C = 1.e-6;
+        static constexpr double Is = 1.e-12;
+        static constexpr double Vt = 0.02585;
+
+        static double source(double t) {
+            return 5 * std::sin(2 * M_PI * 50 * t);
+        }
+
+        static double residual(double in, double d, double c) {
+            return (in - d) / R - Is * (std::exp(d / Vt) - 1) - d / R3 - (d - c) / R;
+        }
+
+        /**
+         * Solves the node equation for d by damped Newton iterations.
+         */
+        static double node(double in, double c) {
+            double d = std::min(0.5 * (in + c), 0.6);
+
+            for (int i = 0; i < 50; i++) {
+                double dr = -2 / R - Is / Vt * std::exp(d / Vt) - 1 / R3;
+                double delta = residual(in, d, c) / dr;
+
+                delta = std::max(-0.1, std::min(0.1, delta));
+                d -= delta;
+
+                if (std::fabs(delta) < 1.e-12) {
+                    break;
+                }
+            }
+
+            return d;
+        }
+
+        size_t _n;
+        bool _dae;
+    };
+
+
+    /**
+     * Brusselator with diffusion on [0, 1], method of lines with n cells
+     * (Hairer & Wanner, II.10):
+     *
+     *     u' = 1 + u^2 v - 4 u + alpha u_xx
+     *     v' = 3 u - u^2 v + alpha v_xx
+     *
+     * alpha = 1/50, u = 1 and v = 3 at the boundary. The state interleaves
+     * (u_i, v_i), so the Jacobian has bandwidth 2; it is declared in the
+     * given structure (dense, banded or sparse) and computed by finite
+     * differences.
+     */
+    class Brusselator : public BenchModel {
+    public:
+
+        Brusselator(size_t n, JacobianStructure::Type structure) : _n(n), _structure(structure) {
+        }
+
+        std::string name() const {
+            static const char* structures[] = {"dense", "banded", "block", "sparse"};
+
+            std::stringstream ss;
+            ss << "brusselator_n" << 2 * _n << "_" << structures[_structure];
+            return ss.str();
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            const double c = (_n + 1.0) * (_n + 1.0) / 50;
+
+            for (size_t i = 0; i < _n; i++) {
+                const double u = y[2 * i];
+                const double v = y[2 * i + 1];
+                const double ul = i > 0 ? y[2 * i - 2] : 1;
+                const double vl = i > 0 ? y[2 * i - 1] : 3;
+                const double ur = i + 1 < _n ? y[2 * i + 2] : 1;
+                const double vr = i + 1 < _n ? y[2 * i + 3] : 3;
+
+                dydt[2 * i] = 1 + u * u * v - 4 * u + c * (ul - 2 * u + ur);
+                dydt[2 * i + 1] = 3 * u - u * u * v + c * (vl - 2 * v + vr);
+            }
+        }
+
+        JacobianStructure getJacobianStructure() {
+            if (_structure == JacobianStructure::BANDED) {
+                return JacobianStructure::banded(2, 2);
+            }
+
+            if (_structure != JacobianStructure::SPARSE) {
+                return JacobianStructure();
+            }
+
+            // u_i and v_i couple with each other and with their neighbors
+            const size_t n = 2 * _n;
+            std::vector<size_t> rowPointers(1, 0);
+            std::vector<size_t> columnIndices;
+
+            for (size_t i = 0; i < n; i++) {
+                for (size_t j = i >= 2 ? i - 2 : 0; j <= std::min(n - 1, i + 2); j++) {
+                    if (j % 2 == i % 2 || j / 2 == i / 2) {
+                        columnIndices.push_back(j);
+                    }
+                }
+
+                rowPointers.push_back(columnIndices.size());
+            }
+
+            return JacobianStructure::sparse(rowPointers, columnIndices);
+        }
+
+        DVec initialValue() const {
+            DVec y(2 * _n);
+
+            for (size_t i = 0; i < _n; i++) {
+                y[2 * i] = 1 + std::sin(2 * M_PI * (i + 1.0) / (_n + 1));
+                y[2 * i + 1] = 3;
+            }
+
+            return y;
+        }
+
+        double endTime() const {
+            return 10;
+        }
+
+    private:
+        size_t _n;
+        JacobianStructure::Type _structure;
+    };
+
+    /**
+     * Preconditioner for Brusselator: I - gamma J without the coupling of
+     * u and v, i.e. one tridiagonal (line) solve per species.
+     */
+    class BrusselatorPreconditioner : public Preconditioner {
+    public:
+
+        BrusselatorPreconditioner(size_t n) : _n(n), _gamma(0), _c(n), _d(n) {
+        }
+
+        bool setup(const DVec& y, const DVec& f, double t, double gamma) {
+            _y = y;
+            _gamma = gamma;
+            return true;
+        }
+
+        void solve(const DVec& r, DVec& z) {
+            const double c = (_n + 1.0) * (_n + 1.0) / 50;
+            const double off = -_gamma * c;
+
+            z.resize(r.size());
+
+            for (size_t s = 0; s < 2; s++) {
+                // Thomas algorithm
+                for (size_t i = 0; i < _n; i++) {
+                    const double u = _y[2 * i];
+                    const double v = _y[2 * i + 1];
+                    const double dfdy = s == 0 ? 2 * u * v - 4 : -u * u;
+                    const double diag = 1 - _gamma * (dfdy - 2 * c) - (i > 0 ? off * _c[i - 1] : 0);
+
+                    _c[i] = off / diag;
+                    _d[i] = (r[2 * i + s] - (i > 0 ? off * _d[i - 1] : 0)) / diag;
+                }
+
+                for (size_t i = _n; i-- > 0;) {
+                    z[2 * i + s] = _d[i] - (i + 1 < _n ? _c[i] * z[2 * i + 2 + s] : 0);
+                }
+            }
+        }
+
+    private:
+        size_t _n;
+        DVec _y;
+        double _gamma;
+        DVec _c;
+        DVec _d;
+    };
+
+    /**
+     * Advection with a fast reaction 2 A <-> B on the periodic [0, 1],
+     * first order upwind with n cells:
+     *
+     *     a_t + a_x = -2 k (a^2 - b)
+     *     b_t + b_x = k (a^2 - b)
+     *
+     * k = 1e4. The state interleaves (a_i, b_i). Split into the non-stiff
+     * transport (explicit) and the stiff, local reaction (implicit, 2 x 2
+     * blocks); the Jacobian of the whole rhs is declared sparse.
+     */
+    class AdvectionReaction : public BenchModel {
+    public:
+
+        AdvectionReaction(size_t n) : _n(n) {
+        }
+
+        std::string name() const {
+            std::stringstream ss;
+            ss << "advectionreaction_n" << 2 * _n;
+            return ss.str();
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            transport(y, dydt);
+
+            for (size_t i = 0; i < _n; i++) {
+                const double r = rate(y, i);
+
+                dydt[2 * i] -= 2 * r;
+                dydt[2 * i + 1] += r;
+            }
+        }
+
+        bool rhs_explicit(const DVec &y, DVec &dydt, const double t) {
+            transport(y, dydt);
+            return true;
+        }
+
+        bool rhs_implicit(const DVec &y, DVec &dydt, const double t) {
+            for (size_t i = 0; i < _n; i++) {
+                const double r = rate(y, i);
+
+                dydt[2 * i] = -2 * r;
+                dydt[2 * i + 1] = r;
+            }
+
+            return true;
+        }
+
+        JacobianStructure getImplicitJacobianStructure() {
+            return JacobianStructure::blockDiagonal(2);
+        }
+
+        JacobianStructure getJacobianStructure() {
+            // the own cell and the upwind neighbor of the same species
+            std::vector<size_t> rowPointers(1, 0);
+            std::vector<size_t> columnIndices;
+
+            for (size_t i = 0; i < 2 * _n; i++) {
+                const size_t cell = i / 2;
+                const size_t upwind = 2 * ((cell + _n - 1) % _n) + i % 2;
+
+                if (upwind < 2 * cell) {
+                    columnIndices.push_back(upwind);
+                }
+
+                columnIndices.push_back(2 * cell);
+                columnIndices.push_back(2 * cell + 1);
+
+                if (upwind > 2 * cell + 1) {
+                    columnIndices.push_back(upwind);
+                }
+
+                rowPointers.push_back(columnIndices.size());
+            }
+
+            return JacobianStructure::sparse(rowPointers, columnIndices);
+        }
+
+        DVec initialValue() const {
+            DVec y(2 * _n, 0);
+
+            for (size_t i = 0; i < _n; i++) {
+                y[2 * i] = 1 + 0.5 * std::sin(2 * M_PI * (i + 0.5) / _n);
+            }
+
+            return y;
+        }
+
+        double endTime() const {
+            return 1;
+        }
+
+    private:
+
+        double rate(const DVec &y, size_t i) const {
+            return 1.e4 * (y[2 * i] * y[2 * i] - y[2 * i + 1]);
+        }
+
+        void transport(const DVec &y, DVec &dydt) const {
+            const double n = _n;
+
+            for (size_t i = 0; i < _n; i++) {
+                const size_t l = (i + _n - 1) % _n;
+
+                dydt[2 * i] = -n * (y[2 * i] - y[2 * l]);
+                dydt[2 * i + 1] = -n * (y[2 * i + 1] - y[2 * l + 1]);
+            }
+        }
+
+        size_t _n;
+    };
+
+    /**
+     * Mackey-Glass equation
+     *
+     *     y' = beta y(t - tau) / (1 + y(t - tau)^10) - gamma y
+     *
+     * with beta = 0.2, gamma = 0.1 and the chaotic delay tau = 17, history
+     * y = 0.5 before t = 0.
+     */
+    class MackeyGlass : public DelayModel {
+    public:
+
+        std::string name() const {
+            return "mackeyglass";
+        }
+
+        size_t getDelayCount() const {
+            return 1;
+        }
+
+        double getDelay(size_t k, const DVec &y, const double t) {
+            return tau;
+        }
+
+        double getMaxDelay() const {
+            return tau;
+        }
+
+        void rhs(const DVec &y, const DVec &delayed, DVec &dydt, const double t) {
+            dydt[0] = production(delayed[0]) - gamma * y[0];
+        }
+
+        void step(const DVec &x, double t) {
+            //
+        }
+
+        DVec initialValue() const {
+            return DVec(1, 0.5);
+        }
+
+        double endTime() const {
+            return 500;
+        }
+
+        static double production(double y) {
+            return beta * y / (1 + std::pow(y, 10));
+        }
+
+        static constexpr double beta = 0.2;
+        static constexpr double gamma = 0.1;
+        static constexpr double tau = 17;
+    };
+
+    /**
+     * Mackey-Glass with the delay replaced by a chain of m linear stages
+     * z_k' = (m / tau) (z_{k-1} - z_k), z_0 = y, i.e. a gamma distributed
+     * delay with mean tau that approaches the fixed delay as m grows. This
+     * is the usual way to solve the equation with an ODE solver.
+     */
+    class MackeyGlassChain : public BenchModel {
+    public:
+
+        MackeyGlassChain(size_t m) : _m(m) {
+        }
+
+        std::string name() const {
+            std::stringstream ss;
+            ss << "mackeyglass_chain" << _m;
+            return ss.str();
+        }
+
+        void rhs(const DVec &y, DVec &dydt, const double t) {
+            const double rate = _m / MackeyGlass::tau;
+
+            dydt[0] = MackeyGlass::production(y[_m]) - MackeyGlass::gamma * y[0];
+
+            for (size_t k = 1; k <= _m; k++) {
+                dydt[k] = rate * (y[k - 1] - y[k]);
+            }
+        }
+
+        DVec initialValue() const {
+            return DVec(_m + 1, 0.5);
+        }
+
+        double endTime() const {
+            return 500;
+        }
+
+    private:
+        size_t _m;
+    };
+
+}
+
+#endif	/* BENCH_PROBLEMS_H */
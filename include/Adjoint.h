@@ -0,0 +1,77 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef ADJOINT_H
+#define	ADJOINT_H
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Scalar objective G = g(y(tn)) of ODESolver::solve_adjoint().
+     */
+    class Objective {
+    public:
+
+        virtual ~Objective() {
+        }
+
+        /**
+         * @param y	state at the end of the solve
+         * @param dgdy	receives dg/dy, has size n on entry
+         * @return g(y)
+         */
+        virtual double evaluate(const DVec& y, double t, DVec& dgdy) = 0;
+    };
+
+    /**
+     * Result of ODESolver::solve_adjoint().
+     */
+    struct AdjointResult {
+        /** G */
+        double value;
+        /** dG/dp for every Model parameter */
+        DVec gradient;
+        /** dG/dy(t0) */
+        DVec initialGradient;
+
+        /** accepted steps of the forward solve */
+        size_t steps;
+        /** forward steps recomputed during the backward pass */
+        size_t recomputedSteps;
+        /** adjoint steps, including rejected ones */
+        size_t adjointSteps;
+        /** largest number of states held as snapshots at the same time */
+        size_t snapshots;
+    };
+
+}
+
+#endif	/* ADJOINT_H */
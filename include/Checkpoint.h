@@ -0,0 +1,130 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef CHECKPOINT_H
+#define	CHECKPOINT_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Types.h"
+#include "SolveStats.h"
+#include "inprofiler.h"
+
+namespace iNumerics {
+
+    /**
+     * State of a running solve after an accepted step. Together with the
+     * Problem this is everything the solver needs to continue; the
+     * explicit Cash-Karp stepper keeps no history between steps, so t, x
+     * and the controller step size dt determine the remaining solve.
+     */
+    class Checkpoint {
+    public:
+        Checkpoint();
+
+        double t;
+        /** step size proposed by the controller for the next step */
+        double dt;
+        DVec x;
+
+        /** Trajectory::size() when the checkpoint was taken */
+        size_t trajectorySize;
+
+        /** counters of the solve up to t, continued on resume */
+        SolveStats stats;
+
+        /**
+         * Writes to path.tmp and renames it to path, so path always holds a
+         * complete checkpoint. Throws std::runtime_error on I/O errors.
+         */
+        void write(const std::string& path) const;
+
+        /**
+         * Throws std::runtime_error if the file is missing, truncated or
+         * fails the checksum.
+         */
+        static Checkpoint read(const std::string& path);
+    };
+
+    /**
+     * Writes checkpoints of a solve in a background thread.
+     *
+     * The solver offers its state after every accepted step; once interval
+     * seconds (wall time) have passed since the last checkpoint the state is
+     * copied and handed to the writer. If the writer is still busy the newer
+     * state replaces the queued one, so the solver never waits for the disk.
+     */
+    class CheckpointWriter {
+    public:
+        CheckpointWriter(const std::string& path, double interval);
+
+        /**
+         * Writes the queued checkpoint and stops the thread.
+         */
+        ~CheckpointWriter();
+
+        /**
+         * @return true if a checkpoint is due
+         */
+        bool isDue() const {
+            return MonotonicClock::now() >= _next;
+        }
+
+        void offer(const Checkpoint& checkpoint);
+
+        /**
+         * @return number of checkpoints written
+         */
+        size_t getWritten() const;
+
+    private:
+        CheckpointWriter(const CheckpointWriter&);
+        CheckpointWriter& operator=(const CheckpointWriter&);
+
+        void writerLoop();
+
+        std::string _path;
+        inULong _interval;
+        inULong _next;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _wake;
+        Checkpoint _queued;
+        bool _hasQueued;
+        bool _stop;
+        size_t _written;
+        std::thread _writer;
+    };
+
+}
+
+#endif	/* CHECKPOINT_H */
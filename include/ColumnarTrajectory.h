@@ -0,0 +1,222 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef COLUMNARTRAJECTORY_H
+#define	COLUMNARTRAJECTORY_H
+
+#include <string>
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Read-only view of a contiguous column section.
+     */
+    struct ColumnSpan {
+
+        ColumnSpan() : data(NULL), size(0) {
+        }
+
+        ColumnSpan(const double* data, size_t size) : data(data), size(size) {
+        }
+
+        const double* begin() const {
+            return data;
+        }
+
+        const double* end() const {
+            return data + size;
+        }
+
+        double operator[](size_t i) const {
+            return data[i];
+        }
+
+        const double* data;
+        size_t size;
+    };
+
+    /**
+     * Writes trajectories in the columnar chunked format (version 1).
+     *
+     * File layout (native byte order, all sections 8 byte aligned):
+     *
+     *   header (64 bytes): char magic[8] = "INCOLTRJ", uint32 version,
+     *                      uint32 dimension, uint64 chunkSize, uint64 records,
+     *                      uint64 chunks, uint64 indexOffset, uint64 reserved[2]
+     *   chunks:  double t[chunkSize], double x0[chunkSize], ..., double x{d-1}[chunkSize]
+     *            (the last chunk is padded to chunkSize rows)
+     *   index:   per chunk: double tMin, tMax, min[dimension], max[dimension]
+     *
+     * Only the chunk being filled is held in memory. The header and the
+     * index are written by close(); a file that was not closed is rejected
+     * by MappedTrajectory.
+     */
+    class ColumnarTrajectoryWriter {
+    public:
+        /**
+         * @param path		file to write, truncated if it exists
+         * @param chunkSize	records per chunk (Range: > 0)
+         */
+        ColumnarTrajectoryWriter(const std::string& path, size_t chunkSize = 4096);
+        ~ColumnarTrajectoryWriter();
+
+        void append(const DVec& x, double t);
+
+        /**
+         * Appends all steps of a trajectory.
+         */
+        void append(const Trajectory& trajectory);
+
+        /**
+         * Writes the pending chunk, the index and the header. Called by the
+         * destructor if necessary.
+         */
+        void close();
+
+        /**
+         * Writes a whole trajectory to a file.
+         */
+        static void write(const std::string& path, const Trajectory& trajectory,
+                size_t chunkSize = 4096);
+
+    private:
+        ColumnarTrajectoryWriter(const ColumnarTrajectoryWriter&);
+        ColumnarTrajectoryWriter& operator=(const ColumnarTrajectoryWriter&);
+
+        void writeChunk();
+        void writeAt(const void* data, size_t n, size_t offset);
+
+        std::string _path;
+        int _fd;
+        size_t _chunkSize;
+        size_t _dimension;
+        size_t _records;
+        size_t _chunks;
+        size_t _fill;
+
+        // column-major chunk buffer and the index of the written chunks
+        std::vector<double> _chunk;
+        std::vector<double> _index;
+    };
+
+    /**
+     * Memory-mapped reader of the columnar trajectory format.
+     *
+     * Time and component columns are accessed in place through ColumnSpan;
+     * nothing is copied or parsed when the file is opened. getState(i) as
+     * required by Trajectory gathers the components of step i into an
+     * internal buffer that is valid until the next call; use the overload
+     * with an output vector or the column spans in hot loops.
+     */
+    class MappedTrajectory : public Trajectory {
+    public:
+        /**
+         * Maps a file written by ColumnarTrajectoryWriter.
+         * Throws std::runtime_error if the file is missing or malformed.
+         */
+        explicit MappedTrajectory(const std::string& path);
+        virtual ~MappedTrajectory();
+
+        /**
+         * Not supported, the file is read-only. Throws std::logic_error.
+         */
+        virtual void operator()(const DVec& x, const double t);
+
+        virtual double getTime(std::size_t i) const;
+        virtual const DVec& getState(std::size_t i) const;
+        virtual size_t size() const;
+
+        void getState(std::size_t i, DVec& out) const;
+
+        double getState(std::size_t i, size_t component) const;
+
+        /**
+         * Min/max are taken from the chunk index.
+         */
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        /**
+         * Chunks inside the window take min/max from the index and sum the
+         * mapped column; only the two boundary chunks are scanned row by row.
+         */
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        size_t getDimension() const;
+        size_t getChunkSize() const;
+        size_t getChunkCount() const;
+
+        /**
+         * Time column of a chunk (only the valid rows).
+         */
+        ColumnSpan getTimeSpan(size_t chunk) const;
+
+        /**
+         * Column of one state component in a chunk (only the valid rows).
+         */
+        ColumnSpan getComponentSpan(size_t chunk, size_t component) const;
+
+        double getChunkMinTime(size_t chunk) const;
+        double getChunkMaxTime(size_t chunk) const;
+        double getChunkMin(size_t chunk, size_t component) const;
+        double getChunkMax(size_t chunk, size_t component) const;
+
+        /**
+         * @return the first chunk whose time range ends at or after t
+         *         (assumes increasing time), getChunkCount() if there is none
+         */
+        size_t findChunk(double t) const;
+
+    private:
+        MappedTrajectory(const MappedTrajectory&);
+        MappedTrajectory& operator=(const MappedTrajectory&);
+
+        const double* column(size_t chunk, size_t column) const;
+        const double* indexEntry(size_t chunk) const;
+
+        int _fd;
+        const char* _base;
+        size_t _length;
+
+        size_t _dimension;
+        size_t _chunkSize;
+        size_t _records;
+        size_t _chunks;
+        size_t _indexOffset;
+
+        mutable DVec _state;
+    };
+
+}
+
+#endif	/* COLUMNARTRAJECTORY_H */
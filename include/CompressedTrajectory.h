@@ -0,0 +1,142 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef COMPRESSEDTRAJECTORY_H
+#define	COMPRESSEDTRAJECTORY_H
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Trajectory that stores steps losslessly compressed with XorCodec.
+     *
+     * Steps are collected in an uncompressed chunk of chunkSize steps. A
+     * full chunk is encoded column by column (time and every component) and
+     * summarized (time range, min/max/sum per component). Random access
+     * decodes a whole chunk into a small cache, so sequential reads decode
+     * every chunk once.
+     *
+     * getState() returns a reference to an internal buffer that is valid
+     * until the next call of getState(). Readers are not thread-safe
+     * because of the shared decode cache.
+     */
+    class CompressedTrajectory : public Trajectory {
+    public:
+        /**
+         * @param chunkSize	steps per compressed chunk (Range: > 0)
+         */
+        explicit CompressedTrajectory(size_t chunkSize = 1024);
+        virtual ~CompressedTrajectory();
+
+        virtual void operator()(const DVec& x, const double t);
+
+        virtual double getTime(std::size_t i) const;
+        virtual const DVec& getState(std::size_t i) const;
+        virtual size_t size() const;
+
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        /**
+         * Uses the chunk summaries; only the boundary chunks are decoded.
+         */
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        size_t getDimension() const;
+        size_t getChunkSize() const;
+        size_t getChunkCount() const;
+
+        /**
+         * Decodes one column of a chunk (0: time, c + 1: component c) into
+         * out, which must hold getChunkSize() values.
+         * @return number of valid values
+         */
+        size_t decodeColumn(size_t chunk, size_t column, double* out) const;
+
+        /**
+         * @return bytes of encoded data, without the uncompressed open chunk
+         */
+        size_t getCompressedBytes() const;
+
+        /**
+         * @return raw size / compressed size of the encoded chunks
+         */
+        double getCompressionRatio() const;
+
+    private:
+        CompressedTrajectory(const CompressedTrajectory&);
+        CompressedTrajectory& operator=(const CompressedTrajectory&);
+
+        struct Chunk {
+            std::vector<unsigned char> data;
+            /** start of every column in data */
+            std::vector<size_t> offsets;
+            double minTime;
+            double maxTime;
+            /** min, max, sum per component */
+            std::vector<double> summary;
+        };
+
+        void sealChunk();
+        const double* chunkColumns(size_t chunk) const;
+        size_t chunkRows(size_t chunk) const;
+
+        enum {
+            CACHE_SLOTS = 4
+        };
+
+        size_t _chunkSize;
+        size_t _dimension;
+        size_t _size;
+
+        std::vector<Chunk> _chunks;
+
+        // column-major, the chunk being filled
+        std::vector<double> _open;
+        size_t _openRows;
+
+        double _minTime;
+        double _maxTime;
+        DVec _minState;
+        DVec _maxState;
+
+        // direct-mapped cache of decoded chunks
+        mutable std::vector<double> _cache[CACHE_SLOTS];
+        mutable size_t _cachedChunk[CACHE_SLOTS];
+
+        mutable DVec _state;
+    };
+
+}
+
+#endif	/* COMPRESSEDTRAJECTORY_H */
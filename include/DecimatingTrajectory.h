@@ -0,0 +1,143 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef DECIMATINGTRAJECTORY_H
+#define	DECIMATINGTRAJECTORY_H
+
+#include "Trajectory.h"
+#include "Problem.h"
+
+namespace iNumerics {
+
+    /**
+     * Records only the steps that are needed to reproduce the solution
+     * within an absolute tolerance and forwards them to a target trajectory.
+     *
+     * A step is dropped if interpolating between the retained neighbours
+     * reproduces it (every component) within the tolerance:
+     *
+     * - linear mode: swinging door, O(dimension) per step and no buffering.
+     *   Every line from the last retained step that stays inside the
+     *   tolerance band of all dropped steps spans a slope interval; a step
+     *   is dropped as long as the intervals of all components stay non-empty.
+     * - Hermite mode: cubic Hermite interpolation with the derivatives from
+     *   Problem (one extra rhs evaluation per step). Dropped steps are kept
+     *   in a window of at most maxWindow steps and rechecked against every
+     *   new candidate end point.
+     *
+     * The last received step is held back until a later step forces it to
+     * be retained or finish() is called; ODESolver calls finish() at the end
+     * of a solve. The accessors return the retained steps of the target.
+     */
+    class DecimatingTrajectory : public Trajectory {
+    public:
+        /**
+         * Linear mode.
+         * @param target	receives the retained steps
+         * @param tolerance	absolute tolerance per component (Range: >= 0)
+         */
+        DecimatingTrajectory(Trajectory& target, double tolerance);
+
+        /**
+         * Hermite mode, derivatives are evaluated with problem.
+         */
+        DecimatingTrajectory(Trajectory& target, double tolerance, Problem& problem,
+                size_t maxWindow = 1024);
+
+        virtual ~DecimatingTrajectory();
+
+        virtual void operator()(const DVec& x, const double t);
+
+        virtual void finish();
+
+        virtual double getTime(std::size_t i) const;
+        virtual const DVec& getState(std::size_t i) const;
+        virtual size_t size() const;
+
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        /**
+         * @return number of steps received
+         */
+        size_t getInputCount() const;
+
+        /**
+         * @return number of steps forwarded to the target
+         */
+        size_t getRetainedCount() const;
+
+    private:
+        DecimatingTrajectory(const DecimatingTrajectory&);
+        DecimatingTrajectory& operator=(const DecimatingTrajectory&);
+
+        bool acceptsLinear(const DVec& x, double t) const;
+        void constrainLinear(const DVec& x, double t);
+        bool acceptsHermite(const DVec& x, const DVec& f, double t) const;
+
+        void retain(const DVec& x, double t);
+        void retainPending();
+
+        Trajectory& _target;
+        double _tolerance;
+        Problem* _problem;
+        size_t _maxWindow;
+
+        size_t _inputs;
+        size_t _retained;
+
+        // last retained step
+        double _anchorT;
+        DVec _anchorX;
+        DVec _anchorF;
+
+        // last received step, not yet retained
+        bool _hasPending;
+        double _pendingT;
+        DVec _pendingX;
+        DVec _pendingF;
+
+        // linear mode: admissible slopes per component
+        DVec _slopeLow;
+        DVec _slopeHigh;
+
+        // Hermite mode: dropped steps since the anchor
+        std::vector<double> _windowT;
+        std::vector<DVec> _windowX;
+        size_t _windowSize;
+    };
+
+}
+
+#endif	/* DECIMATINGTRAJECTORY_H */
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef DELAYHISTORY_H
+#define	DELAYHISTORY_H
+
+#include <vector>
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Ring of dense-output segments y(t) on [t0, t0 + h], the solution
+     * history of a delay differential equation.
+     *
+     * A segment holds the five coefficient vectors r1, ..., r5 of the
+     * continuous extension of Dormand-Prince 5(4) (Hairer, Norsett and
+     * Wanner, contd5):
+     *
+     *     y(t0 + s h) = r1 + s (r2 + (1 - s) (r3 + s (r4 + (1 - s) r5)))
+     *
+     * (r5 = 0 gives the cubic Hermite interpolant). Segments are appended
+     * in time order and dropped from the front with trim(); the ring only
+     * grows if the retained segments do not fit.
+     */
+    class DelayHistory {
+    public:
+        /**
+         * @param dimension	state dimension
+         * @param capacity	initial number of segments
+         */
+        DelayHistory(size_t dimension, size_t capacity = 64);
+
+        /**
+         * Appends the segment [t0, t0 + h] with the coefficients r1, ..., r5
+         * (5 * dimension values). t0 must be the end of the last segment.
+         */
+        void push(double t0, double h, const double* coefficients);
+
+        /**
+         * Drops the segments that end before t.
+         */
+        void trim(double t);
+
+        void clear();
+
+        /**
+         * Evaluates the history at t. Times after the last segment are
+         * extrapolated from it.
+         * @param hint	segment found by the previous lookup of the caller
+         *		(counted since construction, updated); lookups that
+         *		move slowly find their segment in O(1)
+         * @return false if t lies before the first segment or the history
+         *         is empty (y is unchanged)
+         */
+        bool evaluate(double t, double* y, size_t& hint) const;
+
+        double getStartTime() const;
+        double getEndTime() const;
+
+        size_t size() const;
+        size_t getCapacity() const;
+        size_t getDimension() const;
+
+    private:
+        /**
+         * @return slot of the segment with the given index (0: oldest)
+         */
+        const double* segment(size_t index) const;
+
+        /**
+         * @return index of the segment that contains t
+         */
+        size_t find(double t, size_t hint) const;
+
+        size_t _dimension;
+        size_t _stride;
+        size_t _capacity;
+        size_t _first;
+        size_t _count;
+        // segments dropped since construction
+        size_t _dropped;
+
+        // slot: t0, h, r1, ..., r5
+        std::vector<double> _data;
+    };
+
+}
+
+#endif	/* DELAYHISTORY_H */
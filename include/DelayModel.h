@@ -0,0 +1,89 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef DELAYMODEL_H
+#define	DELAYMODEL_H
+
+#include <stdexcept>
+
+#include "Types.h"
+#include "Model.h"
+
+namespace iNumerics {
+
+    /**
+     * Delay differential equation
+     *
+     *     y'(t) = f(t, y(t), y(t - tau_1), ..., y(t - tau_d))
+     *
+     * with constant or state-dependent delays tau_k(t, y(t)) >= 0, solved
+     * by ODESolver::solve_delay().
+     */
+    class DelayModel : public Model {
+    public:
+
+        virtual size_t getDelayCount() const = 0;
+
+        /**
+         * Delay tau_k at (y, t); constant delays ignore y and t.
+         */
+        virtual double getDelay(size_t k, const DVec &y, const double t) = 0;
+
+        /**
+         * Upper bound of all delays. The solver discards the history older
+         * than t - getMaxDelay().
+         */
+        virtual double getMaxDelay() const = 0;
+
+        /**
+         * @param y		y(t)
+         * @param delayed	column-major n x d, column k holds y(t - tau_k)
+         */
+        virtual void rhs(const DVec &y, const DVec &delayed, DVec &dydt, const double t) = 0;
+
+        /**
+         * Initial history y(t) for t < t0.
+         * @return false to use the initial value of the problem (default)
+         */
+        virtual bool history(double t, DVec &y) {
+            return false;
+        }
+
+        /**
+         * Not available without the delayed values; use
+         * ODESolver::solve_delay().
+         */
+        virtual void rhs(const DVec &y, DVec &dydt, const double t) {
+            throw std::logic_error("DelayModel: the delayed rhs requires ODESolver::solve_delay()");
+        }
+    };
+
+}
+
+#endif	/* DELAYMODEL_H */
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef DENSELU_H
+#define	DENSELU_H
+
+#include <vector>
+
+#include "Types.h"
+#include "intypes.h"
+#include "SolveStats.h"
+
+namespace iNumerics {
+
+    /**
+     * LU factorization with partial pivoting (LAPACK dgetrf/dgetrs) of a
+     * dense n x n matrix stored column-major in a DVec. One factorization
+     * serves any number of right hand sides.
+     *
+     * If stats are given, factorizations and solved right hand sides are
+     * counted in luDecompositions and luSolves.
+     */
+    class DenseLU {
+    public:
+        DenseLU(SolveStats* stats = NULL);
+
+        /**
+         * Factors A; the factors are kept in an internal buffer.
+         * @param A	column-major n x n matrix
+         * @return false if A is singular
+         */
+        bool factor(const DVec& A, size_t n);
+
+        /**
+         * Solves A x = b in place for nrhs right hand sides stored one after
+         * the other.
+         */
+        void solve(double* b, size_t nrhs = 1) const;
+
+        void solve(DVec& b) const;
+
+        size_t size() const;
+
+    private:
+        SolveStats* _stats;
+        size_t _n;
+        DVec _lu;
+        std::vector<inInt> _pivots;
+    };
+
+}
+
+#endif	/* DENSELU_H */
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef EVENT_H
+#define	EVENT_H
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Zero crossing of a condition g(x, t), e.g. a contact or a threshold.
+     *
+     * ODESolver evaluates the condition after every accepted step. If its
+     * sign changes in the requested direction, the crossing time is located
+     * on a cubic Hermite interpolant of the step (no additional steps), the
+     * interpolated state at that time is recorded like a regular step and
+     * occurred() is called. A state reset done by occurred() restarts the
+     * integration at the event; a terminal event ends the solve there.
+     *
+     * After a restart the event that reset the state takes its sign from
+     * just after the restart point, where g is 0 up to rounding, so it
+     * triggers again only at its next crossing. The first step after a
+     * restart is no larger than the step that led to it.
+     */
+    class Event {
+    public:
+
+        enum Direction {
+            /** g changes from < 0 to >= 0 */
+            RISING = 1,
+            /** g changes from > 0 to <= 0 */
+            FALLING = -1,
+            /** either */
+            BOTH = 0
+        };
+
+        /**
+         * @param direction	crossings to report
+         * @param terminal	stop the solve at the first crossing
+         */
+        Event(Direction direction = BOTH, bool terminal = false)
+        : _direction(direction), _terminal(terminal) {
+        }
+
+        virtual ~Event() {
+        }
+
+        virtual double condition(const DVec& x, double t) = 0;
+
+        /**
+         * Called at a located crossing.
+         * @param x	state at the crossing, may be modified (state reset)
+         * @return true if x was modified; the integration then restarts
+         *         from the modified state
+         */
+        virtual bool occurred(DVec& x, double t) {
+            return false;
+        }
+
+        Direction getDirection() const {
+            return _direction;
+        }
+
+        bool isTerminal() const {
+            return _terminal;
+        }
+
+    private:
+        Direction _direction;
+        bool _terminal;
+    };
+
+}
+
+#endif	/* EVENT_H */
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef EXPORTPIPELINE_H
+#define	EXPORTPIPELINE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Configuration of an ExportPipeline.
+     */
+    class ExportOptions {
+    public:
+        ExportOptions();
+
+        /**
+         * Directory of the files, or path prefix of the container shards
+         * (path.000, path.001, ...) and of its index (path.index).
+         */
+        std::string path;
+
+        /** one sharded container instead of one file per trajectory */
+        bool container;
+
+        /** encoding threads (Range: > 0) */
+        size_t workers;
+
+        /** I/O threads, always 1 for a container (Range: > 0) */
+        size_t ioThreads;
+
+        /** capacity of the submit queue and of the encoded queue */
+        size_t queueCapacity;
+
+        /** container: encoded trajectories are gathered into one pwritev() up to this size */
+        size_t batchBytes;
+
+        /** container: a new shard is started when a shard would exceed this size */
+        size_t shardBytes;
+    };
+
+    /**
+     * Throughput and backpressure counters of an ExportPipeline.
+     */
+    class ExportStats {
+    public:
+        ExportStats();
+
+        double getBytesPerSecond() const;
+        double getTrajectoriesPerMinute() const;
+
+        void writeJSON(std::ostream& os) const;
+
+        size_t trajectories;
+        size_t bytes;
+        /** write calls (files: one per trajectory, container: one per batch) */
+        size_t writes;
+
+        /** submit() calls that had to wait for a full queue, and their wait time */
+        size_t submitWaits;
+        double submitWaitTime;
+
+        /** encoder waits on a full encoded queue, i.e. the I/O is the bottleneck */
+        size_t encodedWaits;
+        double encodedWaitTime;
+
+        size_t maxSubmitDepth;
+        size_t maxEncodedDepth;
+
+        /** seconds summed over the encoding / I/O threads */
+        double encodeTime;
+        double writeTime;
+
+        /** seconds from construction to the end of finish() (or now) */
+        double wallTime;
+    };
+
+    /**
+     * Writes trajectories of ensemble members in the background.
+     *
+     *   submit() -> [bounded queue] -> encoding workers -> [bounded queue] -> I/O threads
+     *
+     * Trajectories are encoded in the StreamingTrajectory file format. In
+     * file mode every trajectory is written to path/name.traj with a single
+     * pwrite(). In container mode one I/O thread appends encoded
+     * trajectories to the current shard, gathering as many as fit into
+     * batchBytes into one pwritev(). The index lists name, shard, offset and
+     * length of every trajectory:
+     *
+     *   char magic[8] = "INEXPIDX", then per trajectory: uint32 nameLength,
+     *   char name[nameLength], uint32 shard, uint64 offset, uint64 length
+     *
+     * submit() blocks while the submit queue is full, so a fast producer is
+     * throttled to the speed of the disk.
+     */
+    class ExportPipeline {
+    public:
+        explicit ExportPipeline(const ExportOptions& options);
+
+        /**
+         * Calls finish() if necessary; errors are printed to std::cerr.
+         */
+        ~ExportPipeline();
+
+        /**
+         * Queues a trajectory for export. The trajectory must not be
+         * modified until finish() returns. Throws std::invalid_argument if
+         * name is empty, "." or "..", or contains '/' or '\0', i.e. if it
+         * would not name a file directly below path.
+         */
+        void submit(const std::string& name, std::shared_ptr<const Trajectory> trajectory);
+
+        /**
+         * Writes everything that has been submitted, stops the threads and
+         * writes the container index. Throws std::runtime_error if a write
+         * failed.
+         */
+        ExportStats finish();
+
+        /**
+         * @return counters so far
+         */
+        ExportStats getStats() const;
+
+    private:
+        ExportPipeline(const ExportPipeline&);
+        ExportPipeline& operator=(const ExportPipeline&);
+
+        struct Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
+}
+
+#endif	/* EXPORTPIPELINE_H */
@@ -22,6 +22,29 @@ namespace iNumerics {
 
         const double operator()(double t) const;
 
+        /**
+         * Linear interpolation between (t0, x0) and (t1, x1).
+         */
+        static double linear(double t0, double x0, double t1, double x1, double t) {
+            const double delta = (t - t0) / (t1 - t0);
+            return delta * x1 + (1 - delta) * x0;
+        }
+
+        /**
+         * Cubic Hermite interpolation between (t0, x0) and (t1, x1) with
+         * the derivatives f0 and f1 at the end points.
+         */
+        static double hermite(double t0, double x0, double f0,
+                double t1, double x1, double f1, double t) {
+            const double h = t1 - t0;
+            const double s = (t - t0) / h;
+            const double s2 = s * s;
+            const double s3 = s2 * s;
+
+            return (2 * s3 - 3 * s2 + 1) * x0 + (s3 - 2 * s2 + s) * h * f0
+                    + (-2 * s3 + 3 * s2) * x1 + (s3 - s2) * h * f1;
+        }
+
     private:
 
         std::map<double,double> _data;
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef JACOBIANSTRUCTURE_H
+#define	JACOBIANSTRUCTURE_H
+
+#include <vector>
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Sparsity structure of an n x n Jacobian and the storage of its
+     * nonzeros (see Model::getJacobianStructure()):
+     *
+     *  - dense: column-major, J(i, j) at j * n + i
+     *  - banded with lower and upper bandwidth kl and ku: one column of
+     *    kl + ku + 1 entries after the other, J(i, j) at
+     *    j * (kl + ku + 1) + ku + i - j (LAPACK band storage)
+     *  - block-diagonal with square blocks of size b: one column-major block
+     *    after the other
+     *  - sparse: compressed rows, the entries of row i are at
+     *    rowPointers[i], ..., rowPointers[i + 1] - 1 with the columns
+     *    columnIndices[k] (ascending); the diagonal must be included
+     *
+     * index() maps (i, j) to the storage position for all of them. The
+     * dimension is bound with setDimension() by the solver.
+     */
+    class JacobianStructure {
+    public:
+
+        enum Type {
+            DENSE,
+            BANDED,
+            BLOCK_DIAGONAL,
+            SPARSE
+        };
+
+        /** index() of entries outside the structure */
+        static const size_t npos = (size_t) - 1;
+
+        /**
+         * Dense structure.
+         */
+        JacobianStructure();
+
+        static JacobianStructure banded(size_t lower, size_t upper);
+
+        static JacobianStructure blockDiagonal(size_t blockSize);
+
+        static JacobianStructure sparse(const std::vector<size_t>& rowPointers,
+                const std::vector<size_t>& columnIndices);
+
+        Type getType() const;
+
+        size_t getLowerBandwidth() const;
+        size_t getUpperBandwidth() const;
+        size_t getBlockSize() const;
+        const std::vector<size_t>& getRowPointers() const;
+        const std::vector<size_t>& getColumnIndices() const;
+
+        /**
+         * Binds the structure to n x n matrices and checks it
+         * (std::invalid_argument): the block size must divide n, the row
+         * pointers of a sparse structure must have n + 1 entries, columns
+         * must be ascending and below n and the diagonal must be present.
+         */
+        void setDimension(size_t n);
+
+        size_t getDimension() const;
+
+        /**
+         * Number of stored values.
+         */
+        size_t getValueCount() const;
+
+        /**
+         * Storage position of J(i, j) or npos if the entry is not part of
+         * the structure.
+         */
+        size_t index(size_t i, size_t j) const;
+
+        /**
+         * Storage positions of the diagonal.
+         */
+        const std::vector<size_t>& getDiagonal() const;
+
+        /**
+         * Groups of structurally orthogonal columns (no row in common):
+         * group[j] of column j. A Jacobian by finite differences needs one
+         * rhs call per group.
+         * @return number of groups
+         */
+        size_t getColumnGroups(std::vector<size_t>& group) const;
+
+        /**
+         * Column view of the structure (not for dense): the entries of
+         * column j are k = columnPointers[j], ..., columnPointers[j + 1] - 1
+         * in row columnRows[k], stored at columnPositions[k].
+         */
+        const std::vector<size_t>& getColumnPointers() const;
+        const std::vector<size_t>& getColumnRows() const;
+        const std::vector<size_t>& getColumnPositions() const;
+
+    private:
+        Type _type;
+        size_t _n;
+        size_t _lower;
+        size_t _upper;
+        size_t _blockSize;
+        std::vector<size_t> _rowPointers;
+        std::vector<size_t> _columnIndices;
+
+        std::vector<size_t> _diagonal;
+        std::vector<size_t> _columnPointers;
+        std::vector<size_t> _columnRows;
+        std::vector<size_t> _columnPositions;
+    };
+
+}
+
+#endif	/* JACOBIANSTRUCTURE_H */
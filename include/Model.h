@@ -8,6 +8,8 @@
 #ifndef MODEL_H
 #define	MODEL_H
 
+#include "JacobianStructure.h"
+
 namespace iNumerics {
 
     class Model {
@@ -15,6 +17,135 @@ namespace iNumerics {
         
         virtual void rhs(const DVec &y, DVec &dydt, const double t) = 0;
         virtual void step(const DVec &x, double t) = 0;
+
+        /**
+         * Whether the system has a mass matrix (massMatrix() or
+         * massMatrixValues()). Models with one must return true; the
+         * solvers neither allocate nor read a mass matrix otherwise.
+         */
+        virtual bool hasMassMatrix() const {
+            return false;
+        }
+
+        /**
+         * Constant mass matrix M of the system M y' = f(y, t), where f is
+         * rhs(), column-major like jacobian(). M has size n * n and is zero
+         * on entry. Only called if hasMassMatrix() is true. For
+         * semi-explicit DAEs the rows of zeros mark the algebraic equations
+         * and the columns of zeros the algebraic variables; only
+         * ODESolver::solve_implicit() accepts a mass matrix.
+         * @return false for M = I (ordinary differential equations)
+         */
+        virtual bool massMatrix(DVec &M) {
+            return false;
+        }
+
+        /**
+         * Jacobian df/dy at (y, t), column-major: J[j * n + i] = df_i/dy_j.
+         * J has size n * n on entry.
+         * @return false if not implemented; the solvers then use finite
+         *         differences of rhs()
+         */
+        virtual bool jacobian(const DVec &y, DVec &J, const double t) {
+            return false;
+        }
+
+        /**
+         * Sparsity structure of df/dy. ODESolver::solve_implicit()
+         * assembles and factors its iteration matrix in this structure.
+         * Dense by default.
+         */
+        virtual JacobianStructure getJacobianStructure() {
+            return JacobianStructure();
+        }
+
+        /**
+         * Nonzeros of df/dy at (y, t) for a structure other than dense, in
+         * the storage of getJacobianStructure() (see
+         * JacobianStructure::index()). values has size
+         * JacobianStructure::getValueCount() and is zero on entry.
+         * @return false if not implemented; the solvers then use finite
+         *         differences of rhs() with one call per group of columns
+         *         without a common row
+         */
+        virtual bool jacobianValues(const DVec &y, DVec &values, const double t) {
+            return false;
+        }
+
+        /**
+         * Mass matrix (see massMatrix()) for a structure other than dense,
+         * in the storage of getJacobianStructure(); massMatrix() is not
+         * called for such models. values is zero on entry. Only called if
+         * hasMassMatrix() is true.
+         * @return false for M = I
+         */
+        virtual bool massMatrixValues(DVec &values) {
+            return false;
+        }
+
+        /**
+         * Split f = f_E + f_I of rhs() for ODESolver::solve_imex(): the
+         * non-stiff part f_E is integrated explicitly, only the stiff part
+         * f_I implicitly. A split model implements both.
+         * @return false if the model is not split
+         */
+        virtual bool rhs_explicit(const DVec &y, DVec &dydt, const double t) {
+            return false;
+        }
+
+        /**
+         * The stiff part f_I of the split, see rhs_explicit(). Its
+         * Jacobian is always computed by finite differences.
+         */
+        virtual bool rhs_implicit(const DVec &y, DVec &dydt, const double t) {
+            return false;
+        }
+
+        /**
+         * Sparsity structure of df_I/dy, see rhs_implicit(). Defaults to
+         * getJacobianStructure(); a local (e.g. reaction) part is usually
+         * block-diagonal.
+         */
+        virtual JacobianStructure getImplicitJacobianStructure() {
+            return getJacobianStructure();
+        }
+
+        /**
+         * Number of parameters that forward sensitivities can be computed
+         * for. Parameters are read and changed with get/setParameter().
+         */
+        virtual size_t getParameterCount() const {
+            return 0;
+        }
+
+        virtual double getParameter(size_t k) const {
+            return 0;
+        }
+
+        virtual void setParameter(size_t k, double value) {
+        }
+
+        /**
+         * df/dp at (y, t) for all parameters, column-major:
+         * dfdp[k * n + i] = df_i/dp_k. dfdp has size n * getParameterCount()
+         * on entry.
+         * @return false if not implemented; the solvers then use finite
+         *         differences of rhs() with perturbed parameters
+         */
+        virtual bool parameterJacobian(const DVec &y, DVec &dfdp, const double t) {
+            return false;
+        }
+
+        /**
+         * Vector-Jacobian products w^T df/dy and w^T df/dp at (y, t), used
+         * by the adjoint solver. wJy has size n and wJp size
+         * getParameterCount() on entry.
+         * @return false if not implemented; the solver then uses
+         *         jacobian() and parameterJacobian() or finite differences
+         */
+        virtual bool vectorJacobian(const DVec &y, const DVec &w, DVec &wJy, DVec &wJp, const double t) {
+            return false;
+        }
         
         
         virtual ~Model() {
@@ -32,6 +32,9 @@
 #include "Types.h"
 #include "Trajectory.h"
 #include "Problem.h"
+#include "SolveStats.h"
+#include "Checkpoint.h"
+#include "Adjoint.h"
 
 namespace iNumerics {
 
@@ -44,11 +47,179 @@ namespace iNumerics {
         //        ODESolver(const ODESolver& orig);
         virtual ~ODESolver();
 
-        void solve(Problem& problem, Trajectory& trajectory);
-        
-        void solve_implicit(Problem& problem, Trajectory& trajectory);
+        /**
+         * Solves the problem with the explicit Dormand-Prince 5(4) method.
+         * This is the only mode that writes the checkpoints of
+         * Problem::setCheckpointing(); see resume().
+         */
+        SolveStats solve(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Solves a stiff problem with the linearly implicit Rosenbrock-W
+         * method ROS34PW2 (order 3). The Jacobian comes from
+         * Model::jacobian() or finite differences and is factored (LAPACK)
+         * once per step attempt. Events are supported, checkpoints are not
+         * (std::logic_error).
+         *
+         * Models that declare a banded, block-diagonal or sparse Jacobian
+         * (Model::getJacobianStructure()) get the iteration matrix assembled
+         * and factored in that structure (banded LU, LU per block, sparse
+         * LU with a minimum degree ordering), with the values from
+         * Model::jacobianValues() or grouped finite differences, so memory
+         * and work per step follow the nonzeros instead of n^2 and n^3.
+         *
+         * Models with a mass matrix (Model::hasMassMatrix()) are solved as
+         * M y' = f, with M kept in the structure of the Jacobian
+         * (Model::massMatrix() or massMatrixValues()). This covers
+         * semi-explicit index-1 DAEs: the algebraic
+         * equations are solved together with the differential ones in
+         * every stage. The algebraic variables of the initial value are
+         * first made consistent by Newton's method. Events are not
+         * supported with a mass matrix (std::logic_error).
+         */
+        SolveStats solve_implicit(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Stiff solver for large systems whose Jacobian is too big or too
+         * expensive to form: TR-BDF2 (L-stable, order 2) with the stage
+         * equations solved by an inexact Newton method and restarted
+         * GMRES. Jacobian-vector products are differences of the rhs, so
+         * no matrix is stored and memory is linear in the dimension.
+         * Problem::setPreconditioner() supplies an approximate inverse of
+         * I - gamma J, which usually decides how many GMRES iterations are
+         * needed (SolveStats::linearIterations). Mass matrices and
+         * checkpoints are not supported (std::logic_error).
+         */
+        SolveStats solve_krylov(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Stiff solver for long runs: variable-order (1 to 5),
+         * variable-step BDF with a simplified Newton corrector, in the
+         * quasi-constant step size form of ode15s. The Jacobian (in the
+         * structure of Model::getJacobianStructure(), like
+         * solve_implicit()) and the LU factors of the iteration matrix are
+         * reused as long as the step size, the order and the Newton
+         * convergence allow, so far fewer factorizations are needed than
+         * with the Rosenbrock method of solve_implicit(), which factors
+         * once per step. Mass matrices and checkpoints are not supported
+         * (std::logic_error).
+         */
+        SolveStats solve_bdf(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Solves a problem of unknown or changing stiffness without choosing
+         * a method: it starts with the explicit Dormand-Prince 5(4) method,
+         * detects stiffness from its stage data (an estimate of the
+         * dominant eigenvalue times the step size) and switches to the
+         * Rosenbrock-W method of solve_implicit() while the step size is
+         * limited by stability, and back once the explicit method would be
+         * stable at the steps the stiff one takes (after LSODA).
+         * Non-stiff problems never form a Jacobian. SolveStats::stiffSteps
+         * and methodSwitches record the choice. Mass matrices and
+         * checkpoints are not supported (std::logic_error).
+         */
+        SolveStats solve_auto(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Solves a split model (Model::rhs_explicit(), rhs_implicit();
+         * std::invalid_argument otherwise) with the additive (IMEX)
+         * Runge-Kutta pair ARK3(2)4L[2]SA of Kennedy & Carpenter (order 3):
+         * the non-stiff part is evaluated explicitly, four times per step,
+         * and only the stiff part is solved implicitly, with one LU
+         * factorization of its iteration matrix per step shared by the
+         * three implicit stages. Its Jacobian is differenced in
+         * Model::getImplicitJacobianStructure() and reused across steps.
+         * The step size is limited by the stability of the explicit part.
+         * Mass matrices and checkpoints are not supported
+         * (std::logic_error).
+         */
+        SolveStats solve_imex(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Solves the problem together with the forward sensitivities
+         * s_k = dy/dp_k of the parameters selected by
+         * Problem::setSensitivity(). sensitivities receives one step per
+         * step of trajectory with the column-major n x p matrix
+         * (s_1, ..., s_p).
+         *
+         * The sensitivity equations s_k' = J s_k + df/dp_k are integrated
+         * with the same steps as the state. Every rhs evaluation computes
+         * J once, in the storage of Model::getJacobianStructure(), and
+         * applies it to all columns: from Model::jacobian() or
+         * jacobianValues() at no extra rhs calls, or with
+         * Model::parameterJacobian() by differences per column group if
+         * that takes fewer rhs calls than there are columns. Otherwise
+         * J s_k + df/dp_k is one directional difference of the rhs per
+         * column.
+         * Unless requested by Problem::setSensitivity(), the step size is
+         * controlled by the state error only. Events and checkpoints are
+         * not supported (std::logic_error).
+         */
+        SolveStats solve(Problem& problem, Trajectory& trajectory, Trajectory& sensitivities);
+
+        /**
+         * Stiff variant of solve() with sensitivities: the Rosenbrock-W
+         * method of solve_implicit(), where every stage solves the state
+         * and all sensitivity columns with the same LU factors. Events and
+         * checkpoints are not supported (std::logic_error).
+         */
+        SolveStats solve_implicit(Problem& problem, Trajectory& trajectory, Trajectory& sensitivities);
+
+        /**
+         * Solves the problem and computes the gradient of the objective
+         * G = g(y(tn)) with respect to all Model parameters and the initial
+         * state by the continuous adjoint method.
+         *
+         * The forward pass is the explicit solve() and records the step
+         * times. The backward pass integrates the adjoint system
+         * lambda' = -J^T lambda, mu' = -(df/dp)^T lambda from
+         * (dg/dy, 0) at tn to t0 step by step, with y from the quintic
+         * Hermite interpolant through the ends and the midpoint of the
+         * forward step. Forward steps are
+         * recomputed from at most Problem::setAdjointSnapshots() stored
+         * states on a binomial (revolve) schedule, so memory does not grow
+         * with the number of steps apart from the step times. The products
+         * come from Model::vectorJacobian() if implemented, otherwise from
+         * the Jacobians or finite differences. Events and checkpoints are
+         * not supported (std::logic_error).
+         *
+         * The returned counters cover both passes.
+         */
+        SolveStats solve_adjoint(Problem& problem, Trajectory& trajectory,
+                Objective& objective, AdjointResult& result);
+
+        /**
+         * Solves a delay differential equation; problem must wrap a
+         * DelayModel (std::invalid_argument otherwise).
+         *
+         * Dormand-Prince 5(4) whose steps are kept as dense output segments
+         * in a DelayHistory, so y(t - tau) is a lookup in the last
+         * getMaxDelay() of the solution. Before t0 the solution is
+         * DelayModel::history(). Steps do not exceed the smallest current
+         * delay, and the derivative discontinuities that t0 propagates
+         * through the delays (up to order 5) are located and stepped onto,
+         * for state-dependent delays by root finding on the dense output.
+         * Events, mass matrices and checkpoints are not supported
+         * (std::logic_error).
+         */
+        SolveStats solve_delay(Problem& problem, Trajectory& trajectory);
+
+        /**
+         * Continues a solve of problem from a checkpoint written during
+         * solve(). The remaining steps are bit-identical to the ones of the
+         * interrupted solve if the problem is set up the same way.
+         * Steps up to the checkpoint are not recorded again, i.e. trajectory
+         * should hold the first checkpoint.trajectorySize steps (or nothing).
+         * The returned counters include the steps before the checkpoint.
+         */
+        SolveStats resume(Problem& problem, Trajectory& trajectory, const Checkpoint& checkpoint);
 
     private:
+        SolveStats integrate(Problem& problem, Trajectory& trajectory,
+                const Checkpoint& start, bool recordStart);
+
+        SolveStats integrateSensitivity(Problem& problem, Trajectory& trajectory,
+                Trajectory& sensitivities, bool implicit);
 
     };
 
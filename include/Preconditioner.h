@@ -0,0 +1,72 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef PRECONDITIONER_H
+#define	PRECONDITIONER_H
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Preconditioner for the Newton systems (I - gamma J) x = r of
+     * ODESolver::solve_krylov(), J = df/dy.
+     *
+     * GMRES is right-preconditioned, so solve() only needs to approximate
+     * the inverse; the accuracy of the Newton steps does not depend on it,
+     * only the number of Krylov iterations. Typical choices are the inverse
+     * of the stiff local (reaction) part or a few sweeps of an iterative
+     * method on the transport part.
+     */
+    class Preconditioner {
+    public:
+
+        virtual ~Preconditioner() {
+        }
+
+        /**
+         * Called once per step attempt before the stage solves.
+         * @param y	state at the start of the step
+         * @param f	f(y, t)
+         * @param gamma	the factor of J in the Newton matrix
+         * @return false if the preconditioner cannot be set up; the step
+         *         is then retried with half the step size
+         */
+        virtual bool setup(const DVec& y, const DVec& f, double t, double gamma) = 0;
+
+        /**
+         * z approximately solves (I - gamma J) z = r; z has the size of r
+         * on entry.
+         */
+        virtual void solve(const DVec& r, DVec& z) = 0;
+    };
+
+}
+
+#endif	/* PRECONDITIONER_H */
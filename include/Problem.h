@@ -30,9 +30,14 @@
 #define	PROBLEM_H
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "Types.h"
 #include "Model.h"
+#include "Event.h"
+#include "Preconditioner.h"
+#include "inprofiler.h"
 
 
 
@@ -58,7 +63,12 @@ namespace iNumerics {
         virtual ~Problem();
 
         virtual void operator() (const DVec &y, DVec &dydt, const double t) {
-            _model.rhs(y, dydt, t);
+            if (_profiling) {
+                ScopedTimer timer(_rhsRegion);
+                _model.rhs(y, dydt, t);
+            } else {
+                _model.rhs(y, dydt, t);
+            }
         };
 
         Problem& setInitialValue(DVec init);
@@ -67,6 +77,61 @@ namespace iNumerics {
 
         Problem& setPrecision(double absError, double relError, double h = 0.1);
 
+        /**
+         * Times every Model::rhs() call in the Profiler region "rhs".
+         */
+        Problem& setProfiling(bool profiling);
+
+        /**
+         * Writes a Checkpoint to path every interval seconds (wall time)
+         * while the problem is solved with ODESolver::solve(); the other
+         * solve modes reject a checkpoint path (std::logic_error). An empty
+         * path disables checkpoints. See ODESolver::resume().
+         */
+        Problem& setCheckpointing(const std::string& path, double interval);
+
+        /**
+         * Adds an event that is checked after every accepted step. The event
+         * is not copied and must outlive the solve.
+         */
+        Problem& addEvent(Event& event);
+
+        /**
+         * Selects the Model parameters for forward sensitivities (see
+         * ODESolver::solve(Problem&, Trajectory&, Trajectory&)). An empty
+         * list selects all parameters.
+         * @param errorControl	include the sensitivities in the step size
+         *			control; otherwise only the state is controlled
+         */
+        Problem& setSensitivity(const std::vector<size_t>& parameters, bool errorControl = false);
+
+        /**
+         * Initial sensitivities dy(t0)/dp, column-major n x p (one column
+         * per selected parameter). Zero if not set.
+         */
+        Problem& setInitialSensitivity(const DVec& s0);
+
+        /**
+         * Whether the algebraic variables of a DAE (zero columns of
+         * Model::massMatrix()) take part in the error test of
+         * ODESolver::solve_implicit() (default true). Their accuracy
+         * follows from the differential variables for index-1 problems,
+         * so leaving them out usually allows larger steps.
+         */
+        Problem& setAlgebraicErrorControl(bool control);
+
+        /**
+         * Number of states ODESolver::solve_adjoint() may keep as snapshots
+         * for the backward pass (Range: > 0, default 16).
+         */
+        Problem& setAdjointSnapshots(size_t snapshots);
+
+        /**
+         * Preconditioner of ODESolver::solve_krylov() (NULL: none). It is
+         * not copied and must outlive the solve.
+         */
+        Problem& setPreconditioner(Preconditioner* preconditioner);
+
         void step(const DVec &x, double t);
 
         DVec getCurrentSolution() {
@@ -93,6 +158,24 @@ namespace iNumerics {
         DVec _currentSolution;
         double _currentT;
 
+        bool _profiling;
+        inULong _rhsRegion;
+
+        std::string _checkpointPath;
+        double _checkpointInterval;
+
+        std::vector<Event*> _events;
+
+        std::vector<size_t> _sensitivityParameters;
+        bool _sensitivityErrorControl;
+        DVec _initialSensitivity;
+
+        size_t _adjointSnapshots;
+
+        bool _algebraicErrorControl;
+
+        Preconditioner* _preconditioner;
+
     };
 
 }
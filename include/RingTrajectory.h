@@ -0,0 +1,127 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef RINGTRAJECTORY_H
+#define	RINGTRAJECTORY_H
+
+#include <atomic>
+#include <memory>
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Trajectory that keeps only the most recent capacity steps.
+     *
+     * One producer (the solver) appends while any number of consumer
+     * threads read. Every slot is guarded by a sequence lock: the producer
+     * never waits, readers retry a slot that is written concurrently and
+     * skip steps that were overwritten. No memory is allocated after
+     * construction on the producer side.
+     *
+     * Index 0 of the accessors is the oldest step retained at the time of
+     * the call, so indices shift while the producer appends; use
+     * snapshot() to get a consistent copy of the recent window. getState()
+     * returns a reference to a buffer of this trajectory that is valid
+     * until its next getState() call, i.e. concurrent consumers use
+     * snapshot() or getTime() only.
+     */
+    class RingTrajectory : public Trajectory {
+    public:
+        /**
+         * @param capacity	number of steps kept (Range: > 0)
+         * @param dimension	state dimension
+         */
+        RingTrajectory(size_t capacity, size_t dimension);
+        virtual ~RingTrajectory();
+
+        /**
+         * Producer only. Throws std::invalid_argument if x does not have
+         * the dimension given at construction.
+         */
+        virtual void operator()(const DVec& x, const double t);
+
+        virtual double getTime(std::size_t i) const;
+        virtual const DVec& getState(std::size_t i) const;
+        virtual size_t size() const;
+
+        /**
+         * Min/max are computed over the retained steps.
+         */
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        /**
+         * Copies the retained steps with t >= getMaxTime() - window, oldest
+         * first. Allocates only if the output vectors have to grow.
+         * @return number of steps copied
+         */
+        size_t snapshot(std::vector<double>& times, std::vector<DVec>& states,
+                double window = -1) const;
+
+        size_t getCapacity() const;
+        size_t getDimension() const;
+
+        /**
+         * @return number of steps appended since construction
+         */
+        size_t getTotalCount() const;
+
+    private:
+        RingTrajectory(const RingTrajectory&);
+        RingTrajectory& operator=(const RingTrajectory&);
+
+        /**
+         * Reads step number index (counted since construction).
+         * @return false if the step has been overwritten
+         */
+        bool read(size_t index, double& t, DVec* x) const;
+
+        size_t first() const;
+
+        size_t _capacity;
+        size_t _dimension;
+
+        // slot s holds t followed by the state at _data[s * (dimension + 1)]
+        std::unique_ptr<double[]> _data;
+        std::unique_ptr<std::atomic<size_t>[] > _sequence;
+        std::atomic<size_t> _head;
+
+        // returned by getState()
+        mutable DVec _state;
+    };
+
+}
+
+#endif	/* RINGTRAJECTORY_H */
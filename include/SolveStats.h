@@ -0,0 +1,131 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef SOLVESTATS_H
+#define	SOLVESTATS_H
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+
+#include "inperfcounters.h"
+
+namespace iNumerics {
+
+    /**
+     * Counters of a single solve. Returned by every ODESolver solve mode.
+     */
+    class SolveStats {
+    public:
+        SolveStats();
+
+        /**
+         * Records an accepted step of size h.
+         */
+        void recordStep(double h);
+
+        /**
+         * @return mean size of the accepted steps
+         */
+        double getMeanStep() const;
+
+        void writeJSON(std::ostream& os) const;
+
+        size_t acceptedSteps;
+        size_t rejectedSteps;
+        size_t rhsCalls;
+        size_t jacobianCalls;
+        size_t luDecompositions;
+        size_t luSolves;
+        /** Newton iterations of solve_krylov() and solve_bdf() */
+        size_t newtonIterations;
+        /** Krylov (GMRES) iterations, one Jacobian-vector product each */
+        size_t linearIterations;
+        /** accepted steps taken by the stiff method of solve_auto() */
+        size_t stiffSteps;
+        /** switches between the explicit and the stiff method of solve_auto() */
+        size_t methodSwitches;
+        /** located event crossings */
+        size_t events;
+
+        double minStep;
+        double maxStep;
+        double stepSum;
+
+        /** seconds spent in the observer (trajectory and Model::step) */
+        double observerTime;
+        /** seconds from start to end of the solve */
+        double wallTime;
+
+        /**
+         * Hardware counters per region, indexed by PerfRegion. Only filled
+         * if the library is built with INUMERICS_PERF_COUNTERS.
+         */
+        PerfCounts perf[PERF_REGIONS];
+    };
+
+    /**
+     * Collects the SolveStats of the members of an ensemble. add() may be
+     * called concurrently from the threads that run the members.
+     */
+    class EnsembleStats {
+    public:
+        EnsembleStats();
+
+        void add(const SolveStats& stats);
+
+        size_t size() const;
+
+        SolveStats get(size_t i) const;
+
+        /**
+         * Sums counters and times over all members; the step size range
+         * spans all members.
+         */
+        SolveStats getTotal() const;
+
+        /**
+         * Writes every member and min/mean/max/sum of each counter.
+         */
+        void writeJSON(std::ostream& os) const;
+
+        /**
+         * Writes one row per member followed by the rows "min", "mean",
+         * "max" and "sum".
+         */
+        void writeCSV(std::ostream& os) const;
+
+    private:
+        mutable std::mutex _mutex;
+        std::vector<SolveStats> _members;
+    };
+
+}
+
+#endif	/* SOLVESTATS_H */
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef SPARSELU_H
+#define	SPARSELU_H
+
+#include <vector>
+
+#include "Types.h"
+#include "SolveStats.h"
+
+namespace iNumerics {
+
+    /**
+     * Sparse LU factorization P A Q = L U of an n x n matrix in compressed
+     * rows (see JacobianStructure).
+     *
+     * analyze() orders the columns by minimum degree on the pattern of
+     * A + A^T to reduce fill. factor() is left-looking (Gilbert-Peierls)
+     * with threshold partial pivoting that keeps the diagonal of the
+     * ordered matrix where it is not too small, so the work is
+     * proportional to the flops on the nonzeros of the factors.
+     *
+     * If stats are given, factorizations and solved right hand sides are
+     * counted in luDecompositions and luSolves.
+     */
+    class SparseLU {
+    public:
+        SparseLU(SolveStats* stats = NULL);
+
+        /**
+         * Computes the column ordering for the pattern. Must be called
+         * before factor() and again whenever the pattern changes.
+         */
+        void analyze(size_t n, const std::vector<size_t>& rowPointers,
+                const std::vector<size_t>& columnIndices);
+
+        /**
+         * Factors the matrix with the analyzed pattern.
+         * @param values	nonzeros in the order of the column indices
+         * @return false if the matrix is singular
+         */
+        bool factor(const DVec& values);
+
+        /**
+         * Solves A x = b in place for nrhs right hand sides stored one after
+         * the other.
+         */
+        void solve(double* b, size_t nrhs = 1) const;
+
+        size_t size() const;
+
+        /**
+         * Nonzeros of L and U of the last factorization (without the unit
+         * diagonal of L).
+         */
+        size_t getFactorNonzeros() const;
+
+    private:
+        void order(const std::vector<size_t>& rowPointers,
+                const std::vector<size_t>& columnIndices);
+
+        size_t reach(size_t column);
+
+        SolveStats* _stats;
+        size_t _n;
+
+        // A by columns: entries k of column j at _columnPointers[j], ...
+        // in row _rows[k] with the value values[_positions[k]]
+        std::vector<size_t> _columnPointers;
+        std::vector<size_t> _rows;
+        std::vector<size_t> _positions;
+
+        // column ordering
+        std::vector<size_t> _q;
+
+        // L by columns (rows of A, unit diagonal not stored), U by columns
+        // (rows are elimination steps, diagonal in _diagonal)
+        std::vector<size_t> _lPointers;
+        std::vector<size_t> _lRows;
+        DVec _lValues;
+        std::vector<size_t> _uPointers;
+        std::vector<size_t> _uRows;
+        DVec _uValues;
+        DVec _diagonal;
+
+        // _pivotRow[k] is the row of step k, _step[row] its inverse
+        std::vector<size_t> _pivotRow;
+        std::vector<size_t> _step;
+
+        // workspace
+        DVec _x;
+        std::vector<size_t> _reach;
+        std::vector<size_t> _stack;
+        std::vector<size_t> _next;
+        std::vector<size_t> _visited;
+        size_t _stamp;
+        mutable DVec _work;
+        mutable DVec _y;
+    };
+
+}
+
+#endif	/* SPARSELU_H */
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef STREAMINGTRAJECTORY_H
+#define	STREAMINGTRAJECTORY_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Trajectory that streams every step to a binary file instead of
+     * keeping it in memory.
+     *
+     * File layout (native byte order):
+     *
+     *   header:  char magic[8] = "INTRAJ\0\0", uint32 version = 1, uint32 dimension
+     *   records: double t, double x[dimension]   (repeated)
+     *
+     * Records are collected in one of two buffers; a full buffer is handed
+     * to a background thread that writes it while the solver fills the
+     * other one. The solver only waits if both buffers are full. Memory use
+     * is 2 * bufferSize records, independent of the run length.
+     *
+     * The accessors flush pending records and read them back from the file.
+     * getState() returns a reference to an internal buffer that is valid
+     * until the next call of getState().
+     *
+     * I/O errors are reported as std::runtime_error by the next call of
+     * operator(), flush() or an accessor.
+     */
+    class StreamingTrajectory : public Trajectory {
+    public:
+        /**
+         * @param path		file to write, truncated if it exists
+         * @param bufferSize	records per buffer (Range: > 0)
+         */
+        StreamingTrajectory(const std::string& path, size_t bufferSize = 4096);
+        virtual ~StreamingTrajectory();
+
+        virtual void operator()(const DVec& x, const double t);
+
+        /**
+         * Flushes, see flush().
+         */
+        virtual void finish();
+
+        virtual double getTime(std::size_t i) const;
+        virtual const DVec& getState(std::size_t i) const;
+        virtual size_t size() const;
+
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        /**
+         * Scans the window in the file, O(n) in the window size.
+         */
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        /**
+         * Blocks until all records are written to the file.
+         */
+        void flush() const;
+
+        const std::string& getPath() const;
+
+        /**
+         * Appends the file image of a trajectory (header and records) to out.
+         */
+        static void encode(const Trajectory& trajectory, std::vector<unsigned char>& out);
+
+        size_t getDimension() const;
+
+    private:
+        StreamingTrajectory(const StreamingTrajectory&);
+        StreamingTrajectory& operator=(const StreamingTrajectory&);
+
+        void writerLoop();
+        void handOff(std::unique_lock<std::mutex>& lock) const;
+        void checkError() const;
+        void readRecord(std::size_t i) const;
+
+        std::string _path;
+        int _fd;
+        size_t _bufferSize;
+        size_t _dimension;
+        size_t _size;
+
+        // the buffer the solver fills and the one owned by the writer
+        mutable std::vector<double> _active;
+        mutable std::vector<double> _pending;
+        mutable bool _hasPending;
+        size_t _written;
+        bool _stop;
+        std::string _error;
+        std::atomic<bool> _failed;
+
+        mutable std::mutex _mutex;
+        mutable std::condition_variable _wakeWriter;
+        mutable std::condition_variable _wakeSolver;
+        std::thread _writer;
+
+        double _minTime;
+        double _maxTime;
+        DVec _minState;
+        DVec _maxState;
+
+        // last record read back by an accessor
+        mutable size_t _cached;
+        mutable double _time;
+        mutable DVec _state;
+    };
+
+}
+
+#endif	/* STREAMINGTRAJECTORY_H */
@@ -34,27 +34,89 @@
 
 namespace iNumerics {
 
+    /**
+     * Min, max and mean of one state component over a time window.
+     */
+    struct StateSummary {
+        double min;
+        double max;
+        double mean;
+        /** number of steps in the window */
+        std::size_t count;
+    };
+
+    /**
+     * Stores every step in memory.
+     *
+     * Running extrema make the global min/max queries O(1). Steps are also
+     * summarized in blocks of SUMMARY_BLOCK steps that are kept in a
+     * segment tree, so getStateSummary() answers windowed min/max/mean
+     * queries in O(log n). Window queries assume non-decreasing times, as
+     * recorded by ODESolver.
+     */
     class Trajectory {
     public:
         Trajectory();
 //        Trajectory(const Trajectory& orig);
         virtual ~Trajectory();
 
-        void operator()(const DVec& x, const double t);
+        virtual void operator()(const DVec& x, const double t);
+
+        /**
+         * Called by ODESolver after the last step of a solve. Backends that
+         * buffer or hold back steps complete them here.
+         */
+        virtual void finish();
         
-        double getTime(std::size_t i) const;
-        const DVec& getState(std::size_t i) const;
-        size_t size() const;
+        virtual double getTime(std::size_t i) const;
+        virtual const DVec& getState(std::size_t i) const;
+        virtual size_t size() const;
         
-        double getMinTime() const;
-        double getMaxTime() const;
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
         
-        double getMinState(size_t i) const;
-        double getMaxState(size_t i) const;
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        /**
+         * Summarizes component i over all steps with t0 <= t <= t1.
+         * All values are 0 if the window contains no step.
+         */
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        static const size_t SUMMARY_BLOCK = 64;
+
+    protected:
+        /**
+         * Computes getStateSummary() with a binary search and a linear scan
+         * over getTime() / getStateComponent(); for backends without an
+         * index.
+         */
+        StateSummary scanStateSummary(size_t i, double t0, double t1) const;
+
+        /**
+         * @return component c of step i, getState(i)[c] by default;
+         *         backends that store columns read the value directly
+         */
+        virtual double getStateComponent(size_t i, size_t c) const;
 
     private:
+        void updateSummary(const DVec& x);
+        void mergeNode(size_t level, size_t node);
+        void addNode(StateSummary& s, size_t level, size_t node, size_t i) const;
+        void addSteps(StateSummary& s, size_t i, size_t first, size_t last) const;
+
         std::vector< DVec > _states;
         std::vector< double > _times;
+
+        double _minTime;
+        double _maxTime;
+        DVec _minState;
+        DVec _maxState;
+
+        // _levels[l] holds one node per 2^l blocks; a node stores
+        // min, max and sum of every component
+        std::vector< std::vector<double> > _levels;
     };
 
 }
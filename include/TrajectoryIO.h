@@ -0,0 +1,88 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef TRAJECTORYIO_H
+#define	TRAJECTORYIO_H
+
+#include <string>
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Writes trajectories as delimited text (CSV/TSV) or in the binary
+     * StreamingTrajectory format.
+     *
+     * Text rows are "t<d>x0<d>x1..." with the shortest representation that
+     * reads back to the same double (std::to_chars), formatted into a large
+     * buffer and written with write(2); no iostreams are involved.
+     * I/O errors are reported as std::runtime_error.
+     */
+    class TrajectoryWriter {
+    public:
+
+        /**
+         * @param delimiter	',' for CSV, '\t' for TSV
+         * @param header		write a first line "t,x0,x1,..."
+         */
+        static void writeText(const std::string& path, const Trajectory& trajectory,
+                char delimiter = ',', bool header = true);
+
+        static void writeBinary(const std::string& path, const Trajectory& trajectory);
+    };
+
+    /**
+     * Reads files written by TrajectoryWriter (or any delimited table of
+     * numbers with the time in the first column) and appends the steps to
+     * a trajectory.
+     *
+     * The text reader maps the file, finds line ends with SSE2 (16 bytes per
+     * compare; memchr on other targets) and parses every field with
+     * std::from_chars, so values written by TrajectoryWriter round-trip
+     * exactly. A first line that does not start with a number is skipped as
+     * header; blank lines and '\r' line ends are accepted. Malformed input
+     * is reported as std::runtime_error with the line number.
+     *
+     * Binary files with an unknown version or a size that is not a whole
+     * number of records (e.g. a stream cut off while writing) are rejected
+     * with std::runtime_error.
+     */
+    class TrajectoryReader {
+    public:
+
+        static void readText(const std::string& path, Trajectory& trajectory,
+                char delimiter = ',');
+
+        static void readBinary(const std::string& path, Trajectory& trajectory);
+    };
+
+}
+
+#endif	/* TRAJECTORYIO_H */
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef TRAJECTORYVIEW_H
+#define	TRAJECTORYVIEW_H
+
+#include "Trajectory.h"
+
+namespace iNumerics {
+
+    /**
+     * Read-only, lazily evaluated view of another trajectory.
+     *
+     * A view stores only its parameters and a reference to the source, which
+     * must outlive it. Views are trajectories themselves, so they can be
+     * stacked and passed to anything that reads a Trajectory (writers,
+     * ExportPipeline, other views):
+     *
+     * \code
+     * TimeSliceView window(trajectory, 100, 200);
+     * ComponentView x3(window, 3);
+     * ResampledView resampled(x3, 1e-3);
+     * TrajectoryWriter::writeText("x3.csv", resampled);
+     * \endcode
+     *
+     * getState(i) assembles step i into an internal buffer that is valid
+     * until the next call; getState(i, component) reads a single value and
+     * never builds a vector. Views are not thread-safe.
+     */
+    class TrajectoryView : public Trajectory {
+    public:
+        explicit TrajectoryView(const Trajectory& source);
+        virtual ~TrajectoryView();
+
+        /**
+         * Not supported, views are read-only. Throws std::logic_error.
+         */
+        virtual void operator()(const DVec& x, const double t);
+
+        virtual const DVec& getState(std::size_t i) const;
+
+        /**
+         * @return component c of step i
+         */
+        virtual double getState(std::size_t i, size_t component) const = 0;
+
+        /**
+         * @return number of state components
+         */
+        virtual size_t getDimension() const = 0;
+
+        /**
+         * Assumes non-decreasing times. Both are 0 for an empty view.
+         */
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+
+        /**
+         * Binary search for t0 and a scan over the window.
+         */
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        const Trajectory& getSource() const;
+
+    protected:
+        virtual double getStateComponent(size_t i, size_t c) const;
+
+        /**
+         * Component c of source step i without building the state vector
+         * if the source is a view itself.
+         */
+        double sourceState(size_t i, size_t component) const;
+
+        size_t sourceDimension() const;
+
+        /**
+         * @return first source step with time >= t
+         */
+        size_t lowerBound(double t) const;
+
+        /**
+         * @return first source step with time > t
+         */
+        size_t upperBound(double t) const;
+
+        const Trajectory& _source;
+
+    private:
+        const TrajectoryView* _sourceView;
+        mutable DVec _state;
+    };
+
+    /**
+     * Steps of the source with t0 <= t <= t1. The window is located by
+     * binary search on the source times when the view is created.
+     */
+    class TimeSliceView : public TrajectoryView {
+    public:
+        TimeSliceView(const Trajectory& source, double t0, double t1);
+
+        virtual double getTime(std::size_t i) const;
+        virtual double getState(std::size_t i, size_t component) const;
+        virtual size_t size() const;
+        virtual size_t getDimension() const;
+
+        /**
+         * Forwarded to the source with the window intersected, so a
+         * Trajectory source answers in O(log n).
+         */
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        using TrajectoryView::getState;
+
+    private:
+        double _t0;
+        double _t1;
+        size_t _first;
+        size_t _last;
+    };
+
+    /**
+     * Selected state components of the source, in the given order.
+     */
+    class ComponentView : public TrajectoryView {
+    public:
+        /**
+         * Throws std::out_of_range if a component does not exist in a
+         * non-empty source.
+         */
+        ComponentView(const Trajectory& source, const std::vector<size_t>& components);
+        ComponentView(const Trajectory& source, size_t component);
+
+        virtual double getTime(std::size_t i) const;
+        virtual double getState(std::size_t i, size_t component) const;
+        virtual size_t size() const;
+        virtual size_t getDimension() const;
+
+        /**
+         * Forwarded to the source.
+         */
+        virtual double getMinTime() const;
+        virtual double getMaxTime() const;
+        virtual double getMinState(size_t i) const;
+        virtual double getMaxState(size_t i) const;
+        virtual StateSummary getStateSummary(size_t i, double t0, double t1) const;
+
+        using TrajectoryView::getState;
+
+    private:
+        void check() const;
+
+        std::vector<size_t> _components;
+    };
+
+    /**
+     * Every stride-th step of the source, starting with step offset.
+     */
+    class StrideView : public TrajectoryView {
+    public:
+        /**
+         * @param stride	Range: > 0
+         */
+        StrideView(const Trajectory& source, size_t stride, size_t offset = 0);
+
+        virtual double getTime(std::size_t i) const;
+        virtual double getState(std::size_t i, size_t component) const;
+        virtual size_t size() const;
+        virtual size_t getDimension() const;
+
+        using TrajectoryView::getState;
+
+    private:
+        size_t _stride;
+        size_t _offset;
+    };
+
+    /**
+     * The source linearly interpolated (Interpolation::linear) on the grid
+     * t0, t0 + dt, ... <= t1. Sequential access finds the source interval in
+     * O(1) from the previous one; random access uses a binary search.
+     */
+    class ResampledView : public TrajectoryView {
+    public:
+        /**
+         * Resamples the whole time range of the source.
+         * @param dt	grid spacing (Range: > 0)
+         */
+        ResampledView(const Trajectory& source, double dt);
+
+        /**
+         * Resamples [t0, t1]; grid points outside the source range are
+         * clamped to the first or last step.
+         */
+        ResampledView(const Trajectory& source, double t0, double t1, double dt);
+
+        virtual double getTime(std::size_t i) const;
+        virtual double getState(std::size_t i, size_t component) const;
+        virtual size_t size() const;
+        virtual size_t getDimension() const;
+
+        using TrajectoryView::getState;
+
+    private:
+        void init(double t0, double t1, double dt);
+
+        /**
+         * @return j with source time j <= t < source time j + 1, clamped
+         *         to [0, source size - 2]
+         */
+        size_t locate(double t) const;
+
+        double _t0;
+        double _dt;
+        size_t _size;
+        mutable size_t _hint;
+    };
+
+}
+
+#endif	/* TRAJECTORYVIEW_H */
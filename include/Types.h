@@ -30,6 +30,7 @@
 #define	TYPES_H
 
 #include <vector>
+#include <cstddef>
 
 namespace iNumerics {
 
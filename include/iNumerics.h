@@ -34,9 +34,25 @@
 // ode
 
 #include "Trajectory.h"
+#include "StreamingTrajectory.h"
+#include "ColumnarTrajectory.h"
+#include "CompressedTrajectory.h"
+#include "DecimatingTrajectory.h"
+#include "RingTrajectory.h"
+#include "ExportPipeline.h"
+#include "TrajectoryIO.h"
+#include "TrajectoryView.h"
 #include "ODESolver.h"
+#include "Event.h"
+#include "Adjoint.h"
 #include "Problem.h"
 #include "Interpolation.h"
+#include "SolveStats.h"
+#include "Checkpoint.h"
+#include "DelayModel.h"
+#include "DelayHistory.h"
+#include "JacobianStructure.h"
+#include "Preconditioner.h"
 
 // linear algebra
 
@@ -595,3 +595,190 @@ extern "C" void dgesv_(const inInt* n,
         inDouble* b,
         inInt* ldb,
         inInt* info);
+
+
+/**  DGETRF computes an LU factorization of a general M-by-N matrix A
+ *  using partial pivoting with row interchanges.
+ *
+ *  The factorization has the form
+ *     A = P * L * U
+ *  where P is a permutation matrix, L is lower triangular with unit
+ *  diagonal elements, and U is upper triangular.
+ *
+ *  M       (input) INTEGER
+ *          The number of rows of the matrix A.  M >= 0.
+ *
+ *  N       (input) INTEGER
+ *          The number of columns of the matrix A.  N >= 0.
+ *
+ *  A       (input/output) DOUBLE PRECISION array, dimension (LDA,N)
+ *          On entry, the M-by-N matrix to be factored.
+ *          On exit, the factors L and U from the factorization
+ *          A = P*L*U; the unit diagonal elements of L are not stored.
+ *
+ *  LDA     (input) INTEGER
+ *          The leading dimension of the array A.  LDA >= max(1,M).
+ *
+ *  IPIV    (output) INTEGER array, dimension (min(M,N))
+ *          The pivot indices; for 1 <= i <= min(M,N), row i of the
+ *          matrix was interchanged with row IPIV(i).
+ *
+ *  INFO    (output) INTEGER
+ *          = 0:  successful exit
+ *          < 0:  if INFO = -i, the i-th argument had an illegal value
+ *          > 0:  if INFO = i, U(i,i) is exactly zero.
+ */
+extern "C" void dgetrf_(const inInt* m,
+        const inInt* n,
+        inDouble* a,
+        const inInt* lda,
+        inInt* ipiv,
+        inInt* info);
+
+/**  DGETRS solves a system of linear equations
+ *     A * X = B  or  A' * X = B
+ *  with a general N-by-N matrix A using the LU factorization computed
+ *  by DGETRF.
+ *
+ *  TRANS   (input) CHARACTER*1
+ *          = 'N':  A * X = B  (No transpose)
+ *          = 'T':  A'* X = B  (Transpose)
+ *
+ *  N       (input) INTEGER
+ *          The order of the matrix A.  N >= 0.
+ *
+ *  NRHS    (input) INTEGER
+ *          The number of right hand sides, i.e., the number of columns
+ *          of the matrix B.  NRHS >= 0.
+ *
+ *  A       (input) DOUBLE PRECISION array, dimension (LDA,N)
+ *          The factors L and U from the factorization A = P*L*U
+ *          as computed by DGETRF.
+ *
+ *  LDA     (input) INTEGER
+ *          The leading dimension of the array A.  LDA >= max(1,N).
+ *
+ *  IPIV    (input) INTEGER array, dimension (N)
+ *          The pivot indices from DGETRF.
+ *
+ *  B       (input/output) DOUBLE PRECISION array, dimension (LDB,NRHS)
+ *          On entry, the right hand side matrix B.
+ *          On exit, the solution matrix X.
+ *
+ *  LDB     (input) INTEGER
+ *          The leading dimension of the array B.  LDB >= max(1,N).
+ *
+ *  INFO    (output) INTEGER
+ *          = 0:  successful exit
+ *          < 0:  if INFO = -i, the i-th argument had an illegal value
+ */
+extern "C" void dgetrs_(const char* trans,
+        const inInt* n,
+        const inInt* nrhs,
+        const inDouble* a,
+        const inInt* lda,
+        const inInt* ipiv,
+        inDouble* b,
+        const inInt* ldb,
+        inInt* info);
+
+/**  DGBTRF computes an LU factorization of a real m-by-n band matrix A
+ *  using partial pivoting with row interchanges.
+ *
+ *  M       (input) INTEGER
+ *          The number of rows of the matrix A.  M >= 0.
+ *
+ *  N       (input) INTEGER
+ *          The number of columns of the matrix A.  N >= 0.
+ *
+ *  KL      (input) INTEGER
+ *          The number of subdiagonals within the band of A.  KL >= 0.
+ *
+ *  KU      (input) INTEGER
+ *          The number of superdiagonals within the band of A.  KU >= 0.
+ *
+ *  AB      (input/output) DOUBLE PRECISION array, dimension (LDAB,N)
+ *          On entry, the matrix A in band storage, in rows KL+1 to
+ *          2*KL+KU+1; rows 1 to KL of the array need not be set.
+ *          The j-th column of A is stored in the j-th column of the
+ *          array AB as follows:
+ *          AB(kl+ku+1+i-j,j) = A(i,j) for max(1,j-ku)<=i<=min(m,j+kl)
+ *          On exit, details of the factorization: U is stored as an
+ *          upper triangular band matrix with KL+KU superdiagonals in
+ *          rows 1 to KL+KU+1, and the multipliers used during the
+ *          factorization are stored in rows KL+KU+2 to 2*KL+KU+1.
+ *
+ *  LDAB    (input) INTEGER
+ *          The leading dimension of the array AB.  LDAB >= 2*KL+KU+1.
+ *
+ *  IPIV    (output) INTEGER array, dimension (min(M,N))
+ *          The pivot indices; for 1 <= i <= min(M,N), row i of the
+ *          matrix was interchanged with row IPIV(i).
+ *
+ *  INFO    (output) INTEGER
+ *          = 0: successful exit
+ *          < 0: if INFO = -i, the i-th argument had an illegal value
+ *          > 0: if INFO = +i, U(i,i) is exactly zero.
+ */
+extern "C" void dgbtrf_(const inInt* m,
+        const inInt* n,
+        const inInt* kl,
+        const inInt* ku,
+        inDouble* ab,
+        const inInt* ldab,
+        inInt* ipiv,
+        inInt* info);
+
+/**  DGBTRS solves a system of linear equations
+ *     A * X = B  or  A' * X = B
+ *  with a general band matrix A using the LU factorization computed
+ *  by DGBTRF.
+ *
+ *  TRANS   (input) CHARACTER*1
+ *          = 'N':  A * X = B  (No transpose)
+ *          = 'T':  A'* X = B  (Transpose)
+ *
+ *  N       (input) INTEGER
+ *          The order of the matrix A.  N >= 0.
+ *
+ *  KL      (input) INTEGER
+ *          The number of subdiagonals within the band of A.  KL >= 0.
+ *
+ *  KU      (input) INTEGER
+ *          The number of superdiagonals within the band of A.  KU >= 0.
+ *
+ *  NRHS    (input) INTEGER
+ *          The number of right hand sides.  NRHS >= 0.
+ *
+ *  AB      (input) DOUBLE PRECISION array, dimension (LDAB,N)
+ *          Details of the LU factorization of the band matrix A, as
+ *          computed by DGBTRF.
+ *
+ *  LDAB    (input) INTEGER
+ *          The leading dimension of the array AB.  LDAB >= 2*KL+KU+1.
+ *
+ *  IPIV    (input) INTEGER array, dimension (N)
+ *          The pivot indices from DGBTRF.
+ *
+ *  B       (input/output) DOUBLE PRECISION array, dimension (LDB,NRHS)
+ *          On entry, the right hand side matrix B.
+ *          On exit, the solution matrix X.
+ *
+ *  LDB     (input) INTEGER
+ *          The leading dimension of the array B.  LDB >= max(1,N).
+ *
+ *  INFO    (output) INTEGER
+ *          = 0:  successful exit
+ *          < 0: if INFO = -i, the i-th argument had an illegal value
+ */
+extern "C" void dgbtrs_(const char* trans,
+        const inInt* n,
+        const inInt* kl,
+        const inInt* ku,
+        const inInt* nrhs,
+        const inDouble* ab,
+        const inInt* ldab,
+        const inInt* ipiv,
+        inDouble* b,
+        const inInt* ldb,
+        inInt* info);
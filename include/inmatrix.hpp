@@ -10,6 +10,8 @@
 
 #include "inmatrix.h"
 #include "inbaseobject.h"
+#include "inperfcounters.h"
+#include "intracer.h"
 
 //#define DEBUG 2
 
@@ -497,8 +499,10 @@ namespace iNumerics {
     void Matrix<T>::LUdecomposition() {
         IN_DISPLAY("(" << this->_objID << ") Matrix<T>::LUdecomposition()", 1);
         IN_ASSERT(this->nRows() == this->nCols(), 0);
+        IN_PERF_REGION(PERF_LU);
 
         if (this->_decompType == NO_DECOMP) {
+            IN_TRACE_INSTANT("lu", (double) this->nCols());
 
             // /*("should be")*/ programmed for col-wise saved matrices
             for (inULong k = 0; k < this->nCols() - 1; k++) {
@@ -555,6 +559,7 @@ namespace iNumerics {
         IN_DISPLAY("(" << this->_objID << ") and (" << b.ID() << ") Matrix<T>::LUsolving()", 1);
         IN_ASSERT(this->_decompType == LU_DECOMP, 0);
         IN_ASSERT(this->nCols() == b.size(), 0);
+        IN_PERF_REGION(PERF_LU);
 
         Vector<T> x(this->nCols(), true);
 
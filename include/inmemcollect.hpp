@@ -5,6 +5,8 @@
 
 #define INMEMCOLLECT_CPP
 #include "inmemcollect.h"
+#include "inperfcounters.h"
+#include "intracer.h"
 
 //#define DEBUG 0
 
@@ -46,6 +48,7 @@ namespace iNumerics {
     void MemCollect<T>::allocMem(MemType<T>*& mem, inULong n) {
         // Debug-Output
         IN_DISPLAY("MemCollect<T>::allocMem(inULong n)", 1);
+        IN_PERF_REGION(PERF_ALLOCATOR);
 
 
         if (!_initialized) {
@@ -94,6 +97,7 @@ namespace iNumerics {
         
         // If no entry has been found, allocate new memory.
         if (!foundMem) {
+            IN_TRACE_INSTANT("alloc", (double) (n * sizeof (T)));
             mem = new MemType<T > (n);
         }
 
@@ -0,0 +1,118 @@
+/// \file   inperfcounters.h
+/// \brief Contains the declaration of the hardware performance counter regions.
+
+#ifndef INPERFCOUNTERS_H
+#define INPERFCOUNTERS_H
+
+#include "intypes.h"
+
+/**
+ * Attributes the hardware counters of the enclosing scope to region \p r
+ * (see PerfRegion). Regions nest; counts are exclusive, i.e. an RHS call
+ * inside a stepper region is only counted as RHS.
+ *
+ * Expands to nothing unless iNumerics is built with INUMERICS_PERF_COUNTERS
+ * (cmake -DINUMERICS_PERF_COUNTERS=ON).
+ */
+#ifdef INUMERICS_PERF_COUNTERS
+#define IN_PERF_REGION(r) \
+    iNumerics::ScopedPerfRegion IN_PERF_CAT(_inPerfRegion, __LINE__)(r)
+#define IN_PERF_CAT(a, b) IN_PERF_CAT_(a, b)
+#define IN_PERF_CAT_(a, b) a##b
+#else
+#define IN_PERF_REGION(r)
+#endif
+
+/**
+ * \brief iNumerics Standard Namespace
+ */
+namespace iNumerics {
+
+    /**
+     * Hot-path regions that can be instrumented.
+     */
+    enum PerfRegion {
+        PERF_OTHER /**Everything outside of an instrumented region.*/,
+        PERF_RHS /**Model::rhs() calls.*/,
+        PERF_STEPPER /**Stepper algebra, i.e. the step without rhs calls.*/,
+        PERF_OBSERVER /**Trajectory recording and Model::step().*/,
+        PERF_LU /**LU decompositions and solves.*/,
+        PERF_ALLOCATOR /**MemCollect allocations.*/,
+        PERF_REGIONS
+    };
+
+    /**
+     * Counter values of one region.
+     */
+    struct PerfCounts {
+        PerfCounts();
+
+        PerfCounts& operator+=(const PerfCounts& other);
+        PerfCounts& operator-=(const PerfCounts& other);
+
+        /** number of times the region was entered */
+        inULong calls;
+        /** thread cpu time in nanoseconds (software counter, always available) */
+        inULong taskClock;
+        inULong cycles;
+        inULong instructions;
+        inULong cacheMisses;
+        inULong branchMisses;
+    };
+
+    /**
+     * \brief Per-thread hardware counters based on Linux perf_event_open.
+     *
+     * Counters are opened lazily for each thread on first use. Counters the
+     * kernel refuses (e.g. in virtual machines or with a restrictive
+     * perf_event_paranoid setting) read as zero.
+     */
+    class PerfCounters {
+    public:
+
+        /**
+         * @return true if the library was built with INUMERICS_PERF_COUNTERS.
+         */
+        static bool isEnabled();
+
+        /**
+         * @return true if at least the hardware cycle counter could be opened
+         *         for the calling thread.
+         */
+        static bool hasHardwareCounters();
+
+        static void begin(PerfRegion r);
+
+        static void end(PerfRegion r);
+
+        /**
+         * Copies the totals of the calling thread, indexed by PerfRegion.
+         */
+        static void snapshot(PerfCounts counts[PERF_REGIONS]);
+
+        static const char* regionName(PerfRegion r);
+    };
+
+    /**
+     * \brief RAII helper for PerfCounters::begin() / end().
+     */
+    class ScopedPerfRegion {
+    public:
+
+        explicit ScopedPerfRegion(PerfRegion r) : _region(r) {
+            PerfCounters::begin(r);
+        }
+
+        ~ScopedPerfRegion() {
+            PerfCounters::end(_region);
+        }
+
+    private:
+        ScopedPerfRegion(const ScopedPerfRegion&);
+        ScopedPerfRegion& operator=(const ScopedPerfRegion&);
+
+        PerfRegion _region;
+    };
+}
+
+#endif /*INPERFCOUNTERS_H*/
@@ -0,0 +1,244 @@
+/// \file   inprofiler.h
+/// \brief Contains the declaration of the monotonic clock, latency histograms and the profiler.
+
+#ifndef INPROFILER_H
+#define INPROFILER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+
+#include "intypes.h"
+
+/**
+ * Times the enclosing scope under the region \p name. The region is looked up
+ * only once per call site, so the remaining cost is two clock reads and a few
+ * relaxed stores into the calling thread's accumulator.
+ */
+#define IN_PROFILE_SCOPE(name) \
+    static const inULong IN_PROFILE_CAT(_inProfileRegion, __LINE__) = \
+        iNumerics::Profiler::instance().region(name); \
+    iNumerics::ScopedTimer IN_PROFILE_CAT(_inProfileTimer, __LINE__)( \
+        IN_PROFILE_CAT(_inProfileRegion, __LINE__))
+
+#define IN_PROFILE_CAT(a, b) IN_PROFILE_CAT_(a, b)
+#define IN_PROFILE_CAT_(a, b) a##b
+
+/**
+ * \brief iNumerics Standard Namespace
+ */
+namespace iNumerics {
+
+    /**
+     * \brief Monotonic nanosecond clock.
+     *
+     * Unlike clock(), which StopWatch used to rely on, this clock measures wall
+     * time, is not summed over threads and never wraps around.
+     */
+    class MonotonicClock {
+    public:
+
+        /**
+         * @return	Nanoseconds since an unspecified, fixed epoch.
+         */
+        static inULong now() {
+            return (inULong) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        /**
+         * @return	Seconds since an unspecified, fixed epoch.
+         */
+        static double seconds() {
+            return now() * 1.e-9;
+        }
+    };
+
+    /**
+     * \brief Log-linear latency histogram.
+     *
+     * Values below 16 ns get a bucket each, larger values are split into 16
+     * sub-buckets per power of two, i.e. percentiles are accurate to ~6%.
+     * Recording is a couple of shifts and one relaxed increment. Only the
+     * owning thread records; any thread may read.
+     */
+    class LatencyHistogram {
+    public:
+
+        enum {
+            SUB_BUCKETS = 16,
+            MAX_EXPONENT = 48,
+            BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - 4) * SUB_BUCKETS
+        };
+
+        LatencyHistogram();
+
+        /**
+         * Adds one sample.
+         * @param ns	Duration in nanoseconds.
+         */
+        void record(inULong ns) {
+            inULong& c = _counts[bucket(ns)];
+            __atomic_store_n(&c, __atomic_load_n(&c, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+        }
+
+        /**
+         * Adds the counts of another histogram.
+         */
+        void merge(const LatencyHistogram& other);
+
+        void reset();
+
+        /**
+         * @return	Total number of samples.
+         */
+        inULong count() const;
+
+        /**
+         * Returns the q-quantile in nanoseconds (q = 0.5 is the median).
+         * @param q	Quantile (Range: 0 .. 1).
+         */
+        double percentile(double q) const;
+
+        static size_t bucket(inULong ns);
+
+        /**
+         * @return	Lower bound of bucket b in nanoseconds.
+         */
+        static inULong lowerBound(size_t b);
+
+    private:
+        inULong _counts[BUCKETS];
+    };
+
+    /**
+     * \brief Aggregated timing of one region (optionally of one thread).
+     */
+    struct TimerStats {
+        std::string name;
+        /** Thread index or -1 if aggregated over all threads. */
+        long thread;
+        inULong count;
+        double total; ///< seconds
+        double mean; ///< seconds
+        double min; ///< seconds
+        double max; ///< seconds
+        double p50; ///< seconds
+        double p99; ///< seconds
+    };
+
+    /**
+     * \brief Named, per-thread timing accumulators.
+     *
+     * Each thread records into its own accumulator block, so timing never
+     * contends on a lock. report() merges the blocks of all threads, including
+     * threads that have already finished.
+     *
+     * \code
+     * inULong rhs = Profiler::instance().region("rhs");
+     * {
+     *     ScopedTimer timer(rhs);
+     *     model.rhs(y, dydt, t);
+     * }
+     * Profiler::instance().print(std::cout);
+     * \endcode
+     */
+    class Profiler {
+    public:
+
+        enum {
+            MAX_REGIONS = 128
+        };
+
+        static Profiler& instance();
+
+        /**
+         * Returns the id of the region \p name, registering it if necessary.
+         * Ids are stable for the lifetime of the process.
+         */
+        inULong region(const std::string& name);
+
+        /**
+         * Adds a duration to region \p id of the calling thread.
+         */
+        void record(inULong id, inULong ns);
+
+        /**
+         * @param perThread	If true, one entry per region and thread is returned,
+         *			otherwise one entry per region.
+         */
+        std::vector<TimerStats> report(bool perThread = false) const;
+
+        /**
+         * Prints report() as table.
+         */
+        void print(std::ostream& os, bool perThread = false) const;
+
+        /**
+         * Clears all samples, keeps the registered regions.
+         */
+        void reset();
+
+        ~Profiler();
+
+    private:
+
+        struct Accumulator {
+            Accumulator();
+            void record(inULong ns);
+            void merge(const Accumulator& other);
+
+            inULong count;
+            inULong total;
+            inULong min;
+            inULong max;
+            LatencyHistogram histogram;
+        };
+
+        struct ThreadBlock {
+            ThreadBlock(size_t index);
+            ~ThreadBlock();
+
+            size_t index;
+            std::atomic<Accumulator*> regions[MAX_REGIONS];
+        };
+
+        Profiler();
+        Profiler(const Profiler&);
+        Profiler& operator=(const Profiler&);
+
+        ThreadBlock& localBlock();
+
+        static void fill(TimerStats& s, const Accumulator& a);
+
+        mutable std::mutex _mutex;
+        std::vector<std::string> _names;
+        std::vector<ThreadBlock*> _blocks;
+    };
+
+    /**
+     * \brief RAII timer that records its lifetime into a Profiler region.
+     */
+    class ScopedTimer {
+    public:
+
+        explicit ScopedTimer(inULong region) : _region(region), _start(MonotonicClock::now()) {
+        }
+
+        ~ScopedTimer() {
+            Profiler::instance().record(_region, MonotonicClock::now() - _start);
+        }
+
+    private:
+        ScopedTimer(const ScopedTimer&);
+        ScopedTimer& operator=(const ScopedTimer&);
+
+        inULong _region;
+        inULong _start;
+    };
+}
+
+#endif /*INPROFILER_H*/
@@ -6,7 +6,8 @@
 #ifndef INSTOPWATCH_H
 #define INSTOPWATCH_H
 
-#include <time.h>
+#include "intypes.h"
+#include "inprofiler.h"
 
 /**
  * \brief iNumerics Standard Namespace
@@ -15,12 +16,15 @@ namespace iNumerics
 {
 	/**
 	 * \brief Is a stopwatch.
+	 *
+	 * Measures wall time with MonotonicClock. For timing many short,
+	 * possibly concurrent regions use Profiler and ScopedTimer instead.
 	 */
 	class StopWatch
 	{
 		protected:
 			bool     running;
-			clock_t  last_time;
+			inULong  last_time;
 			double   total_time;
 
 
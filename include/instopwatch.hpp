@@ -10,42 +10,40 @@
 namespace iNumerics
 {
 
-	StopWatch::StopWatch()
+	inline StopWatch::StopWatch()
 	{
 		running = 0;
 		last_time = 0;
 		total_time = 0;
 	}
 
-	void StopWatch::reset()
+	inline void StopWatch::reset()
 	{
 		running = 0;
 		last_time = 0;
 		total_time = 0;
 	}
 
-	void StopWatch::start()
+	inline void StopWatch::start()
 	{
 		if ( !running )
 		{
-			last_time = clock();
+			last_time = MonotonicClock::now();
 			running = true;
 		}
 	}
 
-	double StopWatch::stop()
+	inline double StopWatch::stop()
 	{
 		if ( running )
 		{
-			double s = ( double ) ( clock() - last_time ) / ( double ) CLOCKS_PER_SEC;
-			while ( s<0 ) s+= ( double ) ( ( clock_t ) ( -1 ) ) / ( double ) CLOCKS_PER_SEC;
-			total_time+=s;
+			total_time += ( MonotonicClock::now() - last_time ) * 1.e-9;
 			running = 0;
 		}
 		return total_time;
 	}
 
-	double StopWatch::read() const
+	inline double StopWatch::read() const
 	{
 		if ( running ) return -1;
 		return total_time;
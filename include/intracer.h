@@ -0,0 +1,91 @@
+/// \file   intracer.h
+/// \brief Contains the declaration of the event tracer (Chrome trace format).
+
+#ifndef INTRACER_H
+#define INTRACER_H
+
+#include <iostream>
+#include <atomic>
+
+#include "intypes.h"
+
+/**
+ * Tracing hooks. With tracing stopped each hook costs one relaxed load and
+ * a branch that is predicted not taken.
+ */
+#define IN_TRACE_BEGIN(name, arg) \
+    do { if (__builtin_expect(iNumerics::Tracer::isEnabled(), 0)) \
+        iNumerics::Tracer::record(name, 'B', arg); } while (0)
+
+#define IN_TRACE_END(name) \
+    do { if (__builtin_expect(iNumerics::Tracer::isEnabled(), 0)) \
+        iNumerics::Tracer::record(name, 'E', 0); } while (0)
+
+#define IN_TRACE_INSTANT(name, arg) \
+    do { if (__builtin_expect(iNumerics::Tracer::isEnabled(), 0)) \
+        iNumerics::Tracer::record(name, 'i', arg); } while (0)
+
+/**
+ * \brief iNumerics Standard Namespace
+ */
+namespace iNumerics {
+
+    /**
+     * \brief Opt-in event tracer.
+     *
+     * Every thread records into its own fixed-size ring buffer; recording
+     * takes no lock and never allocates after the first event of a thread.
+     * When a buffer is full the oldest events are overwritten. The solver
+     * records step begin/end (arg: step size), step rejections, rhs calls,
+     * Jacobian rebuilds and MemCollect slow-path allocations.
+     *
+     * \code
+     * Tracer::start();
+     * solver.solve(p, t);
+     * Tracer::stop();
+     * std::ofstream file("trace.json");
+     * Tracer::writeChromeTrace(file); // load in chrome://tracing or Perfetto
+     * \endcode
+     */
+    class Tracer {
+    public:
+
+        /**
+         * Enables recording.
+         * @param capacity	Events per thread buffer (Range: > 0). Only
+         *			affects buffers of threads that have not recorded yet.
+         */
+        static void start(size_t capacity = 1 << 16);
+
+        static void stop();
+
+        static bool isEnabled() {
+            return _enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Records an event of the calling thread.
+         * @param name	Event name, must be a string literal (or otherwise outlive the tracer).
+         * @param phase	'B' (begin), 'E' (end) or 'i' (instant).
+         * @param arg	Event argument, e.g. the step size.
+         */
+        static void record(const char* name, char phase, double arg);
+
+        /**
+         * Writes all buffered events as Chrome trace / Perfetto JSON.
+         * May be called while other threads record; events that are
+         * overwritten during the dump are skipped.
+         */
+        static void writeChromeTrace(std::ostream& os);
+
+        /**
+         * Drops all buffered events. Call while no thread records.
+         */
+        static void clear();
+
+    private:
+        static std::atomic<bool> _enabled;
+    };
+}
+
+#endif /*INTRACER_H*/
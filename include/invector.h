@@ -9,6 +9,7 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <climits>
 
 #include "intypes.h"
 #include "inmemtype.h"
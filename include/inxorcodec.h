@@ -0,0 +1,46 @@
+/// \file   inxorcodec.h
+/// \brief Contains the declaration of the lossless predictive floating point codec.
+
+#ifndef INXORCODEC_H
+#define INXORCODEC_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * \brief iNumerics Standard Namespace
+ */
+namespace iNumerics {
+
+    /**
+     * \brief Lossless codec for series of doubles (FPC/Gorilla style).
+     *
+     * Every value is predicted twice, by the previous value and by linear
+     * extrapolation of the two previous values. The prediction with more
+     * leading zero bytes in its XOR residual is selected. Values are encoded
+     * in pairs: one header byte holds two nibbles (1 bit predictor, 3 bits
+     * leading zero byte count, where 4 is stored as 3), followed by the
+     * non-zero low bytes of both residuals.
+     *
+     * All decoding is byte aligned, so decode() runs without bit shuffling.
+     * Smooth series (ODE states, monotone times) typically shrink to
+     * 2-4 bytes per value. The stream layout assumes a little-endian host.
+     */
+    class XorCodec {
+    public:
+
+        /**
+         * Appends the encoding of n values to out.
+         * @return number of bytes appended
+         */
+        static size_t encode(const double* values, size_t n, std::vector<unsigned char>& out);
+
+        /**
+         * Decodes n values from a stream written by encode().
+         * @return pointer past the consumed bytes
+         */
+        static const unsigned char* decode(const unsigned char* in, size_t n, double* values);
+    };
+}
+
+#endif /*INXORCODEC_H*/
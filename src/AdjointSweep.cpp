@@ -0,0 +1,339 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "AdjointSweep.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Interpolation.h"
+
+namespace iNumerics {
+
+    _Adjoint::_Adjoint(Model& model, _CountingRhs rhs, SolveStats& stats, size_t n)
+    : _model(model), _rhs(rhs), _jacobian(model, rhs, stats), _n(n),
+    _vectorJacobian(true), _parameterJacobian(true) {
+    }
+
+    void _Adjoint::setStep(double t0, const DVec& y0, const DVec& f0,
+            const DVec& ym, const DVec& fm,
+            double t1, const DVec& y1, const DVec& f1) {
+        const size_t n = _n;
+        const double h = t1 - t0;
+        const double z[6] = {0, 0, 0.5 * h, 0.5 * h, h, h};
+
+        _t0 = t0;
+        _h = h;
+        _coef.resize(6 * n);
+
+        // Newton form of the quintic Hermite interpolant: divided
+        // differences on the nodes z with derivatives at repeated nodes
+        for (size_t i = 0; i < n; i++) {
+            double d[6] = {y0[i], y0[i], ym[i], ym[i], y1[i], y1[i]};
+            double* c = &_coef[6 * i];
+
+            c[0] = d[0];
+
+            for (size_t k = 1; k < 6; k++) {
+                for (size_t j = 0; j + k < 6; j++) {
+                    if (z[j + k] == z[j]) {
+                        d[j] = j == 0 ? f0[i] : (j == 2 ? fm[i] : f1[i]);
+                    } else {
+                        d[j] = (d[j + 1] - d[j]) / (z[j + k] - z[j]);
+                    }
+                }
+
+                c[k] = d[0];
+            }
+        }
+    }
+
+    void _Adjoint::operator()(const DVec &a, DVec &dadt, const double t) {
+        const size_t n = _n;
+        const size_t p = _model.getParameterCount();
+
+        // Horner scheme of the Newton form
+        const double tau = t - _t0;
+        const double z[5] = {tau, tau, tau - 0.5 * _h, tau - 0.5 * _h, tau - _h};
+
+        _y.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            const double* c = &_coef[6 * i];
+            double value = c[5];
+
+            for (size_t k = 5; k-- > 0;) {
+                value = c[k] + z[k] * value;
+            }
+
+            _y[i] = value;
+        }
+
+        _w.assign(a.begin(), a.begin() + n);
+        _wJy.assign(n, 0);
+        _wJp.assign(p, 0);
+
+        product(t);
+
+        for (size_t i = 0; i < n; i++) {
+            dadt[i] = -_wJy[i];
+        }
+
+        for (size_t k = 0; k < p; k++) {
+            dadt[n + k] = -_wJp[k];
+        }
+    }
+
+    void _Adjoint::product(double t) {
+        const size_t n = _n;
+        const size_t p = _model.getParameterCount();
+
+        if (_vectorJacobian) {
+            _vectorJacobian = _model.vectorJacobian(_y, _w, _wJy, _wJp, t);
+
+            if (_vectorJacobian) {
+                return;
+            }
+        }
+
+        _f.resize(n);
+        _rhs(_y, _f, t);
+
+        _jacobian(_y, _f, t, _J);
+
+        for (size_t j = 0; j < n; j++) {
+            const double* column = &_J[j * n];
+            double sum = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                sum += _w[i] * column[i];
+            }
+
+            _wJy[j] = sum;
+        }
+
+        if (p == 0) {
+            return;
+        }
+
+        if (_parameterJacobian) {
+            _dfdp.assign(n * p, 0);
+            _parameterJacobian = _model.parameterJacobian(_y, _dfdp, t);
+        }
+
+        if (_parameterJacobian) {
+            for (size_t k = 0; k < p; k++) {
+                const double* column = &_dfdp[k * n];
+                double sum = 0;
+
+                for (size_t i = 0; i < n; i++) {
+                    sum += _w[i] * column[i];
+                }
+
+                _wJp[k] = sum;
+            }
+
+            return;
+        }
+
+        _fp.resize(n);
+
+        for (size_t k = 0; k < p; k++) {
+            const double value = _model.getParameter(k);
+            const double delta = std::sqrt(DBL_EPSILON) * (value != 0 ? std::fabs(value) : 1);
+
+            _model.setParameter(k, value + delta);
+            _rhs(_y, _fp, t);
+            _model.setParameter(k, value);
+
+            double sum = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                sum += _w[i] * (_fp[i] - _f[i]);
+            }
+
+            _wJp[k] = sum / delta;
+        }
+    }
+
+    _AdjointSweep::_AdjointSweep(_CountingRhs rhs, _Adjoint& adjoint, const std::vector<double>& times,
+            double absError, double relError, AdjointResult& result)
+    : _rhs(rhs), _adjoint(adjoint), _times(times), _result(result), _live(0),
+    _controlled(_StateErrorChecker(absError, relError, 0)) {
+    }
+
+    void _AdjointSweep::run(const DVec& y0, DVec& a, size_t snapshots) {
+        _a = &a;
+        const size_t m = _times.size() - 1;
+        _dt = m > 0 ? _times[m - 1] - _times[m] : 0;
+
+        if (m > 0) {
+            reverse(0, m, y0, snapshots);
+        }
+    }
+
+    void _AdjointSweep::reverse(size_t first, size_t last, const DVec& y, size_t snapshots) {
+        const size_t m = last - first;
+
+        if (m == 1) {
+            backward(first, y);
+            return;
+        }
+
+        if (snapshots == 0) {
+            for (size_t i = last; i-- > first;) {
+                _y = y;
+                advance(_y, first, i);
+                backward(i, _y);
+            }
+
+            return;
+        }
+
+        size_t r = 1;
+
+        while (binomial(snapshots, r) < m) {
+            r++;
+        }
+
+        size_t right = (size_t) std::min(binomial(snapshots - 1, r), (double) (m - 1));
+        size_t split = last - right;
+
+        DVec snapshot = y;
+        advance(snapshot, first, split);
+
+        _result.snapshots = std::max(_result.snapshots, ++_live);
+        reverse(split, last, snapshot, snapshots - 1);
+        _live--;
+
+        reverse(first, split, y, snapshots);
+    }
+
+    double _AdjointSweep::binomial(size_t s, size_t r) {
+        double result = 1;
+
+        for (size_t k = 1; k <= s; k++) {
+            result = result * (r + k) / k;
+        }
+
+        return result;
+    }
+
+    void _AdjointSweep::advance(DVec& y, size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) {
+            step(y, i);
+        }
+    }
+
+    void _AdjointSweep::step(DVec& y, size_t i) {
+        IN_PERF_REGION(PERF_STEPPER);
+
+        _f.resize(y.size());
+        _next.resize(y.size());
+        _error.resize(y.size());
+        _rhs(y, _f, _times[i]);
+        _stepper.do_step(_rhs, y, _f, _times[i], _next, _times[i + 1] - _times[i], _error);
+        y.swap(_next);
+
+        _result.recomputedSteps++;
+    }
+
+    void _AdjointSweep::backward(size_t i, const DVec& y) {
+        using namespace boost::numeric::odeint;
+
+        const size_t max_attempts = 1000;
+        const double t0 = _times[i];
+        const double t1 = _times[i + 1];
+        const size_t n = y.size();
+
+        _y1 = y;
+        step(_y1, i);
+        _f1.resize(n);
+        _rhs(_y1, _f1, t1);
+
+        // midpoint for the interpolant (_f is still f at t0)
+        _ym.resize(n);
+        _fm.resize(n);
+        _stepper.do_step(_rhs, y, _f, t0, _ym, 0.5 * (t1 - t0), _error);
+        _rhs(_ym, _fm, t0 + 0.5 * (t1 - t0));
+
+        _adjoint.setStep(t0, y, _f, _ym, _fm, t1, _y1, _f1);
+
+        IN_TRACE_BEGIN("adjoint", t0);
+
+        DVec& a = *_a;
+        double t = t1;
+
+        while (t > t0) {
+            // the remainder of the forward step in one step or, if it
+            // is not much longer than the proposal, in two halves
+            // (dt < 0)
+            const double remainder = t0 - t;
+            double dt = _dt;
+            bool shortened = false;
+
+            if (remainder >= _dt) {
+                dt = remainder;
+                shortened = true;
+            } else if (remainder > 2 * _dt) {
+                dt = 0.5 * remainder;
+                shortened = true;
+            }
+
+            double tried = dt;
+            size_t trials = 0;
+            controlled_step_result res = fail;
+
+            while (res == fail && trials < max_attempts) {
+                IN_PERF_REGION(PERF_STEPPER);
+                tried = dt;
+                res = _controlled.try_step(_AdjointRhs(_adjoint), a, t, dt);
+                _result.adjointSteps++;
+                trials++;
+            }
+
+            if (res == fail) {
+                throw std::overflow_error("ODESolver: Maximal number of iterations reached. An adjoint step size could not be found.");
+            }
+
+            if (tried == remainder) {
+                t = t0;
+            }
+
+            // the proposal after a shortened step only counts if it
+            // is larger than the previous one or the step was rejected
+            _dt = (shortened && trials == 1) ? std::min(_dt, dt) : dt;
+        }
+
+        IN_TRACE_END("adjoint");
+    }
+
+}
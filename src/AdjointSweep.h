@@ -0,0 +1,217 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef ADJOINTSWEEP_H
+#define	ADJOINTSWEEP_H
+
+#include <vector>
+
+#include <boost/numeric/odeint/stepper/runge_kutta_cash_karp54.hpp>
+#include <boost/numeric/odeint/stepper/controlled_runge_kutta.hpp>
+
+#include "Types.h"
+#include "Model.h"
+#include "Adjoint.h"
+#include "SolveStats.h"
+#include "SolverSupport.h"
+#include "Jacobian.h"
+
+namespace iNumerics {
+
+    /**
+     * Passes the steps on to a _StepObserver and records the step times
+     * for the backward pass of the adjoint solver.
+     */
+    class _TimeRecorder {
+    public:
+        Trajectory& _trajectory;
+        _StepObserver& _observer;
+        std::vector<double>& _times;
+
+        _TimeRecorder(_StepObserver& observer, std::vector<double>& times)
+        : _trajectory(observer._trajectory), _observer(observer), _times(times) {
+        }
+
+        void operator()(const DVec &x, double t) {
+            _times.push_back(t);
+            _observer(x, t);
+        }
+    };
+
+    /**
+     * Adjoint system a = (lambda, mu) with
+     *
+     *     lambda' = -J^T lambda,   mu' = -(df/dp)^T lambda
+     *
+     * along one forward step, with y from the quintic Hermite interpolant
+     * through the ends and the midpoint of the step. The products
+     * come from Model::vectorJacobian() or, if the model does not implement
+     * it, from the Jacobian (_Jacobian) and Model::parameterJacobian() or
+     * forward differences with perturbed parameters.
+     */
+    class _Adjoint {
+    public:
+
+        _Adjoint(Model& model, _CountingRhs rhs, SolveStats& stats, size_t n);
+
+        /**
+         * Sets the forward step from (t0, y0) to (t1, y1) with the
+         * midpoint ym and the derivatives f0, fm and f1.
+         */
+        void setStep(double t0, const DVec& y0, const DVec& f0,
+                const DVec& ym, const DVec& fm,
+                double t1, const DVec& y1, const DVec& f1);
+
+        void operator()(const DVec &a, DVec &dadt, const double t);
+
+    private:
+
+        /**
+         * _wJy = w^T df/dy and _wJp = w^T df/dp at (_y, t).
+         */
+        void product(double t);
+
+        Model& _model;
+        _CountingRhs _rhs;
+        _Jacobian _jacobian;
+        size_t _n;
+        bool _vectorJacobian;
+        bool _parameterJacobian;
+
+        double _t0;
+        double _h;
+        DVec _coef;
+
+        DVec _y;
+        DVec _w;
+        DVec _wJy;
+        DVec _wJp;
+        DVec _f;
+        DVec _fp;
+        DVec _J;
+        DVec _dfdp;
+    };
+
+    /**
+     * System functor of the adjoint system.
+     */
+    class _AdjointRhs {
+    public:
+        _Adjoint& _adjoint;
+
+        _AdjointRhs(_Adjoint& adjoint) : _adjoint(adjoint) {
+        }
+
+        void operator()(const DVec &a, DVec &dadt, const double t) {
+            _adjoint(a, dadt, t);
+        }
+    };
+
+    /**
+     * Backward pass of the adjoint solver over the recorded forward steps.
+     *
+     * Forward steps are recomputed from snapshots with their recorded step
+     * sizes. The snapshots follow the binomial schedule of revolve
+     * (Griewank and Walther): with s snapshots and m steps every step is
+     * recomputed at most r times, where r is the smallest number with
+     * C(s + r, s) >= m.
+     */
+    class _AdjointSweep {
+    public:
+
+        _AdjointSweep(_CountingRhs rhs, _Adjoint& adjoint, const std::vector<double>& times,
+                double absError, double relError, AdjointResult& result);
+
+        /**
+         * @param y0		state at the first recorded time
+         * @param a		adjoint state at the last recorded time on entry,
+         *			at the first one on exit
+         * @param snapshots	states to keep besides y0
+         */
+        void run(const DVec& y0, DVec& a, size_t snapshots);
+
+    private:
+
+        /**
+         * Integrates the adjoint backward over the steps [first, last),
+         * y is the state at step first.
+         */
+        void reverse(size_t first, size_t last, const DVec& y, size_t snapshots);
+
+        /**
+         * C(s + r, s), the number of steps s snapshots reverse with r
+         * recomputations per step.
+         */
+        static double binomial(size_t s, size_t r);
+
+        /**
+         * Recomputes the steps [from, to) of y.
+         */
+        void advance(DVec& y, size_t from, size_t to);
+
+        /**
+         * Recomputes step i with its recorded size; _f receives f at the
+         * start of the step.
+         */
+        void step(DVec& y, size_t i);
+
+        /**
+         * Integrates the adjoint from the end of step i to its start, y is
+         * the state at the start.
+         */
+        void backward(size_t i, const DVec& y);
+
+        typedef boost::numeric::odeint::runge_kutta_cash_karp54< DVec > _ErrorStepper;
+        typedef boost::numeric::odeint::controlled_runge_kutta< _ErrorStepper, _StateErrorChecker > _ControlledStepper;
+
+        _CountingRhs _rhs;
+        _Adjoint& _adjoint;
+        const std::vector<double>& _times;
+        AdjointResult& _result;
+        size_t _live;
+
+        DVec* _a;
+        double _dt;
+
+        _ErrorStepper _stepper;
+        _ControlledStepper _controlled;
+
+        DVec _y;
+        DVec _y1;
+        DVec _ym;
+        DVec _f;
+        DVec _f1;
+        DVec _fm;
+        DVec _next;
+        DVec _error;
+    };
+
+}
+
+#endif	/* ADJOINTSWEEP_H */
@@ -0,0 +1,446 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef BDF_H
+#define	BDF_H
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <boost/numeric/odeint/stepper/controlled_step_result.hpp>
+
+#include "Types.h"
+#include "StructuredLU.h"
+#include "SolveStats.h"
+#include "Jacobian.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    /**
+     * Variable-order (1 to 5), variable-step BDF in the quasi-constant
+     * step size form of Shampine & Reichelt (ode15s, without the NDF
+     * modification): the history is kept as backward differences of the
+     * solution, which are interpolated to a new step size whenever it
+     * changes. Steps are only changed after order + 1 equal steps or a
+     * failure, and not for a gain below 20%, so the iteration matrix
+     * I - h / alpha_k J and its LU factors are reused across steps.
+     *
+     * The corrector is a simplified Newton iteration. The Jacobian is kept
+     * until the iteration fails to converge (or for MAX_JACOBIAN_AGE
+     * steps) and then evaluated at the start of the step.
+     *
+     * Behind try_step() the stepper carries its own history; if the
+     * integration is restarted at another state or time (events), the
+     * method restarts with order 1.
+     */
+    class _Bdf {
+    public:
+
+        _Bdf(_Jacobian& jacobian, SolveStats& stats, double absError, double relError)
+        : _jacobian(jacobian), _stats(stats), _lu(&stats), _absError(absError), _relError(relError),
+        _started(false), _order(1), _equalSteps(0), _h(0), _t(0),
+        _jacobianValid(false), _jacobianTime(0), _jacobianAge(0), _luValid(false) {
+            _gamma[0] = 0;
+
+            for (size_t k = 1; k <= MAX_ORDER + 1; k++) {
+                _gamma[k] = _gamma[k - 1] + 1. / k;
+            }
+
+            for (size_t k = 0; k <= MAX_ORDER + 1; k++) {
+                _errorConstant[k] = 1. / (k + 1);
+            }
+        }
+
+        template <class System>
+        boost::numeric::odeint::controlled_step_result try_step(System system,
+                DVec& x, const DVec& dxdt, double& t, double& dt) {
+
+            using namespace boost::numeric::odeint;
+
+            const size_t n = x.size();
+
+            if (!_started || t != _t || x != _D[0]) {
+                restart(x, dxdt, t, dt);
+            } else if (dt != _h) {
+                rescale(dt / _h);
+            }
+
+            const size_t k = _order;
+            const double tNew = t + _h;
+            const double c = _h / _gamma[k];
+
+            _predicted = _D[0];
+            _psi.assign(n, 0);
+
+            for (size_t j = 1; j <= k; j++) {
+                for (size_t i = 0; i < n; i++) {
+                    _predicted[i] += _D[j][i];
+                    _psi[i] += _gamma[j] * _D[j][i];
+                }
+            }
+
+            _scale.resize(n);
+
+            for (size_t i = 0; i < n; i++) {
+                _psi[i] /= _gamma[k];
+                _scale[i] = _absError + _relError * std::fabs(_predicted[i]);
+            }
+
+            size_t iterations = 0;
+            bool converged = false;
+
+            while (true) {
+                if (!_luValid) {
+                    if (!_jacobianValid || _jacobianAge >= MAX_JACOBIAN_AGE) {
+                        evaluateJacobian(x, dxdt, t);
+                    }
+
+                    if (!factor(n, c)) {
+                        rescale(0.5);
+                        dt = _h;
+                        return fail;
+                    }
+                }
+
+                converged = newton(system, tNew, c, iterations);
+
+                if (converged || _jacobianTime == t) {
+                    break;
+                }
+
+                // a fresh Jacobian before reducing the step
+                evaluateJacobian(x, dxdt, t);
+                _luValid = false;
+            }
+
+            if (!converged) {
+                IN_TRACE_INSTANT("newton failure", _h);
+                rescale(0.5);
+                dt = _h;
+                return fail;
+            }
+
+            const double safety = 0.9 * (2 * MAX_NEWTON + 1) / (2 * MAX_NEWTON + iterations);
+
+            for (size_t i = 0; i < n; i++) {
+                _scale[i] = _absError + _relError * std::fabs(_y[i]);
+            }
+
+            const double err = _errorConstant[k] * norm(_d);
+
+            if (err > 1) {
+                rescale(std::max(0.2, safety * std::pow(err, -1. / (k + 1))));
+                dt = _h;
+                return fail;
+            }
+
+            // update the differences to the new point
+            for (size_t i = 0; i < n; i++) {
+                _D[k + 2][i] = _d[i] - _D[k + 1][i];
+                _D[k + 1][i] = _d[i];
+            }
+
+            for (size_t j = k + 1; j-- > 0;) {
+                for (size_t i = 0; i < n; i++) {
+                    _D[j][i] += _D[j + 1][i];
+                }
+            }
+
+            _equalSteps++;
+            _jacobianAge++;
+            _t = tNew;
+
+            x = _D[0];
+            t = tNew;
+
+            if (_equalSteps > k) {
+                // error estimates at orders k - 1, k and k + 1
+                double errors[3] = {
+                    k > 1 ? _errorConstant[k - 1] * norm(_D[k]) : HUGE_VAL,
+                    err,
+                    k < MAX_ORDER ? _errorConstant[k + 1] * norm(_D[k + 2]) : HUGE_VAL
+                };
+
+                double factors[3];
+
+                for (size_t j = 0; j < 3; j++) {
+                    factors[j] = errors[j] > 0 ? std::pow(errors[j], -1. / (k + j)) : HUGE_VAL;
+                }
+
+                // largest step, the current order wins a tie
+                size_t best = 1;
+
+                for (size_t j = 0; j < 3; j++) {
+                    if (factors[j] > factors[best]) {
+                        best = j;
+                    }
+                }
+
+                const double factor = std::min(10., safety * factors[best]);
+
+                if (best != 1 || factor >= 1.2 || factor < 1) {
+                    _order = k + best - 1;
+                    rescale(factor);
+                }
+            }
+
+            dt = _h;
+            return success;
+        }
+
+    private:
+
+        static const size_t MAX_ORDER = 5;
+        static const size_t MAX_NEWTON = 4;
+        static const size_t MAX_JACOBIAN_AGE = 50;
+
+        void restart(const DVec& x, const DVec& dxdt, double t, double dt) {
+            const size_t n = x.size();
+
+            _D.assign(MAX_ORDER + 3, DVec(n, 0));
+            _D[0] = x;
+
+            for (size_t i = 0; i < n; i++) {
+                _D[1][i] = dt * dxdt[i];
+            }
+
+            _started = true;
+            _order = 1;
+            _equalSteps = 0;
+            _h = dt;
+            _t = t;
+            _luValid = false;
+        }
+
+        /**
+         * (order + 1) x (order + 1) matrix that maps the differences for
+         * the step h to the ones for factor h.
+         */
+        void differenceMap(double factor, double* R) const {
+            const size_t m = _order + 1;
+
+            for (size_t j = 0; j < m; j++) {
+                R[j] = 1;
+            }
+
+            for (size_t i = 1; i < m; i++) {
+                for (size_t j = 0; j < m; j++) {
+                    R[i * m + j] = R[(i - 1) * m + j] * (j > 0 ? (i - 1 - factor * j) / i : 0.);
+                }
+            }
+        }
+
+        /**
+         * Changes the step to factor h.
+         */
+        void rescale(double factor) {
+            const size_t m = _order + 1;
+            const size_t n = _D[0].size();
+
+            double R[(MAX_ORDER + 1) * (MAX_ORDER + 1)];
+            double U[(MAX_ORDER + 1) * (MAX_ORDER + 1)];
+            double RU[(MAX_ORDER + 1) * (MAX_ORDER + 1)];
+
+            differenceMap(factor, R);
+            differenceMap(1, U);
+
+            for (size_t i = 0; i < m; i++) {
+                for (size_t j = 0; j < m; j++) {
+                    double sum = 0;
+
+                    for (size_t l = 0; l < m; l++) {
+                        sum += R[i * m + l] * U[l * m + j];
+                    }
+
+                    RU[i * m + j] = sum;
+                }
+            }
+
+            _scaled.assign(m, DVec(n, 0));
+
+            for (size_t j = 0; j < m; j++) {
+                for (size_t l = 0; l < m; l++) {
+                    const double r = RU[l * m + j];
+
+                    if (r != 0) {
+                        for (size_t i = 0; i < n; i++) {
+                            _scaled[j][i] += r * _D[l][i];
+                        }
+                    }
+                }
+            }
+
+            for (size_t j = 0; j < m; j++) {
+                _D[j].swap(_scaled[j]);
+            }
+
+            _h *= factor;
+            _equalSteps = 0;
+            _luValid = false;
+        }
+
+        void evaluateJacobian(const DVec& x, const DVec& dxdt, double t) {
+            _jacobian.values(x, dxdt, t, _J);
+            _jacobianValid = true;
+            _jacobianTime = t;
+            _jacobianAge = 0;
+        }
+
+        /**
+         * Factors I - c J.
+         */
+        bool factor(size_t n, double c) {
+            const JacobianStructure& structure = _jacobian.structure(n);
+            const std::vector<size_t>& diagonal = structure.getDiagonal();
+
+            _W.resize(_J.size());
+
+            for (size_t i = 0; i < _J.size(); i++) {
+                _W[i] = -c * _J[i];
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                _W[diagonal[i]] += 1;
+            }
+
+            _luValid = _lu.factor(structure, _W);
+            return _luValid;
+        }
+
+        /**
+         * Solves d = c f(t, predicted + d) - psi into _y = predicted + d
+         * and _d.
+         */
+        template <class System>
+        bool newton(System& system, double t, double c, size_t& iterations) {
+            const size_t n = _predicted.size();
+            const double tolerance = std::max(10 * DBL_EPSILON / _relError, std::min(0.03, std::sqrt(_relError)));
+
+            _y = _predicted;
+            _d.assign(n, 0);
+            _f.resize(n);
+            _delta.resize(n);
+
+            double previous = 0;
+
+            for (size_t it = 0; it < MAX_NEWTON; it++) {
+                iterations++;
+                _stats.newtonIterations++;
+
+                system(_y, _f, t);
+
+                for (size_t i = 0; i < n; i++) {
+                    _delta[i] = c * _f[i] - _psi[i] - _d[i];
+                }
+
+                _lu.solve(_delta.data());
+
+                const double size = norm(_delta);
+
+                if (!std::isfinite(size)) {
+                    return false;
+                }
+
+                const double rate = it > 0 ? size / previous : 0;
+
+                if (it > 0 && (rate >= 1 || std::pow(rate, (double) (MAX_NEWTON - it)) / (1 - rate) * size > tolerance)) {
+                    return false;
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                    _y[i] += _delta[i];
+                    _d[i] += _delta[i];
+                }
+
+                if (size == 0 || (it > 0 && rate / (1 - rate) * size < tolerance)) {
+                    return true;
+                }
+
+                previous = size;
+            }
+
+            return false;
+        }
+
+        /**
+         * Weighted RMS norm with the weights in _scale.
+         */
+        double norm(const DVec& v) const {
+            double sum = 0;
+
+            for (size_t i = 0; i < v.size(); i++) {
+                sum += (v[i] / _scale[i]) * (v[i] / _scale[i]);
+            }
+
+            return v.empty() ? 0 : std::sqrt(sum / v.size());
+        }
+
+        _Jacobian& _jacobian;
+        SolveStats& _stats;
+        StructuredLU _lu;
+        double _absError;
+        double _relError;
+
+        double _gamma[MAX_ORDER + 2];
+        double _errorConstant[MAX_ORDER + 2];
+
+        bool _started;
+        size_t _order;
+        // accepted steps since the last change of step size or order
+        size_t _equalSteps;
+        double _h;
+        // time of _D[0]
+        double _t;
+
+        bool _jacobianValid;
+        double _jacobianTime;
+        size_t _jacobianAge;
+        bool _luValid;
+
+        // backward differences of the solution, _D[0] the last point
+        std::vector<DVec> _D;
+        std::vector<DVec> _scaled;
+        DVec _predicted;
+        DVec _psi;
+        DVec _scale;
+        DVec _y;
+        DVec _d;
+        DVec _f;
+        DVec _delta;
+        DVec _J;
+        DVec _W;
+    };
+
+}
+
+#endif	/* BDF_H */
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "Checkpoint.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace iNumerics {
+
+    static const char _MAGIC[8] = {'I', 'N', 'C', 'H', 'K', 'P', 'T', 0};
+    static const uint32_t _VERSION = 1;
+
+    static uint64_t _fnv1a(const std::vector<char>& data, size_t n) {
+        uint64_t h = 14695981039346656037ULL;
+
+        for (size_t i = 0; i < n; i++) {
+            h ^= (unsigned char) data[i];
+            h *= 1099511628211ULL;
+        }
+
+        return h;
+    }
+
+    // makes a rename() into the directory of path durable
+    static int _syncDirectory(const std::string& path) {
+        size_t slash = path.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+
+        if (fd < 0) {
+            return errno;
+        }
+
+        // some file systems do not support fsync() on directories
+        int error = fsync(fd) != 0 && errno != EINVAL ? errno : 0;
+
+        if (close(fd) != 0 && error == 0) {
+            error = errno;
+        }
+
+        return error;
+    }
+
+    template <class T>
+    static void _put(std::vector<char>& out, T value) {
+        const char* p = reinterpret_cast<const char*> (&value);
+        out.insert(out.end(), p, p + sizeof (T));
+    }
+
+    template <class T>
+    static T _get(const std::vector<char>& in, size_t& pos) {
+        T value;
+
+        if (pos + sizeof (T) > in.size()) {
+            throw std::runtime_error("Checkpoint: file is truncated");
+        }
+
+        memcpy(&value, &in[pos], sizeof (T));
+        pos += sizeof (T);
+
+        return value;
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::Checkpoint                                         *
+     *                                                                            *
+     ******************************************************************************/
+
+    Checkpoint::Checkpoint() : t(0), dt(0), trajectorySize(0) {
+    }
+
+    void Checkpoint::write(const std::string& path) const {
+        std::vector<char> data(_MAGIC, _MAGIC + 8);
+
+        _put<uint32_t>(data, _VERSION);
+        _put<uint32_t>(data, (uint32_t) x.size());
+        _put<double>(data, t);
+        _put<double>(data, dt);
+        _put<uint64_t>(data, trajectorySize);
+        _put<uint64_t>(data, stats.acceptedSteps);
+        _put<uint64_t>(data, stats.rejectedSteps);
+        _put<uint64_t>(data, stats.rhsCalls);
+        _put<double>(data, stats.minStep);
+        _put<double>(data, stats.maxStep);
+        _put<double>(data, stats.stepSum);
+
+        for (size_t i = 0; i < x.size(); i++) {
+            _put<double>(data, x[i]);
+        }
+
+        _put<uint64_t>(data, _fnv1a(data, data.size()));
+
+        std::string tmp = path + ".tmp";
+
+        int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0) {
+            throw std::runtime_error("Checkpoint: cannot open \"" + tmp + "\": " + strerror(errno));
+        }
+
+        size_t done = 0;
+
+        while (done < data.size()) {
+            ssize_t w = ::write(fd, &data[done], data.size() - done);
+
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (w < 0) {
+                std::string msg = strerror(errno);
+                close(fd);
+                throw std::runtime_error("Checkpoint: cannot write \"" + tmp + "\": " + msg);
+            }
+
+            done += (size_t) w;
+        }
+
+        // the data has to be on disk before the rename makes it visible;
+        // the descriptor is closed in any case, the first error is reported
+        int error = fsync(fd) != 0 ? errno : 0;
+
+        if (close(fd) != 0 && error == 0) {
+            error = errno;
+        }
+
+        if (error == 0 && rename(tmp.c_str(), path.c_str()) != 0) {
+            error = errno;
+        }
+
+        if (error == 0) {
+            error = _syncDirectory(path);
+        }
+
+        if (error != 0) {
+            throw std::runtime_error("Checkpoint: cannot store \"" + path + "\": " + strerror(error));
+        }
+    }
+
+    Checkpoint Checkpoint::read(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "rb");
+
+        if (file == NULL) {
+            throw std::runtime_error("Checkpoint: cannot open \"" + path + "\": " + strerror(errno));
+        }
+
+        std::vector<char> data;
+        char buffer[4096];
+        size_t n;
+
+        while ((n = fread(buffer, 1, sizeof (buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + n);
+        }
+
+        fclose(file);
+
+        if (data.size() < 16 || memcmp(&data[0], _MAGIC, 8) != 0) {
+            throw std::runtime_error("Checkpoint: \"" + path + "\" is not a checkpoint");
+        }
+
+        size_t pos = 8;
+
+        if (_get<uint32_t>(data, pos) != _VERSION) {
+            throw std::runtime_error("Checkpoint: \"" + path + "\" has unsupported version");
+        }
+
+        Checkpoint c;
+
+        size_t dimension = _get<uint32_t>(data, pos);
+        c.t = _get<double>(data, pos);
+        c.dt = _get<double>(data, pos);
+        c.trajectorySize = _get<uint64_t>(data, pos);
+        c.stats.acceptedSteps = _get<uint64_t>(data, pos);
+        c.stats.rejectedSteps = _get<uint64_t>(data, pos);
+        c.stats.rhsCalls = _get<uint64_t>(data, pos);
+        c.stats.minStep = _get<double>(data, pos);
+        c.stats.maxStep = _get<double>(data, pos);
+        c.stats.stepSum = _get<double>(data, pos);
+
+        c.x.resize(dimension);
+
+        for (size_t i = 0; i < dimension; i++) {
+            c.x[i] = _get<double>(data, pos);
+        }
+
+        size_t payload = pos;
+
+        if (_get<uint64_t>(data, pos) != _fnv1a(data, payload)) {
+            throw std::runtime_error("Checkpoint: \"" + path + "\" is corrupt");
+        }
+
+        return c;
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::CheckpointWriter                                   *
+     *                                                                            *
+     ******************************************************************************/
+
+    CheckpointWriter::CheckpointWriter(const std::string& path, double interval)
+    : _path(path), _interval((inULong) (interval * 1.e9)), _hasQueued(false), _stop(false),
+    _written(0) {
+        _next = MonotonicClock::now() + _interval;
+        _writer = std::thread(&CheckpointWriter::writerLoop, this);
+    }
+
+    CheckpointWriter::~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wake.notify_one();
+        _writer.join();
+    }
+
+    void CheckpointWriter::offer(const Checkpoint& checkpoint) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queued = checkpoint;
+            _hasQueued = true;
+        }
+
+        _next = MonotonicClock::now() + _interval;
+        _wake.notify_one();
+    }
+
+    void CheckpointWriter::writerLoop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;) {
+            while (!_hasQueued && !_stop) {
+                _wake.wait(lock);
+            }
+
+            if (!_hasQueued) {
+                break;
+            }
+
+            Checkpoint checkpoint = _queued;
+            _hasQueued = false;
+
+            lock.unlock();
+
+            bool ok = true;
+
+            try {
+                checkpoint.write(_path);
+            } catch (const std::exception& e) {
+                // there is nobody to throw to, the solve goes on
+                std::cerr << "CheckpointWriter: " << e.what() << std::endl;
+                ok = false;
+            }
+
+            lock.lock();
+
+            if (ok) {
+                _written++;
+            }
+        }
+    }
+
+    size_t CheckpointWriter::getWritten() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _written;
+    }
+
+}
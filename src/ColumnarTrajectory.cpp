@@ -0,0 +1,488 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "ColumnarTrajectory.h"
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace iNumerics {
+
+    static const char _MAGIC[8] = {'I', 'N', 'C', 'O', 'L', 'T', 'R', 'J'};
+    static const uint32_t _VERSION = 1;
+
+    struct _ColumnarHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t dimension;
+        uint64_t chunkSize;
+        uint64_t records;
+        uint64_t chunks;
+        uint64_t indexOffset;
+        uint64_t reserved[2];
+    };
+
+    static const size_t _HEADER_SIZE = 64;
+
+    static_assert(sizeof (_ColumnarHeader) == _HEADER_SIZE, "unexpected header padding");
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::ColumnarTrajectoryWriter                           *
+     *                                                                            *
+     ******************************************************************************/
+
+    ColumnarTrajectoryWriter::ColumnarTrajectoryWriter(const std::string& path, size_t chunkSize)
+    : _path(path), _fd(-1), _chunkSize(chunkSize > 0 ? chunkSize : 1), _dimension(0),
+    _records(0), _chunks(0), _fill(0) {
+
+        _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (_fd < 0) {
+            throw std::runtime_error("ColumnarTrajectoryWriter: cannot open \"" + path + "\": " + strerror(errno));
+        }
+    }
+
+    ColumnarTrajectoryWriter::~ColumnarTrajectoryWriter() {
+        try {
+            close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    void ColumnarTrajectoryWriter::writeAt(const void* data, size_t n, size_t offset) {
+        const char* p = static_cast<const char*> (data);
+
+        while (n > 0) {
+            ssize_t w = pwrite(_fd, p, n, (off_t) offset);
+
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("ColumnarTrajectoryWriter: cannot write \"" + _path + "\": " + strerror(errno));
+            }
+
+            p += w;
+            n -= (size_t) w;
+            offset += (size_t) w;
+        }
+    }
+
+    void ColumnarTrajectoryWriter::append(const DVec& x, double t) {
+        if (_fd < 0) {
+            throw std::logic_error("ColumnarTrajectoryWriter: append() after close()");
+        }
+
+        if (_records == 0) {
+            _dimension = x.size();
+            _chunk.assign(_chunkSize * (_dimension + 1), 0.0);
+        } else if (x.size() != _dimension) {
+            throw std::invalid_argument("ColumnarTrajectoryWriter: state dimension changed");
+        }
+
+        _chunk[_fill] = t;
+
+        for (size_t c = 0; c < _dimension; c++) {
+            _chunk[(c + 1) * _chunkSize + _fill] = x[c];
+        }
+
+        _fill++;
+        _records++;
+
+        if (_fill == _chunkSize) {
+            writeChunk();
+        }
+    }
+
+    void ColumnarTrajectoryWriter::append(const Trajectory& trajectory) {
+        for (size_t i = 0; i < trajectory.size(); i++) {
+            append(trajectory.getState(i), trajectory.getTime(i));
+        }
+    }
+
+    void ColumnarTrajectoryWriter::writeChunk() {
+        // index entry: tMin, tMax, min[dimension], max[dimension]
+        size_t entry = _index.size();
+        _index.resize(entry + 2 + 2 * _dimension);
+
+        for (size_t col = 0; col <= _dimension; col++) {
+            const double* v = &_chunk[col * _chunkSize];
+            double lo = v[0];
+            double hi = v[0];
+
+            for (size_t i = 1; i < _fill; i++) {
+                if (v[i] < lo) lo = v[i];
+                if (v[i] > hi) hi = v[i];
+            }
+
+            if (col == 0) {
+                _index[entry] = lo;
+                _index[entry + 1] = hi;
+            } else {
+                _index[entry + 1 + col] = lo;
+                _index[entry + 1 + _dimension + col] = hi;
+            }
+        }
+
+        // padding rows of a partial chunk
+        for (size_t col = 0; col <= _dimension; col++) {
+            std::fill(_chunk.begin() + col * _chunkSize + _fill,
+                    _chunk.begin() + (col + 1) * _chunkSize, 0.0);
+        }
+
+        size_t bytes = _chunk.size() * sizeof (double);
+
+        writeAt(_chunk.data(), bytes, _HEADER_SIZE + _chunks * bytes);
+
+        _chunks++;
+        _fill = 0;
+    }
+
+    void ColumnarTrajectoryWriter::close() {
+        if (_fd < 0) {
+            return;
+        }
+
+        if (_fill > 0) {
+            writeChunk();
+        }
+
+        size_t indexOffset = _HEADER_SIZE + _chunks * _chunkSize * (_dimension + 1) * sizeof (double);
+
+        writeAt(_index.data(), _index.size() * sizeof (double), indexOffset);
+
+        _ColumnarHeader header;
+        memset(&header, 0, sizeof (header));
+        memcpy(header.magic, _MAGIC, 8);
+        header.version = _VERSION;
+        header.dimension = (uint32_t) _dimension;
+        header.chunkSize = _chunkSize;
+        header.records = _records;
+        header.chunks = _chunks;
+        header.indexOffset = indexOffset;
+
+        writeAt(&header, sizeof (header), 0);
+
+        int fd = _fd;
+        _fd = -1;
+
+        if (::close(fd) != 0) {
+            throw std::runtime_error("ColumnarTrajectoryWriter: cannot close \"" + _path + "\": " + strerror(errno));
+        }
+    }
+
+    void ColumnarTrajectoryWriter::write(const std::string& path, const Trajectory& trajectory,
+            size_t chunkSize) {
+        ColumnarTrajectoryWriter writer(path, chunkSize);
+        writer.append(trajectory);
+        writer.close();
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::MappedTrajectory                                   *
+     *                                                                            *
+     ******************************************************************************/
+
+    MappedTrajectory::MappedTrajectory(const std::string& path)
+    : _fd(-1), _base(NULL), _length(0), _dimension(0), _chunkSize(0), _records(0),
+    _chunks(0), _indexOffset(0) {
+
+        _fd = open(path.c_str(), O_RDONLY);
+
+        if (_fd < 0) {
+            throw std::runtime_error("MappedTrajectory: cannot open \"" + path + "\": " + strerror(errno));
+        }
+
+        struct stat st;
+
+        if (fstat(_fd, &st) != 0 || (size_t) st.st_size < _HEADER_SIZE) {
+            ::close(_fd);
+            throw std::runtime_error("MappedTrajectory: \"" + path + "\" is not a trajectory file");
+        }
+
+        _length = (size_t) st.st_size;
+
+        void* base = mmap(NULL, _length, PROT_READ, MAP_SHARED, _fd, 0);
+
+        if (base == MAP_FAILED) {
+            ::close(_fd);
+            throw std::runtime_error("MappedTrajectory: cannot map \"" + path + "\": " + strerror(errno));
+        }
+
+        _base = static_cast<const char*> (base);
+
+        const _ColumnarHeader* header = reinterpret_cast<const _ColumnarHeader*> (_base);
+
+        std::string error;
+
+        if (memcmp(header->magic, _MAGIC, 8) != 0) {
+            error = "is not a trajectory file";
+        } else if (header->version != _VERSION) {
+            error = "has unsupported version";
+        } else {
+            _dimension = header->dimension;
+            _chunkSize = header->chunkSize;
+            _records = header->records;
+            _chunks = header->chunks;
+            _indexOffset = header->indexOffset;
+
+            size_t chunkBytes = _chunkSize * (_dimension + 1) * sizeof (double);
+            size_t indexBytes = _chunks * (2 + 2 * _dimension) * sizeof (double);
+
+            if (_chunkSize == 0 || _records > _chunks * _chunkSize
+                    || _indexOffset != _HEADER_SIZE + _chunks * chunkBytes
+                    || _indexOffset + indexBytes > _length) {
+                error = "is truncated or corrupt";
+            }
+        }
+
+        if (!error.empty()) {
+            munmap(const_cast<char*> (_base), _length);
+            ::close(_fd);
+            throw std::runtime_error("MappedTrajectory: \"" + path + "\" " + error);
+        }
+
+        _state.resize(_dimension);
+    }
+
+    MappedTrajectory::~MappedTrajectory() {
+        munmap(const_cast<char*> (_base), _length);
+        ::close(_fd);
+    }
+
+    void MappedTrajectory::operator()(const DVec& x, const double t) {
+        throw std::logic_error("MappedTrajectory is read-only");
+    }
+
+    const double* MappedTrajectory::column(size_t chunk, size_t column) const {
+        return reinterpret_cast<const double*> (_base + _HEADER_SIZE)
+                + (chunk * (_dimension + 1) + column) * _chunkSize;
+    }
+
+    const double* MappedTrajectory::indexEntry(size_t chunk) const {
+        return reinterpret_cast<const double*> (_base + _indexOffset)
+                + chunk * (2 + 2 * _dimension);
+    }
+
+    double MappedTrajectory::getTime(std::size_t i) const {
+        return column(i / _chunkSize, 0)[i % _chunkSize];
+    }
+
+    double MappedTrajectory::getState(std::size_t i, size_t component) const {
+        return column(i / _chunkSize, component + 1)[i % _chunkSize];
+    }
+
+    void MappedTrajectory::getState(std::size_t i, DVec& out) const {
+        size_t chunk = i / _chunkSize;
+        size_t row = i % _chunkSize;
+
+        out.resize(_dimension);
+
+        for (size_t c = 0; c < _dimension; c++) {
+            out[c] = column(chunk, c + 1)[row];
+        }
+    }
+
+    const DVec& MappedTrajectory::getState(std::size_t i) const {
+        getState(i, _state);
+        return _state;
+    }
+
+    size_t MappedTrajectory::size() const {
+        return _records;
+    }
+
+    size_t MappedTrajectory::getDimension() const {
+        return _dimension;
+    }
+
+    size_t MappedTrajectory::getChunkSize() const {
+        return _chunkSize;
+    }
+
+    size_t MappedTrajectory::getChunkCount() const {
+        return _chunks;
+    }
+
+    ColumnSpan MappedTrajectory::getTimeSpan(size_t chunk) const {
+        size_t rows = std::min(_chunkSize, _records - chunk * _chunkSize);
+        return ColumnSpan(column(chunk, 0), rows);
+    }
+
+    ColumnSpan MappedTrajectory::getComponentSpan(size_t chunk, size_t component) const {
+        size_t rows = std::min(_chunkSize, _records - chunk * _chunkSize);
+        return ColumnSpan(column(chunk, component + 1), rows);
+    }
+
+    double MappedTrajectory::getChunkMinTime(size_t chunk) const {
+        return indexEntry(chunk)[0];
+    }
+
+    double MappedTrajectory::getChunkMaxTime(size_t chunk) const {
+        return indexEntry(chunk)[1];
+    }
+
+    double MappedTrajectory::getChunkMin(size_t chunk, size_t component) const {
+        return indexEntry(chunk)[2 + component];
+    }
+
+    double MappedTrajectory::getChunkMax(size_t chunk, size_t component) const {
+        return indexEntry(chunk)[2 + _dimension + component];
+    }
+
+    size_t MappedTrajectory::findChunk(double t) const {
+        size_t lo = 0;
+        size_t hi = _chunks;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (getChunkMaxTime(mid) < t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return lo;
+    }
+
+    double MappedTrajectory::getMinTime() const {
+        if (_chunks == 0) {
+            return 0;
+        }
+
+        double result = getChunkMinTime(0);
+
+        for (size_t c = 1; c < _chunks; c++) {
+            result = std::min(result, getChunkMinTime(c));
+        }
+
+        return result;
+    }
+
+    double MappedTrajectory::getMaxTime() const {
+        if (_chunks == 0) {
+            return 0;
+        }
+
+        double result = getChunkMaxTime(0);
+
+        for (size_t c = 1; c < _chunks; c++) {
+            result = std::max(result, getChunkMaxTime(c));
+        }
+
+        return result;
+    }
+
+    double MappedTrajectory::getMinState(size_t i) const {
+        if (_chunks == 0) {
+            return 0;
+        }
+
+        double result = getChunkMin(0, i);
+
+        for (size_t c = 1; c < _chunks; c++) {
+            result = std::min(result, getChunkMin(c, i));
+        }
+
+        return result;
+    }
+
+    double MappedTrajectory::getMaxState(size_t i) const {
+        if (_chunks == 0) {
+            return 0;
+        }
+
+        double result = getChunkMax(0, i);
+
+        for (size_t c = 1; c < _chunks; c++) {
+            result = std::max(result, getChunkMax(c, i));
+        }
+
+        return result;
+    }
+
+    StateSummary MappedTrajectory::getStateSummary(size_t i, double t0, double t1) const {
+        StateSummary s = {0, 0, 0, 0};
+
+        for (size_t c = findChunk(t0); c < _chunks && getChunkMinTime(c) <= t1; c++) {
+            ColumnSpan times = getTimeSpan(c);
+            ColumnSpan values = getComponentSpan(c, i);
+
+            if (getChunkMinTime(c) >= t0 && getChunkMaxTime(c) <= t1) {
+                double lo = getChunkMin(c, i);
+                double hi = getChunkMax(c, i);
+                double sum = 0;
+
+                for (size_t j = 0; j < values.size; j++) {
+                    sum += values[j];
+                }
+
+                if (s.count == 0 || lo < s.min) s.min = lo;
+                if (s.count == 0 || hi > s.max) s.max = hi;
+                s.mean += sum;
+                s.count += values.size;
+                continue;
+            }
+
+            for (size_t j = 0; j < values.size; j++) {
+                if (times[j] < t0 || times[j] > t1) {
+                    continue;
+                }
+
+                double v = values[j];
+
+                if (s.count == 0 || v < s.min) s.min = v;
+                if (s.count == 0 || v > s.max) s.max = v;
+                s.mean += v;
+                s.count++;
+            }
+        }
+
+        if (s.count > 0) {
+            s.mean /= s.count;
+        }
+
+        return s;
+    }
+
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "CompressedTrajectory.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+#include "inxorcodec.h"
+
+namespace iNumerics {
+
+    CompressedTrajectory::CompressedTrajectory(size_t chunkSize)
+    : _chunkSize(chunkSize > 0 ? chunkSize : 1), _dimension(0), _size(0), _openRows(0),
+    _minTime(0), _maxTime(0) {
+        for (size_t s = 0; s < CACHE_SLOTS; s++) {
+            _cachedChunk[s] = (size_t) - 1;
+        }
+    }
+
+    CompressedTrajectory::~CompressedTrajectory() {
+    }
+
+    void CompressedTrajectory::operator()(const DVec& x, const double t) {
+        if (_size == 0) {
+            _dimension = x.size();
+            _open.assign(_chunkSize * (_dimension + 1), 0.0);
+            _state.resize(_dimension);
+
+            _minTime = _maxTime = t;
+            _minState = _maxState = x;
+        } else if (x.size() != _dimension) {
+            throw std::invalid_argument("CompressedTrajectory: state dimension changed");
+        }
+
+        if (t < _minTime) _minTime = t;
+        if (t > _maxTime) _maxTime = t;
+
+        _open[_openRows] = t;
+
+        for (size_t c = 0; c < _dimension; c++) {
+            _open[(c + 1) * _chunkSize + _openRows] = x[c];
+
+            if (x[c] < _minState[c]) _minState[c] = x[c];
+            if (x[c] > _maxState[c]) _maxState[c] = x[c];
+        }
+
+        _openRows++;
+        _size++;
+
+        if (_openRows == _chunkSize) {
+            sealChunk();
+        }
+    }
+
+    void CompressedTrajectory::sealChunk() {
+        _chunks.push_back(Chunk());
+        Chunk& chunk = _chunks.back();
+
+        chunk.offsets.resize(_dimension + 1);
+        chunk.summary.resize(3 * _dimension);
+
+        for (size_t col = 0; col <= _dimension; col++) {
+            const double* v = &_open[col * _chunkSize];
+
+            chunk.offsets[col] = chunk.data.size();
+            XorCodec::encode(v, _openRows, chunk.data);
+
+            double lo = v[0];
+            double hi = v[0];
+            double sum = 0;
+
+            for (size_t i = 0; i < _openRows; i++) {
+                lo = std::min(lo, v[i]);
+                hi = std::max(hi, v[i]);
+                sum += v[i];
+            }
+
+            if (col == 0) {
+                chunk.minTime = lo;
+                chunk.maxTime = hi;
+            } else {
+                chunk.summary[3 * (col - 1)] = lo;
+                chunk.summary[3 * (col - 1) + 1] = hi;
+                chunk.summary[3 * (col - 1) + 2] = sum;
+            }
+        }
+
+        std::vector<unsigned char>(chunk.data).swap(chunk.data);
+
+        _openRows = 0;
+    }
+
+    size_t CompressedTrajectory::chunkRows(size_t chunk) const {
+        return chunk < _chunks.size() ? _chunkSize : _openRows;
+    }
+
+    size_t CompressedTrajectory::decodeColumn(size_t chunk, size_t column, double* out) const {
+        size_t rows = chunkRows(chunk);
+
+        if (chunk < _chunks.size()) {
+            const Chunk& c = _chunks[chunk];
+            XorCodec::decode(&c.data[c.offsets[column]], rows, out);
+        } else {
+            std::copy(&_open[column * _chunkSize], &_open[column * _chunkSize] + rows, out);
+        }
+
+        return rows;
+    }
+
+    const double* CompressedTrajectory::chunkColumns(size_t chunk) const {
+        if (chunk == _chunks.size()) {
+            return _open.data();
+        }
+
+        size_t slot = chunk % CACHE_SLOTS;
+
+        if (_cachedChunk[slot] != chunk) {
+            _cache[slot].resize(_chunkSize * (_dimension + 1));
+
+            for (size_t col = 0; col <= _dimension; col++) {
+                decodeColumn(chunk, col, &_cache[slot][col * _chunkSize]);
+            }
+
+            _cachedChunk[slot] = chunk;
+        }
+
+        return _cache[slot].data();
+    }
+
+    double CompressedTrajectory::getTime(std::size_t i) const {
+        return chunkColumns(i / _chunkSize)[i % _chunkSize];
+    }
+
+    const DVec& CompressedTrajectory::getState(std::size_t i) const {
+        const double* columns = chunkColumns(i / _chunkSize);
+        size_t row = i % _chunkSize;
+
+        for (size_t c = 0; c < _dimension; c++) {
+            _state[c] = columns[(c + 1) * _chunkSize + row];
+        }
+
+        return _state;
+    }
+
+    size_t CompressedTrajectory::size() const {
+        return _size;
+    }
+
+    double CompressedTrajectory::getMinTime() const {
+        return _minTime;
+    }
+
+    double CompressedTrajectory::getMaxTime() const {
+        return _maxTime;
+    }
+
+    double CompressedTrajectory::getMinState(size_t i) const {
+        return _size > 0 ? _minState[i] : 0;
+    }
+
+    double CompressedTrajectory::getMaxState(size_t i) const {
+        return _size > 0 ? _maxState[i] : 0;
+    }
+
+    StateSummary CompressedTrajectory::getStateSummary(size_t i, double t0, double t1) const {
+        StateSummary s = {0, 0, 0, 0};
+
+        // first sealed chunk that may contain t0
+        size_t lo = 0;
+        size_t hi = _chunks.size();
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (_chunks[mid].maxTime < t0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        for (size_t c = lo; c <= _chunks.size(); c++) {
+            size_t rows = chunkRows(c);
+
+            if (c < _chunks.size()) {
+                const Chunk& chunk = _chunks[c];
+
+                if (chunk.minTime > t1) {
+                    break;
+                }
+
+                if (chunk.minTime >= t0 && chunk.maxTime <= t1) {
+                    const double* v = &chunk.summary[3 * i];
+
+                    if (s.count == 0 || v[0] < s.min) s.min = v[0];
+                    if (s.count == 0 || v[1] > s.max) s.max = v[1];
+                    s.mean += v[2];
+                    s.count += rows;
+                    continue;
+                }
+            }
+
+            const double* columns = chunkColumns(c);
+            const double* times = columns;
+            const double* values = columns + (i + 1) * _chunkSize;
+
+            for (size_t j = 0; j < rows; j++) {
+                if (times[j] < t0 || times[j] > t1) {
+                    continue;
+                }
+
+                if (s.count == 0 || values[j] < s.min) s.min = values[j];
+                if (s.count == 0 || values[j] > s.max) s.max = values[j];
+                s.mean += values[j];
+                s.count++;
+            }
+        }
+
+        if (s.count > 0) {
+            s.mean /= s.count;
+        }
+
+        return s;
+    }
+
+    size_t CompressedTrajectory::getDimension() const {
+        return _dimension;
+    }
+
+    size_t CompressedTrajectory::getChunkSize() const {
+        return _chunkSize;
+    }
+
+    size_t CompressedTrajectory::getChunkCount() const {
+        return _chunks.size() + (_openRows > 0 ? 1 : 0);
+    }
+
+    size_t CompressedTrajectory::getCompressedBytes() const {
+        size_t bytes = 0;
+
+        for (size_t c = 0; c < _chunks.size(); c++) {
+            bytes += _chunks[c].data.size();
+        }
+
+        return bytes;
+    }
+
+    double CompressedTrajectory::getCompressionRatio() const {
+        size_t bytes = getCompressedBytes();
+
+        if (bytes == 0) {
+            return 1;
+        }
+
+        return (double) (_chunks.size() * _chunkSize * (_dimension + 1) * sizeof (double)) / bytes;
+    }
+
+}
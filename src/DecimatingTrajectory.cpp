@@ -0,0 +1,226 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "DecimatingTrajectory.h"
+
+#include <cmath>
+#include <limits>
+
+#include "Interpolation.h"
+
+namespace iNumerics {
+
+    DecimatingTrajectory::DecimatingTrajectory(Trajectory& target, double tolerance)
+    : _target(target), _tolerance(tolerance), _problem(NULL), _maxWindow(0),
+    _inputs(0), _retained(0), _anchorT(0), _hasPending(false), _pendingT(0), _windowSize(0) {
+    }
+
+    DecimatingTrajectory::DecimatingTrajectory(Trajectory& target, double tolerance,
+            Problem& problem, size_t maxWindow)
+    : _target(target), _tolerance(tolerance), _problem(&problem), _maxWindow(maxWindow),
+    _inputs(0), _retained(0), _anchorT(0), _hasPending(false), _pendingT(0), _windowSize(0) {
+    }
+
+    DecimatingTrajectory::~DecimatingTrajectory() {
+    }
+
+    void DecimatingTrajectory::operator()(const DVec& x, const double t) {
+        _inputs++;
+
+        DVec f;
+
+        if (_problem != NULL) {
+            f.resize(x.size());
+            (*_problem)(x, f, t);
+        }
+
+        if (_inputs == 1) {
+            _anchorF = f;
+            retain(x, t);
+            return;
+        }
+
+        if (!_hasPending) {
+            _pendingT = t;
+            _pendingX = x;
+            _pendingF = f;
+            _hasPending = true;
+            return;
+        }
+
+        bool accepted = _problem == NULL
+                ? acceptsLinear(x, t)
+                : _windowSize < _maxWindow && acceptsHermite(x, f, t);
+
+        if (accepted) {
+            // the pending step is dropped
+            if (_problem == NULL) {
+                constrainLinear(_pendingX, _pendingT);
+            } else {
+                if (_windowX.size() == _windowSize) {
+                    _windowX.push_back(DVec());
+                    _windowT.push_back(0);
+                }
+
+                _windowT[_windowSize] = _pendingT;
+                _windowX[_windowSize] = _pendingX;
+                _windowSize++;
+            }
+        } else {
+            retainPending();
+        }
+
+        _pendingT = t;
+        _pendingX = x;
+        _pendingF.swap(f);
+        _hasPending = true;
+    }
+
+    bool DecimatingTrajectory::acceptsLinear(const DVec& x, double t) const {
+        double dt = t - _anchorT;
+        double dp = _pendingT - _anchorT;
+
+        if (!(dt > 0) || !(dp > 0)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < x.size(); i++) {
+            double slope = (x[i] - _anchorX[i]) / dt;
+
+            // the pending step has to be reproduced as well
+            double low = std::max(_slopeLow[i], (_pendingX[i] - _tolerance - _anchorX[i]) / dp);
+            double high = std::min(_slopeHigh[i], (_pendingX[i] + _tolerance - _anchorX[i]) / dp);
+
+            if (!(slope >= low && slope <= high)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void DecimatingTrajectory::constrainLinear(const DVec& x, double t) {
+        double dt = t - _anchorT;
+
+        for (size_t i = 0; i < x.size(); i++) {
+            _slopeLow[i] = std::max(_slopeLow[i], (x[i] - _tolerance - _anchorX[i]) / dt);
+            _slopeHigh[i] = std::min(_slopeHigh[i], (x[i] + _tolerance - _anchorX[i]) / dt);
+        }
+    }
+
+    bool DecimatingTrajectory::acceptsHermite(const DVec& x, const DVec& f, double t) const {
+        if (!(t > _anchorT)) {
+            return false;
+        }
+
+        for (size_t k = 0; k <= _windowSize; k++) {
+            double tk = k < _windowSize ? _windowT[k] : _pendingT;
+            const DVec& xk = k < _windowSize ? _windowX[k] : _pendingX;
+
+            for (size_t i = 0; i < x.size(); i++) {
+                double p = Interpolation::hermite(_anchorT, _anchorX[i], _anchorF[i],
+                        t, x[i], f[i], tk);
+
+                if (!(std::fabs(p - xk[i]) <= _tolerance)) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void DecimatingTrajectory::retain(const DVec& x, double t) {
+        _target(x, t);
+        _retained++;
+
+        _anchorT = t;
+        _anchorX = x;
+
+        _slopeLow.assign(x.size(), -std::numeric_limits<double>::infinity());
+        _slopeHigh.assign(x.size(), std::numeric_limits<double>::infinity());
+        _windowSize = 0;
+    }
+
+    void DecimatingTrajectory::retainPending() {
+        if (!_hasPending) {
+            return;
+        }
+
+        _anchorF.swap(_pendingF);
+        retain(_pendingX, _pendingT);
+        _hasPending = false;
+    }
+
+    void DecimatingTrajectory::finish() {
+        retainPending();
+        _target.finish();
+    }
+
+    double DecimatingTrajectory::getTime(std::size_t i) const {
+        return _target.getTime(i);
+    }
+
+    const DVec& DecimatingTrajectory::getState(std::size_t i) const {
+        return _target.getState(i);
+    }
+
+    size_t DecimatingTrajectory::size() const {
+        return _target.size();
+    }
+
+    double DecimatingTrajectory::getMinTime() const {
+        return _target.getMinTime();
+    }
+
+    double DecimatingTrajectory::getMaxTime() const {
+        return _target.getMaxTime();
+    }
+
+    double DecimatingTrajectory::getMinState(size_t i) const {
+        return _target.getMinState(i);
+    }
+
+    double DecimatingTrajectory::getMaxState(size_t i) const {
+        return _target.getMaxState(i);
+    }
+
+    StateSummary DecimatingTrajectory::getStateSummary(size_t i, double t0, double t1) const {
+        return _target.getStateSummary(i, t0, t1);
+    }
+
+    size_t DecimatingTrajectory::getInputCount() const {
+        return _inputs;
+    }
+
+    size_t DecimatingTrajectory::getRetainedCount() const {
+        return _retained;
+    }
+
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "DelayHistory.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace iNumerics {
+
+    DelayHistory::DelayHistory(size_t dimension, size_t capacity)
+    : _dimension(dimension), _stride(2 + 5 * dimension), _capacity(std::max(capacity, (size_t) 1)),
+    _first(0), _count(0), _dropped(0) {
+        _data.resize(_capacity * _stride);
+    }
+
+    void DelayHistory::push(double t0, double h, const double* coefficients) {
+        if (_count == _capacity) {
+            // unroll the ring into a twice as large one
+            std::vector<double> data(2 * _capacity * _stride);
+
+            for (size_t i = 0; i < _count; i++) {
+                const double* from = segment(i);
+                std::copy(from, from + _stride, &data[i * _stride]);
+            }
+
+            _data.swap(data);
+            _capacity *= 2;
+            _first = 0;
+        }
+
+        double* slot = &_data[((_first + _count) % _capacity) * _stride];
+        slot[0] = t0;
+        slot[1] = h;
+        std::copy(coefficients, coefficients + 5 * _dimension, slot + 2);
+
+        _count++;
+    }
+
+    void DelayHistory::trim(double t) {
+        while (_count > 1) {
+            const double* s = segment(0);
+
+            if (s[0] + s[1] >= t) {
+                break;
+            }
+
+            _first = (_first + 1) % _capacity;
+            _count--;
+            _dropped++;
+        }
+    }
+
+    void DelayHistory::clear() {
+        _dropped += _count;
+        _first = 0;
+        _count = 0;
+    }
+
+    bool DelayHistory::evaluate(double t, double* y, size_t& hint) const {
+        if (_count == 0 || t < segment(0)[0]) {
+            return false;
+        }
+
+        size_t index = find(t, hint >= _dropped ? hint - _dropped : 0);
+        hint = _dropped + index;
+
+        const double* s = segment(index);
+        const size_t n = _dimension;
+        const double* r1 = s + 2;
+        const double* r2 = r1 + n;
+        const double* r3 = r2 + n;
+        const double* r4 = r3 + n;
+        const double* r5 = r4 + n;
+
+        const double theta = (t - s[0]) / s[1];
+        const double theta1 = 1 - theta;
+
+        for (size_t i = 0; i < n; i++) {
+            y[i] = r1[i] + theta * (r2[i] + theta1 * (r3[i] + theta * (r4[i] + theta1 * r5[i])));
+        }
+
+        return true;
+    }
+
+    size_t DelayHistory::find(double t, size_t hint) const {
+        size_t index = std::min(hint, _count - 1);
+
+        // short walk from the hint
+        for (int i = 0; i < 4; i++) {
+            const double* s = segment(index);
+
+            if (t < s[0] && index > 0) {
+                index--;
+            } else if (t > s[0] + s[1] && index + 1 < _count) {
+                index++;
+            } else {
+                return index;
+            }
+        }
+
+        // binary search for the last segment that starts at or before t
+        size_t lo = 0;
+        size_t hi = _count;
+
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (segment(mid)[0] <= t) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return lo;
+    }
+
+    const double* DelayHistory::segment(size_t index) const {
+        return &_data[((_first + index) % _capacity) * _stride];
+    }
+
+    double DelayHistory::getStartTime() const {
+        if (_count == 0) {
+            throw std::logic_error("DelayHistory: empty");
+        }
+
+        return segment(0)[0];
+    }
+
+    double DelayHistory::getEndTime() const {
+        if (_count == 0) {
+            throw std::logic_error("DelayHistory: empty");
+        }
+
+        const double* s = segment(_count - 1);
+
+        return s[0] + s[1];
+    }
+
+    size_t DelayHistory::size() const {
+        return _count;
+    }
+
+    size_t DelayHistory::getCapacity() const {
+        return _capacity;
+    }
+
+    size_t DelayHistory::getDimension() const {
+        return _dimension;
+    }
+
+}
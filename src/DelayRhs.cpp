@@ -0,0 +1,72 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "DelayRhs.h"
+
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    _DelayRhs::_DelayRhs(DelayModel& model, DelayHistory& history, const DVec& y0, double t0, SolveStats& stats)
+    : _model(model), _history(history), _y0(y0), _t0(t0), _stats(stats),
+    _n(y0.size()), _d(model.getDelayCount()), _hints(model.getDelayCount(), 0),
+    _delayed(y0.size() * model.getDelayCount()) {
+    }
+
+    void _DelayRhs::operator()(const DVec &y, DVec &dydt, const double t) {
+        IN_PERF_REGION(PERF_RHS);
+        IN_TRACE_BEGIN("rhs", t);
+        _stats.rhsCalls++;
+
+        for (size_t k = 0; k < _d; k++) {
+            lookup(t - _model.getDelay(k, y, t), &_delayed[k * _n], k);
+        }
+
+        _model.rhs(y, _delayed, dydt, t);
+        IN_TRACE_END("rhs");
+    }
+
+    void _DelayRhs::lookup(double s, double* y, size_t k) {
+        if (s < _t0) {
+            _h.resize(_n);
+
+            const DVec& h = _model.history(s, _h) ? _h : _y0;
+            std::copy(h.begin(), h.end(), y);
+        } else if (!_history.evaluate(s, y, _hints[k])) {
+            if (_history.size() > 0) {
+                throw std::out_of_range("ODESolver: delayed time before the retained history, DelayModel::getMaxDelay() is too small");
+            }
+
+            // first step, only for delays shorter than the step
+            std::copy(_y0.begin(), _y0.end(), y);
+        }
+    }
+
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef DELAYRHS_H
+#define	DELAYRHS_H
+
+#include <vector>
+
+#include "Types.h"
+#include "DelayModel.h"
+#include "DelayHistory.h"
+#include "SolveStats.h"
+
+namespace iNumerics {
+
+    /**
+     * Delayed rhs of a DelayModel: y(t - tau_k) comes from the initial
+     * history before t0 and from the solution history after it.
+     */
+    class _DelayRhs {
+    public:
+
+        _DelayRhs(DelayModel& model, DelayHistory& history, const DVec& y0, double t0, SolveStats& stats);
+
+        void operator()(const DVec &y, DVec &dydt, const double t);
+
+    private:
+
+        void lookup(double s, double* y, size_t k);
+
+        DelayModel& _model;
+        DelayHistory& _history;
+        const DVec& _y0;
+        double _t0;
+        SolveStats& _stats;
+        size_t _n;
+        size_t _d;
+        std::vector<size_t> _hints;
+        DVec _delayed;
+        DVec _h;
+    };
+
+}
+
+#endif	/* DELAYRHS_H */
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "DenseLU.h"
+
+#include <stdexcept>
+
+#include "intypes.h"
+#include "inblaswrapper.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    DenseLU::DenseLU(SolveStats* stats) : _stats(stats), _n(0) {
+    }
+
+    bool DenseLU::factor(const DVec& A, size_t n) {
+        IN_PERF_REGION(PERF_LU);
+        IN_TRACE_INSTANT("lu", (double) n);
+
+        if (A.size() != n * n) {
+            throw std::invalid_argument("DenseLU: matrix size does not match n");
+        }
+
+        _n = n;
+        _lu = A;
+        _pivots.resize(n);
+
+        inInt m = n;
+        inInt info = 0;
+
+        if (n > 0) {
+            dgetrf_(&m, &m, &_lu[0], &m, &_pivots[0], &info);
+        }
+
+        if (_stats != NULL) {
+            _stats->luDecompositions++;
+        }
+
+        return info == 0;
+    }
+
+    void DenseLU::solve(double* b, size_t nrhs) const {
+        IN_PERF_REGION(PERF_LU);
+
+        if (_n == 0 || nrhs == 0) {
+            return;
+        }
+
+        inInt n = _n;
+        inInt k = nrhs;
+        inInt info = 0;
+        char trans = 'N';
+
+        dgetrs_(&trans, &n, &k, &_lu[0], &n, &_pivots[0], b, &n, &info);
+
+        if (_stats != NULL) {
+            _stats->luSolves += nrhs;
+        }
+    }
+
+    void DenseLU::solve(DVec& b) const {
+        if (b.size() % (_n > 0 ? _n : 1) != 0) {
+            throw std::invalid_argument("DenseLU: right hand side size is not a multiple of n");
+        }
+
+        solve(b.data(), _n > 0 ? b.size() / _n : 0);
+    }
+
+    size_t DenseLU::size() const {
+        return _n;
+    }
+
+}
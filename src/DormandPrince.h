@@ -0,0 +1,196 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef DORMANDPRINCE_H
+#define	DORMANDPRINCE_H
+
+#include <cmath>
+#include <algorithm>
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Dormand-Prince 5(4) with the continuous extension of order 4 (Hairer,
+     * Norsett and Wanner, DOPRI5).
+     */
+    class _DormandPrince {
+    public:
+
+        _DormandPrince(double absError, double relError)
+        : _absError(absError), _relError(relError) {
+        }
+
+        /**
+         * One step of size h from (t, y) with k1 = f(t, y).
+         * @param ynew	solution at t + h
+         * @param k7	f(t + h, ynew), k1 of the next step
+         * @param dense	coefficients r1, ..., r5 of the dense output (see
+         *		DelayHistory)
+         * @return weighted RMS norm of the error estimate
+         */
+        template <class System>
+        double step(System& f, const DVec& y, const DVec& k1, double t, double h,
+                DVec& ynew, DVec& k7, DVec& dense) {
+
+            static const double c2 = 1. / 5, c3 = 3. / 10, c4 = 4. / 5, c5 = 8. / 9;
+            static const double a21 = 1. / 5;
+            static const double a31 = 3. / 40, a32 = 9. / 40;
+            static const double a41 = 44. / 45, a42 = -56. / 15, a43 = 32. / 9;
+            static const double a51 = 19372. / 6561, a52 = -25360. / 2187,
+                    a53 = 64448. / 6561, a54 = -212. / 729;
+            static const double a61 = 9017. / 3168, a62 = -355. / 33, a63 = 46732. / 5247,
+                    a64 = 49. / 176, a65 = -5103. / 18656;
+            static const double a71 = 35. / 384, a73 = 500. / 1113, a74 = 125. / 192,
+                    a75 = -2187. / 6784, a76 = 11. / 84;
+            static const double e1 = 71. / 57600, e3 = -71. / 16695, e4 = 71. / 1920,
+                    e5 = -17253. / 339200, e6 = 22. / 525, e7 = -1. / 40;
+            static const double d1 = -12715105075. / 11282082432, d3 = 87487479700. / 32700410799,
+                    d4 = -10690763975. / 1880347072, d5 = 701980252875. / 199316789632,
+                    d6 = -1453857185. / 822651844, d7 = 69997945. / 29380423;
+
+            const size_t n = y.size();
+
+            _z.resize(n);
+            _k2.resize(n);
+            _k3.resize(n);
+            _k4.resize(n);
+            _k5.resize(n);
+            _k6.resize(n);
+            ynew.resize(n);
+            k7.resize(n);
+            dense.resize(5 * n);
+
+            for (size_t i = 0; i < n; i++) {
+                _z[i] = y[i] + h * a21 * k1[i];
+            }
+
+            f(_z, _k2, t + c2 * h);
+
+            for (size_t i = 0; i < n; i++) {
+                _z[i] = y[i] + h * (a31 * k1[i] + a32 * _k2[i]);
+            }
+
+            f(_z, _k3, t + c3 * h);
+
+            for (size_t i = 0; i < n; i++) {
+                _z[i] = y[i] + h * (a41 * k1[i] + a42 * _k2[i] + a43 * _k3[i]);
+            }
+
+            f(_z, _k4, t + c4 * h);
+
+            for (size_t i = 0; i < n; i++) {
+                _z[i] = y[i] + h * (a51 * k1[i] + a52 * _k2[i] + a53 * _k3[i] + a54 * _k4[i]);
+            }
+
+            f(_z, _k5, t + c5 * h);
+
+            for (size_t i = 0; i < n; i++) {
+                _z[i] = y[i] + h * (a61 * k1[i] + a62 * _k2[i] + a63 * _k3[i] + a64 * _k4[i] + a65 * _k5[i]);
+            }
+
+            f(_z, _k6, t + h);
+
+            for (size_t i = 0; i < n; i++) {
+                ynew[i] = y[i] + h * (a71 * k1[i] + a73 * _k3[i] + a74 * _k4[i] + a75 * _k5[i] + a76 * _k6[i]);
+            }
+
+            f(ynew, k7, t + h);
+
+            double err = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                double e = h * (e1 * k1[i] + e3 * _k3[i] + e4 * _k4[i] + e5 * _k5[i] + e6 * _k6[i] + e7 * k7[i]);
+                double sk = _absError + _relError * std::max(std::fabs(y[i]), std::fabs(ynew[i]));
+                err += (e / sk) * (e / sk);
+
+                double diff = ynew[i] - y[i];
+                double b = h * k1[i] - diff;
+
+                dense[i] = y[i];
+                dense[n + i] = diff;
+                dense[2 * n + i] = b;
+                dense[3 * n + i] = diff - h * k7[i] - b;
+                dense[4 * n + i] = h * (d1 * k1[i] + d3 * _k3[i] + d4 * _k4[i] + d5 * _k5[i] + d6 * _k6[i] + d7 * k7[i]);
+            }
+
+            return n > 0 ? std::sqrt(err / n) : 0;
+        }
+
+        /**
+         * Estimate of the spectral radius of the Jacobian along the last
+         * step (Hairer & Wanner, DOPRI5): stage 6 and the solution are both
+         * taken at t + h, so the ratio of the differences of their
+         * derivatives and of their states approximates the dominant
+         * eigenvalue without extra rhs calls.
+         * @param ynew	solution of the last step
+         * @param k7	f(t + h, ynew)
+         */
+        double stiffness(const DVec& ynew, const DVec& k7) const {
+            double num = 0, den = 0;
+
+            for (size_t i = 0; i < ynew.size(); i++) {
+                num += (k7[i] - _k6[i]) * (k7[i] - _k6[i]);
+                den += (ynew[i] - _z[i]) * (ynew[i] - _z[i]);
+            }
+
+            return den > 0 ? std::sqrt(num / den) : 0;
+        }
+
+        /**
+         * Evaluates the dense output of a step of size h at t0 + theta h.
+         */
+        static void interpolate(const DVec& dense, double theta, DVec& y) {
+            const size_t n = dense.size() / 5;
+            const double theta1 = 1 - theta;
+
+            y.resize(n);
+
+            for (size_t i = 0; i < n; i++) {
+                y[i] = dense[i] + theta * (dense[n + i] + theta1 * (dense[2 * n + i]
+                        + theta * (dense[3 * n + i] + theta1 * dense[4 * n + i])));
+            }
+        }
+
+    private:
+        double _absError;
+        double _relError;
+
+        DVec _z;
+        DVec _k2;
+        DVec _k3;
+        DVec _k4;
+        DVec _k5;
+        DVec _k6;
+    };
+
+}
+
+#endif	/* DORMANDPRINCE_H */
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "EventLocator.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Interpolation.h"
+
+namespace iNumerics {
+
+    _EventLocator::_EventLocator(std::vector<Event*>& events)
+    : _events(events), _g0(events.size()), _g1(events.size()), _restarted(events.size(), false) {
+    }
+
+    bool _EventLocator::isEmpty() const {
+        return _events.empty();
+    }
+
+    void _EventLocator::reset(const DVec& x, double t) {
+        for (size_t e = 0; e < _events.size(); e++) {
+            _g0[e] = _events[e]->condition(x, t);
+        }
+    }
+
+    void _EventLocator::restart(size_t e) {
+        _restarted[e] = true;
+    }
+
+    void _EventLocator::locate(const DVec& x0, const DVec& f0, double t0,
+            const DVec& x1, const DVec& f1, double t1, std::vector<Hit>& hits) {
+
+        hits.clear();
+
+        for (size_t e = 0; e < _events.size(); e++) {
+            _g1[e] = _events[e]->condition(x1, t1);
+
+            double ta = t0;
+            double ga = _g0[e];
+
+            // after a restart on the event surface the sign just after
+            // the start decides
+            if (ga == 0 || _restarted[e]) {
+                ta = t0 + 1.e-7 * (t1 - t0);
+                interpolate(x0, f0, t0, x1, f1, t1, ta, _x);
+                ga = _events[e]->condition(_x, ta);
+            }
+
+            if (isCrossing(*_events[e], ga, _g1[e])) {
+                double t = findRoot(*_events[e], x0, f0, t0, ta, ga, x1, f1, t1, _g1[e]);
+                hits.push_back(Hit(t, e));
+            }
+        }
+
+        std::sort(hits.begin(), hits.end());
+
+        _g0.swap(_g1);
+        _restarted.assign(_events.size(), false);
+    }
+
+    void _EventLocator::interpolate(const DVec& x0, const DVec& f0, double t0,
+            const DVec& x1, const DVec& f1, double t1, double t, DVec& x) {
+
+        x.resize(x0.size());
+
+        for (size_t i = 0; i < x0.size(); i++) {
+            x[i] = Interpolation::hermite(t0, x0[i], f0[i], t1, x1[i], f1[i], t);
+        }
+    }
+
+    Event& _EventLocator::getEvent(size_t e) {
+        return *_events[e];
+    }
+
+    bool _EventLocator::isCrossing(const Event& event, double g0, double g1) {
+        bool rising = g0 < 0 && g1 >= 0;
+        bool falling = g0 > 0 && g1 <= 0;
+
+        switch (event.getDirection()) {
+            case Event::RISING: return rising;
+            case Event::FALLING: return falling;
+            default: return rising || falling;
+        }
+    }
+
+    double _EventLocator::findRoot(Event& event, const DVec& x0, const DVec& f0, double t0,
+            double ta, double ga, const DVec& x1, const DVec& f1, double t1, double g1) {
+
+        const size_t maxIterations = 100;
+        const double tol = std::max(4 * DBL_EPSILON * std::max(std::fabs(t0), std::fabs(t1)),
+                1.e-12 * (t1 - t0));
+
+        // a root on the end point would never be approached: every
+        // interior point has the sign of ga, not of g1 == 0
+        if (g1 == 0) {
+            return t1;
+        }
+
+        double a = ta;
+        double b = t1, gb = g1;
+        int side = 0;
+
+        for (size_t k = 0; k < maxIterations && b - a > tol; k++) {
+            double c = (a * gb - b * ga) / (gb - ga);
+
+            if (!(c > a && c < b)) {
+                c = 0.5 * (a + b);
+            }
+
+            interpolate(x0, f0, t0, x1, f1, t1, c, _x);
+            double gc = event.condition(_x, c);
+
+            if (gc == 0 || (gc > 0) != (ga > 0)) {
+                b = c;
+                gb = gc;
+
+                if (gc == 0) {
+                    break;
+                }
+
+                if (side == -1) {
+                    ga *= 0.5;
+                }
+                side = -1;
+            } else {
+                a = c;
+                ga = gc;
+
+                if (side == 1) {
+                    gb *= 0.5;
+                }
+                side = 1;
+            }
+        }
+
+        return b;
+    }
+
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef EVENTLOCATOR_H
+#define	EVENTLOCATOR_H
+
+#include <vector>
+#include <utility>
+
+#include "Types.h"
+#include "Event.h"
+
+namespace iNumerics {
+
+    /**
+     * Locates the event crossings of an accepted step on the cubic Hermite
+     * interpolant through (t0, x0, f0) and (t1, x1, f1).
+     */
+    class _EventLocator {
+    public:
+
+        /**
+         * Crossing time and event index.
+         */
+        typedef std::pair<double, size_t> Hit;
+
+        _EventLocator(std::vector<Event*>& events);
+
+        bool isEmpty() const;
+
+        /**
+         * Evaluates the conditions at the start of the next step.
+         */
+        void reset(const DVec& x, double t);
+
+        /**
+         * Marks event e as the one whose state reset restarted the
+         * integration at the last reset(). Its condition is 0 there up to
+         * rounding, with either sign, so the next step takes the sign just
+         * after the restart instead.
+         */
+        void restart(size_t e);
+
+        /**
+         * Finds all crossings of the step, sorted by time.
+         */
+        void locate(const DVec& x0, const DVec& f0, double t0,
+                const DVec& x1, const DVec& f1, double t1, std::vector<Hit>& hits);
+
+        static void interpolate(const DVec& x0, const DVec& f0, double t0,
+                const DVec& x1, const DVec& f1, double t1, double t, DVec& x);
+
+        Event& getEvent(size_t e);
+
+    private:
+
+        static bool isCrossing(const Event& event, double g0, double g1);
+
+        /**
+         * Illinois iteration on [ta, t1] of the step [t0, t1]. Returns the
+         * end of the final bracket that has the sign of g1.
+         */
+        double findRoot(Event& event, const DVec& x0, const DVec& f0, double t0,
+                double ta, double ga, const DVec& x1, const DVec& f1, double t1, double g1);
+
+        std::vector<Event*>& _events;
+        DVec _g0;
+        DVec _g1;
+        std::vector<bool> _restarted;
+        DVec _x;
+    };
+
+}
+
+#endif	/* EVENTLOCATOR_H */
@@ -0,0 +1,599 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "ExportPipeline.h"
+
+#include <deque>
+#include <algorithm>
+#include <cstdio>
+#include <condition_variable>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#include "StreamingTrajectory.h"
+#include "inprofiler.h"
+
+namespace iNumerics {
+
+    /**
+     * Blocking FIFO with a fixed capacity.
+     */
+    template <class T>
+    class _BoundedQueue {
+    public:
+
+        _BoundedQueue(size_t capacity) : _capacity(capacity > 0 ? capacity : 1), _closed(false),
+        _waits(0), _waitTime(0), _maxDepth(0) {
+        }
+
+        void push(T& item) {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            if (_items.size() >= _capacity) {
+                inULong start = MonotonicClock::now();
+
+                while (_items.size() >= _capacity) {
+                    _notFull.wait(lock);
+                }
+
+                _waits++;
+                _waitTime += MonotonicClock::now() - start;
+            }
+
+            _items.push_back(T());
+            std::swap(_items.back(), item);
+
+            if (_items.size() > _maxDepth) {
+                _maxDepth = _items.size();
+            }
+
+            _notEmpty.notify_one();
+        }
+
+        /**
+         * Waits for an item.
+         * @return false if the queue is closed and empty
+         */
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            while (_items.empty() && !_closed) {
+                _notEmpty.wait(lock);
+            }
+
+            return take(item);
+        }
+
+        /**
+         * @return false if no item is available right now
+         */
+        bool tryPop(T& item) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return take(item);
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+            _notEmpty.notify_all();
+        }
+
+        void counters(size_t& waits, double& waitTime, size_t& maxDepth) const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            waits = _waits;
+            waitTime = _waitTime * 1.e-9;
+            maxDepth = _maxDepth;
+        }
+
+    private:
+
+        bool take(T& item) {
+            if (_items.empty()) {
+                return false;
+            }
+
+            std::swap(item, _items.front());
+            _items.pop_front();
+            _notFull.notify_one();
+
+            return true;
+        }
+
+        size_t _capacity;
+        bool _closed;
+
+        size_t _waits;
+        inULong _waitTime;
+        size_t _maxDepth;
+
+        std::deque<T> _items;
+        mutable std::mutex _mutex;
+        std::condition_variable _notEmpty;
+        std::condition_variable _notFull;
+    };
+
+    struct _ExportJob {
+        std::string name;
+        std::shared_ptr<const Trajectory> trajectory;
+    };
+
+    struct _ExportBlob {
+        std::string name;
+        std::vector<unsigned char> data;
+    };
+
+    static std::string _writeAll(int fd, const unsigned char* data, size_t n, off_t offset) {
+        while (n > 0) {
+            ssize_t w = pwrite(fd, data, n, offset);
+
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return strerror(errno);
+            }
+
+            data += w;
+            n -= (size_t) w;
+            offset += w;
+        }
+
+        return "";
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::ExportOptions / ExportStats                        *
+     *                                                                            *
+     ******************************************************************************/
+
+    ExportOptions::ExportOptions() : path("."), container(false), workers(2), ioThreads(1),
+    queueCapacity(64), batchBytes(4 << 20), shardBytes((size_t) 1 << 30) {
+        size_t cores = std::thread::hardware_concurrency();
+
+        if (cores > 2) {
+            workers = cores - 1;
+        }
+    }
+
+    ExportStats::ExportStats() : trajectories(0), bytes(0), writes(0),
+    submitWaits(0), submitWaitTime(0), encodedWaits(0), encodedWaitTime(0),
+    maxSubmitDepth(0), maxEncodedDepth(0), encodeTime(0), writeTime(0), wallTime(0) {
+    }
+
+    double ExportStats::getBytesPerSecond() const {
+        return wallTime > 0 ? bytes / wallTime : 0;
+    }
+
+    double ExportStats::getTrajectoriesPerMinute() const {
+        return wallTime > 0 ? 60 * trajectories / wallTime : 0;
+    }
+
+    void ExportStats::writeJSON(std::ostream& os) const {
+        os << "{\"trajectories\": " << trajectories
+                << ", \"bytes\": " << bytes
+                << ", \"writes\": " << writes
+                << ", \"submitWaits\": " << submitWaits
+                << ", \"submitWaitTime\": " << submitWaitTime
+                << ", \"encodedWaits\": " << encodedWaits
+                << ", \"encodedWaitTime\": " << encodedWaitTime
+                << ", \"maxSubmitDepth\": " << maxSubmitDepth
+                << ", \"maxEncodedDepth\": " << maxEncodedDepth
+                << ", \"encodeTime\": " << encodeTime
+                << ", \"writeTime\": " << writeTime
+                << ", \"wallTime\": " << wallTime
+                << ", \"bytesPerSecond\": " << getBytesPerSecond()
+                << ", \"trajectoriesPerMinute\": " << getTrajectoriesPerMinute()
+                << "}";
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::ExportPipeline                                     *
+     *                                                                            *
+     ******************************************************************************/
+
+    struct ExportPipeline::Impl {
+
+        Impl(const ExportOptions& options) : options(options),
+        submitted(options.queueCapacity), encoded(options.queueCapacity),
+        start(MonotonicClock::now()), end(0), finished(false),
+        trajectories(0), bytes(0), writes(0), encodeTime(0), writeTime(0),
+        shard(0), shardFd(-1), shardOffset(0) {
+
+            if (this->options.container) {
+                this->options.ioThreads = 1;
+            }
+        }
+
+        void encodeLoop() {
+            _ExportJob job;
+
+            while (submitted.pop(job)) {
+                inULong t0 = MonotonicClock::now();
+
+                _ExportBlob blob;
+                blob.name.swap(job.name);
+                StreamingTrajectory::encode(*job.trajectory, blob.data);
+                job.trajectory.reset();
+
+                addTime(encodeTime, t0);
+
+                encoded.push(blob);
+            }
+        }
+
+        void fileLoop() {
+            _ExportBlob blob;
+
+            while (encoded.pop(blob)) {
+                inULong t0 = MonotonicClock::now();
+
+                std::string path = options.path + "/" + blob.name + ".traj";
+                int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                std::string msg = fd < 0 ? strerror(errno) : _writeAll(fd, blob.data.data(), blob.data.size(), 0);
+
+                if (fd >= 0 && close(fd) != 0 && msg.empty()) {
+                    msg = strerror(errno);
+                }
+
+                if (!msg.empty()) {
+                    fail("cannot write \"" + path + "\": " + msg);
+                } else {
+                    written(1, 1, blob.data.size());
+                }
+
+                addTime(writeTime, t0);
+            }
+        }
+
+        void containerLoop() {
+            std::vector<_ExportBlob> batch;
+            std::vector<struct iovec> iov;
+            _ExportBlob blob;
+
+            while (encoded.pop(blob)) {
+                inULong t0 = MonotonicClock::now();
+
+                batch.clear();
+                size_t batchSize = blob.data.size();
+                batch.push_back(_ExportBlob());
+                std::swap(batch.back(), blob);
+
+                // gather what is ready, the batch is written with one call
+                while (batchSize < options.batchBytes && batch.size() < IOV_MAX && encoded.tryPop(blob)) {
+                    batchSize += blob.data.size();
+                    batch.push_back(_ExportBlob());
+                    std::swap(batch.back(), blob);
+                }
+
+                size_t first = 0;
+
+                while (first < batch.size()) {
+                    if (shardFd < 0 || (shardOffset > 0 && shardOffset + batch[first].data.size() > options.shardBytes)) {
+                        nextShard();
+                    }
+
+                    // blobs that fit into the current shard
+                    size_t last = first;
+                    size_t length = 0;
+                    iov.clear();
+
+                    while (last < batch.size()
+                            && ((length == 0 && shardOffset == 0)
+                            || shardOffset + length + batch[last].data.size() <= options.shardBytes)) {
+                        struct iovec v;
+                        v.iov_base = batch[last].data.data();
+                        v.iov_len = batch[last].data.size();
+                        iov.push_back(v);
+
+                        IndexEntry entry;
+                        entry.name = batch[last].name;
+                        entry.shard = (unsigned int) shard;
+                        entry.offset = shardOffset + length;
+                        entry.length = batch[last].data.size();
+                        index.push_back(entry);
+
+                        length += batch[last].data.size();
+                        last++;
+                    }
+
+                    if (writeBatch(iov, length)) {
+                        written(last - first, 1, length);
+                    }
+
+                    first = last;
+                }
+
+                addTime(writeTime, t0);
+            }
+
+            if (shardFd >= 0 && close(shardFd) != 0) {
+                fail(std::string("cannot close shard: ") + strerror(errno));
+            }
+
+            writeIndex();
+        }
+
+        void nextShard() {
+            if (shardFd >= 0) {
+                if (close(shardFd) != 0) {
+                    fail(std::string("cannot close shard: ") + strerror(errno));
+                }
+                shard++;
+            }
+
+            char suffix[16];
+            snprintf(suffix, sizeof (suffix), ".%03u", (unsigned) shard);
+
+            std::string path = options.path + suffix;
+            shardFd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            shardOffset = 0;
+
+            if (shardFd < 0) {
+                fail("cannot open \"" + path + "\": " + strerror(errno));
+            }
+        }
+
+        /**
+         * @return false if the batch could not be written
+         */
+        bool writeBatch(std::vector<struct iovec>& iov, size_t length) {
+            if (shardFd < 0) {
+                return false;
+            }
+
+            size_t done = 0;
+            size_t v = 0;
+
+            while (done < length) {
+                ssize_t w = pwritev(shardFd, &iov[v], (int) (iov.size() - v), (off_t) (shardOffset + done));
+
+                if (w < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    fail(std::string("cannot write shard: ") + strerror(errno));
+                    return false;
+                }
+
+                done += (size_t) w;
+
+                // skip the fully written vectors after a partial write
+                while (v < iov.size() && (size_t) w >= iov[v].iov_len) {
+                    w -= iov[v].iov_len;
+                    v++;
+                }
+
+                if (v < iov.size()) {
+                    iov[v].iov_base = static_cast<char*> (iov[v].iov_base) + w;
+                    iov[v].iov_len -= (size_t) w;
+                }
+            }
+
+            shardOffset += length;
+
+            return true;
+        }
+
+        void writeIndex() {
+            std::vector<unsigned char> data;
+            const char magic[8] = {'I', 'N', 'E', 'X', 'P', 'I', 'D', 'X'};
+            data.insert(data.end(), magic, magic + 8);
+
+            for (size_t i = 0; i < index.size(); i++) {
+                const IndexEntry& e = index[i];
+                uint32_t nameLength = (uint32_t) e.name.size();
+                uint32_t shard = e.shard;
+                uint64_t offset = e.offset;
+                uint64_t length = e.length;
+
+                append(data, &nameLength, 4);
+                append(data, e.name.data(), e.name.size());
+                append(data, &shard, 4);
+                append(data, &offset, 8);
+                append(data, &length, 8);
+            }
+
+            std::string path = options.path + ".index";
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            std::string msg = fd < 0 ? strerror(errno) : _writeAll(fd, data.data(), data.size(), 0);
+
+            if (fd >= 0) {
+                close(fd);
+            }
+
+            if (!msg.empty()) {
+                fail("cannot write \"" + path + "\": " + msg);
+            }
+        }
+
+        static void append(std::vector<unsigned char>& data, const void* p, size_t n) {
+            const unsigned char* c = static_cast<const unsigned char*> (p);
+            data.insert(data.end(), c, c + n);
+        }
+
+        void written(size_t n, size_t calls, size_t size) {
+            std::lock_guard<std::mutex> lock(mutex);
+            trajectories += n;
+            writes += calls;
+            bytes += size;
+        }
+
+        void addTime(inULong& counter, inULong t0) {
+            inULong dt = MonotonicClock::now() - t0;
+            std::lock_guard<std::mutex> lock(mutex);
+            counter += dt;
+        }
+
+        void fail(const std::string& msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (error.empty()) {
+                error = "ExportPipeline: " + msg;
+            }
+        }
+
+        ExportStats stats() const {
+            ExportStats s;
+
+            submitted.counters(s.submitWaits, s.submitWaitTime, s.maxSubmitDepth);
+            encoded.counters(s.encodedWaits, s.encodedWaitTime, s.maxEncodedDepth);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            s.trajectories = trajectories;
+            s.bytes = bytes;
+            s.writes = writes;
+            s.encodeTime = encodeTime * 1.e-9;
+            s.writeTime = writeTime * 1.e-9;
+            s.wallTime = ((finished ? end : MonotonicClock::now()) - start) * 1.e-9;
+
+            return s;
+        }
+
+        struct IndexEntry {
+            std::string name;
+            unsigned int shard;
+            size_t offset;
+            size_t length;
+        };
+
+        ExportOptions options;
+
+        _BoundedQueue<_ExportJob> submitted;
+        _BoundedQueue<_ExportBlob> encoded;
+
+        std::vector<std::thread> encoders;
+        std::vector<std::thread> writers;
+
+        inULong start;
+        inULong end;
+        bool finished;
+
+        mutable std::mutex mutex;
+        size_t trajectories;
+        size_t bytes;
+        size_t writes;
+        inULong encodeTime;
+        inULong writeTime;
+        std::string error;
+
+        // container state, only used by the single I/O thread
+        size_t shard;
+        int shardFd;
+        size_t shardOffset;
+        std::vector<IndexEntry> index;
+    };
+
+    ExportPipeline::ExportPipeline(const ExportOptions& options) : _impl(new Impl(options)) {
+        Impl& impl = *_impl;
+
+        for (size_t i = 0; i < std::max<size_t>(1, impl.options.workers); i++) {
+            impl.encoders.push_back(std::thread(&Impl::encodeLoop, &impl));
+        }
+
+        for (size_t i = 0; i < std::max<size_t>(1, impl.options.ioThreads); i++) {
+            impl.writers.push_back(std::thread(
+                    impl.options.container ? &Impl::containerLoop : &Impl::fileLoop, &impl));
+        }
+    }
+
+    ExportPipeline::~ExportPipeline() {
+        if (!_impl->finished) {
+            try {
+                finish();
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+    }
+
+    void ExportPipeline::submit(const std::string& name, std::shared_ptr<const Trajectory> trajectory) {
+        if (_impl->finished) {
+            throw std::logic_error("ExportPipeline: submit() after finish()");
+        }
+
+        // the name becomes a file name below path
+        if (name.empty() || name == "." || name == ".."
+                || name.find('/') != std::string::npos || name.find('\0') != std::string::npos) {
+            throw std::invalid_argument("ExportPipeline: invalid trajectory name \"" + name + "\"");
+        }
+
+        _ExportJob job;
+        job.name = name;
+        job.trajectory = trajectory;
+
+        _impl->submitted.push(job);
+    }
+
+    ExportStats ExportPipeline::finish() {
+        Impl& impl = *_impl;
+
+        if (!impl.finished) {
+            impl.submitted.close();
+
+            for (size_t i = 0; i < impl.encoders.size(); i++) {
+                impl.encoders[i].join();
+            }
+
+            impl.encoded.close();
+
+            for (size_t i = 0; i < impl.writers.size(); i++) {
+                impl.writers[i].join();
+            }
+
+            std::lock_guard<std::mutex> lock(impl.mutex);
+            impl.end = MonotonicClock::now();
+            impl.finished = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(impl.mutex);
+
+            if (!impl.error.empty()) {
+                throw std::runtime_error(impl.error);
+            }
+        }
+
+        return impl.stats();
+    }
+
+    ExportStats ExportPipeline::getStats() const {
+        return _impl->stats();
+    }
+
+}
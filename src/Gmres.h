@@ -0,0 +1,232 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef GMRES_H
+#define	GMRES_H
+
+#include <vector>
+#include <cmath>
+
+#include "Types.h"
+
+namespace iNumerics {
+
+    /**
+     * Restarted GMRES(m) with right preconditioning (Saad & Schultz 1986),
+     * modified Gram-Schmidt and Givens rotations. Memory is m + 3 vectors
+     * of size n.
+     */
+    class _Gmres {
+    public:
+
+        _Gmres(size_t restart, size_t maxRestarts)
+        : _m(restart), _maxRestarts(maxRestarts) {
+        }
+
+        /**
+         * Approximately solves A x = b from x = 0 until the residual
+         * ||b - A x||_2 <= tolerance or the restarts are exhausted.
+         * @param A	applies the operator, A(v, Av)
+         * @param M	applies the preconditioner inverse, M(v, z)
+         * @return number of iterations (operator applications in the
+         *         Arnoldi process)
+         */
+        template <class Operator, class Preconditioner>
+        size_t solve(Operator& A, Preconditioner& M, const DVec& b, DVec& x, double tolerance) {
+            const size_t n = b.size();
+            const size_t m = _m;
+
+            x.assign(n, 0);
+            _r = b;
+
+            double beta = _norm(_r);
+            size_t iterations = 0;
+
+            if (beta <= tolerance) {
+                return 0;
+            }
+
+            _v.resize(m + 1);
+            _h.assign((m + 1) * m, 0);
+            _g.resize(m + 1);
+            _cs.resize(m);
+            _sn.resize(m);
+            _y.resize(m);
+
+            for (size_t cycle = 0; cycle <= _maxRestarts; cycle++) {
+                _v[0].resize(n);
+
+                for (size_t i = 0; i < n; i++) {
+                    _v[0][i] = _r[i] / beta;
+                }
+
+                std::fill(_g.begin(), _g.end(), 0);
+                _g[0] = beta;
+
+                double residual = beta;
+                size_t k = 0;
+
+                while (k < m) {
+                    const size_t j = k;
+
+                    M(_v[j], _z);
+                    A(_z, _w);
+                    iterations++;
+
+                    for (size_t i = 0; i <= j; i++) {
+                        double hij = _dot(_w, _v[i]);
+                        H(i, j) = hij;
+
+                        for (size_t l = 0; l < n; l++) {
+                            _w[l] -= hij * _v[i][l];
+                        }
+                    }
+
+                    const double next = _norm(_w);
+                    H(j + 1, j) = next;
+
+                    if (next > 0) {
+                        _v[j + 1].resize(n);
+
+                        for (size_t l = 0; l < n; l++) {
+                            _v[j + 1][l] = _w[l] / next;
+                        }
+                    }
+
+                    // QR of the Hessenberg matrix by Givens rotations
+                    for (size_t i = 0; i < j; i++) {
+                        const double a = H(i, j);
+                        const double c = H(i + 1, j);
+
+                        H(i, j) = _cs[i] * a + _sn[i] * c;
+                        H(i + 1, j) = -_sn[i] * a + _cs[i] * c;
+                    }
+
+                    const double a = H(j, j);
+                    const double c = H(j + 1, j);
+                    const double r = std::sqrt(a * a + c * c);
+
+                    _cs[j] = r > 0 ? a / r : 1;
+                    _sn[j] = r > 0 ? c / r : 0;
+                    H(j, j) = r;
+                    H(j + 1, j) = 0;
+
+                    _g[j + 1] = -_sn[j] * _g[j];
+                    _g[j] = _cs[j] * _g[j];
+
+                    residual = std::fabs(_g[j + 1]);
+                    k++;
+
+                    if (residual <= tolerance || next == 0) {
+                        break;
+                    }
+                }
+
+                // x += M^-1 V y with H y = g
+                for (size_t i = k; i-- > 0;) {
+                    double sum = _g[i];
+
+                    for (size_t l = i + 1; l < k; l++) {
+                        sum -= H(i, l) * _y[l];
+                    }
+
+                    _y[i] = H(i, i) != 0 ? sum / H(i, i) : 0;
+                }
+
+                _w.assign(n, 0);
+
+                for (size_t i = 0; i < k; i++) {
+                    for (size_t l = 0; l < n; l++) {
+                        _w[l] += _y[i] * _v[i][l];
+                    }
+                }
+
+                M(_w, _z);
+
+                for (size_t l = 0; l < n; l++) {
+                    x[l] += _z[l];
+                }
+
+                if (residual <= tolerance || cycle == _maxRestarts) {
+                    break;
+                }
+
+                A(x, _w);
+
+                for (size_t l = 0; l < n; l++) {
+                    _r[l] = b[l] - _w[l];
+                }
+
+                beta = _norm(_r);
+
+                if (beta <= tolerance) {
+                    break;
+                }
+            }
+
+            return iterations;
+        }
+
+    private:
+
+        double& H(size_t i, size_t j) {
+            return _h[j * (_m + 1) + i];
+        }
+
+        static double _dot(const DVec& a, const DVec& b) {
+            double sum = 0;
+
+            for (size_t i = 0; i < a.size(); i++) {
+                sum += a[i] * b[i];
+            }
+
+            return sum;
+        }
+
+        static double _norm(const DVec& a) {
+            return std::sqrt(_dot(a, a));
+        }
+
+        size_t _m;
+        size_t _maxRestarts;
+
+        std::vector<DVec> _v;
+        DVec _h;
+        DVec _g;
+        DVec _cs;
+        DVec _sn;
+        DVec _y;
+        DVec _r;
+        DVec _w;
+        DVec _z;
+    };
+
+}
+
+#endif	/* GMRES_H */
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "ImexStepper.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    _ImexStepper::_ImexStepper(_Jacobian& jacobian, SolveStats& stats, double absError, double relError)
+    : _jacobian(jacobian), _stats(stats), _lu(&stats), _absError(absError), _relError(relError),
+    _jacobianValid(false), _jacobianTime(0), _luDiagonal(0), _lastRejected(false) {
+    }
+
+    boost::numeric::odeint::controlled_step_result _ImexStepper::try_step(_SplitRhs& system,
+            DVec& x, const DVec& dxdt, double& t, double& dt) {
+
+        using namespace boost::numeric::odeint;
+
+        static const _ArkCoefficients coef;
+        const size_t S = _ArkCoefficients::STAGES;
+        const size_t n = x.size();
+        const double hg = dt * coef.gamma;
+
+        system.parts(x, t);
+        _fe[0] = system.lastExplicit();
+        _fi[0] = system.lastImplicit();
+
+        _weights.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            _weights[i] = _absError + _relError * std::fabs(x[i]);
+        }
+
+        if (!_jacobianValid) {
+            evaluateJacobian(x, t);
+        }
+
+        if (hg != _luDiagonal && !factor(n, hg)) {
+            dt *= 0.5;
+            _lastRejected = true;
+            return fail;
+        }
+
+        _psi.resize(n);
+        _z.resize(n);
+
+        for (size_t s = 1; s < S; s++) {
+            for (size_t i = 0; i < n; i++) {
+                double sum = 0;
+
+                for (size_t j = 0; j < s; j++) {
+                    sum += coef.ae[s][j] * _fe[j][i] + coef.ai[s][j] * _fi[j][i];
+                }
+
+                _psi[i] = x[i] + dt * sum;
+                // predictor: the stiff part of the previous stage
+                _z[i] = _psi[i] + hg * _fi[s - 1][i];
+            }
+
+            if (!stage(system, x, t, t + coef.c[s] * dt, hg, s)) {
+                return newtonFailure(dt);
+            }
+        }
+
+        _xnew.resize(n);
+        _err.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            double sum = 0;
+            double ei = 0;
+
+            for (size_t s = 0; s < S; s++) {
+                const double f = _fe[s][i] + _fi[s][i];
+
+                sum += coef.b[s] * f;
+                ei += coef.e[s] * f;
+            }
+
+            _xnew[i] = x[i] + dt * sum;
+            _err[i] = dt * ei;
+        }
+
+        // The embedded solution is not stiffly accurate, so the raw
+        // estimate does not vanish with h in the stiff components of
+        // f_I; filtered like in RADAU5 it does.
+        _lu.solve(_err.data());
+
+        double err = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            double sk = _absError + _relError * std::max(std::fabs(x[i]), std::fabs(_xnew[i]));
+            err += (_err[i] / sk) * (_err[i] / sk);
+        }
+
+        err = n > 0 ? std::sqrt(err / n) : 0;
+
+        // embedded order 2
+        double fac = err > 0 ? 0.9 * std::pow(err, -1. / 3) : 5;
+        fac = std::max(0.2, std::min(5., fac));
+
+        if (err <= 1) {
+            if (_lastRejected) {
+                fac = std::min(fac, 1.);
+            }
+
+            x.swap(_xnew);
+            t += dt;
+            dt *= fac;
+            _lastRejected = false;
+            return success;
+        }
+
+        dt *= fac;
+        _lastRejected = true;
+        return fail;
+    }
+
+    boost::numeric::odeint::controlled_step_result _ImexStepper::newtonFailure(double& dt) {
+        IN_TRACE_INSTANT("newton failure", dt);
+        dt *= 0.25;
+        _lastRejected = true;
+        return boost::numeric::odeint::fail;
+    }
+
+    void _ImexStepper::evaluateJacobian(const DVec& x, double t) {
+        _jacobian.values(x, _fi[0], t, _J);
+        _jacobianValid = true;
+        _jacobianTime = t;
+        _luDiagonal = 0;
+    }
+
+    bool _ImexStepper::factor(size_t n, double hg) {
+        const JacobianStructure& structure = _jacobian.structure(n);
+        const std::vector<size_t>& diagonal = structure.getDiagonal();
+
+        _W.resize(_J.size());
+
+        for (size_t i = 0; i < _J.size(); i++) {
+            _W[i] = -hg * _J[i];
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            _W[diagonal[i]] += 1;
+        }
+
+        _luDiagonal = _lu.factor(structure, _W) ? hg : 0;
+        _newtonTest.reset();
+        return _luDiagonal != 0;
+    }
+
+    bool _ImexStepper::stage(_SplitRhs& system, const DVec& x, double t0, double t, double hg, size_t s) {
+        const size_t n = x.size();
+
+        _start = _z;
+
+        while (!newton(system, t, hg)) {
+            if (_jacobianTime == t0) {
+                return false;
+            }
+
+            evaluateJacobian(x, t0);
+
+            if (!factor(n, hg)) {
+                return false;
+            }
+
+            _z = _start;
+        }
+
+        _fi[s].resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            _fi[s][i] = (_z[i] - _psi[i]) / hg;
+        }
+
+        _fe[s].resize(n);
+        system._explicit(_z, _fe[s], t);
+
+        return true;
+    }
+
+    bool _ImexStepper::newton(_SplitRhs& system, double t, double hg) {
+        const size_t n = _z.size();
+
+        _f.resize(n);
+        _delta.resize(n);
+
+        for (size_t it = 0; it < MAX_NEWTON; it++) {
+            system._implicit(_z, _f, t);
+            _stats.newtonIterations++;
+
+            for (size_t i = 0; i < n; i++) {
+                _delta[i] = _psi[i] + hg * _f[i] - _z[i];
+            }
+
+            _lu.solve(_delta.data());
+
+            double norm = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                _z[i] += _delta[i];
+                norm += (_delta[i] / _weights[i]) * (_delta[i] / _weights[i]);
+            }
+
+            norm = n > 0 ? std::sqrt(norm / n) : 0;
+
+            _NewtonTest::Result result = _newtonTest(it, norm);
+
+            if (result != _NewtonTest::CONTINUE) {
+                return result == _NewtonTest::CONVERGED;
+            }
+        }
+
+        return false;
+    }
+
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef IMEXSTEPPER_H
+#define	IMEXSTEPPER_H
+
+#include <memory>
+
+#include <boost/numeric/odeint/stepper/controlled_step_result.hpp>
+
+#include "Types.h"
+#include "Model.h"
+#include "Problem.h"
+#include "StructuredLU.h"
+#include "SolveStats.h"
+#include "SolverSupport.h"
+#include "Jacobian.h"
+#include "NewtonTest.h"
+
+namespace iNumerics {
+
+    /**
+     * f = f_E + f_I of a split model for the driver. The parts of the last
+     * point are kept (shared by all copies), so the IMEX stepper takes
+     * them for its first stage instead of evaluating them again.
+     */
+    class _SplitRhs {
+    public:
+
+        _SplitRhs(Problem& problem, Model& model, SolveStats& stats)
+        : _explicit(problem, model, stats, _CountingRhs::EXPLICIT),
+        _implicit(problem, model, stats, _CountingRhs::IMPLICIT), _last(new _Point()) {
+        }
+
+        void operator()(const DVec &y, DVec &dydt, const double t) {
+            parts(y, t);
+
+            dydt.resize(y.size());
+
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = _last->fe[i] + _last->fi[i];
+            }
+        }
+
+        /**
+         * f_E and f_I at (y, t) in lastExplicit() and lastImplicit().
+         */
+        void parts(const DVec &y, const double t) {
+            if (_last->valid && _last->t == t && _last->y == y) {
+                return;
+            }
+
+            _last->fe.resize(y.size());
+            _last->fi.resize(y.size());
+
+            _explicit(y, _last->fe, t);
+            _implicit(y, _last->fi, t);
+
+            _last->y = y;
+            _last->t = t;
+            _last->valid = true;
+        }
+
+        const DVec& lastExplicit() const {
+            return _last->fe;
+        }
+
+        const DVec& lastImplicit() const {
+            return _last->fi;
+        }
+
+        _CountingRhs _explicit;
+        _CountingRhs _implicit;
+
+    private:
+
+        struct _Point {
+
+            _Point() : t(0), valid(false) {
+            }
+
+            DVec y;
+            double t;
+            bool valid;
+            DVec fe;
+            DVec fi;
+        };
+
+        std::shared_ptr<_Point> _last;
+    };
+
+    /**
+     * Coefficients of ARK3(2)4L[2]SA (Kennedy & Carpenter 2003): an
+     * additive Runge-Kutta pair of order 3 with an embedded order 2
+     * solution. The implicit part is an L-stable, stiffly accurate ESDIRK
+     * with the same diagonal in all stages, and the pair stays stable and
+     * damps the stiff modes for any explicit eigenvalue within the region
+     * of the explicit method.
+     */
+    struct _ArkCoefficients {
+        static const size_t STAGES = 4;
+
+        double gamma;
+        double c[STAGES];
+        double ae[STAGES][STAGES];
+        double ai[STAGES][STAGES];
+        double b[STAGES];
+        // b - bhat
+        double e[STAGES];
+
+        _ArkCoefficients() {
+            const double g = 1767732205903. / 4055673282236.;
+
+            const double AE[STAGES][STAGES] = {
+                {0, 0, 0, 0},
+                {1767732205903. / 2027836641118., 0, 0, 0},
+                {5535828885825. / 10492691773637., 788022342437. / 10882634858940., 0, 0},
+                {6485989280629. / 16251701735622., -4246266847089. / 9704473918619.,
+                    10755448449292. / 10357097424841., 0}
+            };
+
+            const double AI[STAGES][STAGES] = {
+                {0, 0, 0, 0},
+                {g, g, 0, 0},
+                {2746238789719. / 10658868560708., -640167445237. / 6845629431997., g, 0},
+                {1471266399579. / 7840856788654., -4482444167858. / 7529755066697.,
+                    11266239266428. / 11593286722821., g}
+            };
+
+            const double bhat[STAGES] = {
+                2756255671327. / 12835298489170., -10771552573575. / 22201958757719.,
+                9247589265047. / 10645013368117., 2193209047091. / 5459859503100.
+            };
+
+            gamma = g;
+
+            for (size_t i = 0; i < STAGES; i++) {
+                c[i] = 0;
+
+                for (size_t j = 0; j < STAGES; j++) {
+                    ae[i][j] = AE[i][j];
+                    ai[i][j] = AI[i][j];
+                    c[i] += AE[i][j];
+                }
+
+                // stiffly accurate
+                b[i] = AI[STAGES - 1][i];
+                e[i] = b[i] - bhat[i];
+            }
+        }
+    };
+
+    /**
+     * Controlled additive Runge-Kutta (IMEX) stepper for
+     * y' = f_E(y) + f_I(y) with the coefficients of _ArkCoefficients: f_E
+     * is evaluated explicitly, f_I implicitly.
+     *
+     * All implicit stages have the diagonal h gamma and are solved by a
+     * simplified Newton iteration with the same LU factors of
+     * I - h gamma df_I/dy. The Jacobian of f_I is kept across steps until
+     * the iteration fails to converge.
+     */
+    class _ImexStepper {
+    public:
+
+        _ImexStepper(_Jacobian& jacobian, SolveStats& stats, double absError, double relError);
+
+        boost::numeric::odeint::controlled_step_result try_step(_SplitRhs& system,
+                DVec& x, const DVec& dxdt, double& t, double& dt);
+
+    private:
+
+        static const size_t MAX_NEWTON = 4;
+
+        boost::numeric::odeint::controlled_step_result newtonFailure(double& dt);
+
+        void evaluateJacobian(const DVec& x, double t);
+
+        /**
+         * Factors I - hg J.
+         */
+        bool factor(size_t n, double hg);
+
+        /**
+         * Solves z = psi + hg f_I(t, z) from the predictor in _z, with a
+         * fresh Jacobian if the one of an earlier step fails, and
+         * evaluates both parts at the stage.
+         */
+        bool stage(_SplitRhs& system, const DVec& x, double t0, double t, double hg, size_t s);
+
+        bool newton(_SplitRhs& system, double t, double hg);
+
+        _Jacobian& _jacobian;
+        SolveStats& _stats;
+        StructuredLU _lu;
+        double _absError;
+        double _relError;
+
+        bool _jacobianValid;
+        double _jacobianTime;
+        // h gamma of the factors, 0 if none
+        double _luDiagonal;
+        _NewtonTest _newtonTest;
+        bool _lastRejected;
+
+        DVec _fe[_ArkCoefficients::STAGES];
+        DVec _fi[_ArkCoefficients::STAGES];
+        DVec _weights;
+        DVec _psi;
+        DVec _z;
+        DVec _start;
+        DVec _f;
+        DVec _delta;
+        DVec _xnew;
+        DVec _err;
+        DVec _J;
+        DVec _W;
+    };
+
+}
+
+#endif	/* IMEXSTEPPER_H */
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef INTEGRATEADAPTIVE_H
+#define	INTEGRATEADAPTIVE_H
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/numeric/odeint/stepper/controlled_step_result.hpp>
+
+#include "Types.h"
+#include "Checkpoint.h"
+#include "SolveStats.h"
+#include "EventLocator.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    /**
+     * Adaptive integration with a controlled stepper. Same control flow as
+     * odeint's integrate_adaptive(), but rejected steps are counted and the
+     * derivative at the start of a step is evaluated once for all trials.
+     * With events the derivative at the end of a step is evaluated right
+     * after the step, serves the Hermite interpolant of the event search and
+     * is reused by the next step.
+     */
+    template <class ControlledStepper, class System, class Observer>
+    static void _integrate_adaptive(ControlledStepper stepper, System rhs,
+            DVec& x, double t, double tn, double dt,
+            Observer& observer, _EventLocator& events, SolveStats& stats,
+            bool recordStart, CheckpointWriter* checkpoints) {
+
+        using namespace boost::numeric::odeint;
+
+        const size_t max_attempts = 1000;
+
+        std::vector<_EventLocator::Hit> hits;
+        DVec x0, f0, xe;
+
+        DVec dxdt(x.size());
+        bool haveDxdt = false;
+
+        if (recordStart) {
+            observer(x, t);
+        }
+
+        if (!events.isEmpty()) {
+            events.reset(x, t);
+        }
+
+        while (t < tn) {
+            if ((t + dt) > tn) {
+                dt = tn - t;
+            }
+
+            if (!haveDxdt) {
+                rhs(x, dxdt, t);
+            }
+
+            double tOld = t;
+            size_t trials = 0;
+            controlled_step_result res = success;
+
+            if (!events.isEmpty()) {
+                x0 = x;
+                f0 = dxdt;
+            }
+
+            IN_TRACE_BEGIN("step", dt);
+
+            do {
+                IN_PERF_REGION(PERF_STEPPER);
+                double tried = dt;
+                res = stepper.try_step(rhs, x, dxdt, t, dt);
+                ++trials;
+
+                if (res == fail) {
+                    IN_TRACE_INSTANT("reject", tried);
+                    stats.rejectedSteps++;
+                }
+            } while ((res == fail) && (trials < max_attempts));
+
+            if (trials == max_attempts) {
+                throw std::overflow_error("ODESolver: Maximal number of iterations reached. A step size could not be found.");
+            }
+
+            IN_TRACE_END("step");
+
+            stats.recordStep(t - tOld);
+
+            haveDxdt = false;
+
+            if (!events.isEmpty()) {
+                rhs(x, dxdt, t);
+                haveDxdt = true;
+
+                events.locate(x0, f0, tOld, x, dxdt, t, hits);
+
+                bool stop = false;
+
+                for (size_t h = 0; h < hits.size() && !stop; h++) {
+                    double te = hits[h].first;
+                    Event& event = events.getEvent(hits[h].second);
+
+                    IN_TRACE_INSTANT("event", te);
+                    stats.events++;
+
+                    _EventLocator::interpolate(x0, f0, tOld, x, dxdt, t, te, xe);
+                    observer(xe, te);
+
+                    bool modified = event.occurred(xe, te);
+
+                    if (modified) {
+                        observer(xe, te);
+                    }
+
+                    if (event.isTerminal()) {
+                        x = xe;
+                        t = te;
+                        tn = te;
+                        stop = true;
+                    } else if (modified) {
+                        // the rest of the step is discarded, and the next
+                        // step starts no larger than this one: the step
+                        // size suggested for the old state may span
+                        // several crossings of the new one
+                        dt = std::min(dt, t - tOld);
+                        x = xe;
+                        t = te;
+                        rhs(x, dxdt, t);
+                        events.reset(x, t);
+                        events.restart(hits[h].second);
+                        stop = true;
+                    }
+                }
+
+                if (stop) {
+                    continue;
+                }
+            }
+
+            observer(x, t);
+
+            if (checkpoints != NULL && checkpoints->isDue()) {
+                Checkpoint checkpoint;
+                checkpoint.t = t;
+                checkpoint.dt = dt;
+                checkpoint.x = x;
+                checkpoint.trajectorySize = observer._trajectory.size();
+                checkpoint.stats = stats;
+                checkpoints->offer(checkpoint);
+            }
+        }
+    }
+
+}
+
+#endif	/* INTEGRATEADAPTIVE_H */
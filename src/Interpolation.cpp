@@ -38,8 +38,7 @@ namespace iNumerics {
         i_t l = i;
         --l;
 
-        const double delta = (t - l->first) / (i->first - l->first);
-        return delta * i->second + (1 - delta) * l->second;
+        return linear(l->first, l->second, i->first, i->second, t);
     }
 
 }
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "Jacobian.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    _Jacobian::_Jacobian(Model& model, _CountingRhs rhs, SolveStats& stats)
+    : _model(model), _rhs(rhs), _stats(stats), _analytic(rhs._part == _CountingRhs::FULL),
+    _analyticValues(rhs._part == _CountingRhs::FULL), _bound(false) {
+    }
+
+    void _Jacobian::operator()(const DVec& y, const DVec& f, double t, DVec& J) {
+        const size_t n = y.size();
+
+        IN_TRACE_INSTANT("jacobian", (double) n);
+        _stats.jacobianCalls++;
+
+        J.assign(n * n, 0);
+
+        if (_analytic && _model.jacobian(y, J, t)) {
+            return;
+        }
+
+        _analytic = false;
+
+        const JacobianStructure& s = structure(n);
+
+        if (s.getType() != JacobianStructure::DENSE) {
+            compute(y, f, t, _values);
+
+            const std::vector<size_t>& pointers = s.getColumnPointers();
+            const std::vector<size_t>& rows = s.getColumnRows();
+            const std::vector<size_t>& positions = s.getColumnPositions();
+
+            for (size_t j = 0; j < n; j++) {
+                for (size_t k = pointers[j]; k < pointers[j + 1]; k++) {
+                    J[j * n + rows[k]] = _values[positions[k]];
+                }
+            }
+
+            return;
+        }
+
+        // perturbations relative to the component, but not below a
+        // fraction of the largest component
+        const double scale = perturbationScale(y);
+
+        _y = y;
+        _f.resize(n);
+
+        for (size_t j = 0; j < n; j++) {
+            double delta = std::sqrt(DBL_EPSILON) * std::max(std::fabs(y[j]), scale);
+
+            _y[j] = y[j] + delta;
+            delta = _y[j] - y[j];
+
+            _rhs(_y, _f, t);
+
+            for (size_t i = 0; i < n; i++) {
+                J[j * n + i] = (_f[i] - f[i]) / delta;
+            }
+
+            _y[j] = y[j];
+        }
+    }
+
+    void _Jacobian::values(const DVec& y, const DVec& f, double t, DVec& values) {
+        const size_t n = y.size();
+
+        if (structure(n).getType() == JacobianStructure::DENSE) {
+            (*this)(y, f, t, values);
+            return;
+        }
+
+        IN_TRACE_INSTANT("jacobian", (double) n);
+        _stats.jacobianCalls++;
+
+        compute(y, f, t, values);
+    }
+
+    const JacobianStructure& _Jacobian::structure(size_t n) {
+        if (!_bound || _structure.getDimension() != n) {
+            _structure = _rhs._part == _CountingRhs::IMPLICIT ?
+                    _model.getImplicitJacobianStructure() : _model.getJacobianStructure();
+            _structure.setDimension(n);
+            _groups.clear();
+            _bound = true;
+        }
+
+        return _structure;
+    }
+
+    bool _Jacobian::isDifferenced(size_t n) {
+        return structure(n).getType() == JacobianStructure::DENSE ? !_analytic : !_analyticValues;
+    }
+
+    size_t _Jacobian::getDifferenceCost(size_t n) {
+        std::vector<size_t> group;
+        return structure(n).getColumnGroups(group);
+    }
+
+    double _Jacobian::perturbationScale(const DVec& y) {
+        double scale = 0;
+
+        for (size_t j = 0; j < y.size(); j++) {
+            scale = std::max(scale, std::fabs(y[j]));
+        }
+
+        return scale > 0 ? 1.e-3 * scale : 1;
+    }
+
+    void _Jacobian::compute(const DVec& y, const DVec& f, double t, DVec& values) {
+        const size_t n = y.size();
+        const JacobianStructure& s = structure(n);
+
+        values.assign(s.getValueCount(), 0);
+
+        if (_analyticValues && _model.jacobianValues(y, values, t)) {
+            return;
+        }
+
+        _analyticValues = false;
+
+        if (_groups.empty() && n > 0) {
+            std::vector<size_t> group;
+            _groups.resize(s.getColumnGroups(group));
+
+            for (size_t j = 0; j < n; j++) {
+                _groups[group[j]].push_back(j);
+            }
+        }
+
+        const std::vector<size_t>& pointers = s.getColumnPointers();
+        const std::vector<size_t>& rows = s.getColumnRows();
+        const std::vector<size_t>& positions = s.getColumnPositions();
+
+        const double scale = perturbationScale(y);
+
+        _y = y;
+        _f.resize(n);
+        _delta.resize(n);
+
+        for (size_t g = 0; g < _groups.size(); g++) {
+            const std::vector<size_t>& columns = _groups[g];
+
+            for (size_t c = 0; c < columns.size(); c++) {
+                const size_t j = columns[c];
+
+                _y[j] = y[j] + std::sqrt(DBL_EPSILON) * std::max(std::fabs(y[j]), scale);
+                _delta[j] = _y[j] - y[j];
+            }
+
+            _rhs(_y, _f, t);
+
+            for (size_t c = 0; c < columns.size(); c++) {
+                const size_t j = columns[c];
+
+                for (size_t k = pointers[j]; k < pointers[j + 1]; k++) {
+                    values[positions[k]] = (_f[rows[k]] - f[rows[k]]) / _delta[j];
+                }
+
+                _y[j] = y[j];
+            }
+        }
+    }
+
+}
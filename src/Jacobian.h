@@ -0,0 +1,111 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef JACOBIAN_H
+#define	JACOBIAN_H
+
+#include <vector>
+
+#include "Types.h"
+#include "Model.h"
+#include "JacobianStructure.h"
+#include "SolveStats.h"
+#include "SolverSupport.h"
+
+namespace iNumerics {
+
+    /**
+     * Jacobian df/dy from Model::jacobian() or, if the model does not
+     * implement it, by forward differences of the rhs (n rhs calls).
+     *
+     * values() gives df/dy in the storage of Model::getJacobianStructure()
+     * from Model::jacobianValues() or by differences with one rhs call per
+     * group of columns without a common row.
+     *
+     * For the implicit part of a split model (rhs of the part IMPLICIT)
+     * the Jacobian is always differenced, in
+     * Model::getImplicitJacobianStructure().
+     */
+    class _Jacobian {
+    public:
+
+        _Jacobian(Model& model, _CountingRhs rhs, SolveStats& stats);
+
+        /**
+         * @param y	state (size n)
+         * @param f	f(y, t)
+         * @param J	column-major n x n result
+         */
+        void operator()(const DVec& y, const DVec& f, double t, DVec& J);
+
+        /**
+         * df/dy in the storage of structure(y.size()).
+         */
+        void values(const DVec& y, const DVec& f, double t, DVec& values);
+
+        /**
+         * Model::getJacobianStructure() with the dimension set to n.
+         */
+        const JacobianStructure& structure(size_t n);
+
+        /**
+         * @return true if the model does not provide the Jacobian in
+         *         structure(n), known after the first values()
+         */
+        bool isDifferenced(size_t n);
+
+        /**
+         * rhs calls of a differenced values(): one per group of columns
+         * without a common row, n for a dense structure.
+         */
+        size_t getDifferenceCost(size_t n);
+
+    private:
+
+        static double perturbationScale(const DVec& y);
+
+        void compute(const DVec& y, const DVec& f, double t, DVec& values);
+
+        Model& _model;
+        _CountingRhs _rhs;
+        SolveStats& _stats;
+        bool _analytic;
+        bool _analyticValues;
+        bool _bound;
+        JacobianStructure _structure;
+        std::vector<std::vector<size_t> > _groups;
+        DVec _y;
+        DVec _f;
+        DVec _delta;
+        DVec _values;
+    };
+
+}
+
+#endif	/* JACOBIAN_H */
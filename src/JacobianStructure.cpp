@@ -0,0 +1,315 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+
+#include "JacobianStructure.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace iNumerics {
+
+    JacobianStructure::JacobianStructure()
+    : _type(DENSE), _n(0), _lower(0), _upper(0), _blockSize(0) {
+    }
+
+    JacobianStructure JacobianStructure::banded(size_t lower, size_t upper) {
+        JacobianStructure s;
+        s._type = BANDED;
+        s._lower = lower;
+        s._upper = upper;
+
+        return s;
+    }
+
+    JacobianStructure JacobianStructure::blockDiagonal(size_t blockSize) {
+        if (blockSize == 0) {
+            throw std::invalid_argument("JacobianStructure: block size must be > 0");
+        }
+
+        JacobianStructure s;
+        s._type = BLOCK_DIAGONAL;
+        s._blockSize = blockSize;
+
+        return s;
+    }
+
+    JacobianStructure JacobianStructure::sparse(const std::vector<size_t>& rowPointers,
+            const std::vector<size_t>& columnIndices) {
+        JacobianStructure s;
+        s._type = SPARSE;
+        s._rowPointers = rowPointers;
+        s._columnIndices = columnIndices;
+
+        return s;
+    }
+
+    JacobianStructure::Type JacobianStructure::getType() const {
+        return _type;
+    }
+
+    size_t JacobianStructure::getLowerBandwidth() const {
+        return _lower;
+    }
+
+    size_t JacobianStructure::getUpperBandwidth() const {
+        return _upper;
+    }
+
+    size_t JacobianStructure::getBlockSize() const {
+        return _blockSize;
+    }
+
+    const std::vector<size_t>& JacobianStructure::getRowPointers() const {
+        return _rowPointers;
+    }
+
+    const std::vector<size_t>& JacobianStructure::getColumnIndices() const {
+        return _columnIndices;
+    }
+
+    void JacobianStructure::setDimension(size_t n) {
+        if (_type == BLOCK_DIAGONAL && n % _blockSize != 0) {
+            throw std::invalid_argument("JacobianStructure: block size does not divide the dimension");
+        }
+
+        if (_type == SPARSE) {
+            if (_rowPointers.size() != n + 1 || _rowPointers[0] != 0
+                    || _rowPointers[n] != _columnIndices.size()) {
+                throw std::invalid_argument("JacobianStructure: row pointers do not match the dimension");
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                bool diagonal = false;
+
+                if (_rowPointers[i] > _rowPointers[i + 1]) {
+                    throw std::invalid_argument("JacobianStructure: row pointers must not decrease");
+                }
+
+                for (size_t k = _rowPointers[i]; k < _rowPointers[i + 1]; k++) {
+                    if (_columnIndices[k] >= n
+                            || (k > _rowPointers[i] && _columnIndices[k] <= _columnIndices[k - 1])) {
+                        throw std::invalid_argument("JacobianStructure: column indices must be ascending and < n");
+                    }
+
+                    diagonal = diagonal || _columnIndices[k] == i;
+                }
+
+                if (!diagonal) {
+                    throw std::invalid_argument("JacobianStructure: the diagonal must be part of a sparse structure");
+                }
+            }
+        }
+
+        _n = n;
+
+        _diagonal.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            _diagonal[i] = index(i, i);
+        }
+
+        _columnPointers.clear();
+        _columnRows.clear();
+        _columnPositions.clear();
+
+        if (_type == DENSE) {
+            return;
+        }
+
+        _columnPointers.assign(n + 1, 0);
+
+        if (_type == SPARSE) {
+            for (size_t k = 0; k < _columnIndices.size(); k++) {
+                _columnPointers[_columnIndices[k] + 1]++;
+            }
+
+            for (size_t j = 0; j < n; j++) {
+                _columnPointers[j + 1] += _columnPointers[j];
+            }
+
+            std::vector<size_t> next(_columnPointers.begin(), _columnPointers.end() - 1);
+            _columnRows.resize(_columnIndices.size());
+            _columnPositions.resize(_columnIndices.size());
+
+            for (size_t i = 0; i < n; i++) {
+                for (size_t k = _rowPointers[i]; k < _rowPointers[i + 1]; k++) {
+                    size_t& p = next[_columnIndices[k]];
+                    _columnRows[p] = i;
+                    _columnPositions[p] = k;
+                    p++;
+                }
+            }
+
+            return;
+        }
+
+        for (size_t j = 0; j < n; j++) {
+            size_t first, last;
+
+            if (_type == BANDED) {
+                first = j > _upper ? j - _upper : 0;
+                last = std::min(n - 1, j + _lower);
+            } else {
+                first = j - j % _blockSize;
+                last = first + _blockSize - 1;
+            }
+
+            for (size_t i = first; i <= last; i++) {
+                _columnRows.push_back(i);
+                _columnPositions.push_back(index(i, j));
+            }
+
+            _columnPointers[j + 1] = _columnRows.size();
+        }
+    }
+
+    size_t JacobianStructure::getDimension() const {
+        return _n;
+    }
+
+    size_t JacobianStructure::getValueCount() const {
+        switch (_type) {
+            case BANDED:
+                return _n * (_lower + _upper + 1);
+            case BLOCK_DIAGONAL:
+                return _n * _blockSize;
+            case SPARSE:
+                return _columnIndices.size();
+            default:
+                return _n * _n;
+        }
+    }
+
+    size_t JacobianStructure::index(size_t i, size_t j) const {
+        if (i >= _n || j >= _n) {
+            return npos;
+        }
+
+        switch (_type) {
+            case BANDED:
+                if (i + _upper < j || i > j + _lower) {
+                    return npos;
+                }
+
+                return j * (_lower + _upper + 1) + _upper + i - j;
+            case BLOCK_DIAGONAL:
+            {
+                size_t first = i - i % _blockSize;
+
+                if (j < first || j >= first + _blockSize) {
+                    return npos;
+                }
+
+                return first * _blockSize + (j - first) * _blockSize + i - first;
+            }
+            case SPARSE:
+            {
+                std::vector<size_t>::const_iterator begin = _columnIndices.begin() + _rowPointers[i];
+                std::vector<size_t>::const_iterator end = _columnIndices.begin() + _rowPointers[i + 1];
+                std::vector<size_t>::const_iterator k = std::lower_bound(begin, end, j);
+
+                return k != end && *k == j ? k - _columnIndices.begin() : npos;
+            }
+            default:
+                return j * _n + i;
+        }
+    }
+
+    const std::vector<size_t>& JacobianStructure::getDiagonal() const {
+        return _diagonal;
+    }
+
+    size_t JacobianStructure::getColumnGroups(std::vector<size_t>& group) const {
+        const size_t n = _n;
+
+        group.resize(n);
+
+        if (_type != SPARSE) {
+            size_t width = n;
+
+            if (_type == BANDED) {
+                width = _lower + _upper + 1;
+            } else if (_type == BLOCK_DIAGONAL) {
+                width = _blockSize;
+            }
+
+            for (size_t j = 0; j < n; j++) {
+                group[j] = j % width;
+            }
+
+            return std::min(width, n);
+        }
+
+        // greedy coloring in column order
+        const size_t unassigned = npos;
+        std::vector<size_t> usedBy(n, unassigned);
+        size_t count = 0;
+
+        group.assign(n, unassigned);
+
+        for (size_t j = 0; j < n; j++) {
+            for (size_t k = _columnPointers[j]; k < _columnPointers[j + 1]; k++) {
+                const size_t i = _columnRows[k];
+
+                for (size_t l = _rowPointers[i]; l < _rowPointers[i + 1]; l++) {
+                    const size_t c = group[_columnIndices[l]];
+
+                    if (c != unassigned) {
+                        usedBy[c] = j;
+                    }
+                }
+            }
+
+            size_t c = 0;
+
+            while (c < count && usedBy[c] == j) {
+                c++;
+            }
+
+            group[j] = c;
+            count = std::max(count, c + 1);
+        }
+
+        return count;
+    }
+
+    const std::vector<size_t>& JacobianStructure::getColumnPointers() const {
+        return _columnPointers;
+    }
+
+    const std::vector<size_t>& JacobianStructure::getColumnRows() const {
+        return _columnRows;
+    }
+
+    const std::vector<size_t>& JacobianStructure::getColumnPositions() const {
+        return _columnPositions;
+    }
+
+}
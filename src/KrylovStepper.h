@@ -0,0 +1,340 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef KRYLOVSTEPPER_H
+#define	KRYLOVSTEPPER_H
+
+#include <cmath>
+#include <algorithm>
+
+#include <boost/numeric/odeint/stepper/controlled_step_result.hpp>
+
+#include "Types.h"
+#include "Preconditioner.h"
+#include "SolveStats.h"
+#include "Gmres.h"
+#include "NewtonTest.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    /**
+     * Controlled TR-BDF2 stepper (Bank et al. 1985, as the ESDIRK of
+     * Hosea & Shampine 1996: L-stable, stiffly accurate, order 2 with an
+     * embedded order 3 error estimate) whose stage equations are solved by
+     * an inexact Newton method with GMRES. Jacobian-vector products are
+     * differences of the rhs, so no Jacobian is ever formed and memory is
+     * linear in n.
+     *
+     * All norms are weighted RMS norms with the weights
+     * absError + relError |y| of the step start; GMRES runs on the
+     * correspondingly scaled system.
+     */
+    class _KrylovStepper {
+    public:
+
+        _KrylovStepper(SolveStats& stats, Preconditioner* preconditioner,
+                double absError, double relError)
+        : _stats(stats), _preconditioner(preconditioner), _gmres(KRYLOV_DIMENSION, KRYLOV_RESTARTS),
+        _absError(absError), _relError(relError), _lastRejected(false) {
+        }
+
+        template <class System>
+        boost::numeric::odeint::controlled_step_result try_step(System system,
+                DVec& x, const DVec& dxdt, double& t, double& dt) {
+
+            using namespace boost::numeric::odeint;
+
+            static const double gamma = 2 - std::sqrt(2.);
+            static const double d = gamma / 2;
+            static const double w = std::sqrt(2.) / 4;
+            // embedded order 3 weights
+            static const double e1 = w - (1 - w) / 3;
+            static const double e2 = w - (3 * w + 1) / 3;
+            static const double e3 = d - d / 3;
+
+            const size_t n = x.size();
+            const double hd = dt * d;
+
+            _weights.resize(n);
+
+            for (size_t i = 0; i < n; i++) {
+                _weights[i] = _absError + _relError * std::fabs(x[i]);
+            }
+
+            if (_preconditioner != NULL && !_preconditioner->setup(x, dxdt, t, hd)) {
+                dt *= 0.5;
+                _lastRejected = true;
+                return fail;
+            }
+
+            _newtonTest.reset();
+
+            _psi.resize(n);
+            _z.resize(n);
+
+            // stage 2: trapezoidal rule to t + gamma h
+            for (size_t i = 0; i < n; i++) {
+                _psi[i] = x[i] + hd * dxdt[i];
+                _z[i] = x[i] + gamma * dt * dxdt[i];
+            }
+
+            if (!stage(system, t + gamma * dt, hd, _k2)) {
+                IN_TRACE_INSTANT("newton failure", dt);
+                dt *= 0.25;
+                _lastRejected = true;
+                return fail;
+            }
+
+            // stage 3: BDF2 to t + h
+            for (size_t i = 0; i < n; i++) {
+                _psi[i] = x[i] + dt * w * (dxdt[i] + _k2[i]);
+                _z[i] = _psi[i] + hd * _k2[i];
+            }
+
+            if (!stage(system, t + dt, hd, _k3)) {
+                IN_TRACE_INSTANT("newton failure", dt);
+                dt *= 0.25;
+                _lastRejected = true;
+                return fail;
+            }
+
+            double err = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                double e = dt * (e1 * dxdt[i] + e2 * _k2[i] + e3 * _k3[i]);
+                double sk = _absError + _relError * std::max(std::fabs(x[i]), std::fabs(_z[i]));
+                err += (e / sk) * (e / sk);
+            }
+
+            err = n > 0 ? std::sqrt(err / n) : 0;
+
+            // the error estimate is of order 2
+            double fac = err > 0 ? 0.9 * std::pow(err, -1. / 3) : 5;
+            fac = std::max(0.2, std::min(5., fac));
+
+            if (err <= 1) {
+                if (_lastRejected) {
+                    fac = std::min(fac, 1.);
+                }
+
+                x.swap(_z);
+                t += dt;
+                dt *= fac;
+                _lastRejected = false;
+                return success;
+            }
+
+            dt *= fac;
+            _lastRejected = true;
+            return fail;
+        }
+
+    private:
+
+        static const size_t KRYLOV_DIMENSION = 20;
+        static const size_t KRYLOV_RESTARTS = 4;
+        static const size_t MAX_NEWTON = 4;
+
+        /**
+         * Applies I - gamma J to a scaled vector by a difference of the rhs
+         * at the current Newton iterate.
+         */
+        template <class System>
+        class _NewtonOperator {
+        public:
+
+            _NewtonOperator(System& system, const DVec& z, const DVec& fz, double t, double gamma,
+                    const DVec& weights)
+            : _system(system), _z(z), _fz(fz), _t(t), _gamma(gamma), _weights(weights) {
+            }
+
+            void operator()(const DVec& v, DVec& Av) {
+                const size_t n = v.size();
+                double norm = 0;
+
+                for (size_t i = 0; i < n; i++) {
+                    norm += v[i] * v[i];
+                }
+
+                norm = n > 0 ? std::sqrt(norm / n) : 0;
+                Av.resize(n);
+
+                if (norm == 0) {
+                    std::fill(Av.begin(), Av.end(), 0);
+                    return;
+                }
+
+                // a perturbation of the size of the error weights
+                const double sigma = 1 / norm;
+
+                _zp.resize(n);
+                _fp.resize(n);
+
+                for (size_t i = 0; i < n; i++) {
+                    _zp[i] = _z[i] + sigma * _weights[i] * v[i];
+                }
+
+                _system(_zp, _fp, _t);
+
+                for (size_t i = 0; i < n; i++) {
+                    Av[i] = v[i] - _gamma * (_fp[i] - _fz[i]) / (sigma * _weights[i]);
+                }
+            }
+
+        private:
+            System& _system;
+            const DVec& _z;
+            const DVec& _fz;
+            double _t;
+            double _gamma;
+            const DVec& _weights;
+            DVec _zp;
+            DVec _fp;
+        };
+
+        /**
+         * The user preconditioner on scaled vectors (identity if none).
+         */
+        class _ScaledPreconditioner {
+        public:
+
+            _ScaledPreconditioner(Preconditioner* preconditioner, const DVec& weights)
+            : _preconditioner(preconditioner), _weights(weights) {
+            }
+
+            void operator()(const DVec& v, DVec& z) {
+                const size_t n = v.size();
+
+                if (_preconditioner == NULL) {
+                    z = v;
+                    return;
+                }
+
+                _r.resize(n);
+                z.resize(n);
+
+                for (size_t i = 0; i < n; i++) {
+                    _r[i] = _weights[i] * v[i];
+                }
+
+                _preconditioner->solve(_r, z);
+
+                for (size_t i = 0; i < n; i++) {
+                    z[i] /= _weights[i];
+                }
+            }
+
+        private:
+            Preconditioner* _preconditioner;
+            const DVec& _weights;
+            DVec _r;
+        };
+
+        /**
+         * Solves z = psi + gamma f(t, z) from the predictor in _z.
+         * @param k	receives (z - psi) / gamma, i.e. f(t, z)
+         * @return false if Newton's method does not converge
+         */
+        template <class System>
+        bool stage(System& system, double t, double gamma, DVec& k) {
+            const size_t n = _z.size();
+
+            // GMRES solves to 5% of the Newton tolerance
+            const double eta = 0.05 * 0.1;
+
+            _fz.resize(n);
+            _b.resize(n);
+
+            _ScaledPreconditioner M(_preconditioner, _weights);
+
+            for (size_t it = 0; it < MAX_NEWTON; it++) {
+                system(_z, _fz, t);
+
+                for (size_t i = 0; i < n; i++) {
+                    _b[i] = (_psi[i] + gamma * _fz[i] - _z[i]) / _weights[i];
+                }
+
+                _NewtonOperator<System> A(system, _z, _fz, t, gamma, _weights);
+
+                _stats.linearIterations += _gmres.solve(A, M, _b, _delta, eta * std::sqrt((double) n));
+                _stats.newtonIterations++;
+
+                double norm = 0;
+
+                for (size_t i = 0; i < n; i++) {
+                    _z[i] += _weights[i] * _delta[i];
+                    norm += _delta[i] * _delta[i];
+                }
+
+                norm = n > 0 ? std::sqrt(norm / n) : 0;
+
+                _NewtonTest::Result result = _newtonTest(it, norm);
+
+                if (result == _NewtonTest::DIVERGED) {
+                    return false;
+                }
+
+                if (result == _NewtonTest::CONVERGED) {
+                    k.resize(n);
+
+                    for (size_t i = 0; i < n; i++) {
+                        k[i] = (_z[i] - _psi[i]) / gamma;
+                    }
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        SolveStats& _stats;
+        Preconditioner* _preconditioner;
+        _Gmres _gmres;
+        double _absError;
+        double _relError;
+
+        _NewtonTest _newtonTest;
+        bool _lastRejected;
+
+        DVec _weights;
+        DVec _psi;
+        DVec _z;
+        DVec _fz;
+        DVec _b;
+        DVec _delta;
+        DVec _k2;
+        DVec _k3;
+    };
+
+}
+
+#endif	/* KRYLOVSTEPPER_H */
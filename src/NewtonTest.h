@@ -0,0 +1,95 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef NEWTONTEST_H
+#define	NEWTONTEST_H
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+namespace iNumerics {
+
+    /**
+     * Convergence test of the Newton iterations of the implicit stage
+     * solvers, after CVODE: the estimate of the convergence rate starts at
+     * 1 for every new iteration matrix and decreases by at most a factor
+     * of 0.3 per iteration, and the iteration has converged when the
+     * weighted RMS norm of the correction times min(1, rate) is below a
+     * tenth of the tolerance.
+     */
+    class _NewtonTest {
+    public:
+
+        enum Result {
+            CONTINUE, CONVERGED, DIVERGED
+        };
+
+        _NewtonTest() : _rate(1), _previous(0) {
+        }
+
+        /**
+         * For a new iteration matrix.
+         */
+        void reset() {
+            _rate = 1;
+        }
+
+        /**
+         * @param it	iteration, 0 for the first one of a solve
+         * @param norm	weighted RMS norm of its correction
+         */
+        Result operator()(size_t it, double norm) {
+            if (!std::isfinite(norm)) {
+                return DIVERGED;
+            }
+
+            if (it > 0) {
+                const double ratio = norm / _previous;
+
+                if (ratio >= 0.9) {
+                    return DIVERGED;
+                }
+
+                _rate = std::max(0.3 * _rate, ratio);
+            }
+
+            _previous = norm;
+
+            return norm * std::min(1., _rate) <= 0.1 ? CONVERGED : CONTINUE;
+        }
+
+    private:
+        double _rate;
+        double _previous;
+    };
+
+}
+
+#endif	/* NEWTONTEST_H */
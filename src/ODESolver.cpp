@@ -28,24 +28,40 @@
 
 #include "ODESolver.h"
 
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
 #include <boost/numeric/odeint.hpp>
 
-namespace iNumerics {
+#include "inprofiler.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+#include "Interpolation.h"
+#include "DenseLU.h"
+#include "StructuredLU.h"
+#include "Adjoint.h"
+#include "DelayModel.h"
+#include "DelayHistory.h"
+#include "Preconditioner.h"
 
-    class _StepObserver {
-    public:
-        Trajectory& _trajectory;
-        Problem& _p;
-
-        _StepObserver(Problem& p, Trajectory& trajectory)
-        : _trajectory(trajectory), _p(p) {
-        }
+#include "SolverSupport.h"
+#include "Jacobian.h"
+#include "Sensitivity.h"
+#include "RosenbrockW.h"
+#include "KrylovStepper.h"
+#include "Bdf.h"
+#include "ImexStepper.h"
+#include "EventLocator.h"
+#include "IntegrateAdaptive.h"
+#include "AdjointSweep.h"
+#include "DelayRhs.h"
+#include "DormandPrince.h"
+#include "SwitchingStepper.h"
 
-        void operator()(const DVec &x, double t) {
-            _trajectory(x, t);
-            _p.step(x, t);
-        }
-    };
+namespace iNumerics {
 
 //    class _RhsWrapper {
 //    public:
@@ -62,45 +78,890 @@ namespace iNumerics {
 //        Problem& _rhsObj;
 //    };
 
+    /**
+     * Reads the mass matrix of the model in the storage of structure (bound
+     * to the dimension, see Model::getJacobianStructure()). Nothing is
+     * allocated for models without one (Model::hasMassMatrix()).
+     * @return false for M = I
+     */
+    static bool _massMatrix(Model& model, const JacobianStructure& structure, DVec& M) {
+        if (!model.hasMassMatrix()) {
+            M.clear();
+            return false;
+        }
+
+        M.assign(structure.getValueCount(), 0);
+
+        bool mass = structure.getType() == JacobianStructure::DENSE ?
+                model.massMatrix(M) : model.massMatrixValues(M);
+
+        if (!mass) {
+            M.clear();
+        }
+
+        return mass;
+    }
+
+    /**
+     * Consistent initial values of a semi-explicit DAE M y' = f(y, t): the
+     * algebraic variables (zero columns of M) are corrected by Newton's
+     * method until the algebraic equations (zero rows of M) hold. The
+     * differential variables are left unchanged. M is in the storage of
+     * jacobian.structure().
+     */
+    static void _initializeAlgebraic(const DVec& M, _CountingRhs& rhs, _Jacobian& jacobian,
+            SolveStats& stats, double absError, double relError, DVec& x, double t) {
+
+        const size_t n = x.size();
+        const size_t max_iterations = 20;
+        const JacobianStructure& structure = jacobian.structure(n);
+
+        std::vector<bool> zeroRow(n, true);
+        std::vector<bool> zeroColumn(n, true);
+
+        if (structure.getType() == JacobianStructure::DENSE) {
+            for (size_t j = 0; j < n; j++) {
+                for (size_t i = 0; i < n; i++) {
+                    if (M[j * n + i] != 0) {
+                        zeroRow[i] = false;
+                        zeroColumn[j] = false;
+                    }
+                }
+            }
+        } else {
+            const std::vector<size_t>& pointers = structure.getColumnPointers();
+            const std::vector<size_t>& rows = structure.getColumnRows();
+            const std::vector<size_t>& positions = structure.getColumnPositions();
+
+            for (size_t j = 0; j < n; j++) {
+                for (size_t k = pointers[j]; k < pointers[j + 1]; k++) {
+                    if (M[positions[k]] != 0) {
+                        zeroRow[rows[k]] = false;
+                        zeroColumn[j] = false;
+                    }
+                }
+            }
+        }
+
+        std::vector<size_t> equations;
+        std::vector<size_t> variables;
+
+        for (size_t k = 0; k < n; k++) {
+            if (zeroRow[k]) {
+                equations.push_back(k);
+            }
+
+            if (zeroColumn[k]) {
+                variables.push_back(k);
+            }
+        }
+
+        if (equations.size() != variables.size()) {
+            throw std::invalid_argument("ODESolver: the mass matrix is not semi-explicit (algebraic equations and variables differ in number)");
+        }
+
+        const size_t m = variables.size();
+
+        if (m == 0) {
+            return;
+        }
+
+        DenseLU lu(&stats);
+        DVec f(n), J, A(m * m), r(m);
+
+        for (size_t iteration = 0; iteration < max_iterations; iteration++) {
+            rhs(x, f, t);
+            jacobian.values(x, f, t, J);
+
+            for (size_t j = 0; j < m; j++) {
+                for (size_t i = 0; i < m; i++) {
+                    size_t position = structure.index(equations[i], variables[j]);
+                    A[j * m + i] = position == JacobianStructure::npos ? 0 : J[position];
+                }
+
+                r[j] = f[equations[j]];
+            }
+
+            if (!lu.factor(A, m)) {
+                throw std::runtime_error("ODESolver: singular algebraic Jacobian, the DAE is not of index 1");
+            }
+
+            lu.solve(r);
+
+            double norm = 0;
+
+            for (size_t j = 0; j < m; j++) {
+                double& v = x[variables[j]];
+                v -= r[j];
+                norm = std::max(norm, std::fabs(r[j]) / (absError + relError * std::fabs(v)));
+            }
+
+            if (norm <= 1.e-3) {
+                return;
+            }
+        }
+
+        throw std::runtime_error("ODESolver: consistent initialization failed");
+    }
+
+    /**
+     * Derivative discontinuity of a DDE solution at t. It propagates to the
+     * times t' with t' - tau_k(t', y(t')) = t, one order higher.
+     */
+    struct _Discontinuity {
+        double t;
+        int order;
+        // delays for which the propagated discontinuity has been reached
+        std::vector<bool> passed;
+    };
+
+    /**
+     * Stores the hardware counters of the calling thread between
+     * construction and finish() in the stats.
+     */
+    class _PerfScope {
+    public:
+
+        _PerfScope(SolveStats& stats) : _stats(stats) {
+            PerfCounters::snapshot(_start);
+        }
+
+        void finish() {
+            PerfCounters::snapshot(_stats.perf);
+
+            for (int r = 0; r < PERF_REGIONS; r++) {
+                _stats.perf[r] -= _start[r];
+            }
+        }
+
+    private:
+        SolveStats& _stats;
+        PerfCounts _start[PERF_REGIONS];
+    };
+
     ODESolver::ODESolver() {
     }
 
     ODESolver::~ODESolver() {
     }
 
-    void ODESolver::solve(Problem& problem, Trajectory& trajectory) {
+    SolveStats ODESolver::solve(Problem& problem, Trajectory& trajectory) {
+        Checkpoint start;
+        start.t = problem._t0;
+        start.dt = problem._h;
+        start.x = problem._init;
+
+        return integrate(problem, trajectory, start, true);
+    }
+
+    SolveStats ODESolver::resume(Problem& problem, Trajectory& trajectory, const Checkpoint& checkpoint) {
+        if (checkpoint.x.size() != problem._init.size()) {
+            throw std::invalid_argument("ODESolver: checkpoint does not match the problem dimension");
+        }
+
+        return integrate(problem, trajectory, checkpoint, false);
+    }
+
+    SolveStats ODESolver::integrate(Problem& problem, Trajectory& trajectory,
+            const Checkpoint& from, bool recordStart) {
 
         using namespace boost::numeric::odeint;
 
         typedef runge_kutta_cash_karp54< DVec > error_stepper_type; // may change
 
-        integrate_adaptive(
+        if (problem._model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: a mass matrix requires solve_implicit()");
+        }
+
+        SolveStats stats = from.stats;
+        stats.observerTime = 0;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        std::unique_ptr<CheckpointWriter> checkpoints;
+
+        if (!problem._checkpointPath.empty()) {
+            checkpoints.reset(new CheckpointWriter(problem._checkpointPath, problem._checkpointInterval));
+        }
+
+        DVec x = from.x;
+        _StepObserver observer(problem, trajectory, stats);
+        _EventLocator events(problem._events);
+
+        _integrate_adaptive(
                 make_controlled< error_stepper_type > (problem._absError, problem._relError),
-                problem,
-                problem._init,
-                problem._t0,
+                _CountingRhs(problem, stats),
+                x,
+                from.t,
                 problem._tn,
-                problem._h,
-                _StepObserver(problem, trajectory));
+                from.dt,
+                observer,
+                events,
+                stats,
+                recordStart,
+                checkpoints.get());
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
     }
     
     
-    void ODESolver::solve_implicit(Problem& problem, Trajectory& trajectory) {
-        
-        std::cerr << "void ODESolver::solve_implicit(...) not implemented!" << std::endl;
-        
+    SolveStats ODESolver::solve_implicit(Problem& problem, Trajectory& trajectory) {
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
 
-//        using namespace boost::numeric::odeint;
-//
-//        typedef implicit_euler< DVec > error_stepper_type; // may change
-//
-//        integrate_adaptive(
-//                make_controlled< error_stepper_type > (problem._absError, problem._relError),
-//                problem,
-//                problem._init,
-//                problem._t0,
-//                problem._tn,
-//                problem._h,
-//                _StepObserver(problem, trajectory));
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DVec x = problem._init;
+        _CountingRhs rhs(problem, stats);
+        _Jacobian jacobian(problem._model, rhs, stats);
+        _StepObserver observer(problem, trajectory, stats);
+        _EventLocator events(problem._events);
+        _RosenbrockW stepper(jacobian, stats, x.size(), problem._absError, problem._relError, true);
+
+        DVec M;
+
+        if (_massMatrix(problem._model, jacobian.structure(x.size()), M)) {
+            if (!problem._events.empty()) {
+                throw std::logic_error("ODESolver: events are not supported with a mass matrix");
+            }
+
+            _initializeAlgebraic(M, rhs, jacobian, stats, problem._absError, problem._relError, x, problem._t0);
+            stepper.setMassMatrix(M, problem._algebraicErrorControl);
+        }
+
+        _integrate_adaptive(
+                stepper,
+                rhs,
+                x,
+                problem._t0,
+                problem._tn,
+                problem._h,
+                observer,
+                events,
+                stats,
+                true,
+                NULL);
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+
+    SolveStats ODESolver::solve_krylov(Problem& problem, Trajectory& trajectory) {
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        if (problem._model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: a mass matrix requires solve_implicit()");
+        }
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DVec x = problem._init;
+        _StepObserver observer(problem, trajectory, stats);
+        _EventLocator events(problem._events);
+
+        _integrate_adaptive(
+                _KrylovStepper(stats, problem._preconditioner, problem._absError, problem._relError),
+                _CountingRhs(problem, stats),
+                x,
+                problem._t0,
+                problem._tn,
+                problem._h,
+                observer,
+                events,
+                stats,
+                true,
+                NULL);
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+
+    SolveStats ODESolver::solve_bdf(Problem& problem, Trajectory& trajectory) {
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        if (problem._model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: a mass matrix requires solve_implicit()");
+        }
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DVec x = problem._init;
+        _CountingRhs rhs(problem, stats);
+        _Jacobian jacobian(problem._model, rhs, stats);
+        _StepObserver observer(problem, trajectory, stats);
+        _EventLocator events(problem._events);
+        _Bdf stepper(jacobian, stats, problem._absError, problem._relError);
+
+        // by reference: the stepper keeps the history across steps
+        _integrate_adaptive< _Bdf& >(
+                stepper,
+                rhs,
+                x,
+                problem._t0,
+                problem._tn,
+                problem._h,
+                observer,
+                events,
+                stats,
+                true,
+                NULL);
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
     }
+
+    SolveStats ODESolver::solve_auto(Problem& problem, Trajectory& trajectory) {
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        if (problem._model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: a mass matrix requires solve_implicit()");
+        }
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DVec x = problem._init;
+        _CountingRhs rhs(problem, stats);
+        _Jacobian jacobian(problem._model, rhs, stats);
+        _StepObserver observer(problem, trajectory, stats);
+        _EventLocator events(problem._events);
+        _SwitchingStepper stepper(jacobian, stats, x.size(), problem._absError, problem._relError);
+
+        // by reference: the stepper keeps the method and its counters
+        _integrate_adaptive< _SwitchingStepper& >(
+                stepper,
+                rhs,
+                x,
+                problem._t0,
+                problem._tn,
+                problem._h,
+                observer,
+                events,
+                stats,
+                true,
+                NULL);
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+
+    SolveStats ODESolver::solve_imex(Problem& problem, Trajectory& trajectory) {
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        if (problem._model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: a mass matrix requires solve_implicit()");
+        }
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DVec x = problem._init;
+        _SplitRhs rhs(problem, problem._model, stats);
+        _Jacobian jacobian(problem._model, rhs._implicit, stats);
+        _StepObserver observer(problem, trajectory, stats);
+        _EventLocator events(problem._events);
+        _ImexStepper stepper(jacobian, stats, problem._absError, problem._relError);
+
+        _integrate_adaptive< _ImexStepper& >(
+                stepper,
+                rhs,
+                x,
+                problem._t0,
+                problem._tn,
+                problem._h,
+                observer,
+                events,
+                stats,
+                true,
+                NULL);
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+
+    SolveStats ODESolver::solve(Problem& problem, Trajectory& trajectory, Trajectory& sensitivities) {
+        return integrateSensitivity(problem, trajectory, sensitivities, false);
+    }
+
+    SolveStats ODESolver::solve_implicit(Problem& problem, Trajectory& trajectory, Trajectory& sensitivities) {
+        return integrateSensitivity(problem, trajectory, sensitivities, true);
+    }
+
+    SolveStats ODESolver::integrateSensitivity(Problem& problem, Trajectory& trajectory,
+            Trajectory& sensitivities, bool implicit) {
+
+        using namespace boost::numeric::odeint;
+
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        Model& model = problem._model;
+        const size_t n = problem._init.size();
+
+        std::vector<size_t> parameters = problem._sensitivityParameters;
+
+        if (parameters.empty()) {
+            for (size_t k = 0; k < model.getParameterCount(); k++) {
+                parameters.push_back(k);
+            }
+        }
+
+        if (parameters.empty()) {
+            throw std::invalid_argument("ODESolver: the model has no parameters for sensitivities");
+        }
+
+        for (size_t k = 0; k < parameters.size(); k++) {
+            if (parameters[k] >= model.getParameterCount()) {
+                throw std::out_of_range("ODESolver: sensitivity parameter out of range");
+            }
+        }
+
+        const size_t p = parameters.size();
+
+        if (!problem._initialSensitivity.empty() && problem._initialSensitivity.size() != n * p) {
+            throw std::invalid_argument("ODESolver: initial sensitivity must have n * p entries");
+        }
+
+        if (!problem._events.empty()) {
+            throw std::logic_error("ODESolver: events are not supported with sensitivities");
+        }
+
+        if (model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: sensitivities are not supported with a mass matrix");
+        }
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DVec z(n * (p + 1), 0);
+        std::copy(problem._init.begin(), problem._init.end(), z.begin());
+        std::copy(problem._initialSensitivity.begin(), problem._initialSensitivity.end(), z.begin() + n);
+
+        _CountingRhs rhs(problem, stats);
+        _Sensitivity sensitivity(model, rhs, stats, n, parameters);
+        _SensitivityObserver observer(problem, trajectory, sensitivities, stats, n);
+
+        std::vector<Event*> noEvents;
+        _EventLocator events(noEvents);
+
+        size_t controlled = problem._sensitivityErrorControl ? 0 : n;
+
+        if (implicit) {
+            _Jacobian jacobian(model, rhs, stats);
+
+            _integrate_adaptive(
+                    _RosenbrockW(jacobian, stats, n, problem._absError, problem._relError, controlled == 0),
+                    _SensitivityRhs(sensitivity),
+                    z, problem._t0, problem._tn, problem._h,
+                    observer, events, stats, true, NULL);
+        } else {
+            typedef runge_kutta_cash_karp54< DVec > error_stepper_type;
+            typedef controlled_runge_kutta< error_stepper_type, _StateErrorChecker > controlled_stepper_type;
+
+            _integrate_adaptive(
+                    controlled_stepper_type(_StateErrorChecker(problem._absError, problem._relError, controlled)),
+                    _SensitivityRhs(sensitivity),
+                    z, problem._t0, problem._tn, problem._h,
+                    observer, events, stats, true, NULL);
+        }
+
+        trajectory.finish();
+        sensitivities.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+
+    SolveStats ODESolver::solve_adjoint(Problem& problem, Trajectory& trajectory,
+            Objective& objective, AdjointResult& result) {
+
+        using namespace boost::numeric::odeint;
+
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        typedef runge_kutta_cash_karp54< DVec > error_stepper_type;
+
+        Model& model = problem._model;
+        const size_t n = problem._init.size();
+        const size_t p = model.getParameterCount();
+
+        if (!problem._events.empty()) {
+            throw std::logic_error("ODESolver: events are not supported with adjoint sensitivities");
+        }
+
+        if (model.hasMassMatrix()) {
+            throw std::logic_error("ODESolver: adjoint sensitivities are not supported with a mass matrix");
+        }
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        result = AdjointResult();
+
+        // forward pass: the trajectory and the step times
+        std::vector<double> times;
+        DVec x = problem._init;
+        _CountingRhs rhs(problem, stats);
+        _StepObserver stepObserver(problem, trajectory, stats);
+        _TimeRecorder observer(stepObserver, times);
+
+        std::vector<Event*> noEvents;
+        _EventLocator events(noEvents);
+
+        _integrate_adaptive(
+                make_controlled< error_stepper_type > (problem._absError, problem._relError),
+                rhs, x, problem._t0, problem._tn, problem._h,
+                observer, events, stats, true, NULL);
+
+        trajectory.finish();
+
+        result.steps = times.size() - 1;
+
+        // backward pass: a = (lambda, mu) from (dg/dy, 0) at tn to t0
+        DVec dgdy(n, 0);
+        result.value = objective.evaluate(x, times.back(), dgdy);
+
+        if (dgdy.size() != n) {
+            throw std::invalid_argument("ODESolver: objective gradient must have n entries");
+        }
+
+        DVec a(n + p, 0);
+        std::copy(dgdy.begin(), dgdy.end(), a.begin());
+
+        _Adjoint adjoint(model, rhs, stats, n);
+        _AdjointSweep sweep(rhs, adjoint, times, problem._absError, problem._relError, result);
+
+        sweep.run(problem._init, a, problem._adjointSnapshots);
+
+        result.initialGradient.assign(a.begin(), a.begin() + n);
+        result.gradient.assign(a.begin() + n, a.end());
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+    SolveStats ODESolver::solve_delay(Problem& problem, Trajectory& trajectory) {
+
+        DelayModel* model = dynamic_cast<DelayModel*> (&problem._model);
+
+        if (model == NULL) {
+            throw std::invalid_argument("ODESolver: solve_delay() requires a DelayModel");
+        }
+
+        if (!problem._events.empty()) {
+            throw std::logic_error("ODESolver: events are not supported with delays");
+        }
+
+        if (!problem._checkpointPath.empty()) {
+            throw std::logic_error("ODESolver: checkpoints require solve()");
+        }
+
+        const size_t n = problem._init.size();
+        const size_t d = model->getDelayCount();
+        const double maxDelay = model->getMaxDelay();
+        const double t0 = problem._t0;
+        const double tn = problem._tn;
+
+        if (model->hasMassMatrix()) {
+            throw std::logic_error("ODESolver: a mass matrix is not supported with delays");
+        }
+
+        // discontinuities of higher order than the method do not limit its accuracy
+        const int maxOrder = 5;
+        const size_t max_attempts = 1000;
+        const double tolerance = 1.e-12 * std::max(1.0, std::fabs(tn - t0));
+
+        SolveStats stats;
+        inULong start = MonotonicClock::now();
+        _PerfScope perf(stats);
+
+        DelayHistory history(n);
+        _DelayRhs rhs(*model, history, problem._init, t0, stats);
+        _DormandPrince stepper(problem._absError, problem._relError);
+        _StepObserver observer(problem, trajectory, stats);
+
+        DVec y = problem._init;
+        DVec f(n), ynew(n), fnew(n), dense(5 * n), yd(n);
+        DVec tau(d), tauNew(d);
+
+        // delays whose discontinuities are predicted as xi + tau_k(t, y);
+        // a miss (the delay changed during the step) leaves them to root finding
+        std::vector<bool> predictable(d, true);
+
+        std::vector<_Discontinuity> breaks(1);
+        breaks[0].t = t0;
+        breaks[0].order = 0;
+        breaks[0].passed.assign(d, false);
+
+        // g(t) = t - tau_k(t, y(t)) - xi changes sign where the
+        // discontinuity at xi reaches the solution through delay k
+        auto lag = [&](size_t k, double theta, double t, double h, double xi) {
+            _DormandPrince::interpolate(dense, theta, yd);
+            double s = t + theta * h;
+
+            return s - model->getDelay(k, yd, s) - xi;
+        };
+
+        double t = t0;
+        double dt = problem._h;
+
+        observer(y, t);
+        rhs(y, f, t);
+
+        while (t < tn) {
+            if ((t + dt) > tn) {
+                dt = tn - t;
+            }
+
+            // step size before it is shortened for delays and discontinuities
+            double proposed = dt;
+
+            // method of steps: the delayed arguments stay in the history
+            for (size_t k = 0; k < d; k++) {
+                tau[k] = model->getDelay(k, y, t);
+
+                if (tau[k] > 0 && tau[k] < dt) {
+                    dt = tau[k];
+                }
+            }
+
+            // step onto the predicted discontinuities
+            size_t predictedBreak = breaks.size(), predictedDelay = d;
+
+            for (size_t b = 0; b < breaks.size(); b++) {
+                for (size_t k = 0; k < d; k++) {
+                    double c = breaks[b].t + tau[k];
+
+                    if (predictable[k] && !breaks[b].passed[k] && c > t + tolerance && c < t + dt) {
+                        dt = c - t;
+                        predictedBreak = b;
+                        predictedDelay = k;
+                    }
+                }
+            }
+
+            size_t trials = 0;
+            double err = 0;
+
+            // discontinuity (break, delay) located by root finding; the
+            // retried step ends on it up to the accuracy of the solution
+            size_t targetBreak = breaks.size(), targetDelay = d;
+
+            IN_TRACE_BEGIN("step", dt);
+
+            while (true) {
+                if (++trials > max_attempts) {
+                    throw std::overflow_error("ODESolver: Maximal number of iterations reached. A step size could not be found.");
+                }
+
+                {
+                    IN_PERF_REGION(PERF_STEPPER);
+                    err = stepper.step(rhs, y, f, t, dt, ynew, fnew, dense);
+                }
+
+                if (!(err <= 1)) {
+                    IN_TRACE_INSTANT("reject", dt);
+                    stats.rejectedSteps++;
+                    dt *= std::isfinite(err) ? std::max(0.2, 0.9 * std::pow(err, -0.2)) : 0.2;
+                    proposed = 0;
+                    targetBreak = breaks.size();
+                    predictedBreak = breaks.size();
+                    continue;
+                }
+
+                // state-dependent delays: find the earliest discontinuity
+                // crossed inside the step and shorten the step onto it
+                double theta = 1;
+
+                for (size_t k = 0; k < d; k++) {
+                    tauNew[k] = model->getDelay(k, ynew, t + dt);
+
+                    for (size_t b = 0; b < breaks.size(); b++) {
+                        const double xi = breaks[b].t;
+
+                        if (breaks[b].passed[k]
+                                || (b == targetBreak && k == targetDelay)
+                                || t - tau[k] - xi >= 0
+                                || t + dt - tauNew[k] - xi <= tolerance) {
+                            continue;
+                        }
+
+                        // Illinois
+                        double a = 0, ga = t - tau[k] - xi;
+                        double c = 1, gc = t + dt - tauNew[k] - xi;
+                        int side = 0;
+
+                        for (size_t it = 0; it < 100 && (c - a) * dt > tolerance; it++) {
+                            double m = (a * gc - c * ga) / (gc - ga);
+                            double gm = lag(k, m, t, dt, xi);
+
+                            if (gm < 0) {
+                                a = m;
+                                ga = gm;
+                                gc *= side == -1 ? 0.5 : 1;
+                                side = -1;
+                            } else {
+                                c = m;
+                                gc = gm;
+                                ga *= side == 1 ? 0.5 : 1;
+                                side = 1;
+                            }
+                        }
+
+                        if (c < theta) {
+                            theta = c;
+                            targetBreak = b;
+                            targetDelay = k;
+                        }
+                    }
+                }
+
+                if (theta < 1) {
+                    predictedBreak = breaks.size();
+                    IN_TRACE_INSTANT("reject", dt);
+                    stats.rejectedSteps++;
+                    dt *= theta;
+                    continue;
+                }
+
+                break;
+            }
+
+            IN_TRACE_END("step");
+
+            const double tNew = t + dt;
+
+            // discontinuities reached by the step
+            const size_t count = breaks.size();
+
+            for (size_t b = 0; b < count; b++) {
+                for (size_t k = 0; k < d; k++) {
+                    const double xi = breaks[b].t;
+
+                    // skip passed and unreached discontinuities, except
+                    // the one the step was shortened onto
+                    if (breaks[b].passed[k]
+                            || ((t - tau[k] - xi >= 0 || tNew - tauNew[k] - xi < -tolerance)
+                            && !(b == targetBreak && k == targetDelay))) {
+                        continue;
+                    }
+
+                    breaks[b].passed[k] = true;
+
+                    const int order = breaks[b].order + 1;
+
+                    if (order > maxOrder) {
+                        continue;
+                    }
+
+                    size_t j = 0;
+
+                    while (j < breaks.size() && std::fabs(breaks[j].t - tNew) > tolerance) {
+                        j++;
+                    }
+
+                    if (j == breaks.size()) {
+                        _Discontinuity next;
+                        next.t = tNew;
+                        next.order = order;
+                        next.passed.assign(d, false);
+                        breaks.push_back(next);
+                    } else {
+                        breaks[j].order = std::min(breaks[j].order, order);
+                    }
+                }
+            }
+
+            if (predictedBreak < count && !breaks[predictedBreak].passed[predictedDelay]) {
+                predictable[predictedDelay] = false;
+            }
+
+            for (size_t b = 0; b < breaks.size();) {
+                if (std::find(breaks[b].passed.begin(), breaks[b].passed.end(), false) == breaks[b].passed.end()) {
+                    breaks.erase(breaks.begin() + b);
+                } else {
+                    b++;
+                }
+            }
+
+            history.push(t, dt, &dense[0]);
+            history.trim(tNew - maxDelay);
+
+            stats.recordStep(dt);
+
+            t = tNew;
+            y.swap(ynew);
+            f.swap(fnew);
+
+            observer(y, t);
+
+            double factor = std::min(5.0, std::max(0.2, 0.9 * std::pow(std::max(err, 1.e-10), -0.2)));
+
+            if (proposed == 0) {
+                factor = std::min(factor, 1.0);
+            }
+
+            // a step shortened onto a discontinuity says little about the
+            // next one
+            dt = std::max(dt * factor, std::min(proposed, dt * 5));
+        }
+
+        trajectory.finish();
+
+        perf.finish();
+        stats.wallTime = (MonotonicClock::now() - start) * 1.e-9;
+
+        return stats;
+    }
+
 }
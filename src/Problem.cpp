@@ -35,6 +35,13 @@ namespace iNumerics {
         _absError = 1.e-10;
         _relError = 1.e-6;
         _h = 0.1;
+        _profiling = false;
+        _checkpointInterval = 0;
+        _sensitivityErrorControl = false;
+        _adjointSnapshots = 16;
+        _algebraicErrorControl = true;
+        _preconditioner = NULL;
+        _rhsRegion = Profiler::instance().region("rhs");
     }
 
     Problem::~Problem() {
@@ -62,7 +69,56 @@ namespace iNumerics {
         return *this;
     }
 
+    Problem& Problem::setProfiling(bool profiling) {
+        _profiling = profiling;
+
+        return *this;
+    }
     
+    Problem& Problem::setCheckpointing(const std::string& path, double interval) {
+        _checkpointPath = path;
+        _checkpointInterval = interval;
+
+        return *this;
+    }
+
+    Problem& Problem::addEvent(Event& event) {
+        _events.push_back(&event);
+
+        return *this;
+    }
+
+    Problem& Problem::setSensitivity(const std::vector<size_t>& parameters, bool errorControl) {
+        _sensitivityParameters = parameters;
+        _sensitivityErrorControl = errorControl;
+
+        return *this;
+    }
+
+    Problem& Problem::setInitialSensitivity(const DVec& s0) {
+        _initialSensitivity = s0;
+
+        return *this;
+    }
+
+    Problem& Problem::setAlgebraicErrorControl(bool control) {
+        _algebraicErrorControl = control;
+
+        return *this;
+    }
+
+    Problem& Problem::setAdjointSnapshots(size_t snapshots) {
+        _adjointSnapshots = snapshots > 0 ? snapshots : 1;
+
+        return *this;
+    }
+
+    Problem& Problem::setPreconditioner(Preconditioner* preconditioner) {
+        _preconditioner = preconditioner;
+
+        return *this;
+    }
+
     void Problem::step(const DVec &x, double t) {
         // std::cout << " --> new step(" << t << ") = "<< x[0] << std::endl;
         _currentSolution = x;
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "RingTrajectory.h"
+
+#include <stdexcept>
+
+namespace iNumerics {
+
+    // slot data is accessed with relaxed atomics, the sequence orders them
+    static inline void _store(double* p, double v) {
+        __atomic_store(p, &v, __ATOMIC_RELAXED);
+    }
+
+    static inline double _load(const double* p) {
+        double v;
+        __atomic_load(p, &v, __ATOMIC_RELAXED);
+        return v;
+    }
+
+    RingTrajectory::RingTrajectory(size_t capacity, size_t dimension)
+    : _capacity(capacity > 0 ? capacity : 1), _dimension(dimension),
+    _data(new double[_capacity * (dimension + 1)]),
+    _sequence(new std::atomic<size_t>[_capacity]), _head(0), _state(dimension) {
+
+        for (size_t s = 0; s < _capacity; s++) {
+            _sequence[s].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    RingTrajectory::~RingTrajectory() {
+    }
+
+    void RingTrajectory::operator()(const DVec& x, const double t) {
+        if (x.size() != _dimension) {
+            throw std::invalid_argument("RingTrajectory: state dimension does not match");
+        }
+
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t slot = head % _capacity;
+        double* p = &_data[slot * (_dimension + 1)];
+
+        // odd while the slot is written
+        size_t seq = _sequence[slot].load(std::memory_order_relaxed);
+        _sequence[slot].store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        _store(p, t);
+
+        for (size_t i = 0; i < _dimension; i++) {
+            _store(p + 1 + i, x[i]);
+        }
+
+        _sequence[slot].store(seq + 2, std::memory_order_release);
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    bool RingTrajectory::read(size_t index, double& t, DVec* x) const {
+        size_t slot = index % _capacity;
+        // sequence value after step index has been written
+        size_t expected = 2 * (index / _capacity + 1);
+        const double* p = &_data[slot * (_dimension + 1)];
+
+        for (;;) {
+            size_t before = _sequence[slot].load(std::memory_order_acquire);
+
+            if (before > expected) {
+                return false; // overwritten
+            }
+
+            if (before != expected) {
+                continue; // being written
+            }
+
+            t = _load(p);
+
+            if (x != NULL) {
+                for (size_t i = 0; i < _dimension; i++) {
+                    (*x)[i] = _load(p + 1 + i);
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (_sequence[slot].load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+    }
+
+    size_t RingTrajectory::first() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        return head > _capacity ? head - _capacity : 0;
+    }
+
+    double RingTrajectory::getTime(std::size_t i) const {
+        if (i >= size()) {
+            throw std::out_of_range("RingTrajectory: index out of range");
+        }
+
+        double t = 0;
+
+        while (!read(first() + i, t, NULL)) {
+        }
+
+        return t;
+    }
+
+    const DVec& RingTrajectory::getState(std::size_t i) const {
+        if (i >= size()) {
+            throw std::out_of_range("RingTrajectory: index out of range");
+        }
+
+        double t = 0;
+
+        while (!read(first() + i, t, &_state)) {
+        }
+
+        return _state;
+    }
+
+    size_t RingTrajectory::size() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        return head < _capacity ? head : _capacity;
+    }
+
+    size_t RingTrajectory::snapshot(std::vector<double>& times, std::vector<DVec>& states,
+            double window) const {
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t begin = head > _capacity ? head - _capacity : 0;
+
+        times.resize(head - begin);
+        states.resize(head - begin);
+
+        size_t n = 0;
+
+        for (size_t index = begin; index < head; index++) {
+            states[n].resize(_dimension);
+
+            if (read(index, times[n], &states[n])) {
+                n++;
+            }
+        }
+
+        times.resize(n);
+        states.resize(n);
+
+        if (window >= 0 && n > 0) {
+            double from = times[n - 1] - window;
+            size_t skip = 0;
+
+            while (skip < n && times[skip] < from) {
+                skip++;
+            }
+
+            times.erase(times.begin(), times.begin() + skip);
+            states.erase(states.begin(), states.begin() + skip);
+        }
+
+        return times.size();
+    }
+
+    double RingTrajectory::getMinTime() const {
+        return size() > 0 ? getTime(0) : 0;
+    }
+
+    double RingTrajectory::getMaxTime() const {
+        double t = 0;
+
+        // retry with the new head if the last step was overwritten meanwhile
+        for (;;) {
+            size_t head = _head.load(std::memory_order_acquire);
+
+            if (head == 0 || read(head - 1, t, NULL)) {
+                return t;
+            }
+        }
+    }
+
+    double RingTrajectory::getMinState(size_t i) const {
+        std::vector<double> times;
+        std::vector<DVec> states;
+
+        if (snapshot(times, states) == 0) {
+            return 0;
+        }
+
+        double result = states[0][i];
+
+        for (size_t j = 1; j < states.size(); j++) {
+            if (states[j][i] < result) {
+                result = states[j][i];
+            }
+        }
+
+        return result;
+    }
+
+    double RingTrajectory::getMaxState(size_t i) const {
+        std::vector<double> times;
+        std::vector<DVec> states;
+
+        if (snapshot(times, states) == 0) {
+            return 0;
+        }
+
+        double result = states[0][i];
+
+        for (size_t j = 1; j < states.size(); j++) {
+            if (states[j][i] > result) {
+                result = states[j][i];
+            }
+        }
+
+        return result;
+    }
+
+    StateSummary RingTrajectory::getStateSummary(size_t i, double t0, double t1) const {
+        StateSummary s = {0, 0, 0, 0};
+
+        std::vector<double> times;
+        std::vector<DVec> states;
+
+        snapshot(times, states);
+
+        for (size_t j = 0; j < times.size(); j++) {
+            if (times[j] < t0 || times[j] > t1) {
+                continue;
+            }
+
+            double v = states[j][i];
+
+            if (s.count == 0 || v < s.min) s.min = v;
+            if (s.count == 0 || v > s.max) s.max = v;
+            s.mean += v;
+            s.count++;
+        }
+
+        if (s.count > 0) {
+            s.mean /= s.count;
+        }
+
+        return s;
+    }
+
+    size_t RingTrajectory::getCapacity() const {
+        return _capacity;
+    }
+
+    size_t RingTrajectory::getDimension() const {
+        return _dimension;
+    }
+
+    size_t RingTrajectory::getTotalCount() const {
+        return _head.load(std::memory_order_acquire);
+    }
+
+}
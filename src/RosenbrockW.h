@@ -0,0 +1,417 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef ROSENBROCKW_H
+#define	ROSENBROCKW_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <boost/numeric/odeint/stepper/controlled_step_result.hpp>
+
+#include "Types.h"
+#include "StructuredLU.h"
+#include "SolveStats.h"
+#include "Jacobian.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    /**
+     * Coefficients of ROS34PW2 (Rang & Angermann 2005): 4 stages, order 3
+     * with an embedded order 2 solution, stiffly accurate. It is a
+     * W-method, i.e. the order holds for any approximation of the
+     * Jacobian. Stored in the transformed form of Hairer & Wanner IV.7
+     * that avoids products with the Jacobian.
+     */
+    struct _RosenbrockCoefficients {
+        static const size_t STAGES = 4;
+
+        double gamma;
+        double a[STAGES][STAGES];
+        double c[STAGES][STAGES];
+        double alpha[STAGES];
+        double m[STAGES];
+        double e[STAGES];
+
+        _RosenbrockCoefficients() {
+            const double g = 0.435866521508459;
+
+            const double A[STAGES][STAGES] = {
+                {0, 0, 0, 0},
+                {0.87173304301691801, 0, 0, 0},
+                {0.84457060015369423, -0.11299064236484185, 0, 0},
+                {0, 0, 1, 0}
+            };
+
+            const double G[STAGES][STAGES] = {
+                {g, 0, 0, 0},
+                {-0.87173304301691801, g, 0, 0},
+                {-0.90338057013044082, 0.054180672388095326, g, 0},
+                {0.24212380706095346, -1.2232505839045147, 0.54526025533510214, g}
+            };
+
+            const double b[STAGES] = {0.24212380706095346, -1.2232505839045147, 1.5452602553351020, g};
+            const double bhat[STAGES] = {0.37810903145819369, -0.096042292212423178, 0.5, 0.2179332607542295};
+
+            // inverse of the lower triangular G
+            double Ginv[STAGES][STAGES] = {{0}};
+
+            for (size_t i = 0; i < STAGES; i++) {
+                Ginv[i][i] = 1 / G[i][i];
+
+                for (size_t j = 0; j < i; j++) {
+                    double sum = 0;
+
+                    for (size_t k = j; k < i; k++) {
+                        sum += G[i][k] * Ginv[k][j];
+                    }
+
+                    Ginv[i][j] = -sum / G[i][i];
+                }
+            }
+
+            gamma = g;
+
+            for (size_t i = 0; i < STAGES; i++) {
+                alpha[i] = 0;
+                m[i] = 0;
+                e[i] = 0;
+
+                for (size_t j = 0; j < STAGES; j++) {
+                    alpha[i] += A[i][j];
+
+                    a[i][j] = 0;
+
+                    for (size_t k = 0; k < STAGES; k++) {
+                        a[i][j] += A[i][k] * Ginv[k][j];
+                    }
+
+                    c[i][j] = (i == j ? 1 / g : 0) - Ginv[i][j];
+
+                    m[i] += b[j] * Ginv[j][i];
+                    e[i] += (b[j] - bhat[j]) * Ginv[j][i];
+                }
+            }
+        }
+    };
+
+    /**
+     * Controlled Rosenbrock-W stepper with the try_step() interface of
+     * odeint's controlled steppers.
+     *
+     * The state may carry p sensitivity blocks after the first n
+     * components (z = (y, s_1, ..., s_p)). The matrix I / (h gamma) - J is
+     * formed from the state Jacobian only and factored once per attempt;
+     * every stage then solves the state and all sensitivity blocks with
+     * the same factors in one call (staggered, multiple right hand sides).
+     * Since ROS34PW2 is a W-method, the omitted coupling of the
+     * sensitivities to the state in the Jacobian does not reduce the order.
+     *
+     * With a mass matrix M the stages solve M y' = f with M / (h gamma) - J;
+     * ROS34PW2 is stiffly accurate and thus suited for index-1 DAEs.
+     *
+     * The matrix is assembled and factored in the structure of the model's
+     * Jacobian (Model::getJacobianStructure()).
+     */
+    class _RosenbrockW {
+    public:
+
+        _RosenbrockW(_Jacobian& jacobian, SolveStats& stats, size_t n,
+                double absError, double relError, bool controlAll)
+        : _jacobian(jacobian), _lu(&stats), _n(n), _absError(absError), _relError(relError),
+        _controlAll(controlAll), _jacobianValid(false), _lastRejected(false) {
+        }
+
+        /**
+         * Solves M y' = f instead of y' = f, M in the storage of the
+         * Jacobian structure (empty: I). Without algebraic error control
+         * the variables with a zero column in M are left out of the error
+         * test.
+         */
+        void setMassMatrix(const DVec& M, bool algebraicErrorControl) {
+            const size_t n = _n;
+            const JacobianStructure& structure = _jacobian.structure(n);
+
+            _mass.clear();
+
+            if (structure.getType() == JacobianStructure::DENSE) {
+                for (size_t j = 0; j < n; j++) {
+                    for (size_t i = 0; i < n; i++) {
+                        if (M[j * n + i] != 0) {
+                            _MassEntry e = {i, j, j * n + i, M[j * n + i]};
+                            _mass.push_back(e);
+                        }
+                    }
+                }
+            } else {
+                const std::vector<size_t>& pointers = structure.getColumnPointers();
+                const std::vector<size_t>& rows = structure.getColumnRows();
+                const std::vector<size_t>& positions = structure.getColumnPositions();
+
+                for (size_t j = 0; j < n; j++) {
+                    for (size_t k = pointers[j]; k < pointers[j + 1]; k++) {
+                        if (M[positions[k]] != 0) {
+                            _MassEntry e = {rows[k], j, positions[k], M[positions[k]]};
+                            _mass.push_back(e);
+                        }
+                    }
+                }
+            }
+
+            _skipError.assign(n, !algebraicErrorControl);
+
+            for (size_t k = 0; k < _mass.size() && !algebraicErrorControl; k++) {
+                _skipError[_mass[k].column] = false;
+            }
+        }
+
+        template <class System>
+        boost::numeric::odeint::controlled_step_result try_step(System system,
+                DVec& x, const DVec& dxdt, double& t, double& dt) {
+
+            using namespace boost::numeric::odeint;
+
+            static const _RosenbrockCoefficients coef;
+            const size_t S = _RosenbrockCoefficients::STAGES;
+            const size_t n = _n;
+            const size_t N = x.size();
+
+            if (!_jacobianValid || t != _jacobianTime) {
+                _y.assign(x.begin(), x.begin() + n);
+                _f.assign(dxdt.begin(), dxdt.begin() + n);
+                _jacobian.values(_y, _f, t, _J);
+                _jacobianTime = t;
+                _jacobianValid = true;
+            }
+
+            // W = M / (h gamma) - J in the structure of J
+            const JacobianStructure& structure = _jacobian.structure(n);
+
+            _W.resize(_J.size());
+
+            for (size_t i = 0; i < _J.size(); i++) {
+                _W[i] = -_J[i];
+            }
+
+            if (_mass.empty()) {
+                const std::vector<size_t>& diagonal = structure.getDiagonal();
+
+                for (size_t i = 0; i < n; i++) {
+                    _W[diagonal[i]] += 1 / (dt * coef.gamma);
+                }
+            } else {
+                for (size_t k = 0; k < _mass.size(); k++) {
+                    _W[_mass[k].position] += _mass[k].value / (dt * coef.gamma);
+                }
+            }
+
+            if (!_lu.factor(structure, _W)) {
+                dt *= 0.5;
+                _lastRejected = true;
+                return fail;
+            }
+
+            _u.resize(S);
+            _z.resize(N);
+            _F.resize(N);
+
+            for (size_t s = 0; s < S; s++) {
+                DVec& u = _u[s];
+
+                if (s == 0) {
+                    u = dxdt;
+                } else {
+                    _z = x;
+
+                    for (size_t j = 0; j < s; j++) {
+                        const double a = coef.a[s][j];
+
+                        if (a != 0) {
+                            for (size_t i = 0; i < N; i++) {
+                                _z[i] += a * _u[j][i];
+                            }
+                        }
+                    }
+
+                    system(_z, _F, t + coef.alpha[s] * dt);
+                    u = _F;
+                }
+
+                if (_mass.empty()) {
+                    for (size_t j = 0; j < s; j++) {
+                        const double c = coef.c[s][j] / dt;
+
+                        for (size_t i = 0; i < N; i++) {
+                            u[i] += c * _u[j][i];
+                        }
+                    }
+                } else if (s > 0) {
+                    _v.assign(N, 0);
+
+                    for (size_t j = 0; j < s; j++) {
+                        const double c = coef.c[s][j] / dt;
+
+                        for (size_t i = 0; i < N; i++) {
+                            _v[i] += c * _u[j][i];
+                        }
+                    }
+
+                    // u += M v, block by block
+                    for (size_t b = 0; b < N; b += n) {
+                        for (size_t k = 0; k < _mass.size(); k++) {
+                            const _MassEntry& e = _mass[k];
+
+                            u[b + e.row] += e.value * _v[b + e.column];
+                        }
+                    }
+                }
+
+                _lu.solve(u.data(), N / n);
+            }
+
+            _xnew = x;
+            _err.assign(N, 0);
+
+            for (size_t s = 0; s < S; s++) {
+                for (size_t i = 0; i < N; i++) {
+                    _xnew[i] += coef.m[s] * _u[s][i];
+                    _err[i] += coef.e[s] * _u[s][i];
+                }
+            }
+
+            size_t controlled = _controlAll ? N : n;
+            size_t count = 0;
+            double err = 0;
+
+            for (size_t i = 0; i < controlled; i++) {
+                if (i < _skipError.size() && _skipError[i]) {
+                    continue;
+                }
+
+                double sk = _absError + _relError * std::max(std::fabs(x[i]), std::fabs(_xnew[i]));
+                err += (_err[i] / sk) * (_err[i] / sk);
+                count++;
+            }
+
+            err = count > 0 ? std::sqrt(err / count) : 0;
+
+            // embedded order 2
+            double fac = err > 0 ? 0.9 * std::pow(err, -1. / 3) : 5;
+            fac = std::max(0.2, std::min(5., fac));
+
+            if (err <= 1) {
+                if (_lastRejected) {
+                    fac = std::min(fac, 1.);
+                }
+
+                x.swap(_xnew);
+                t += dt;
+                dt *= fac;
+                _jacobianValid = false;
+                _lastRejected = false;
+                return success;
+            }
+
+            dt *= fac;
+            _lastRejected = true;
+            return fail;
+        }
+
+        /**
+         * Maximum row sum norm of the Jacobian of the last step attempt, an
+         * upper bound of its spectral radius.
+         */
+        double jacobianNorm() {
+            const size_t n = _n;
+            const JacobianStructure& structure = _jacobian.structure(n);
+
+            _v.assign(n, 0);
+
+            if (structure.getType() == JacobianStructure::DENSE) {
+                for (size_t j = 0; j < n; j++) {
+                    for (size_t i = 0; i < n; i++) {
+                        _v[i] += std::fabs(_J[j * n + i]);
+                    }
+                }
+            } else {
+                const std::vector<size_t>& pointers = structure.getColumnPointers();
+                const std::vector<size_t>& rows = structure.getColumnRows();
+                const std::vector<size_t>& positions = structure.getColumnPositions();
+
+                for (size_t j = 0; j < n; j++) {
+                    for (size_t k = pointers[j]; k < pointers[j + 1]; k++) {
+                        _v[rows[k]] += std::fabs(_J[positions[k]]);
+                    }
+                }
+            }
+
+            return n > 0 ? *std::max_element(_v.begin(), _v.end()) : 0;
+        }
+
+    private:
+
+        struct _MassEntry {
+            size_t row;
+            size_t column;
+            // in the structure of the Jacobian
+            size_t position;
+            double value;
+        };
+
+        _Jacobian& _jacobian;
+        StructuredLU _lu;
+        size_t _n;
+        double _absError;
+        double _relError;
+        bool _controlAll;
+
+        bool _jacobianValid;
+        double _jacobianTime;
+        bool _lastRejected;
+
+        std::vector<_MassEntry> _mass;
+        std::vector<bool> _skipError;
+        DVec _y;
+        DVec _f;
+        DVec _J;
+        DVec _W;
+        DVec _v;
+        DVec _z;
+        DVec _F;
+        DVec _xnew;
+        DVec _err;
+        std::vector<DVec> _u;
+    };
+
+}
+
+#endif	/* ROSENBROCKW_H */
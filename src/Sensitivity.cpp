@@ -0,0 +1,187 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "Sensitivity.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+namespace iNumerics {
+
+    _Sensitivity::_Sensitivity(Model& model, _CountingRhs rhs, SolveStats& stats,
+            size_t n, const std::vector<size_t>& parameters)
+    : _model(model), _rhs(rhs), _stats(stats), _jacobian(model, rhs, stats), _n(n),
+    _parameters(parameters), _analyticParameters(true), _probed(false), _differenced(true),
+    _differenceCost(0) {
+    }
+
+    size_t _Sensitivity::getDimension() const {
+        return _n;
+    }
+
+    size_t _Sensitivity::getParameterCount() const {
+        return _parameters.size();
+    }
+
+    void _Sensitivity::rhs(const DVec& z, DVec& dz, double t) {
+        const size_t n = _n;
+        const size_t p = _parameters.size();
+
+        _y.assign(z.begin(), z.begin() + n);
+        _f.resize(n);
+        _rhs(_y, _f, t);
+
+        std::copy(_f.begin(), _f.end(), dz.begin());
+
+        if (_analyticParameters) {
+            _dfdp.assign(n * _model.getParameterCount(), 0);
+            _analyticParameters = _model.parameterJacobian(_y, _dfdp, t);
+        }
+
+        if (!_probed) {
+            // one evaluation tells whether J is analytic
+            _jacobian.values(_y, _f, t, _values);
+            _differenced = _jacobian.isDifferenced(n);
+            _differenceCost = _jacobian.getDifferenceCost(n);
+            _probed = true;
+        } else if (products()) {
+            _jacobian.values(_y, _f, t, _values);
+        }
+
+        if (!products()) {
+            for (size_t k = 0; k < p; k++) {
+                directionalDifference(&z[(k + 1) * n], _parameters[k], t, &dz[(k + 1) * n]);
+            }
+
+            return;
+        }
+
+        for (size_t k = 0; k < p; k++) {
+            double* ds = &dz[(k + 1) * n];
+
+            if (_analyticParameters) {
+                const double* b = &_dfdp[_parameters[k] * n];
+                std::copy(b, b + n, ds);
+            } else {
+                parameterDifference(k, t, ds);
+            }
+
+            multiplyAdd(&z[(k + 1) * n], ds);
+        }
+    }
+
+    void _Sensitivity::directionalDifference(const double* s, size_t parameter, double t, double* ds) {
+        const size_t n = _n;
+        const double root = std::sqrt(DBL_EPSILON);
+
+        double yNorm = 0;
+        double sNorm = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            yNorm = std::max(yNorm, std::fabs(_y[i]));
+            sNorm = std::max(sNorm, std::fabs(s[i]));
+        }
+
+        double p = _model.getParameter(parameter);
+        double delta = root * (p != 0 ? std::fabs(p) : 1);
+
+        if (sNorm > 0) {
+            delta = std::min(delta, root * (yNorm > 0 ? yNorm : 1) / sNorm);
+        }
+
+        _yp.resize(n);
+        _fp.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            _yp[i] = _y[i] + delta * s[i];
+        }
+
+        _model.setParameter(parameter, p + delta);
+        _rhs(_yp, _fp, t);
+        _model.setParameter(parameter, p);
+
+        for (size_t i = 0; i < n; i++) {
+            ds[i] = (_fp[i] - _f[i]) / delta;
+        }
+    }
+
+    bool _Sensitivity::products() const {
+        return !_differenced || (_analyticParameters && _differenceCost < _parameters.size());
+    }
+
+    void _Sensitivity::parameterDifference(size_t k, double t, double* b) {
+        const size_t n = _n;
+        const size_t parameter = _parameters[k];
+
+        double p = _model.getParameter(parameter);
+        double delta = std::sqrt(DBL_EPSILON) * (p != 0 ? std::fabs(p) : 1);
+
+        _fp.resize(n);
+
+        _model.setParameter(parameter, p + delta);
+        _rhs(_y, _fp, t);
+        _model.setParameter(parameter, p);
+
+        for (size_t i = 0; i < n; i++) {
+            b[i] = (_fp[i] - _f[i]) / delta;
+        }
+    }
+
+    void _Sensitivity::multiplyAdd(const double* s, double* ds) {
+        const size_t n = _n;
+        const JacobianStructure& structure = _jacobian.structure(n);
+
+        if (structure.getType() == JacobianStructure::DENSE) {
+            for (size_t j = 0; j < n; j++) {
+                const double* column = &_values[j * n];
+                const double sj = s[j];
+
+                for (size_t i = 0; i < n; i++) {
+                    ds[i] += column[i] * sj;
+                }
+            }
+
+            return;
+        }
+
+        const std::vector<size_t>& pointers = structure.getColumnPointers();
+        const std::vector<size_t>& rows = structure.getColumnRows();
+        const std::vector<size_t>& positions = structure.getColumnPositions();
+
+        for (size_t j = 0; j < n; j++) {
+            const double sj = s[j];
+
+            for (size_t k = pointers[j]; k < pointers[j + 1]; k++) {
+                ds[rows[k]] += _values[positions[k]] * sj;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef SENSITIVITY_H
+#define	SENSITIVITY_H
+
+#include <vector>
+
+#include "Types.h"
+#include "Model.h"
+#include "Trajectory.h"
+#include "Problem.h"
+#include "SolveStats.h"
+#include "SolverSupport.h"
+#include "Jacobian.h"
+
+namespace iNumerics {
+
+    /**
+     * State and forward sensitivities as one system z = (y, s_1, ..., s_p)
+     * with s_k = dy/dp_k and s_k' = J s_k + df/dp_k.
+     *
+     * J is evaluated once per rhs() in the storage of
+     * Model::getJacobianStructure() and applied to all p columns. It comes
+     * from Model::jacobian()/jacobianValues() or, if Model::parameterJacobian()
+     * is implemented and a differenced J needs fewer rhs calls than there
+     * are parameters, from differences by column groups. Otherwise each
+     * J s_k + df/dp_k is a directional difference of the rhs along
+     * (s_k, e_k), i.e. one rhs call per parameter.
+     *
+     * J is not kept over the stages of a step: a Jacobian frozen at the
+     * start of the step makes the sensitivities only first order accurate.
+     */
+    class _Sensitivity {
+    public:
+
+        _Sensitivity(Model& model, _CountingRhs rhs, SolveStats& stats,
+                size_t n, const std::vector<size_t>& parameters);
+
+        size_t getDimension() const;
+
+        size_t getParameterCount() const;
+
+        void rhs(const DVec& z, DVec& dz, double t);
+
+    private:
+
+        /**
+         * ds = J s + df/dp_k by one forward difference along (s, e_k) with
+         * the smaller of the step sizes suited for y and p_k (the default
+         * difference quotient of CVODES).
+         */
+        void directionalDifference(const double* s, size_t parameter, double t, double* ds);
+
+        /**
+         * @return true if J s_k + df/dp_k is computed from J, false for
+         *         directional differences
+         */
+        bool products() const;
+
+        /**
+         * Column k of df/dp (parameter _parameters[k]) by a forward
+         * difference in p_k.
+         */
+        void parameterDifference(size_t k, double t, double* b);
+
+        /**
+         * ds += J s with J in _values.
+         */
+        void multiplyAdd(const double* s, double* ds);
+
+        Model& _model;
+        _CountingRhs _rhs;
+        SolveStats& _stats;
+        _Jacobian _jacobian;
+        size_t _n;
+        std::vector<size_t> _parameters;
+        bool _analyticParameters;
+        bool _probed;
+        bool _differenced;
+        size_t _differenceCost;
+
+        DVec _y;
+        DVec _f;
+        DVec _yp;
+        DVec _fp;
+        DVec _values;
+        DVec _dfdp;
+    };
+
+    /**
+     * System functor of the augmented sensitivity system.
+     */
+    class _SensitivityRhs {
+    public:
+        _Sensitivity& _sensitivity;
+
+        _SensitivityRhs(_Sensitivity& sensitivity) : _sensitivity(sensitivity) {
+        }
+
+        void operator()(const DVec &z, DVec &dzdt, const double t) {
+            _sensitivity.rhs(z, dzdt, t);
+        }
+    };
+
+    /**
+     * Records the state part of z in the trajectory and the sensitivities
+     * (column-major n x p) in a second trajectory.
+     */
+    class _SensitivityObserver {
+    public:
+        Trajectory& _trajectory;
+        Trajectory& _sensitivities;
+        Problem& _p;
+        SolveStats& _stats;
+        size_t _n;
+        DVec _y;
+        DVec _s;
+
+        _SensitivityObserver(Problem& p, Trajectory& trajectory, Trajectory& sensitivities,
+                SolveStats& stats, size_t n)
+        : _trajectory(trajectory), _sensitivities(sensitivities), _p(p), _stats(stats), _n(n) {
+        }
+
+        void operator()(const DVec &z, double t) {
+            IN_PERF_REGION(PERF_OBSERVER);
+            inULong start = MonotonicClock::now();
+            _y.assign(z.begin(), z.begin() + _n);
+            _s.assign(z.begin() + _n, z.end());
+            _trajectory(_y, t);
+            _sensitivities(_s, t);
+            _p.step(_y, t);
+            _stats.observerTime += (MonotonicClock::now() - start) * 1.e-9;
+        }
+    };
+
+}
+
+#endif	/* SENSITIVITY_H */
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "SolveStats.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace iNumerics {
+
+    // Field table shared by the JSON and CSV writers. Step sizes and times
+    // are doubles, counters are converted on the fly.
+    struct _StatsField {
+        const char* name;
+        double (*get)(const SolveStats& s);
+    };
+
+    static double _accepted(const SolveStats& s) { return (double) s.acceptedSteps; }
+    static double _rejected(const SolveStats& s) { return (double) s.rejectedSteps; }
+    static double _rhs(const SolveStats& s) { return (double) s.rhsCalls; }
+    static double _jacobian(const SolveStats& s) { return (double) s.jacobianCalls; }
+    static double _lu(const SolveStats& s) { return (double) s.luDecompositions; }
+    static double _luSolves(const SolveStats& s) { return (double) s.luSolves; }
+    static double _newton(const SolveStats& s) { return (double) s.newtonIterations; }
+    static double _linear(const SolveStats& s) { return (double) s.linearIterations; }
+    static double _stiffSteps(const SolveStats& s) { return (double) s.stiffSteps; }
+    static double _switches(const SolveStats& s) { return (double) s.methodSwitches; }
+    static double _events(const SolveStats& s) { return (double) s.events; }
+    static double _minStep(const SolveStats& s) { return s.acceptedSteps > 0 ? s.minStep : 0; }
+    static double _maxStep(const SolveStats& s) { return s.maxStep; }
+    static double _meanStep(const SolveStats& s) { return s.getMeanStep(); }
+    static double _observerTime(const SolveStats& s) { return s.observerTime; }
+    static double _wallTime(const SolveStats& s) { return s.wallTime; }
+
+    static const _StatsField _fields[] = {
+        {"acceptedSteps", &_accepted},
+        {"rejectedSteps", &_rejected},
+        {"rhsCalls", &_rhs},
+        {"jacobianCalls", &_jacobian},
+        {"luDecompositions", &_lu},
+        {"luSolves", &_luSolves},
+        {"newtonIterations", &_newton},
+        {"linearIterations", &_linear},
+        {"stiffSteps", &_stiffSteps},
+        {"methodSwitches", &_switches},
+        {"events", &_events},
+        {"minStep", &_minStep},
+        {"maxStep", &_maxStep},
+        {"meanStep", &_meanStep},
+        {"observerTime", &_observerTime},
+        {"wallTime", &_wallTime}
+    };
+
+    static const size_t _numFields = sizeof (_fields) / sizeof (_fields[0]);
+
+    SolveStats::SolveStats() {
+        acceptedSteps = 0;
+        rejectedSteps = 0;
+        rhsCalls = 0;
+        jacobianCalls = 0;
+        luDecompositions = 0;
+        luSolves = 0;
+        newtonIterations = 0;
+        linearIterations = 0;
+        stiffSteps = 0;
+        methodSwitches = 0;
+        events = 0;
+        minStep = std::numeric_limits<double>::max();
+        maxStep = 0;
+        stepSum = 0;
+        observerTime = 0;
+        wallTime = 0;
+    }
+
+    void SolveStats::recordStep(double h) {
+        acceptedSteps++;
+        stepSum += h;
+
+        if (h < minStep) {
+            minStep = h;
+        }
+
+        if (h > maxStep) {
+            maxStep = h;
+        }
+    }
+
+    double SolveStats::getMeanStep() const {
+        if (acceptedSteps == 0) {
+            return 0;
+        }
+
+        return stepSum / acceptedSteps;
+    }
+
+    void SolveStats::writeJSON(std::ostream& os) const {
+        std::streamsize precision = os.precision(17);
+
+        os << "{";
+
+        for (size_t i = 0; i < _numFields; i++) {
+            if (i > 0) {
+                os << ", ";
+            }
+            os << "\"" << _fields[i].name << "\": " << _fields[i].get(*this);
+        }
+
+        if (PerfCounters::isEnabled()) {
+            os << ", \"perf\": {";
+
+            for (int r = 0; r < PERF_REGIONS; r++) {
+                const PerfCounts& c = perf[r];
+
+                os << (r > 0 ? ", " : "") << "\"" << PerfCounters::regionName((PerfRegion) r) << "\": {"
+                        << "\"calls\": " << c.calls
+                        << ", \"taskClock\": " << c.taskClock
+                        << ", \"cycles\": " << c.cycles
+                        << ", \"instructions\": " << c.instructions
+                        << ", \"cacheMisses\": " << c.cacheMisses
+                        << ", \"branchMisses\": " << c.branchMisses;
+
+                // per rhs call for the rhs region, per step for the others
+                double n = r == PERF_RHS ? (double) c.calls : (double) acceptedSteps + rejectedSteps;
+
+                if (n > 0) {
+                    os << ", \"cyclesPer\": " << c.cycles / n
+                            << ", \"instructionsPer\": " << c.instructions / n;
+                }
+
+                os << "}";
+            }
+
+            os << "}";
+        }
+
+        os << "}";
+
+        os.precision(precision);
+    }
+
+    EnsembleStats::EnsembleStats() {
+    }
+
+    void EnsembleStats::add(const SolveStats& stats) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _members.push_back(stats);
+    }
+
+    size_t EnsembleStats::size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _members.size();
+    }
+
+    SolveStats EnsembleStats::get(size_t i) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _members[i];
+    }
+
+    SolveStats EnsembleStats::getTotal() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        SolveStats total;
+
+        for (size_t i = 0; i < _members.size(); i++) {
+            const SolveStats& s = _members[i];
+
+            total.acceptedSteps += s.acceptedSteps;
+            total.rejectedSteps += s.rejectedSteps;
+            total.rhsCalls += s.rhsCalls;
+            total.jacobianCalls += s.jacobianCalls;
+            total.luDecompositions += s.luDecompositions;
+            total.luSolves += s.luSolves;
+            total.newtonIterations += s.newtonIterations;
+            total.linearIterations += s.linearIterations;
+            total.stiffSteps += s.stiffSteps;
+            total.methodSwitches += s.methodSwitches;
+            total.events += s.events;
+            total.stepSum += s.stepSum;
+            total.observerTime += s.observerTime;
+            total.wallTime += s.wallTime;
+            total.minStep = std::min(total.minStep, s.minStep);
+            total.maxStep = std::max(total.maxStep, s.maxStep);
+
+            for (int r = 0; r < PERF_REGIONS; r++) {
+                total.perf[r] += s.perf[r];
+            }
+        }
+
+        return total;
+    }
+
+    // min, mean, max and sum of one field over all members
+    static void _aggregate(const std::vector<SolveStats>& members,
+            const _StatsField& field, double result[4]) {
+
+        result[0] = std::numeric_limits<double>::max();
+        result[1] = 0;
+        result[2] = -std::numeric_limits<double>::max();
+        result[3] = 0;
+
+        for (size_t i = 0; i < members.size(); i++) {
+            double v = field.get(members[i]);
+            result[0] = std::min(result[0], v);
+            result[2] = std::max(result[2], v);
+            result[3] += v;
+        }
+
+        if (members.empty()) {
+            result[0] = result[2] = 0;
+        } else {
+            result[1] = result[3] / members.size();
+        }
+    }
+
+    static const char* _aggregateNames[] = {"min", "mean", "max", "sum"};
+
+    void EnsembleStats::writeJSON(std::ostream& os) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::streamsize precision = os.precision(17);
+
+        os << "{\n  \"runs\": " << _members.size() << ",\n  \"aggregate\": {\n";
+
+        for (size_t f = 0; f < _numFields; f++) {
+            double agg[4];
+            _aggregate(_members, _fields[f], agg);
+
+            os << "    \"" << _fields[f].name << "\": {";
+
+            for (size_t a = 0; a < 4; a++) {
+                os << (a > 0 ? ", " : "") << "\"" << _aggregateNames[a] << "\": " << agg[a];
+            }
+
+            os << "}" << (f + 1 < _numFields ? "," : "") << "\n";
+        }
+
+        os << "  },\n  \"members\": [\n";
+
+        for (size_t i = 0; i < _members.size(); i++) {
+            os << "    ";
+            _members[i].writeJSON(os);
+            os << (i + 1 < _members.size() ? "," : "") << "\n";
+        }
+
+        os << "  ]\n}\n";
+
+        os.precision(precision);
+    }
+
+    void EnsembleStats::writeCSV(std::ostream& os) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::streamsize precision = os.precision(17);
+
+        os << "member";
+
+        for (size_t f = 0; f < _numFields; f++) {
+            os << "," << _fields[f].name;
+        }
+
+        os << "\n";
+
+        for (size_t i = 0; i < _members.size(); i++) {
+            os << i;
+
+            for (size_t f = 0; f < _numFields; f++) {
+                os << "," << _fields[f].get(_members[i]);
+            }
+
+            os << "\n";
+        }
+
+        double agg[_numFields][4];
+
+        for (size_t f = 0; f < _numFields; f++) {
+            _aggregate(_members, _fields[f], agg[f]);
+        }
+
+        for (size_t a = 0; a < 4; a++) {
+            os << _aggregateNames[a];
+
+            for (size_t f = 0; f < _numFields; f++) {
+                os << "," << agg[f][a];
+            }
+
+            os << "\n";
+        }
+
+        os.precision(precision);
+    }
+
+}
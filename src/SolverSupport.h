@@ -0,0 +1,139 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef SOLVERSUPPORT_H
+#define	SOLVERSUPPORT_H
+
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+#include "Types.h"
+#include "Trajectory.h"
+#include "Problem.h"
+#include "SolveStats.h"
+#include "inprofiler.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    class _StepObserver {
+    public:
+        Trajectory& _trajectory;
+        Problem& _p;
+        SolveStats& _stats;
+
+        _StepObserver(Problem& p, Trajectory& trajectory, SolveStats& stats)
+        : _trajectory(trajectory), _p(p), _stats(stats) {
+        }
+
+        void operator()(const DVec &x, double t) {
+            IN_PERF_REGION(PERF_OBSERVER);
+            inULong start = MonotonicClock::now();
+            _trajectory(x, t);
+            _p.step(x, t);
+            _stats.observerTime += (MonotonicClock::now() - start) * 1.e-9;
+        }
+    };
+
+    /**
+     * Counts the rhs evaluations the stepper requests. Evaluates rhs() or
+     * one part of a split model (Model::rhs_explicit(), rhs_implicit()).
+     */
+    class _CountingRhs {
+    public:
+
+        enum Part {
+            FULL, EXPLICIT, IMPLICIT
+        };
+
+        Problem& _p;
+        SolveStats& _stats;
+        Model* _model;
+        Part _part;
+
+        _CountingRhs(Problem& p, SolveStats& stats) : _p(p), _stats(stats), _model(NULL), _part(FULL) {
+        }
+
+        _CountingRhs(Problem& p, Model& model, SolveStats& stats, Part part)
+        : _p(p), _stats(stats), _model(&model), _part(part) {
+        }
+
+        void operator()(const DVec &y, DVec &dydt, const double t) {
+            IN_PERF_REGION(PERF_RHS);
+            IN_TRACE_BEGIN("rhs", t);
+            _stats.rhsCalls++;
+
+            if (_part == FULL) {
+                _p(y, dydt, t);
+            } else if (!(_part == EXPLICIT ? _model->rhs_explicit(y, dydt, t) : _model->rhs_implicit(y, dydt, t))) {
+                throw std::invalid_argument("ODESolver: the model does not implement rhs_explicit() and rhs_implicit()");
+            }
+
+            IN_TRACE_END("rhs");
+        }
+    };
+
+    /**
+     * odeint error checker that only takes the first n components into
+     * account (n = 0: all), with the same weights as odeint's
+     * default_error_checker. Unlike the latter it also works for
+     * backward integration (dt < 0).
+     */
+    class _StateErrorChecker {
+    public:
+
+        _StateErrorChecker(double absError, double relError, size_t n)
+        : _absError(absError), _relError(relError), _n(n) {
+        }
+
+        template <class Algebra, class State, class Deriv, class Err, class Time>
+        double error(Algebra& algebra, const State& x_old, const Deriv& dxdt_old, Err& x_err, const Time& dt) const {
+            size_t n = _n > 0 ? std::min(_n, x_err.size()) : x_err.size();
+            double result = 0;
+
+            for (size_t i = 0; i < n; i++) {
+                double e = std::fabs(x_err[i])
+                        / (_absError + _relError * (std::fabs(x_old[i]) + std::fabs(dt) * std::fabs(dxdt_old[i])));
+                result = std::max(result, e);
+            }
+
+            return result;
+        }
+
+    private:
+        double _absError;
+        double _relError;
+        size_t _n;
+    };
+
+}
+
+#endif	/* SOLVERSUPPORT_H */
@@ -0,0 +1,472 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+
+#include "SparseLU.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    static const size_t NONE = (size_t) - 1;
+
+    // a pivot off the diagonal is only taken if the diagonal is smaller
+    // than this fraction of the largest candidate
+    static const double PIVOT_THRESHOLD = 0.1;
+
+    SparseLU::SparseLU(SolveStats* stats) : _stats(stats), _n(0), _stamp(0) {
+    }
+
+    void SparseLU::analyze(size_t n, const std::vector<size_t>& rowPointers,
+            const std::vector<size_t>& columnIndices) {
+
+        if (rowPointers.size() != n + 1 || rowPointers[n] != columnIndices.size()) {
+            throw std::invalid_argument("SparseLU: row pointers do not match n");
+        }
+
+        _n = n;
+
+        // transpose to columns
+        _columnPointers.assign(n + 1, 0);
+
+        for (size_t k = 0; k < columnIndices.size(); k++) {
+            if (columnIndices[k] >= n) {
+                throw std::invalid_argument("SparseLU: column index out of range");
+            }
+
+            _columnPointers[columnIndices[k] + 1]++;
+        }
+
+        for (size_t j = 0; j < n; j++) {
+            _columnPointers[j + 1] += _columnPointers[j];
+        }
+
+        std::vector<size_t> next(_columnPointers.begin(), _columnPointers.end() - 1);
+        _rows.resize(columnIndices.size());
+        _positions.resize(columnIndices.size());
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = rowPointers[i]; k < rowPointers[i + 1]; k++) {
+                size_t& p = next[columnIndices[k]];
+                _rows[p] = i;
+                _positions[p] = k;
+                p++;
+            }
+        }
+
+        order(rowPointers, columnIndices);
+
+        _x.assign(n, 0);
+        _reach.resize(n);
+        _stack.resize(n);
+        _next.resize(n);
+        _visited.assign(n, 0);
+        _stamp = 0;
+        _step.assign(n, NONE);
+        _pivotRow.assign(n, NONE);
+        _lPointers.assign(n + 1, 0);
+        _uPointers.assign(n + 1, 0);
+        _diagonal.assign(n, 0);
+        _lRows.clear();
+        _lValues.clear();
+        _uRows.clear();
+        _uValues.clear();
+    }
+
+    /**
+     * Minimum degree on the quotient graph of A + A^T: every eliminated
+     * variable becomes an element that stands for the clique of its
+     * neighbors, elements adjacent to the pivot are absorbed into the new
+     * one. Degrees are exact.
+     */
+    void SparseLU::order(const std::vector<size_t>& rowPointers,
+            const std::vector<size_t>& columnIndices) {
+
+        const size_t n = _n;
+
+        std::vector<std::vector<size_t> > variables(n);
+        std::vector<std::vector<size_t> > elements(n);
+        std::vector<std::vector<size_t> > members(n);
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = rowPointers[i]; k < rowPointers[i + 1]; k++) {
+                const size_t j = columnIndices[k];
+
+                if (i != j) {
+                    variables[i].push_back(j);
+                    variables[j].push_back(i);
+                }
+            }
+        }
+
+        std::set<std::pair<size_t, size_t> > queue;
+        std::vector<size_t> degree(n);
+
+        for (size_t i = 0; i < n; i++) {
+            std::vector<size_t>& v = variables[i];
+            std::sort(v.begin(), v.end());
+            v.erase(std::unique(v.begin(), v.end()), v.end());
+
+            degree[i] = v.size();
+            queue.insert(std::make_pair(degree[i], i));
+        }
+
+        std::vector<bool> eliminated(n, false);
+        std::vector<bool> absorbed(n, false);
+        std::vector<size_t> mark(n, 0);
+        size_t stamp = 0;
+
+        _q.clear();
+        _q.reserve(n);
+
+        while (!queue.empty()) {
+            const size_t p = queue.begin()->second;
+            queue.erase(queue.begin());
+
+            _q.push_back(p);
+            eliminated[p] = true;
+
+            // the new element: all neighbors of p
+            std::vector<size_t>& element = members[p];
+            element.clear();
+            stamp++;
+            mark[p] = stamp;
+
+            for (size_t k = 0; k < variables[p].size(); k++) {
+                const size_t v = variables[p][k];
+
+                if (!eliminated[v] && mark[v] != stamp) {
+                    mark[v] = stamp;
+                    element.push_back(v);
+                }
+            }
+
+            for (size_t k = 0; k < elements[p].size(); k++) {
+                const size_t e = elements[p][k];
+
+                if (absorbed[e]) {
+                    continue;
+                }
+
+                for (size_t l = 0; l < members[e].size(); l++) {
+                    const size_t v = members[e][l];
+
+                    if (!eliminated[v] && mark[v] != stamp) {
+                        mark[v] = stamp;
+                        element.push_back(v);
+                    }
+                }
+
+                absorbed[e] = true;
+                std::vector<size_t>().swap(members[e]);
+            }
+
+            std::vector<size_t>().swap(variables[p]);
+            std::vector<size_t>().swap(elements[p]);
+
+            const size_t inElement = stamp;
+
+            for (size_t k = 0; k < element.size(); k++) {
+                const size_t i = element[k];
+
+                // edges inside the new element are implied by it
+                std::vector<size_t>& vi = variables[i];
+                size_t m = 0;
+
+                for (size_t l = 0; l < vi.size(); l++) {
+                    if (!eliminated[vi[l]] && mark[vi[l]] != inElement) {
+                        vi[m++] = vi[l];
+                    }
+                }
+
+                vi.resize(m);
+
+                std::vector<size_t>& ei = elements[i];
+                m = 0;
+
+                for (size_t l = 0; l < ei.size(); l++) {
+                    if (!absorbed[ei[l]]) {
+                        ei[m++] = ei[l];
+                    }
+                }
+
+                ei.resize(m);
+                ei.push_back(p);
+            }
+
+            // exact external degrees of the variables of the new element
+            for (size_t k = 0; k < element.size(); k++) {
+                const size_t i = element[k];
+
+                stamp++;
+                mark[i] = stamp;
+                size_t d = 0;
+
+                for (size_t l = 0; l < variables[i].size(); l++) {
+                    mark[variables[i][l]] = stamp;
+                    d++;
+                }
+
+                for (size_t l = 0; l < elements[i].size(); l++) {
+                    const std::vector<size_t>& me = members[elements[i][l]];
+
+                    for (size_t r = 0; r < me.size(); r++) {
+                        const size_t v = me[r];
+
+                        if (!eliminated[v] && mark[v] != stamp) {
+                            mark[v] = stamp;
+                            d++;
+                        }
+                    }
+                }
+
+                queue.erase(std::make_pair(degree[i], i));
+                degree[i] = d;
+                queue.insert(std::make_pair(d, i));
+            }
+        }
+    }
+
+    /**
+     * Rows of column j of L U reachable from the nonzeros of column column
+     * of A, in topological order at _reach[top], ..., _reach[n - 1].
+     * @return top
+     */
+    size_t SparseLU::reach(size_t column) {
+        size_t top = _n;
+
+        _stamp++;
+
+        for (size_t k = _columnPointers[column]; k < _columnPointers[column + 1]; k++) {
+            const size_t start = _rows[k];
+
+            if (_visited[start] == _stamp) {
+                continue;
+            }
+
+            // depth-first search without recursion
+            size_t depth = 0;
+            _stack[0] = start;
+
+            while (true) {
+                const size_t r = _stack[depth];
+                const size_t j = _step[r];
+
+                if (_visited[r] != _stamp) {
+                    _visited[r] = _stamp;
+                    _next[depth] = j == NONE ? 0 : _lPointers[j];
+                }
+
+                const size_t end = j == NONE ? 0 : _lPointers[j + 1];
+                bool done = true;
+
+                for (size_t p = _next[depth]; p < end; p++) {
+                    const size_t i = _lRows[p];
+
+                    if (_visited[i] != _stamp) {
+                        _next[depth] = p + 1;
+                        _stack[++depth] = i;
+                        done = false;
+                        break;
+                    }
+                }
+
+                if (done) {
+                    _reach[--top] = r;
+
+                    if (depth == 0) {
+                        break;
+                    }
+
+                    depth--;
+                }
+            }
+        }
+
+        return top;
+    }
+
+    bool SparseLU::factor(const DVec& values) {
+        IN_PERF_REGION(PERF_LU);
+        IN_TRACE_INSTANT("lu", (double) _n);
+
+        const size_t n = _n;
+
+        if (_columnPointers.size() != n + 1 || values.size() != _positions.size()) {
+            throw std::invalid_argument("SparseLU: values do not match the analyzed pattern");
+        }
+
+        if (_stats != NULL) {
+            _stats->luDecompositions++;
+        }
+
+        std::fill(_step.begin(), _step.end(), NONE);
+        _lRows.clear();
+        _lValues.clear();
+        _uRows.clear();
+        _uValues.clear();
+
+        for (size_t k = 0; k < n; k++) {
+            const size_t column = _q[k];
+
+            _uPointers[k] = _uRows.size();
+            _lPointers[k] = _lRows.size();
+
+            const size_t top = reach(column);
+
+            for (size_t p = top; p < n; p++) {
+                _x[_reach[p]] = 0;
+            }
+
+            for (size_t p = _columnPointers[column]; p < _columnPointers[column + 1]; p++) {
+                _x[_rows[p]] = values[_positions[p]];
+            }
+
+            // x = L \ A(:, column) in topological order
+            for (size_t p = top; p < n; p++) {
+                const size_t r = _reach[p];
+                const size_t j = _step[r];
+
+                if (j == NONE) {
+                    continue;
+                }
+
+                const double xr = _x[r];
+
+                _uRows.push_back(j);
+                _uValues.push_back(xr);
+
+                for (size_t l = _lPointers[j]; l < _lPointers[j + 1]; l++) {
+                    _x[_lRows[l]] -= _lValues[l] * xr;
+                }
+            }
+
+            size_t pivot = NONE;
+            double largest = 0;
+
+            for (size_t p = top; p < n; p++) {
+                const size_t r = _reach[p];
+
+                if (_step[r] == NONE && std::fabs(_x[r]) > largest) {
+                    largest = std::fabs(_x[r]);
+                    pivot = r;
+                }
+            }
+
+            if (largest == 0 || !std::isfinite(largest)) {
+                return false;
+            }
+
+            if (_step[column] == NONE && _visited[column] == _stamp
+                    && std::fabs(_x[column]) >= PIVOT_THRESHOLD * largest) {
+                pivot = column;
+            }
+
+            const double d = _x[pivot];
+
+            _diagonal[k] = d;
+            _pivotRow[k] = pivot;
+            _step[pivot] = k;
+
+            for (size_t p = top; p < n; p++) {
+                const size_t r = _reach[p];
+
+                if (_step[r] == NONE) {
+                    _lRows.push_back(r);
+                    _lValues.push_back(_x[r] / d);
+                }
+            }
+        }
+
+        _uPointers[n] = _uRows.size();
+        _lPointers[n] = _lRows.size();
+
+        return true;
+    }
+
+    void SparseLU::solve(double* b, size_t nrhs) const {
+        IN_PERF_REGION(PERF_LU);
+
+        const size_t n = _n;
+
+        _work.resize(n);
+        _y.resize(n);
+
+        for (size_t r = 0; r < nrhs; r++) {
+            double* x = b + r * n;
+
+            std::copy(x, x + n, _work.begin());
+
+            // L y = P b
+            for (size_t k = 0; k < n; k++) {
+                const double v = _work[_pivotRow[k]];
+                _y[k] = v;
+
+                if (v != 0) {
+                    for (size_t l = _lPointers[k]; l < _lPointers[k + 1]; l++) {
+                        _work[_lRows[l]] -= _lValues[l] * v;
+                    }
+                }
+            }
+
+            // U z = y, x = Q z
+            for (size_t k = n; k-- > 0;) {
+                const double z = _y[k] / _diagonal[k];
+                _y[k] = z;
+
+                if (z != 0) {
+                    for (size_t l = _uPointers[k]; l < _uPointers[k + 1]; l++) {
+                        _y[_uRows[l]] -= _uValues[l] * z;
+                    }
+                }
+
+                x[_q[k]] = z;
+            }
+        }
+
+        if (_stats != NULL) {
+            _stats->luSolves += nrhs;
+        }
+    }
+
+    size_t SparseLU::size() const {
+        return _n;
+    }
+
+    size_t SparseLU::getFactorNonzeros() const {
+        return _lRows.size() + _uRows.size() + _n;
+    }
+
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "StreamingTrajectory.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace iNumerics {
+
+    static const char _MAGIC[8] = {'I', 'N', 'T', 'R', 'A', 'J', 0, 0};
+    static const unsigned int _VERSION = 1;
+    static const size_t _HEADER_SIZE = 16;
+
+    static void _header(unsigned char* header, unsigned int dimension) {
+        memcpy(header, _MAGIC, 8);
+        memcpy(header + 8, &_VERSION, 4);
+        memcpy(header + 12, &dimension, 4);
+    }
+
+    /**
+     * Writes n bytes at offset, retrying partial writes.
+     * @return false on error (errno is set)
+     */
+    static bool _pwriteAll(int fd, const void* data, size_t n, off_t offset) {
+        const char* p = static_cast<const char*> (data);
+
+        while (n > 0) {
+            ssize_t w = pwrite(fd, p, n, offset);
+
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+
+            p += w;
+            n -= (size_t) w;
+            offset += w;
+        }
+
+        return true;
+    }
+
+    StreamingTrajectory::StreamingTrajectory(const std::string& path, size_t bufferSize)
+    : _path(path), _fd(-1), _bufferSize(bufferSize > 0 ? bufferSize : 1), _dimension(0), _size(0),
+    _hasPending(false), _written(0), _stop(false), _failed(false),
+    _minTime(0), _maxTime(0), _cached((size_t) - 1), _time(0) {
+
+        _fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (_fd < 0) {
+            throw std::runtime_error("StreamingTrajectory: cannot open \"" + path + "\": " + strerror(errno));
+        }
+
+        // header with dimension 0, completed by the writer with the first buffer
+        unsigned char header[_HEADER_SIZE];
+        _header(header, 0);
+
+        if (!_pwriteAll(_fd, header, _HEADER_SIZE, 0)) {
+            std::string msg = strerror(errno);
+            close(_fd);
+            throw std::runtime_error("StreamingTrajectory: cannot write \"" + path + "\": " + msg);
+        }
+
+        _writer = std::thread(&StreamingTrajectory::writerLoop, this);
+    }
+
+    StreamingTrajectory::~StreamingTrajectory() {
+        flush();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wakeWriter.notify_one();
+        _writer.join();
+
+        close(_fd);
+    }
+
+    void StreamingTrajectory::operator()(const DVec& x, const double t) {
+        checkError();
+
+        if (_size == 0) {
+            _dimension = x.size();
+            _active.reserve(_bufferSize * (_dimension + 1));
+            _pending.reserve(_bufferSize * (_dimension + 1));
+
+            _minTime = _maxTime = t;
+            _minState = _maxState = x;
+        } else if (x.size() != _dimension) {
+            throw std::invalid_argument("StreamingTrajectory: state dimension changed");
+        }
+
+        _active.push_back(t);
+        _active.insert(_active.end(), x.begin(), x.end());
+        _size++;
+
+        if (t < _minTime) _minTime = t;
+        if (t > _maxTime) _maxTime = t;
+
+        for (size_t i = 0; i < _dimension; i++) {
+            if (x[i] < _minState[i]) _minState[i] = x[i];
+            if (x[i] > _maxState[i]) _maxState[i] = x[i];
+        }
+
+        if (_active.size() == _bufferSize * (_dimension + 1)) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            handOff(lock);
+        }
+    }
+
+    void StreamingTrajectory::finish() {
+        flush();
+        checkError();
+    }
+
+    void StreamingTrajectory::handOff(std::unique_lock<std::mutex>& lock) const {
+        // the only place where the solver may wait for the disk
+        while (_hasPending) {
+            _wakeSolver.wait(lock);
+        }
+
+        _active.swap(_pending);
+        _hasPending = true;
+
+        _wakeWriter.notify_one();
+    }
+
+    void StreamingTrajectory::writerLoop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        bool headerComplete = false;
+
+        for (;;) {
+            while (!_hasPending && !_stop) {
+                _wakeWriter.wait(lock);
+            }
+
+            if (!_hasPending) {
+                break; // stopped and nothing left
+            }
+
+            size_t recordSize = (_dimension + 1) * sizeof (double);
+            off_t offset = (off_t) (_HEADER_SIZE + _written * recordSize);
+            size_t records = _pending.size() / (_dimension + 1);
+
+            lock.unlock();
+
+            // _pending belongs to this thread until _hasPending is reset
+            bool ok = true;
+
+            if (!headerComplete) {
+                unsigned int dimension = (unsigned int) _dimension;
+                ok = _pwriteAll(_fd, &dimension, 4, 12);
+                headerComplete = ok;
+            }
+
+            if (ok) {
+                ok = _pwriteAll(_fd, _pending.data(), _pending.size() * sizeof (double), offset);
+            }
+
+            std::string msg = ok ? "" : strerror(errno);
+
+            lock.lock();
+
+            if (ok) {
+                _written += records;
+            } else if (!_failed) {
+                _error = "StreamingTrajectory: cannot write \"" + _path + "\": " + msg;
+                _failed = true;
+            }
+
+            _pending.clear();
+            _hasPending = false;
+
+            _wakeSolver.notify_all();
+        }
+    }
+
+    void StreamingTrajectory::flush() const {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        if (!_active.empty()) {
+            handOff(lock);
+        }
+
+        while (_hasPending) {
+            _wakeSolver.wait(lock);
+        }
+    }
+
+    void StreamingTrajectory::checkError() const {
+        if (_failed) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            throw std::runtime_error(_error);
+        }
+    }
+
+    void StreamingTrajectory::readRecord(std::size_t i) const {
+        if (i == _cached) {
+            return;
+        }
+
+        if (i >= _size) {
+            throw std::out_of_range("StreamingTrajectory: index out of range");
+        }
+
+        flush();
+        checkError();
+
+        std::vector<double> record(_dimension + 1);
+        size_t n = record.size() * sizeof (double);
+        off_t offset = (off_t) (_HEADER_SIZE + i * n);
+
+        if (pread(_fd, record.data(), n, offset) != (ssize_t) n) {
+            throw std::runtime_error("StreamingTrajectory: cannot read \"" + _path + "\"");
+        }
+
+        _time = record[0];
+        _state.assign(record.begin() + 1, record.end());
+        _cached = i;
+    }
+
+    double StreamingTrajectory::getTime(std::size_t i) const {
+        readRecord(i);
+        return _time;
+    }
+
+    const DVec& StreamingTrajectory::getState(std::size_t i) const {
+        readRecord(i);
+        return _state;
+    }
+
+    size_t StreamingTrajectory::size() const {
+        return _size;
+    }
+
+    double StreamingTrajectory::getMinTime() const {
+        return _minTime;
+    }
+
+    double StreamingTrajectory::getMaxTime() const {
+        return _maxTime;
+    }
+
+    double StreamingTrajectory::getMinState(size_t i) const {
+        return _size > 0 ? _minState[i] : 0;
+    }
+
+    double StreamingTrajectory::getMaxState(size_t i) const {
+        return _size > 0 ? _maxState[i] : 0;
+    }
+
+    void StreamingTrajectory::encode(const Trajectory& trajectory, std::vector<unsigned char>& out) {
+        size_t n = trajectory.size();
+        size_t dimension = n > 0 ? trajectory.getState(0).size() : 0;
+        size_t recordSize = (dimension + 1) * sizeof (double);
+
+        size_t start = out.size();
+        out.resize(start + _HEADER_SIZE + n * recordSize);
+
+        unsigned char* p = &out[start];
+        _header(p, (unsigned int) dimension);
+        p += _HEADER_SIZE;
+
+        for (size_t i = 0; i < n; i++) {
+            double t = trajectory.getTime(i);
+            const DVec& x = trajectory.getState(i);
+
+            memcpy(p, &t, sizeof (double));
+            memcpy(p + sizeof (double), x.data(), dimension * sizeof (double));
+            p += recordSize;
+        }
+    }
+
+    StateSummary StreamingTrajectory::getStateSummary(size_t i, double t0, double t1) const {
+        return scanStateSummary(i, t0, t1);
+    }
+
+    const std::string& StreamingTrajectory::getPath() const {
+        return _path;
+    }
+
+    size_t StreamingTrajectory::getDimension() const {
+        return _dimension;
+    }
+
+}
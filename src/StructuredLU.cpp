@@ -0,0 +1,231 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+
+#include "StructuredLU.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "inblaswrapper.h"
+#include "inperfcounters.h"
+#include "intracer.h"
+
+namespace iNumerics {
+
+    StructuredLU::StructuredLU(SolveStats* stats)
+    : _stats(stats), _type(JacobianStructure::DENSE), _n(0), _lower(0), _upper(0), _blockSize(0),
+    _dense(stats), _sparse(stats) {
+    }
+
+    bool StructuredLU::factor(const JacobianStructure& structure, const DVec& values) {
+        const size_t n = structure.getDimension();
+
+        if (values.size() != structure.getValueCount()) {
+            throw std::invalid_argument("StructuredLU: value count does not match the structure");
+        }
+
+        _type = structure.getType();
+        _n = n;
+
+        if (_type == JacobianStructure::DENSE) {
+            return _dense.factor(values, n);
+        }
+
+        if (_type == JacobianStructure::SPARSE) {
+            if (_sparse.size() != n
+                    || structure.getRowPointers() != _rowPointers
+                    || structure.getColumnIndices() != _columnIndices) {
+                _rowPointers = structure.getRowPointers();
+                _columnIndices = structure.getColumnIndices();
+                _sparse.analyze(n, _rowPointers, _columnIndices);
+            }
+
+            return _sparse.factor(values);
+        }
+
+        IN_PERF_REGION(PERF_LU);
+        IN_TRACE_INSTANT("lu", (double) n);
+
+        if (_stats != NULL) {
+            _stats->luDecompositions++;
+        }
+
+        _pivots.resize(n);
+
+        inInt info = 0;
+
+        if (_type == JacobianStructure::BANDED) {
+            _lower = structure.getLowerBandwidth();
+            _upper = structure.getUpperBandwidth();
+
+            // dgbtrf needs kl extra rows above the band for the fill
+            const size_t width = _lower + _upper + 1;
+            const size_t ld = width + _lower;
+
+            _lu.assign(ld * n, 0);
+
+            for (size_t j = 0; j < n; j++) {
+                std::copy(values.begin() + j * width, values.begin() + (j + 1) * width,
+                        _lu.begin() + j * ld + _lower);
+            }
+
+            inInt m = n;
+            inInt kl = _lower;
+            inInt ku = _upper;
+            inInt ldab = ld;
+
+            if (n > 0) {
+                dgbtrf_(&m, &m, &kl, &ku, &_lu[0], &ldab, &_pivots[0], &info);
+            }
+
+            return info == 0;
+        }
+
+        // LU with partial pivoting per block, inline: the blocks are
+        // usually small, and then one LAPACK call per block costs more
+        // than the factorization itself
+        const size_t bs = structure.getBlockSize();
+
+        _blockSize = bs;
+        _lu = values;
+        _blockPivots.resize(n);
+
+        for (size_t first = 0; first < n; first += bs) {
+            double* A = &_lu[first * bs];
+            size_t* pivots = &_blockPivots[first];
+
+            for (size_t k = 0; k < bs; k++) {
+                size_t p = k;
+
+                for (size_t i = k + 1; i < bs; i++) {
+                    if (std::fabs(A[k * bs + i]) > std::fabs(A[k * bs + p])) {
+                        p = i;
+                    }
+                }
+
+                pivots[k] = p;
+
+                if (A[k * bs + p] == 0) {
+                    return false;
+                }
+
+                if (p != k) {
+                    for (size_t j = 0; j < bs; j++) {
+                        std::swap(A[j * bs + k], A[j * bs + p]);
+                    }
+                }
+
+                for (size_t i = k + 1; i < bs; i++) {
+                    A[k * bs + i] /= A[k * bs + k];
+                }
+
+                for (size_t j = k + 1; j < bs; j++) {
+                    for (size_t i = k + 1; i < bs; i++) {
+                        A[j * bs + i] -= A[k * bs + i] * A[j * bs + k];
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void StructuredLU::solve(double* b, size_t nrhs) const {
+        if (_type == JacobianStructure::DENSE) {
+            _dense.solve(b, nrhs);
+            return;
+        }
+
+        if (_type == JacobianStructure::SPARSE) {
+            _sparse.solve(b, nrhs);
+            return;
+        }
+
+        IN_PERF_REGION(PERF_LU);
+
+        if (_n == 0 || nrhs == 0) {
+            return;
+        }
+
+        inInt n = _n;
+        inInt k = nrhs;
+        inInt info = 0;
+        char trans = 'N';
+
+        if (_type == JacobianStructure::BANDED) {
+            inInt kl = _lower;
+            inInt ku = _upper;
+            inInt ldab = 2 * _lower + _upper + 1;
+
+            dgbtrs_(&trans, &n, &kl, &ku, &k, &_lu[0], &ldab, &_pivots[0], b, &n, &info);
+        } else {
+            const size_t bs = _blockSize;
+
+            for (size_t r = 0; r < nrhs; r++) {
+                for (size_t first = 0; first < _n; first += bs) {
+                    const double* A = &_lu[first * bs];
+                    double* x = b + r * _n + first;
+
+                    for (size_t i = 0; i < bs; i++) {
+                        const size_t p = _blockPivots[first + i];
+
+                        if (p != i) {
+                            std::swap(x[i], x[p]);
+                        }
+                    }
+
+                    for (size_t j = 0; j < bs; j++) {
+                        for (size_t i = j + 1; i < bs; i++) {
+                            x[i] -= A[j * bs + i] * x[j];
+                        }
+                    }
+
+                    for (size_t j = bs; j-- > 0;) {
+                        x[j] /= A[j * bs + j];
+
+                        for (size_t i = 0; i < j; i++) {
+                            x[i] -= A[j * bs + i] * x[j];
+                        }
+                    }
+                }
+            }
+        }
+
+        if (_stats != NULL) {
+            _stats->luSolves += nrhs;
+        }
+    }
+
+    size_t StructuredLU::size() const {
+        return _n;
+    }
+
+}
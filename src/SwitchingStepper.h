@@ -0,0 +1,148 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#ifndef SWITCHINGSTEPPER_H
+#define	SWITCHINGSTEPPER_H
+
+#include <cmath>
+#include <algorithm>
+
+#include <boost/numeric/odeint/stepper/controlled_step_result.hpp>
+
+#include "Types.h"
+#include "SolveStats.h"
+#include "Jacobian.h"
+#include "RosenbrockW.h"
+#include "DormandPrince.h"
+
+namespace iNumerics {
+
+    /**
+     * Automatic switching between Dormand-Prince 5(4) and the Rosenbrock-W
+     * method, after the stiffness detection of DOPRI5 and the method
+     * selection of LSODA. The explicit method starts; its accepted steps
+     * estimate h rho from the stage data and the problem is taken as stiff
+     * once h rho exceeds the stability boundary (3.25) in 15 accepted
+     * steps without 6 non-stiff ones in a row. The stiff method returns
+     * to the explicit one after 5 accepted steps whose proposed step size
+     * is within the stability limit 3.3 / |J| of the explicit method,
+     * with |J| the row sum norm of the Jacobian it has already formed.
+     */
+    class _SwitchingStepper {
+    public:
+
+        _SwitchingStepper(_Jacobian& jacobian, SolveStats& stats, size_t n,
+                double absError, double relError)
+        : _explicit(absError, relError), _stiff(jacobian, stats, n, absError, relError, true),
+        _stats(stats), _isStiff(false), _lastRejected(false), _stiffCount(0), _nonstiffCount(0) {
+        }
+
+        template <class System>
+        boost::numeric::odeint::controlled_step_result try_step(System system,
+                DVec& x, const DVec& dxdt, double& t, double& dt) {
+
+            using namespace boost::numeric::odeint;
+
+            if (_isStiff) {
+                if (_stiff.try_step(system, x, dxdt, t, dt) == fail) {
+                    return fail;
+                }
+
+                _stats.stiffSteps++;
+
+                const double norm = _stiff.jacobianNorm();
+
+                if (norm * dt <= 3.3) {
+                    if (++_nonstiffCount == 5) {
+                        IN_TRACE_INSTANT("nonstiff", t);
+                        _stats.methodSwitches++;
+                        _isStiff = false;
+                        _lastRejected = false;
+                        _stiffCount = 0;
+                        _nonstiffCount = 0;
+                    }
+                } else {
+                    _nonstiffCount = 0;
+                }
+
+                return success;
+            }
+
+            const double err = _explicit.step(system, x, dxdt, t, dt, _xnew, _k7, _dense);
+
+            if (!(err <= 1)) {
+                dt *= std::isfinite(err) ? std::max(0.2, 0.9 * std::pow(err, -0.2)) : 0.2;
+                _lastRejected = true;
+                return fail;
+            }
+
+            if (dt * _explicit.stiffness(_xnew, _k7) > 3.25) {
+                _nonstiffCount = 0;
+
+                if (++_stiffCount == 15) {
+                    IN_TRACE_INSTANT("stiff", t + dt);
+                    _stats.methodSwitches++;
+                    _isStiff = true;
+                    _stiffCount = 0;
+                }
+            } else if (++_nonstiffCount == 6) {
+                _stiffCount = 0;
+            }
+
+            double fac = std::min(10., std::max(0.2, 0.9 * std::pow(std::max(err, 1.e-10), -0.2)));
+
+            if (_lastRejected) {
+                fac = std::min(fac, 1.);
+            }
+
+            x.swap(_xnew);
+            t += dt;
+            dt *= fac;
+            _lastRejected = false;
+            return success;
+        }
+
+    private:
+        _DormandPrince _explicit;
+        _RosenbrockW _stiff;
+        SolveStats& _stats;
+
+        bool _isStiff;
+        bool _lastRejected;
+        size_t _stiffCount;
+        size_t _nonstiffCount;
+
+        DVec _xnew;
+        DVec _k7;
+        DVec _dense;
+    };
+
+}
+
+#endif	/* SWITCHINGSTEPPER_H */
@@ -26,13 +26,15 @@
  * or implied, of Michael Hoffer <info@michaelhoffer.de>.
  */
 
+
 #include "Trajectory.h"
 
 #include "iostream"
+#include <algorithm>
 
 namespace iNumerics {
 
-    Trajectory::Trajectory() {
+    Trajectory::Trajectory() : _minTime(0), _maxTime(0) {
     }
 
 //    Trajectory::Trajectory(const Trajectory& orig) {
@@ -44,8 +46,95 @@ namespace iNumerics {
     }
 
     void Trajectory::operator()(const DVec& x, const double t) {
+        if (_times.empty()) {
+            _minTime = _maxTime = t;
+            _minState = _maxState = x;
+        } else {
+            if (t < _minTime) _minTime = t;
+            if (t > _maxTime) _maxTime = t;
+
+            for (size_t i = 0; i < x.size(); i++) {
+                if (x[i] < _minState[i]) _minState[i] = x[i];
+                if (x[i] > _maxState[i]) _maxState[i] = x[i];
+            }
+        }
+
         _states.push_back(x);
         _times.push_back(t);
+
+        updateSummary(x);
+    }
+
+    void Trajectory::finish() {
+    }
+
+    void Trajectory::updateSummary(const DVec& x) {
+        size_t n = _times.size();
+        size_t d = x.size();
+        size_t block = (n - 1) / SUMMARY_BLOCK;
+
+        if (_levels.empty()) {
+            _levels.resize(1);
+        }
+
+        std::vector<double>& leaves = _levels[0];
+
+        if ((n - 1) % SUMMARY_BLOCK == 0) {
+            for (size_t i = 0; i < d; i++) {
+                leaves.push_back(x[i]);
+                leaves.push_back(x[i]);
+                leaves.push_back(x[i]);
+            }
+        } else {
+            double* node = &leaves[block * 3 * d];
+
+            for (size_t i = 0; i < d; i++, node += 3) {
+                if (x[i] < node[0]) node[0] = x[i];
+                if (x[i] > node[1]) node[1] = x[i];
+                node[2] += x[i];
+            }
+        }
+
+        // a completed block is propagated to the upper levels
+        if (n % SUMMARY_BLOCK == 0) {
+            size_t node = block;
+
+            for (size_t l = 1; _levels[l - 1].size() > 3 * d; l++) {
+                node /= 2;
+                mergeNode(l, node);
+            }
+        }
+    }
+
+    void Trajectory::mergeNode(size_t level, size_t node) {
+        size_t d = _minState.size();
+
+        if (_levels.size() <= level) {
+            _levels.resize(level + 1);
+        }
+
+        std::vector<double>& parent = _levels[level];
+        const std::vector<double>& children = _levels[level - 1];
+
+        if (parent.size() < (node + 1) * 3 * d) {
+            parent.resize((node + 1) * 3 * d);
+        }
+
+        const double* left = &children[2 * node * 3 * d];
+        const double* right = children.size() >= (2 * node + 2) * 3 * d ? left + 3 * d : NULL;
+        double* result = &parent[node * 3 * d];
+
+        for (size_t i = 0; i < 3 * d; i += 3) {
+            result[i] = left[i];
+            result[i + 1] = left[i + 1];
+            result[i + 2] = left[i + 2];
+
+            if (right != NULL) {
+                result[i] = std::min(result[i], right[i]);
+                result[i + 1] = std::max(result[i + 1], right[i + 1]);
+                result[i + 2] += right[i + 2];
+            }
+        }
     }
 
     double Trajectory::getTime(std::size_t i) const {
@@ -61,23 +150,11 @@ namespace iNumerics {
     }
 
     double Trajectory::getMinTime() const {
-        
-        if (_times.size() == 0) {
-            return 0;
-        }
-
-        return *std::min_element(_times.begin(), _times.end());
-        
+        return _minTime;
     }
 
     double Trajectory::getMaxTime() const {
-        
-        if (_times.size() == 0) {
-            return 0;
-        }
-
-        return *std::max_element(_times.begin(), _times.end());
-        
+        return _maxTime;
     }
 
     double Trajectory::getMinState(size_t i) const {
@@ -86,15 +163,7 @@ namespace iNumerics {
             return 0;
         }
         
-        double result = _states[0][i];
-        
-        for (size_t j = 0; j < _states.size();j++) {
-            if (_states[j][i] < result) {
-                result = _states[j][i];
-            }
-        }
-        
-        return result;
+        return _minState[i];
     }
 
     double Trajectory::getMaxState(size_t i) const {
@@ -103,15 +172,95 @@ namespace iNumerics {
             return 0;
         }
         
-        double result = _states[0][i];
-        
-        for (size_t j = 0; j < _states.size();j++) {
-            if (_states[j][i] > result) {
-                result = _states[j][i];
+        return _maxState[i];
+    }
+
+    void Trajectory::addNode(StateSummary& s, size_t level, size_t node, size_t i) const {
+        const double* v = &_levels[level][(node * _minState.size() + i) * 3];
+
+        if (s.count == 0 || v[0] < s.min) s.min = v[0];
+        if (s.count == 0 || v[1] > s.max) s.max = v[1];
+        s.mean += v[2];
+        s.count += SUMMARY_BLOCK << level;
+    }
+
+    void Trajectory::addSteps(StateSummary& s, size_t i, size_t first, size_t last) const {
+        for (size_t j = first; j < last; j++) {
+            double v = _states[j][i];
+
+            if (s.count == 0 || v < s.min) s.min = v;
+            if (s.count == 0 || v > s.max) s.max = v;
+            s.mean += v;
+            s.count++;
+        }
+    }
+
+    StateSummary Trajectory::getStateSummary(size_t i, double t0, double t1) const {
+        StateSummary s = {0, 0, 0, 0};
+
+        size_t first = std::lower_bound(_times.begin(), _times.end(), t0) - _times.begin();
+        size_t last = std::upper_bound(_times.begin(), _times.end(), t1) - _times.begin();
+
+        if (first >= last) {
+            return s;
+        }
+
+        // complete blocks inside the window
+        size_t b0 = (first + SUMMARY_BLOCK - 1) / SUMMARY_BLOCK;
+        size_t b1 = last / SUMMARY_BLOCK;
+
+        if (b0 >= b1) {
+            addSteps(s, i, first, last);
+        } else {
+            addSteps(s, i, first, b0 * SUMMARY_BLOCK);
+            addSteps(s, i, b1 * SUMMARY_BLOCK, last);
+
+            for (size_t l = 0; b0 < b1; l++, b0 /= 2, b1 /= 2) {
+                if (b0 & 1) addNode(s, l, b0++, i);
+                if (b1 & 1) addNode(s, l, --b1, i);
             }
         }
-        
-        return result;
+
+        s.mean /= s.count;
+
+        return s;
+    }
+
+    double Trajectory::getStateComponent(size_t i, size_t c) const {
+        return getState(i)[c];
+    }
+
+    StateSummary Trajectory::scanStateSummary(size_t i, double t0, double t1) const {
+        StateSummary s = {0, 0, 0, 0};
+
+        // first step with t >= t0
+        size_t lo = 0;
+        size_t hi = size();
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (getTime(mid) < t0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        for (size_t j = lo; j < size() && getTime(j) <= t1; j++) {
+            double v = getStateComponent(j, i);
+
+            if (s.count == 0 || v < s.min) s.min = v;
+            if (s.count == 0 || v > s.max) s.max = v;
+            s.mean += v;
+            s.count++;
+        }
+
+        if (s.count > 0) {
+            s.mean /= s.count;
+        }
+
+        return s;
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "TrajectoryIO.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "StreamingTrajectory.h"
+
+namespace iNumerics {
+
+    static const size_t _BUFFER_SIZE = 1 << 20;
+
+    // std::to_chars needs at most 24 characters for a double
+    static const size_t _MAX_NUMBER = 32;
+
+    /**
+     * Output file with a large write buffer.
+     */
+    class _BufferedFile {
+    public:
+
+        _BufferedFile(const std::string& path) : _path(path), _used(0), _buffer(_BUFFER_SIZE) {
+            _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+            if (_fd < 0) {
+                throw std::runtime_error("TrajectoryWriter: cannot open \"" + path + "\": " + strerror(errno));
+            }
+        }
+
+        ~_BufferedFile() {
+            if (_fd >= 0) {
+                ::close(_fd);
+            }
+        }
+
+        /**
+         * @return space for at least n characters
+         */
+        char* reserve(size_t n) {
+            if (_used + n > _buffer.size()) {
+                flush();
+
+                if (n > _buffer.size()) {
+                    _buffer.resize(n);
+                }
+            }
+
+            return &_buffer[_used];
+        }
+
+        void commit(char* end) {
+            _used = end - &_buffer[0];
+        }
+
+        void write(const void* data, size_t n) {
+            const char* p = static_cast<const char*> (data);
+
+            while (n > 0) {
+                size_t chunk = std::min(n, _buffer.size());
+                memcpy(reserve(chunk), p, chunk);
+                _used += chunk;
+                p += chunk;
+                n -= chunk;
+            }
+        }
+
+        void flush() {
+            size_t done = 0;
+
+            while (done < _used) {
+                ssize_t w = ::write(_fd, &_buffer[done], _used - done);
+
+                if (w < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if (w < 0) {
+                    throw std::runtime_error("TrajectoryWriter: cannot write \"" + _path + "\": " + strerror(errno));
+                }
+
+                done += (size_t) w;
+            }
+
+            _used = 0;
+        }
+
+        void close() {
+            flush();
+
+            int fd = _fd;
+            _fd = -1;
+
+            if (::close(fd) != 0) {
+                throw std::runtime_error("TrajectoryWriter: cannot close \"" + _path + "\": " + strerror(errno));
+            }
+        }
+
+    private:
+        std::string _path;
+        int _fd;
+        size_t _used;
+        std::vector<char> _buffer;
+    };
+
+    /**
+     * Read-only mapping of a whole file.
+     */
+    class _MappedFile {
+    public:
+
+        _MappedFile(const std::string& path) : _data(NULL), _size(0) {
+            _fd = open(path.c_str(), O_RDONLY);
+
+            if (_fd < 0) {
+                throw std::runtime_error("TrajectoryReader: cannot open \"" + path + "\": " + strerror(errno));
+            }
+
+            struct stat st;
+
+            if (fstat(_fd, &st) != 0) {
+                ::close(_fd);
+                throw std::runtime_error("TrajectoryReader: cannot stat \"" + path + "\": " + strerror(errno));
+            }
+
+            _size = (size_t) st.st_size;
+
+            if (_size > 0) {
+                void* data = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+
+                if (data == MAP_FAILED) {
+                    ::close(_fd);
+                    throw std::runtime_error("TrajectoryReader: cannot map \"" + path + "\": " + strerror(errno));
+                }
+
+                _data = static_cast<const char*> (data);
+                madvise(data, _size, MADV_SEQUENTIAL);
+            }
+        }
+
+        ~_MappedFile() {
+            if (_data != NULL) {
+                munmap(const_cast<char*> (_data), _size);
+            }
+            ::close(_fd);
+        }
+
+        const char* begin() const {
+            return _data;
+        }
+
+        const char* end() const {
+            return _data + _size;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+    private:
+        int _fd;
+        const char* _data;
+        size_t _size;
+    };
+
+    /**
+     * @return position of the next '\n' in [p, end) or end
+     */
+    static inline const char* _findNewline(const char* p, const char* end) {
+#ifdef __SSE2__
+        const __m128i newline = _mm_set1_epi8('\n');
+
+        while (p + 16 <= end) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*> (p));
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+
+            p += 16;
+        }
+#endif
+        const void* hit = memchr(p, '\n', end - p);
+
+        return hit != NULL ? static_cast<const char*> (hit) : end;
+    }
+
+    static void _parseError(const std::string& what, size_t line) {
+        std::stringstream msg;
+        msg << "TrajectoryReader: " << what << " in line " << line;
+        throw std::runtime_error(msg.str());
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::TrajectoryWriter                                   *
+     *                                                                            *
+     ******************************************************************************/
+
+    void TrajectoryWriter::writeText(const std::string& path, const Trajectory& trajectory,
+            char delimiter, bool header) {
+
+        _BufferedFile file(path);
+
+        size_t n = trajectory.size();
+        size_t dimension = n > 0 ? trajectory.getState(0).size() : 0;
+
+        if (header) {
+            std::stringstream line;
+            line << "t";
+
+            for (size_t c = 0; c < dimension; c++) {
+                line << delimiter << "x" << c;
+            }
+
+            line << "\n";
+
+            std::string s = line.str();
+            file.write(s.data(), s.size());
+        }
+
+        size_t rowSize = (dimension + 1) * _MAX_NUMBER;
+
+        for (size_t i = 0; i < n; i++) {
+            const DVec& x = trajectory.getState(i);
+            char* p = file.reserve(rowSize);
+            char* end = p + rowSize;
+
+            p = std::to_chars(p, end, trajectory.getTime(i)).ptr;
+
+            for (size_t c = 0; c < dimension; c++) {
+                *p++ = delimiter;
+                p = std::to_chars(p, end, x[c]).ptr;
+            }
+
+            *p++ = '\n';
+
+            file.commit(p);
+        }
+
+        file.close();
+    }
+
+    void TrajectoryWriter::writeBinary(const std::string& path, const Trajectory& trajectory) {
+        std::vector<unsigned char> data;
+        StreamingTrajectory::encode(trajectory, data);
+
+        _BufferedFile file(path);
+        file.write(data.data(), data.size());
+        file.close();
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::TrajectoryReader                                   *
+     *                                                                            *
+     ******************************************************************************/
+
+    void TrajectoryReader::readText(const std::string& path, Trajectory& trajectory, char delimiter) {
+        _MappedFile file(path);
+
+        const char* p = file.begin();
+        const char* end = file.end();
+
+        DVec x;
+        size_t dimension = (size_t) - 1;
+        size_t line = 0;
+
+        while (p < end) {
+            const char* eol = _findNewline(p, end);
+            const char* last = eol;
+            line++;
+
+            if (last > p && last[-1] == '\r') {
+                last--;
+            }
+
+            if (last == p) {
+                p = eol + 1;
+                continue; // blank line
+            }
+
+            double t;
+            std::from_chars_result r = std::from_chars(p, last, t);
+
+            if (r.ec != std::errc()) {
+                if (line == 1) {
+                    p = eol + 1;
+                    continue; // header
+                }
+                _parseError("invalid time", line);
+            }
+
+            x.clear();
+            const char* q = r.ptr;
+
+            while (q < last) {
+                if (*q != delimiter) {
+                    _parseError("expected delimiter", line);
+                }
+
+                q++;
+
+                while (q < last && *q == ' ') {
+                    q++;
+                }
+
+                double v;
+                r = std::from_chars(q, last, v);
+
+                if (r.ec != std::errc()) {
+                    _parseError("invalid number", line);
+                }
+
+                x.push_back(v);
+                q = r.ptr;
+            }
+
+            if (dimension == (size_t) - 1) {
+                dimension = x.size();
+            } else if (x.size() != dimension) {
+                _parseError("wrong number of columns", line);
+            }
+
+            trajectory(x, t);
+
+            p = eol + 1;
+        }
+    }
+
+    void TrajectoryReader::readBinary(const std::string& path, Trajectory& trajectory) {
+        _MappedFile file(path);
+
+        const size_t headerSize = 16;
+        const char magic[8] = {'I', 'N', 'T', 'R', 'A', 'J', 0, 0};
+
+        if (file.size() < headerSize || memcmp(file.begin(), magic, 8) != 0) {
+            throw std::runtime_error("TrajectoryReader: \"" + path + "\" is not a trajectory file");
+        }
+
+        unsigned int version;
+        unsigned int dimension;
+        memcpy(&version, file.begin() + 8, 4);
+        memcpy(&dimension, file.begin() + 12, 4);
+
+        if (version != 1) {
+            throw std::runtime_error("TrajectoryReader: \"" + path + "\" has unsupported version");
+        }
+
+        // dimension 0 is only valid for a stream that never got its first step
+        size_t recordSize = ((size_t) dimension + 1) * sizeof (double);
+        size_t payload = file.size() - headerSize;
+
+        if ((dimension == 0 && payload != 0) || payload % recordSize != 0) {
+            throw std::runtime_error("TrajectoryReader: \"" + path + "\" is truncated or corrupt");
+        }
+
+        size_t n = payload / recordSize;
+
+        if (n == 0) {
+            return;
+        }
+
+        DVec x(dimension);
+        const char* p = file.begin() + headerSize;
+
+        for (size_t i = 0; i < n; i++, p += recordSize) {
+            double t;
+            memcpy(&t, p, sizeof (double));
+            memcpy(x.data(), p + sizeof (double), dimension * sizeof (double));
+            trajectory(x, t);
+        }
+    }
+
+}
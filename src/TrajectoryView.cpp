@@ -0,0 +1,375 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+
+#include "TrajectoryView.h"
+
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+
+#include "Interpolation.h"
+
+namespace iNumerics {
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::TrajectoryView                                     *
+     *                                                                            *
+     ******************************************************************************/
+
+    TrajectoryView::TrajectoryView(const Trajectory& source)
+    : _source(source), _sourceView(dynamic_cast<const TrajectoryView*> (&source)) {
+    }
+
+    TrajectoryView::~TrajectoryView() {
+    }
+
+    void TrajectoryView::operator()(const DVec& x, const double t) {
+        throw std::logic_error("TrajectoryView is read-only");
+    }
+
+    const DVec& TrajectoryView::getState(std::size_t i) const {
+        size_t d = getDimension();
+        _state.resize(d);
+
+        for (size_t c = 0; c < d; c++) {
+            _state[c] = getState(i, c);
+        }
+
+        return _state;
+    }
+
+    double TrajectoryView::getMinTime() const {
+        return size() > 0 ? getTime(0) : 0;
+    }
+
+    double TrajectoryView::getMaxTime() const {
+        return size() > 0 ? getTime(size() - 1) : 0;
+    }
+
+    double TrajectoryView::getMinState(size_t i) const {
+        return getStateSummary(i, getMinTime(), getMaxTime()).min;
+    }
+
+    double TrajectoryView::getMaxState(size_t i) const {
+        return getStateSummary(i, getMinTime(), getMaxTime()).max;
+    }
+
+    StateSummary TrajectoryView::getStateSummary(size_t i, double t0, double t1) const {
+        return scanStateSummary(i, t0, t1);
+    }
+
+    double TrajectoryView::getStateComponent(size_t i, size_t c) const {
+        return getState(i, c);
+    }
+
+    const Trajectory& TrajectoryView::getSource() const {
+        return _source;
+    }
+
+    double TrajectoryView::sourceState(size_t i, size_t component) const {
+        if (_sourceView != NULL) {
+            return _sourceView->getState(i, component);
+        }
+
+        return _source.getState(i)[component];
+    }
+
+    size_t TrajectoryView::sourceDimension() const {
+        if (_sourceView != NULL) {
+            return _sourceView->getDimension();
+        }
+
+        return _source.size() > 0 ? _source.getState(0).size() : 0;
+    }
+
+    size_t TrajectoryView::lowerBound(double t) const {
+        size_t lo = 0;
+        size_t hi = _source.size();
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (_source.getTime(mid) < t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return lo;
+    }
+
+    size_t TrajectoryView::upperBound(double t) const {
+        size_t lo = 0;
+        size_t hi = _source.size();
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (_source.getTime(mid) <= t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return lo;
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::TimeSliceView                                      *
+     *                                                                            *
+     ******************************************************************************/
+
+    TimeSliceView::TimeSliceView(const Trajectory& source, double t0, double t1)
+    : TrajectoryView(source), _t0(t0), _t1(t1) {
+        _first = lowerBound(t0);
+        _last = std::max(_first, upperBound(t1));
+    }
+
+    double TimeSliceView::getTime(std::size_t i) const {
+        return _source.getTime(_first + i);
+    }
+
+    double TimeSliceView::getState(std::size_t i, size_t component) const {
+        return sourceState(_first + i, component);
+    }
+
+    size_t TimeSliceView::size() const {
+        return _last - _first;
+    }
+
+    size_t TimeSliceView::getDimension() const {
+        return sourceDimension();
+    }
+
+    double TimeSliceView::getMinState(size_t i) const {
+        return getStateSummary(i, _t0, _t1).min;
+    }
+
+    double TimeSliceView::getMaxState(size_t i) const {
+        return getStateSummary(i, _t0, _t1).max;
+    }
+
+    StateSummary TimeSliceView::getStateSummary(size_t i, double t0, double t1) const {
+        return _source.getStateSummary(i, std::max(t0, _t0), std::min(t1, _t1));
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::ComponentView                                      *
+     *                                                                            *
+     ******************************************************************************/
+
+    ComponentView::ComponentView(const Trajectory& source, const std::vector<size_t>& components)
+    : TrajectoryView(source), _components(components) {
+        check();
+    }
+
+    ComponentView::ComponentView(const Trajectory& source, size_t component)
+    : TrajectoryView(source), _components(1, component) {
+        check();
+    }
+
+    void ComponentView::check() const {
+        if (_source.size() == 0) {
+            return;
+        }
+
+        size_t d = sourceDimension();
+
+        for (size_t c = 0; c < _components.size(); c++) {
+            if (_components[c] >= d) {
+                throw std::out_of_range("ComponentView: component out of range");
+            }
+        }
+    }
+
+    double ComponentView::getTime(std::size_t i) const {
+        return _source.getTime(i);
+    }
+
+    double ComponentView::getState(std::size_t i, size_t component) const {
+        return sourceState(i, _components[component]);
+    }
+
+    size_t ComponentView::size() const {
+        return _source.size();
+    }
+
+    size_t ComponentView::getDimension() const {
+        return _components.size();
+    }
+
+    double ComponentView::getMinTime() const {
+        return _source.getMinTime();
+    }
+
+    double ComponentView::getMaxTime() const {
+        return _source.getMaxTime();
+    }
+
+    double ComponentView::getMinState(size_t i) const {
+        return _source.getMinState(_components[i]);
+    }
+
+    double ComponentView::getMaxState(size_t i) const {
+        return _source.getMaxState(_components[i]);
+    }
+
+    StateSummary ComponentView::getStateSummary(size_t i, double t0, double t1) const {
+        return _source.getStateSummary(_components[i], t0, t1);
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::StrideView                                         *
+     *                                                                            *
+     ******************************************************************************/
+
+    StrideView::StrideView(const Trajectory& source, size_t stride, size_t offset)
+    : TrajectoryView(source), _stride(stride), _offset(offset) {
+        if (stride == 0) {
+            throw std::invalid_argument("StrideView: stride must be > 0");
+        }
+    }
+
+    double StrideView::getTime(std::size_t i) const {
+        return _source.getTime(_offset + i * _stride);
+    }
+
+    double StrideView::getState(std::size_t i, size_t component) const {
+        return sourceState(_offset + i * _stride, component);
+    }
+
+    size_t StrideView::size() const {
+        size_t n = _source.size();
+
+        return n > _offset ? (n - _offset + _stride - 1) / _stride : 0;
+    }
+
+    size_t StrideView::getDimension() const {
+        return sourceDimension();
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::ResampledView                                      *
+     *                                                                            *
+     ******************************************************************************/
+
+    ResampledView::ResampledView(const Trajectory& source, double dt)
+    : TrajectoryView(source) {
+        if (source.size() == 0) {
+            init(0, -1, dt);
+        } else {
+            init(source.getTime(0), source.getTime(source.size() - 1), dt);
+        }
+    }
+
+    ResampledView::ResampledView(const Trajectory& source, double t0, double t1, double dt)
+    : TrajectoryView(source) {
+        init(t0, t1, dt);
+    }
+
+    void ResampledView::init(double t0, double t1, double dt) {
+        if (!(dt > 0)) {
+            throw std::invalid_argument("ResampledView: dt must be > 0");
+        }
+
+        _t0 = t0;
+        _dt = dt;
+        _hint = 0;
+
+        // a grid point that misses t1 by rounding only is kept
+        if (_source.size() == 0 || t1 < t0) {
+            _size = 0;
+        } else {
+            _size = (size_t) std::floor((t1 - t0) / dt * (1 + 1e-12)) + 1;
+        }
+    }
+
+    size_t ResampledView::locate(double t) const {
+        size_t n = _source.size();
+
+        if (n < 2) {
+            return 0;
+        }
+
+        size_t j = _hint;
+
+        if (j + 1 < n && _source.getTime(j) <= t) {
+            if (t < _source.getTime(j + 1)) {
+                return j;
+            }
+
+            if (j + 2 < n && t < _source.getTime(j + 2)) {
+                return _hint = j + 1;
+            }
+        }
+
+        j = upperBound(t);
+        j = j > 0 ? j - 1 : 0;
+
+        return _hint = std::min(j, n - 2);
+    }
+
+    double ResampledView::getTime(std::size_t i) const {
+        return _t0 + i * _dt;
+    }
+
+    double ResampledView::getState(std::size_t i, size_t component) const {
+        double t = getTime(i);
+        size_t n = _source.size();
+
+        if (n == 1 || t <= _source.getTime(0)) {
+            return sourceState(0, component);
+        }
+
+        if (t >= _source.getTime(n - 1)) {
+            return sourceState(n - 1, component);
+        }
+
+        size_t j = locate(t);
+
+        return Interpolation::linear(_source.getTime(j), sourceState(j, component),
+                _source.getTime(j + 1), sourceState(j + 1, component), t);
+    }
+
+    size_t ResampledView::size() const {
+        return _size;
+    }
+
+    size_t ResampledView::getDimension() const {
+        return sourceDimension();
+    }
+
+}
@@ -407,6 +407,8 @@ namespace iNumerics {
     Vector<inDouble> operator|(Matrix<inDouble>& A, const Vector<inDouble>& b) {
         
         IN_DISPLAY("(" << A.ID() << ") and (" << b.ID() << ") iNumerics::operator| ( Matrix<inDouble>& A, const Vector<inDouble>& B )", 1);
+        IN_PERF_REGION(PERF_LU);
+        IN_TRACE_INSTANT("lu", (double) A.nRows());
 
         inInt n = A.nRows();
         inInt lda = A.memDimRows();
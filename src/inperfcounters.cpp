@@ -0,0 +1,246 @@
+/// \file   inperfcounters.cpp
+/// \brief Contains the definition of the hardware performance counter regions.
+
+#include "inperfcounters.h"
+
+#if defined(INUMERICS_PERF_COUNTERS) && defined(__linux__)
+#define IN_PERF_LINUX
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace iNumerics {
+
+    PerfCounts::PerfCounts() : calls(0), taskClock(0), cycles(0), instructions(0),
+    cacheMisses(0), branchMisses(0) {
+    }
+
+    PerfCounts& PerfCounts::operator+=(const PerfCounts& other) {
+        calls += other.calls;
+        taskClock += other.taskClock;
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cacheMisses += other.cacheMisses;
+        branchMisses += other.branchMisses;
+        return *this;
+    }
+
+    PerfCounts& PerfCounts::operator-=(const PerfCounts& other) {
+        calls -= other.calls;
+        taskClock -= other.taskClock;
+        cycles -= other.cycles;
+        instructions -= other.instructions;
+        cacheMisses -= other.cacheMisses;
+        branchMisses -= other.branchMisses;
+        return *this;
+    }
+
+    const char* PerfCounters::regionName(PerfRegion r) {
+        static const char* names[PERF_REGIONS] = {
+            "other", "rhs", "stepper", "observer", "lu", "allocator"
+        };
+
+        return r < PERF_REGIONS ? names[r] : "unknown";
+    }
+
+#ifdef IN_PERF_LINUX
+
+    enum {
+        EVENT_TASK_CLOCK, EVENT_CYCLES, EVENT_INSTRUCTIONS, EVENT_CACHE_MISSES,
+        EVENT_BRANCH_MISSES, EVENTS,
+        MAX_DEPTH = 64
+    };
+
+    /**
+     * Counter group and region stack of one thread. The software task clock
+     * leads the group so that the group opens even if no hardware counter is
+     * available; hardware counters join when the kernel allows it.
+     */
+    struct _ThreadCounters {
+
+        _ThreadCounters() : leader(-1), depth(0), overflow(0) {
+            for (int i = 0; i < EVENTS; i++) {
+                fds[i] = -1;
+                position[i] = -1;
+                last[i] = 0;
+            }
+
+            stack[0] = PERF_OTHER;
+
+            static const inULong types[EVENTS] = {
+                PERF_TYPE_SOFTWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+            };
+            static const inULong configs[EVENTS] = {
+                PERF_COUNT_SW_TASK_CLOCK, PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES
+            };
+
+            int opened = 0;
+
+            for (int i = 0; i < EVENTS; i++) {
+                struct perf_event_attr attr;
+                memset(&attr, 0, sizeof (attr));
+                attr.size = sizeof (attr);
+                attr.type = (unsigned) types[i];
+                attr.config = configs[i];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.disabled = leader == -1 ? 1 : 0;
+
+                int fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+
+                if (fd < 0) {
+                    if (i == EVENT_TASK_CLOCK) {
+                        return; // no group at all
+                    }
+                    continue;
+                }
+
+                if (leader == -1) {
+                    leader = fd;
+                }
+
+                fds[i] = fd;
+                position[i] = opened++;
+            }
+
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, 0);
+
+            read(last);
+        }
+
+        ~_ThreadCounters() {
+            for (int i = EVENTS - 1; i >= 0; i--) {
+                if (fds[i] >= 0) {
+                    close(fds[i]);
+                }
+            }
+        }
+
+        void read(inULong values[EVENTS]) {
+            inULong buffer[1 + EVENTS];
+
+            if (leader < 0 || ::read(leader, buffer, sizeof (buffer)) <= 0) {
+                return;
+            }
+
+            for (int i = 0; i < EVENTS; i++) {
+                if (position[i] >= 0 && (inULong) position[i] < buffer[0]) {
+                    values[i] = buffer[1 + position[i]];
+                }
+            }
+        }
+
+        // attribute everything since the last read to the current region
+        void account() {
+            inULong now[EVENTS];
+
+            for (int i = 0; i < EVENTS; i++) {
+                now[i] = last[i];
+            }
+
+            read(now);
+
+            PerfCounts& c = totals[stack[depth]];
+            c.taskClock += now[EVENT_TASK_CLOCK] - last[EVENT_TASK_CLOCK];
+            c.cycles += now[EVENT_CYCLES] - last[EVENT_CYCLES];
+            c.instructions += now[EVENT_INSTRUCTIONS] - last[EVENT_INSTRUCTIONS];
+            c.cacheMisses += now[EVENT_CACHE_MISSES] - last[EVENT_CACHE_MISSES];
+            c.branchMisses += now[EVENT_BRANCH_MISSES] - last[EVENT_BRANCH_MISSES];
+
+            for (int i = 0; i < EVENTS; i++) {
+                last[i] = now[i];
+            }
+        }
+
+        int leader;
+        int fds[EVENTS];
+        int position[EVENTS];
+        inULong last[EVENTS];
+
+        PerfRegion stack[MAX_DEPTH];
+        int depth;
+        // regions nested deeper than MAX_DEPTH, charged to stack[depth]
+        int overflow;
+
+        PerfCounts totals[PERF_REGIONS];
+    };
+
+    static _ThreadCounters& _local() {
+        static thread_local _ThreadCounters counters;
+        return counters;
+    }
+
+    bool PerfCounters::isEnabled() {
+        return true;
+    }
+
+    bool PerfCounters::hasHardwareCounters() {
+        return _local().fds[EVENT_CYCLES] >= 0;
+    }
+
+    void PerfCounters::begin(PerfRegion r) {
+        _ThreadCounters& c = _local();
+
+        c.account();
+        c.totals[r].calls++;
+
+        if (c.overflow == 0 && c.depth + 1 < MAX_DEPTH) {
+            c.stack[++c.depth] = r;
+        } else {
+            c.overflow++;
+        }
+    }
+
+    void PerfCounters::end(PerfRegion r) {
+        _ThreadCounters& c = _local();
+
+        c.account();
+
+        if (c.overflow > 0) {
+            c.overflow--;
+        } else if (c.depth > 0) {
+            c.depth--;
+        }
+    }
+
+    void PerfCounters::snapshot(PerfCounts counts[PERF_REGIONS]) {
+        _ThreadCounters& c = _local();
+
+        c.account();
+
+        for (int i = 0; i < PERF_REGIONS; i++) {
+            counts[i] = c.totals[i];
+        }
+    }
+
+#else
+
+    bool PerfCounters::isEnabled() {
+        return false;
+    }
+
+    bool PerfCounters::hasHardwareCounters() {
+        return false;
+    }
+
+    void PerfCounters::begin(PerfRegion r) {
+    }
+
+    void PerfCounters::end(PerfRegion r) {
+    }
+
+    void PerfCounters::snapshot(PerfCounts counts[PERF_REGIONS]) {
+        for (int i = 0; i < PERF_REGIONS; i++) {
+            counts[i] = PerfCounts();
+        }
+    }
+
+#endif
+}
@@ -0,0 +1,321 @@
+/// \file   inprofiler.cpp
+/// \brief Contains the definition of the latency histogram and the profiler.
+
+#include <iomanip>
+#include <cstring>
+
+#include "inprofiler.h"
+
+#define IN_RELAXED_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define IN_RELAXED_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+namespace iNumerics {
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::LatencyHistogram                                   *
+     *                                                                            *
+     ******************************************************************************/
+
+    LatencyHistogram::LatencyHistogram() {
+        reset();
+    }
+
+    void LatencyHistogram::reset() {
+        for (size_t i = 0; i < BUCKETS; i++) {
+            IN_RELAXED_STORE(_counts[i], 0);
+        }
+    }
+
+    size_t LatencyHistogram::bucket(inULong ns) {
+        if (ns < SUB_BUCKETS) {
+            return (size_t) ns;
+        }
+
+        // position of the highest set bit, >= 4
+        size_t e = 63 - __builtin_clzll(ns);
+
+        if (e >= MAX_EXPONENT) {
+            return BUCKETS - 1;
+        }
+
+        size_t sub = (size_t) ((ns >> (e - 4)) & (SUB_BUCKETS - 1));
+
+        return SUB_BUCKETS + (e - 4) * SUB_BUCKETS + sub;
+    }
+
+    inULong LatencyHistogram::lowerBound(size_t b) {
+        if (b < SUB_BUCKETS) {
+            return b;
+        }
+
+        size_t e = (b - SUB_BUCKETS) / SUB_BUCKETS + 4;
+        size_t sub = (b - SUB_BUCKETS) % SUB_BUCKETS;
+
+        return ((inULong) 1 << e) + ((inULong) sub << (e - 4));
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; i++) {
+            _counts[i] += IN_RELAXED_LOAD(other._counts[i]);
+        }
+    }
+
+    inULong LatencyHistogram::count() const {
+        inULong result = 0;
+
+        for (size_t i = 0; i < BUCKETS; i++) {
+            result += IN_RELAXED_LOAD(_counts[i]);
+        }
+
+        return result;
+    }
+
+    double LatencyHistogram::percentile(double q) const {
+        inULong n = count();
+
+        if (n == 0) {
+            return 0;
+        }
+
+        if (q < 0) q = 0;
+        if (q > 1) q = 1;
+
+        // rank of the requested sample (1-based)
+        inULong rank = (inULong) (q * (n - 1)) + 1;
+        inULong seen = 0;
+
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += IN_RELAXED_LOAD(_counts[i]);
+
+            if (seen >= rank) {
+                if (i < SUB_BUCKETS) {
+                    return (double) i;
+                }
+
+                // report the middle of the bucket
+                double lo = (double) lowerBound(i);
+                double hi = (double) lowerBound(i + 1);
+
+                return 0.5 * (lo + hi);
+            }
+        }
+
+        return (double) lowerBound(BUCKETS - 1);
+    }
+
+    /******************************************************************************
+     *                                                                            *
+     *       Class: iNumerics::Profiler                                           *
+     *                                                                            *
+     ******************************************************************************/
+
+    // The block of the calling thread. Blocks are owned by the profiler and
+    // outlive their thread so that report() still sees finished workers.
+    static thread_local void* _localBlock = NULL;
+
+    Profiler::Accumulator::Accumulator() : count(0), total(0), min((inULong) - 1), max(0) {
+    }
+
+    void Profiler::Accumulator::record(inULong ns) {
+        // only the owning thread writes, readers use relaxed loads
+        IN_RELAXED_STORE(count, IN_RELAXED_LOAD(count) + 1);
+        IN_RELAXED_STORE(total, IN_RELAXED_LOAD(total) + ns);
+
+        if (ns < IN_RELAXED_LOAD(min)) {
+            IN_RELAXED_STORE(min, ns);
+        }
+
+        if (ns > IN_RELAXED_LOAD(max)) {
+            IN_RELAXED_STORE(max, ns);
+        }
+
+        histogram.record(ns);
+    }
+
+    void Profiler::Accumulator::merge(const Accumulator& other) {
+        count += IN_RELAXED_LOAD(other.count);
+        total += IN_RELAXED_LOAD(other.total);
+
+        inULong otherMin = IN_RELAXED_LOAD(other.min);
+        inULong otherMax = IN_RELAXED_LOAD(other.max);
+
+        if (otherMin < min) min = otherMin;
+        if (otherMax > max) max = otherMax;
+
+        histogram.merge(other.histogram);
+    }
+
+    Profiler::ThreadBlock::ThreadBlock(size_t index) : index(index) {
+        for (size_t i = 0; i < MAX_REGIONS; i++) {
+            regions[i].store(NULL, std::memory_order_relaxed);
+        }
+    }
+
+    Profiler::ThreadBlock::~ThreadBlock() {
+        for (size_t i = 0; i < MAX_REGIONS; i++) {
+            delete regions[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    Profiler::Profiler() {
+    }
+
+    Profiler::~Profiler() {
+        for (size_t i = 0; i < _blocks.size(); i++) {
+            delete _blocks[i];
+        }
+    }
+
+    Profiler& Profiler::instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    inULong Profiler::region(const std::string& name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (size_t i = 0; i < _names.size(); i++) {
+            if (_names[i] == name) {
+                return i;
+            }
+        }
+
+        if (_names.size() == MAX_REGIONS) {
+            std::cerr << "Profiler::region(): too many regions, \"" << name
+                    << "\" is recorded as \"" << _names.back() << "\"" << std::endl;
+            return MAX_REGIONS - 1;
+        }
+
+        _names.push_back(name);
+
+        return _names.size() - 1;
+    }
+
+    Profiler::ThreadBlock& Profiler::localBlock() {
+        if (_localBlock == NULL) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ThreadBlock* block = new ThreadBlock(_blocks.size());
+            _blocks.push_back(block);
+            _localBlock = block;
+        }
+
+        return *static_cast<ThreadBlock*> (_localBlock);
+    }
+
+    void Profiler::record(inULong id, inULong ns) {
+        ThreadBlock& block = localBlock();
+
+        Accumulator* acc = block.regions[id].load(std::memory_order_relaxed);
+
+        if (acc == NULL) {
+            acc = new Accumulator();
+            block.regions[id].store(acc, std::memory_order_release);
+        }
+
+        acc->record(ns);
+    }
+
+    void Profiler::fill(TimerStats& s, const Accumulator& a) {
+        s.count = a.count;
+        s.total = a.total * 1.e-9;
+        s.mean = a.count > 0 ? s.total / a.count : 0;
+        s.min = a.count > 0 ? a.min * 1.e-9 : 0;
+        s.max = a.max * 1.e-9;
+        s.p50 = a.histogram.percentile(0.5) * 1.e-9;
+        s.p99 = a.histogram.percentile(0.99) * 1.e-9;
+    }
+
+    std::vector<TimerStats> Profiler::report(bool perThread) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::vector<TimerStats> result;
+
+        for (size_t r = 0; r < _names.size(); r++) {
+            Accumulator sum;
+
+            for (size_t b = 0; b < _blocks.size(); b++) {
+                const Accumulator* acc = _blocks[b]->regions[r].load(std::memory_order_acquire);
+
+                if (acc == NULL) {
+                    continue;
+                }
+
+                if (perThread) {
+                    Accumulator single;
+                    single.merge(*acc);
+
+                    TimerStats s;
+                    s.name = _names[r];
+                    s.thread = (long) _blocks[b]->index;
+                    fill(s, single);
+                    result.push_back(s);
+                } else {
+                    sum.merge(*acc);
+                }
+            }
+
+            if (!perThread && sum.count > 0) {
+                TimerStats s;
+                s.name = _names[r];
+                s.thread = -1;
+                fill(s, sum);
+                result.push_back(s);
+            }
+        }
+
+        return result;
+    }
+
+    void Profiler::print(std::ostream& os, bool perThread) const {
+        std::vector<TimerStats> stats = report(perThread);
+
+        os << std::left << std::setw(24) << "region"
+                << std::right << std::setw(8) << "thread"
+                << std::setw(12) << "count"
+                << std::setw(14) << "total[s]"
+                << std::setw(14) << "mean[us]"
+                << std::setw(14) << "p50[us]"
+                << std::setw(14) << "p99[us]"
+                << std::setw(14) << "max[us]" << std::endl;
+
+        for (size_t i = 0; i < stats.size(); i++) {
+            const TimerStats& s = stats[i];
+
+            os << std::left << std::setw(24) << s.name << std::right << std::setw(8);
+
+            if (s.thread < 0) {
+                os << "*";
+            } else {
+                os << s.thread;
+            }
+
+            os << std::setw(12) << s.count
+                    << std::setw(14) << s.total
+                    << std::setw(14) << s.mean * 1.e6
+                    << std::setw(14) << s.p50 * 1.e6
+                    << std::setw(14) << s.p99 * 1.e6
+                    << std::setw(14) << s.max * 1.e6 << std::endl;
+        }
+    }
+
+    void Profiler::reset() {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Accumulators are cleared in place; they stay owned by their thread.
+        // Call reset() while no timed code is running to get a clean cut.
+        for (size_t b = 0; b < _blocks.size(); b++) {
+            for (size_t r = 0; r < MAX_REGIONS; r++) {
+                Accumulator* acc = _blocks[b]->regions[r].load(std::memory_order_acquire);
+
+                if (acc != NULL) {
+                    IN_RELAXED_STORE(acc->count, 0);
+                    IN_RELAXED_STORE(acc->total, 0);
+                    IN_RELAXED_STORE(acc->min, (inULong) - 1);
+                    IN_RELAXED_STORE(acc->max, 0);
+                    acc->histogram.reset();
+                }
+            }
+        }
+    }
+}
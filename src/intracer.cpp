@@ -0,0 +1,168 @@
+/// \file   intracer.cpp
+/// \brief Contains the definition of the event tracer.
+
+#include <vector>
+#include <mutex>
+
+#include "intracer.h"
+#include "inprofiler.h"
+
+#define IN_RELAXED_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define IN_RELAXED_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+namespace iNumerics {
+
+    std::atomic<bool> Tracer::_enabled(false);
+
+    namespace {
+
+        struct Event {
+            inULong ts;
+            const char* name;
+            double arg;
+            char phase;
+        };
+
+        /**
+         * Single-producer ring buffer. The owning thread writes a slot and
+         * then publishes it by advancing head; readers copy a range and
+         * re-check head to detect slots overwritten during the copy.
+         */
+        struct Ring {
+
+            Ring(size_t capacity, size_t tid) : events(capacity), head(0), tid(tid) {
+            }
+
+            void push(const char* name, char phase, double arg, inULong ts) {
+                size_t h = head.load(std::memory_order_relaxed);
+                Event& e = events[h % events.size()];
+
+                IN_RELAXED_STORE(e.ts, ts);
+                IN_RELAXED_STORE(e.name, name);
+                IN_RELAXED_STORE(e.phase, phase);
+                __atomic_store(&e.arg, &arg, __ATOMIC_RELAXED);
+
+                head.store(h + 1, std::memory_order_release);
+            }
+
+            std::vector<Event> events;
+            std::atomic<size_t> head;
+            size_t tid;
+        };
+
+        std::mutex _mutex;
+        std::vector<Ring*> _rings;
+        size_t _capacity = 1 << 16;
+        inULong _origin = 0;
+
+        thread_local Ring* _localRing = NULL;
+
+        Ring& localRing() {
+            if (_localRing == NULL) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _localRing = new Ring(_capacity, _rings.size());
+                _rings.push_back(_localRing);
+            }
+
+            return *_localRing;
+        }
+
+        void writeEvent(std::ostream& os, const Event& e, size_t tid, bool& first) {
+            os << (first ? "\n" : ",\n");
+            first = false;
+
+            double us = (e.ts - _origin) * 1.e-3;
+
+            os << "{\"name\": \"" << e.name << "\", \"ph\": \"" << e.phase
+                    << "\", \"ts\": " << us << ", \"pid\": 1, \"tid\": " << tid;
+
+            if (e.phase == 'i') {
+                os << ", \"s\": \"t\"";
+            }
+
+            if (e.phase != 'E') {
+                os << ", \"args\": {\"value\": " << e.arg << "}";
+            }
+
+            os << "}";
+        }
+    }
+
+    void Tracer::start(size_t capacity) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _capacity = capacity > 0 ? capacity : 1;
+
+            if (_origin == 0) {
+                _origin = MonotonicClock::now();
+            }
+        }
+
+        _enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void Tracer::stop() {
+        _enabled.store(false, std::memory_order_relaxed);
+    }
+
+    void Tracer::record(const char* name, char phase, double arg) {
+        localRing().push(name, phase, arg, MonotonicClock::now());
+    }
+
+    void Tracer::writeChromeTrace(std::ostream& os) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        std::streamsize precision = os.precision(15);
+
+        os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+        bool first = true;
+
+        for (size_t r = 0; r < _rings.size(); r++) {
+            Ring& ring = *_rings[r];
+            size_t cap = ring.events.size();
+
+            size_t end = ring.head.load(std::memory_order_acquire);
+            size_t begin = end > cap ? end - cap : 0;
+
+            std::vector<Event> copy;
+            copy.reserve(end - begin);
+
+            for (size_t i = begin; i < end; i++) {
+                const Event& src = ring.events[i % cap];
+                Event e;
+                e.ts = IN_RELAXED_LOAD(src.ts);
+                e.name = IN_RELAXED_LOAD(src.name);
+                e.phase = IN_RELAXED_LOAD(src.phase);
+                __atomic_load(&src.arg, &e.arg, __ATOMIC_RELAXED);
+                copy.push_back(e);
+            }
+
+            // order the relaxed copies before re-reading head; everything
+            // up to newEnd - cap may have been overwritten meanwhile, the slot
+            // of newEnd itself possibly by a write that is not published yet
+            std::atomic_thread_fence(std::memory_order_acquire);
+            size_t newEnd = ring.head.load(std::memory_order_relaxed);
+            size_t valid = newEnd + 1 > cap ? newEnd + 1 - cap : 0;
+
+            for (size_t i = begin; i < end; i++) {
+                if (i >= valid) {
+                    writeEvent(os, copy[i - begin], ring.tid, first);
+                }
+            }
+        }
+
+        os << "\n]}\n";
+
+        os.precision(precision);
+    }
+
+    void Tracer::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (size_t r = 0; r < _rings.size(); r++) {
+            _rings[r]->head.store(0, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/// \file   inxorcodec.cpp
+/// \brief Contains the definition of the lossless predictive floating point codec.
+
+#include <cstring>
+#include <stdint.h>
+
+#include "inxorcodec.h"
+
+namespace iNumerics {
+
+    // decode() loads residuals with one unaligned 8 byte read
+    static const size_t _SLACK = 8;
+
+    static inline uint64_t _bits(double v) {
+        uint64_t b;
+        memcpy(&b, &v, 8);
+        return b;
+    }
+
+    static inline double _value(uint64_t b) {
+        double v;
+        memcpy(&v, &b, 8);
+        return v;
+    }
+
+    static inline unsigned _zeroBytes(uint64_t x) {
+        return x == 0 ? 8 : (unsigned) __builtin_clzll(x) / 8;
+    }
+
+    /**
+     * Selects the predictor for value v.
+     * @return nibble (predictor << 3 | code), residual in x, its length in bytes
+     */
+    static inline unsigned _residual(uint64_t v, uint64_t last, uint64_t linear,
+            uint64_t& x, unsigned& bytes) {
+        uint64_t x0 = v ^ last;
+        uint64_t x1 = v ^ linear;
+
+        unsigned z0 = _zeroBytes(x0);
+        unsigned z1 = _zeroBytes(x1);
+
+        unsigned selector = z1 > z0 ? 1 : 0;
+        unsigned zeros = selector ? z1 : z0;
+
+        x = selector ? x1 : x0;
+
+        // 3 bits for 0..8 zero bytes: 4 is coded as 3
+        if (zeros == 4) {
+            zeros = 3;
+        }
+
+        bytes = 8 - zeros;
+
+        return (selector << 3) | (zeros < 4 ? zeros : zeros - 1);
+    }
+
+    static inline double _linear(double last, double beforeLast) {
+        return 2.0 * last - beforeLast;
+    }
+
+    size_t XorCodec::encode(const double* values, size_t n, std::vector<unsigned char>& out) {
+        size_t start = out.size();
+
+        double last = 0;
+        double beforeLast = 0;
+
+        for (size_t i = 0; i < n; i += 2) {
+            uint64_t x[2] = {0, 0};
+            unsigned bytes[2] = {0, 0};
+            unsigned header = 0;
+
+            for (size_t k = 0; k < 2; k++) {
+                unsigned nibble = 7; // padding: 8 zero bytes, no residual
+
+                if (i + k < n) {
+                    double v = values[i + k];
+                    nibble = _residual(_bits(v), _bits(last), _bits(_linear(last, beforeLast)),
+                            x[k], bytes[k]);
+                    beforeLast = last;
+                    last = v;
+                }
+
+                header |= nibble << (4 * k);
+            }
+
+            out.push_back((unsigned char) header);
+
+            for (size_t k = 0; k < 2; k++) {
+                for (unsigned b = 0; b < bytes[k]; b++) {
+                    out.push_back((unsigned char) (x[k] >> (8 * b)));
+                }
+            }
+        }
+
+        out.insert(out.end(), _SLACK, 0);
+
+        return out.size() - start;
+    }
+
+    const unsigned char* XorCodec::decode(const unsigned char* in, size_t n, double* values) {
+        // residual length per 3 bit code
+        static const unsigned lengths[8] = {8, 7, 6, 5, 3, 2, 1, 0};
+
+        double last = 0;
+        double beforeLast = 0;
+
+        for (size_t i = 0; i < n; i += 2) {
+            unsigned header = *in++;
+
+            for (size_t k = 0; k < 2 && i + k < n; k++) {
+                unsigned nibble = (header >> (4 * k)) & 0xf;
+                unsigned bytes = lengths[nibble & 7];
+
+                uint64_t x;
+                memcpy(&x, in, 8);
+                x = bytes == 8 ? x : x & ((((uint64_t) 1) << (8 * bytes)) - 1);
+                in += bytes;
+
+                uint64_t prediction = (nibble & 8) ? _bits(_linear(last, beforeLast)) : _bits(last);
+
+                double v = _value(x ^ prediction);
+                values[i + k] = v;
+
+                beforeLast = last;
+                last = v;
+            }
+        }
+
+        return in + _SLACK;
+    }
+}
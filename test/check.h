@@ -0,0 +1,91 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+#ifndef CHECK_H
+#define	CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+/*
+ * Minimal assertions for the test programs: a failed check is printed with
+ * its location and counted, CHECK_RESULT() is the exit code of main().
+ */
+
+namespace iNumericsTest {
+
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char* file, int line, const char* what) {
+        std::printf("%s:%d: check failed: %s\n", file, line, what);
+        failures()++;
+    }
+
+    inline void failClose(const char* file, int line, const char* what,
+            double a, double b, double tolerance) {
+        std::printf("%s:%d: check failed: %s (%.17g vs %.17g, tolerance %g)\n",
+                file, line, what, a, b, tolerance);
+        failures()++;
+    }
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            iNumericsTest::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+/** |a - b| <= tolerance, fails for NaN */
+#define CHECK_CLOSE(a, b, tolerance) \
+    do { \
+        double _a = (a), _b = (b), _tolerance = (tolerance); \
+        if (!(std::fabs(_a - _b) <= _tolerance)) { \
+            iNumericsTest::failClose(__FILE__, __LINE__, #a " == " #b, _a, _b, _tolerance); \
+        } \
+    } while (0)
+
+#define CHECK_THROWS(statement, exception) \
+    do { \
+        bool _thrown = false; \
+        try { \
+            statement; \
+        } catch (const exception&) { \
+            _thrown = true; \
+        } \
+        if (!_thrown) { \
+            iNumericsTest::fail(__FILE__, __LINE__, #statement " throws " #exception); \
+        } \
+    } while (0)
+
+#define CHECK_RESULT() (iNumericsTest::failures() == 0 ? 0 : 1)
+
+#endif	/* CHECK_H */
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Adjoint gradients against central finite differences of the objective.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * SIR model s' = -b s i, i' = b s i - g i with the parameters (b, g).
+     * With derivatives, the Jacobians are analytic; without, the solver
+     * differences the rhs.
+     */
+    class Sir : public Model {
+    public:
+
+        Sir(bool derivatives) : _derivatives(derivatives) {
+            _p[0] = 2;
+            _p[1] = 1;
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = -_p[0] * y[0] * y[1];
+            dydt[1] = _p[0] * y[0] * y[1] - _p[1] * y[1];
+        }
+
+        bool jacobian(const DVec& y, DVec& J, const double t) {
+            if (!_derivatives) {
+                return false;
+            }
+
+            J[0] = -_p[0] * y[1];
+            J[1] = _p[0] * y[1];
+            J[2] = -_p[0] * y[0];
+            J[3] = _p[0] * y[0] - _p[1];
+            return true;
+        }
+
+        size_t getParameterCount() const {
+            return 2;
+        }
+
+        double getParameter(size_t k) const {
+            return _p[k];
+        }
+
+        void setParameter(size_t k, double value) {
+            _p[k] = value;
+        }
+
+        bool parameterJacobian(const DVec& y, DVec& dfdp, const double t) {
+            if (!_derivatives) {
+                return false;
+            }
+
+            dfdp[0] = -y[0] * y[1];
+            dfdp[1] = y[0] * y[1];
+            dfdp[2] = 0;
+            dfdp[3] = -y[1];
+            return true;
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+    private:
+        bool _derivatives;
+        double _p[2];
+    };
+
+    /**
+     * G = s(tn) + i(tn)^2
+     */
+    class Final : public Objective {
+    public:
+
+        double evaluate(const DVec& y, double t, DVec& dgdy) {
+            dgdy[0] = 1;
+            dgdy[1] = 2 * y[1];
+            return y[0] + y[1] * y[1];
+        }
+    };
+
+    const double tolerance = 1.e-12;
+
+    DVec initialValue() {
+        DVec y0(2);
+        y0[0] = 0.9;
+        y0[1] = 0.1;
+        return y0;
+    }
+
+    DVec finalState(Model& model, const DVec& y0) {
+        Problem problem(model);
+        problem.setInitialValue(y0)
+                .setTimeRange(0, 5)
+                .setPrecision(tolerance, tolerance);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        solver.solve(problem, trajectory);
+
+        return trajectory.getState(trajectory.size() - 1);
+    }
+
+    double objective(Model& model, const DVec& y0) {
+        DVec y = finalState(model, y0);
+        DVec dgdy(2);
+        return Final().evaluate(y, 5, dgdy);
+    }
+
+    void testAdjoint(bool derivatives) {
+        Sir model(derivatives);
+        DVec y0 = initialValue();
+
+        Problem problem(model);
+        problem.setInitialValue(y0)
+                .setTimeRange(0, 5)
+                .setPrecision(1.e-10, 1.e-10)
+                .setAdjointSnapshots(4);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        Final final;
+        AdjointResult result;
+        solver.solve_adjoint(problem, trajectory, final, result);
+
+        CHECK_CLOSE(result.value, objective(model, y0), 1.e-8);
+        CHECK(result.gradient.size() == 2);
+        CHECK(result.initialGradient.size() == 2);
+        CHECK(result.snapshots <= 4);
+
+        // with fewer snapshots than steps, steps are recomputed
+        CHECK(result.recomputedSteps > 0);
+
+        for (size_t k = 0; k < 2; k++) {
+            double p = model.getParameter(k);
+            double h = 1.e-5 * p;
+
+            model.setParameter(k, p + h);
+            double plus = objective(model, y0);
+            model.setParameter(k, p - h);
+            double minus = objective(model, y0);
+            model.setParameter(k, p);
+
+            CHECK_CLOSE(result.gradient[k], (plus - minus) / (2 * h), 1.e-6);
+        }
+
+        for (size_t i = 0; i < 2; i++) {
+            const double h = 1.e-6;
+            DVec plus = y0;
+            DVec minus = y0;
+            plus[i] += h;
+            minus[i] -= h;
+
+            CHECK_CLOSE(result.initialGradient[i],
+                    (objective(model, plus) - objective(model, minus)) / (2 * h), 1.e-6);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    testAdjoint(true);
+    testAdjoint(false);
+
+    return CHECK_RESULT();
+}
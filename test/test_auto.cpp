@@ -0,0 +1,147 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * solve_auto() against closed-form solutions of non-stiff and stiff
+ * problems, and its choice of method.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * y_i' = -k_i y_i, y_i(0) = 1.
+     */
+    class Decay : public Model {
+    public:
+
+        Decay(const DVec& rates) : _rates(rates) {
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = -_rates[i] * y[i];
+            }
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+    private:
+        DVec _rates;
+    };
+
+    /**
+     * Largest error at tn = 2 for the given tolerance.
+     */
+    double decayError(const DVec& rates, double tolerance, SolveStats& stats) {
+        Decay model(rates);
+        Problem problem(model);
+        problem.setInitialValue(DVec(rates.size(), 1.0))
+                .setTimeRange(0, 2)
+                .setPrecision(tolerance, tolerance, 1.e-4);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        stats = solver.solve_auto(problem, trajectory);
+
+        CHECK(trajectory.size() > 1);
+        CHECK(trajectory.getTime(0) == 0);
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), 2, 1.e-12);
+
+        for (size_t i = 1; i < trajectory.size(); i++) {
+            CHECK(trajectory.getTime(i) > trajectory.getTime(i - 1));
+        }
+
+        const DVec& y = trajectory.getState(trajectory.size() - 1);
+        double error = 0;
+
+        for (size_t i = 0; i < y.size(); i++) {
+            error = std::max(error, std::fabs(y[i] - std::exp(-2 * rates[i])));
+        }
+
+        return error;
+    }
+
+    void testConvergence() {
+        DVec rates(2);
+        rates[0] = 1;
+        rates[1] = 1000;
+
+        SolveStats loose;
+        SolveStats tight;
+        double looseError = decayError(rates, 1.e-5, loose);
+        double tightError = decayError(rates, 1.e-8, tight);
+
+        std::printf("error %.3g at 1e-5 (%lu steps), %.3g at 1e-8 (%lu steps)\n",
+                looseError, (unsigned long) loose.acceptedSteps,
+                tightError, (unsigned long) tight.acceptedSteps);
+
+        CHECK(looseError < 1.e-3);
+        CHECK(tightError < 1.e-5);
+        CHECK(tightError < 0.1 * looseError);
+        CHECK(tight.acceptedSteps > loose.acceptedSteps);
+    }
+
+    void testSwitching() {
+        // non-stiff: Dormand-Prince throughout, no Jacobian
+        DVec nonStiff(1, 1.0);
+        SolveStats stats;
+
+        CHECK(decayError(nonStiff, 1.e-8, stats) < 1.e-6);
+        CHECK(stats.stiffSteps == 0);
+        CHECK(stats.methodSwitches == 0);
+        CHECK(stats.jacobianCalls == 0);
+
+        // stiff: switches to the Rosenbrock method
+        DVec stiff(2);
+        stiff[0] = 1;
+        stiff[1] = 1.e5;
+
+        CHECK(decayError(stiff, 1.e-8, stats) < 1.e-6);
+        CHECK(stats.stiffSteps > 0);
+        CHECK(stats.methodSwitches > 0);
+        CHECK(stats.stiffSteps <= stats.acceptedSteps + stats.rejectedSteps);
+    }
+}
+
+int main(int argc, char** argv) {
+    testConvergence();
+    testSwitching();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * solve_bdf() on stiff problems: accuracy and reuse of the Jacobian and
+ * the LU factors.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * y_i' = -k_i y_i, y_i(0) = 1.
+     */
+    class Decay : public Model {
+    public:
+
+        Decay(const DVec& rates) : _rates(rates) {
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = -_rates[i] * y[i];
+            }
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+    private:
+        DVec _rates;
+    };
+
+    /**
+     * Robertson's chemical kinetics, the classic stiff test problem.
+     */
+    class Robertson : public Model {
+    public:
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = -0.04 * y[0] + 1.e4 * y[1] * y[2];
+            dydt[1] = 0.04 * y[0] - 1.e4 * y[1] * y[2] - 3.e7 * y[1] * y[1];
+            dydt[2] = 3.e7 * y[1] * y[1];
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    double decayError(double tolerance, SolveStats& stats) {
+        DVec k(2);
+        k[0] = 1;
+        k[1] = 1000;
+
+        Decay model(k);
+        Problem problem(model);
+        problem.setInitialValue(DVec(2, 1.0))
+                .setTimeRange(0, 2)
+                .setPrecision(tolerance, tolerance, 1.e-4);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        stats = solver.solve_bdf(problem, trajectory);
+
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), 2, 1.e-12);
+
+        const DVec& y = trajectory.getState(trajectory.size() - 1);
+
+        return std::max(std::fabs(y[0] - std::exp(-2.)), std::fabs(y[1] - std::exp(-2000.)));
+    }
+
+    void testConvergence() {
+        SolveStats loose;
+        SolveStats tight;
+        double looseError = decayError(1.e-5, loose);
+        double tightError = decayError(1.e-8, tight);
+
+        std::printf("error %.3g at 1e-5 (%lu steps), %.3g at 1e-8 (%lu steps)\n",
+                looseError, (unsigned long) loose.acceptedSteps,
+                tightError, (unsigned long) tight.acceptedSteps);
+
+        CHECK(looseError < 1.e-3);
+        CHECK(tightError < 1.e-5);
+        CHECK(tightError < 0.1 * looseError);
+        CHECK(tight.acceptedSteps > loose.acceptedSteps);
+    }
+
+    void testRobertson() {
+        Robertson model;
+        Problem problem(model);
+
+        DVec y0(3, 0.0);
+        y0[0] = 1;
+
+        problem.setInitialValue(y0)
+                .setTimeRange(0, 40)
+                .setPrecision(1.e-10, 1.e-6);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        SolveStats stats = solver.solve_bdf(problem, trajectory);
+
+        std::printf("robertson: %lu steps, %lu Jacobians, %lu LU\n",
+                (unsigned long) stats.acceptedSteps, (unsigned long) stats.jacobianCalls,
+                (unsigned long) stats.luDecompositions);
+
+        // reference values at t = 40 (Hairer & Wanner)
+        const DVec& y = trajectory.getState(trajectory.size() - 1);
+        CHECK_CLOSE(y[0], 0.7158270687193, 1.e-5);
+        CHECK_CLOSE(y[1], 9.185534764e-6, 1.e-10);
+        CHECK_CLOSE(y[2], 0.2841637457, 1.e-5);
+        CHECK_CLOSE(y[0] + y[1] + y[2], 1, 1.e-8);
+
+        // the iteration matrix is reused over many steps
+        CHECK(stats.luDecompositions < stats.acceptedSteps / 2);
+        CHECK(stats.jacobianCalls <= stats.luDecompositions);
+    }
+}
+
+int main(int argc, char** argv) {
+    testConvergence();
+    testRobertson();
+
+    return CHECK_RESULT();
+}
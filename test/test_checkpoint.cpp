@@ -0,0 +1,324 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Resuming from a checkpoint reproduces the uninterrupted solve bit for bit;
+ * damaged checkpoint files are rejected.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    const double crashTime = 7.3;
+
+    /**
+     * Van der Pol oscillator; step() optionally throws after crashTime to
+     * simulate a solve that dies mid-way.
+     */
+    class VanDerPol : public Model {
+    public:
+
+        VanDerPol(bool crash) : _crash(crash) {
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = y[1];
+            dydt[1] = 2.0 * (1 - y[0] * y[0]) * y[1] - y[0];
+        }
+
+        void step(const DVec& x, double t) {
+            if (_crash && t > crashTime) {
+                throw std::runtime_error("crash");
+            }
+        }
+
+    private:
+        bool _crash;
+    };
+
+    /**
+     * y' = -y(t - 1)
+     */
+    class Lag : public DelayModel {
+    public:
+
+        size_t getDelayCount() const {
+            return 1;
+        }
+
+        double getDelay(size_t k, const DVec& y, const double t) {
+            return 1;
+        }
+
+        double getMaxDelay() const {
+            return 1;
+        }
+
+        void rhs(const DVec& y, const DVec& delayed, DVec& dydt, const double t) {
+            dydt[0] = -delayed[0];
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    /**
+     * G = y_1(tn)
+     */
+    class First : public Objective {
+    public:
+
+        double evaluate(const DVec& y, double t, DVec& dgdy) {
+            dgdy[0] = 1;
+            dgdy[1] = 0;
+            return y[0];
+        }
+    };
+
+    void setup(Problem& problem) {
+        DVec init(2);
+        init[0] = 2;
+        init[1] = 0;
+
+        problem.setInitialValue(init)
+                .setTimeRange(0, 20)
+                .setPrecision(1.e-8, 1.e-8);
+    }
+
+    std::string scratchDir() {
+        char dir[] = "/tmp/test_checkpointXXXXXX";
+
+        if (mkdtemp(dir) == NULL) {
+            std::perror("mkdtemp");
+            std::exit(1);
+        }
+
+        return dir;
+    }
+
+    std::vector<char> load(const std::string& path) {
+        std::vector<char> data;
+        FILE* file = std::fopen(path.c_str(), "rb");
+
+        if (file == NULL) {
+            return data;
+        }
+
+        char buffer[4096];
+        size_t n;
+
+        while ((n = std::fread(buffer, 1, sizeof (buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + n);
+        }
+
+        std::fclose(file);
+
+        return data;
+    }
+
+    void save(const std::string& path, const std::vector<char>& data, size_t size) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite(data.empty() ? NULL : &data[0], 1, size, file);
+        std::fclose(file);
+    }
+
+    void testResumeIsExact(const std::string& dir) {
+        std::string path = dir + "/resume.ckpt";
+
+        VanDerPol model(false);
+        Problem problem(model);
+        setup(problem);
+        Trajectory full;
+        SolveStats fullStats = ODESolver().solve(problem, full);
+
+        // a checkpoint after every step, the last one before the crash stays
+        VanDerPol crashing(true);
+        Problem interrupted(crashing);
+        setup(interrupted);
+        interrupted.setCheckpointing(path, 0);
+        Trajectory partial;
+        CHECK_THROWS(ODESolver().solve(interrupted, partial), std::runtime_error);
+
+        Checkpoint checkpoint = Checkpoint::read(path);
+        CHECK(checkpoint.t > 0 && checkpoint.t <= crashTime);
+        CHECK(checkpoint.trajectorySize > 1 && checkpoint.trajectorySize < full.size());
+        CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+
+        size_t k = checkpoint.trajectorySize - 1;
+        CHECK(checkpoint.t == full.getTime(k));
+        CHECK(checkpoint.x[0] == full.getState(k)[0]);
+        CHECK(checkpoint.x[1] == full.getState(k)[1]);
+
+        Trajectory resumed;
+
+        for (size_t i = 0; i < checkpoint.trajectorySize; i++) {
+            resumed(full.getState(i), full.getTime(i));
+        }
+
+        SolveStats stats = ODESolver().resume(problem, resumed, checkpoint);
+
+        CHECK(resumed.size() == full.size());
+        CHECK(stats.acceptedSteps == fullStats.acceptedSteps);
+        CHECK(stats.rejectedSteps == fullStats.rejectedSteps);
+        CHECK(stats.rhsCalls == fullStats.rhsCalls);
+
+        for (size_t i = 0; i < full.size() && i < resumed.size(); i++) {
+            CHECK(resumed.getTime(i) == full.getTime(i));
+            CHECK(resumed.getState(i)[0] == full.getState(i)[0]);
+            CHECK(resumed.getState(i)[1] == full.getState(i)[1]);
+        }
+
+        std::remove(path.c_str());
+    }
+
+    void testRoundTrip(const std::string& dir) {
+        std::string path = dir + "/roundtrip.ckpt";
+
+        Checkpoint c;
+        c.t = 1.0 / 3;
+        c.dt = 1.e-300;
+        c.x.resize(3);
+        c.x[0] = -0.0;
+        c.x[1] = 4.9e-324;
+        c.x[2] = 1.e308;
+        c.trajectorySize = 12345;
+        c.stats.acceptedSteps = 10;
+        c.stats.rejectedSteps = 2;
+        c.stats.rhsCalls = 71;
+        c.write(path);
+
+        Checkpoint r = Checkpoint::read(path);
+        CHECK(r.t == c.t && r.dt == c.dt);
+        CHECK(r.x.size() == 3);
+        CHECK(r.x[1] == c.x[1] && r.x[2] == c.x[2]);
+        CHECK(std::signbit(r.x[0]));
+        CHECK(r.trajectorySize == c.trajectorySize);
+        CHECK(r.stats.acceptedSteps == 10 && r.stats.rejectedSteps == 2 && r.stats.rhsCalls == 71);
+
+        std::remove(path.c_str());
+    }
+
+    void testDamagedFiles(const std::string& dir) {
+        std::string path = dir + "/damaged.ckpt";
+
+        CHECK_THROWS(Checkpoint::read(dir + "/missing.ckpt"), std::runtime_error);
+
+        Checkpoint c;
+        c.t = 2.5;
+        c.dt = 0.125;
+        c.x.assign(4, 1.5);
+        c.write(path);
+
+        std::vector<char> data = load(path);
+        CHECK(data.size() > 16);
+
+        // every truncation, including an empty file, is rejected
+        for (size_t size = 0; size < data.size(); size++) {
+            save(path, data, size);
+            CHECK_THROWS(Checkpoint::read(path), std::runtime_error);
+        }
+
+        // a flipped bit anywhere fails the magic, version or checksum
+        for (size_t i = 0; i < data.size(); i++) {
+            std::vector<char> corrupt = data;
+            corrupt[i] ^= 0x10;
+            save(path, corrupt, corrupt.size());
+            CHECK_THROWS(Checkpoint::read(path), std::runtime_error);
+        }
+
+        save(path, data, data.size());
+        CHECK(Checkpoint::read(path).t == 2.5);
+
+        std::remove(path.c_str());
+    }
+
+    /**
+     * Only solve() writes checkpoints; the other modes must not silently
+     * ignore a checkpoint path.
+     */
+    void testOtherModes(const std::string& dir) {
+        const std::string path = dir + "/other.ckpt";
+        VanDerPol model(false);
+        Problem problem(model);
+        setup(problem);
+        problem.setCheckpointing(path, 0);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        Trajectory sensitivities;
+        First objective;
+        AdjointResult result;
+
+        CHECK_THROWS(solver.solve_implicit(problem, trajectory), std::logic_error);
+        CHECK_THROWS(solver.solve_krylov(problem, trajectory), std::logic_error);
+        CHECK_THROWS(solver.solve_bdf(problem, trajectory), std::logic_error);
+        CHECK_THROWS(solver.solve_auto(problem, trajectory), std::logic_error);
+        CHECK_THROWS(solver.solve_imex(problem, trajectory), std::logic_error);
+        CHECK_THROWS(solver.solve(problem, trajectory, sensitivities), std::logic_error);
+        CHECK_THROWS(solver.solve_implicit(problem, trajectory, sensitivities), std::logic_error);
+        CHECK_THROWS(solver.solve_adjoint(problem, trajectory, objective, result), std::logic_error);
+
+        Lag lag;
+        Problem delayed(lag);
+        delayed.setInitialValue(DVec(1, 1.0))
+                .setTimeRange(0, 3)
+                .setPrecision(1.e-8, 1.e-8)
+                .setCheckpointing(path, 0);
+
+        CHECK_THROWS(solver.solve_delay(delayed, trajectory), std::logic_error);
+
+        CHECK(trajectory.size() == 0);
+        CHECK(access(path.c_str(), F_OK) != 0);
+    }
+}
+
+int main() {
+    std::string dir = scratchDir();
+
+    testResumeIsExact(dir);
+    testRoundTrip(dir);
+    testDamagedFiles(dir);
+    testOtherModes(dir);
+
+    rmdir(dir.c_str());
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Bit-exact round trips of XorCodec and CompressedTrajectory, including
+ * NaN, signed zeros, subnormals and constant columns.
+ */
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "iNumerics.h"
+#include "inxorcodec.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    uint64_t bits(double v) {
+        uint64_t b;
+        std::memcpy(&b, &v, sizeof (b));
+        return b;
+    }
+
+    double fromBits(uint64_t b) {
+        double v;
+        std::memcpy(&v, &b, sizeof (v));
+        return v;
+    }
+
+    bool sameBits(const double* a, const double* b, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            if (bits(a[i]) != bits(b[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Values that are easy to lose in a predictive float codec.
+     */
+    std::vector<double> specialValues() {
+        std::vector<double> v;
+
+        v.push_back(0.0);
+        v.push_back(-0.0);
+        v.push_back(std::numeric_limits<double>::quiet_NaN());
+        v.push_back(-std::numeric_limits<double>::quiet_NaN());
+        v.push_back(fromBits(0x7ff0000000000001ULL)); // signaling NaN
+        v.push_back(fromBits(0x7ff8dead0000beefULL)); // NaN with payload
+        v.push_back(std::numeric_limits<double>::infinity());
+        v.push_back(-std::numeric_limits<double>::infinity());
+        v.push_back(std::numeric_limits<double>::denorm_min());
+        v.push_back(-std::numeric_limits<double>::denorm_min());
+        v.push_back(1.e-310);
+        v.push_back(DBL_MIN);
+        v.push_back(DBL_MAX);
+        v.push_back(-DBL_MAX);
+        v.push_back(1);
+        v.push_back(1);
+        v.push_back(-0.0);
+        v.push_back(0.0);
+
+        return v;
+    }
+
+    void roundTrip(const std::vector<double>& values) {
+        std::vector<unsigned char> encoded;
+        size_t bytes = XorCodec::encode(values.data(), values.size(), encoded);
+        CHECK(bytes == encoded.size());
+
+        std::vector<double> decoded(values.size() + 1, 42.0);
+        const unsigned char* end = XorCodec::decode(encoded.data(), values.size(), decoded.data());
+
+        CHECK(end == encoded.data() + encoded.size());
+        CHECK(sameBits(values.data(), decoded.data(), values.size()));
+
+        // nothing is written past n
+        CHECK(decoded[values.size()] == 42.0);
+    }
+
+    void testCodec() {
+        roundTrip(std::vector<double>());
+        roundTrip(std::vector<double>(1, -0.0));
+
+        std::vector<double> special = specialValues();
+        roundTrip(special);
+
+        // every special value after every other one
+        std::vector<double> pairs;
+
+        for (size_t i = 0; i < special.size(); i++) {
+            for (size_t j = 0; j < special.size(); j++) {
+                pairs.push_back(special[i]);
+                pairs.push_back(special[j]);
+            }
+        }
+
+        roundTrip(pairs);
+
+        // constant columns compress to almost nothing
+        std::vector<double> constant(1000, 3.25);
+        std::vector<unsigned char> encoded;
+        XorCodec::encode(constant.data(), constant.size(), encoded);
+        CHECK(encoded.size() < constant.size());
+        roundTrip(constant);
+        roundTrip(std::vector<double>(1000, 0.0));
+        roundTrip(std::vector<double>(1000, std::numeric_limits<double>::quiet_NaN()));
+
+        // smooth, linear and noisy series
+        std::vector<double> smooth, linear, noisy;
+        uint64_t state = 88172645463325252ULL;
+
+        for (size_t i = 0; i < 5000; i++) {
+            smooth.push_back(std::sin(0.01 * i) * std::exp(-1.e-4 * i));
+            linear.push_back(0.5 * i);
+
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            noisy.push_back(fromBits(state));
+        }
+
+        roundTrip(smooth);
+        roundTrip(linear);
+        roundTrip(noisy);
+
+        // streams of several encodes are decoded back to back
+        encoded.clear();
+        XorCodec::encode(smooth.data(), smooth.size(), encoded);
+        XorCodec::encode(special.data(), special.size(), encoded);
+
+        std::vector<double> first(smooth.size()), second(special.size());
+        const unsigned char* in = XorCodec::decode(encoded.data(), first.size(), first.data());
+        in = XorCodec::decode(in, second.size(), second.data());
+
+        CHECK(in == encoded.data() + encoded.size());
+        CHECK(sameBits(first.data(), smooth.data(), smooth.size()));
+        CHECK(sameBits(second.data(), special.data(), special.size()));
+    }
+
+    void testTrajectory(size_t chunkSize, size_t steps) {
+        const size_t n = 4;
+        std::vector<double> special = specialValues();
+
+        CompressedTrajectory compressed(chunkSize);
+        Trajectory reference;
+
+        for (size_t i = 0; i < steps; i++) {
+            DVec x(n);
+            x[0] = std::cos(0.05 * i);
+            x[1] = 7; // constant
+            x[2] = special[i % special.size()];
+            x[3] = i % 3 == 0 ? -0.0 : 1.e-315 * i;
+
+            compressed(x, 0.01 * i);
+            reference(x, 0.01 * i);
+        }
+
+        CHECK(compressed.size() == steps);
+        CHECK(compressed.getDimension() == (steps > 0 ? n : 0));
+        // the open chunk counts as well
+        CHECK(compressed.getChunkCount() == (steps + chunkSize - 1) / chunkSize);
+
+        // random access in reverse order crosses every chunk boundary
+        for (size_t k = steps; k > 0; k--) {
+            size_t i = k - 1;
+            CHECK(bits(compressed.getTime(i)) == bits(reference.getTime(i)));
+
+            const DVec& x = compressed.getState(i);
+            CHECK(x.size() == n);
+            CHECK(sameBits(&x[0], &reference.getState(i)[0], n));
+        }
+
+        // column 0 is the time, column 3 the special values
+        std::vector<double> column(chunkSize);
+
+        for (size_t c = 0; c < compressed.getChunkCount(); c++) {
+            size_t rows = std::min(chunkSize, steps - c * chunkSize);
+            CHECK(compressed.decodeColumn(c, 3, column.data()) == rows);
+
+            for (size_t r = 0; r < rows; r++) {
+                CHECK(bits(column[r]) == bits(reference.getState(c * chunkSize + r)[2]));
+            }
+        }
+
+        if (steps == 0) {
+            return;
+        }
+
+        CHECK(compressed.getMinTime() == 0);
+        CHECK(compressed.getMaxTime() == reference.getTime(steps - 1));
+        CHECK(compressed.getMinState(1) == 7 && compressed.getMaxState(1) == 7);
+        CHECK(compressed.getMinState(0) == reference.getMinState(0));
+        CHECK(compressed.getMaxState(0) == reference.getMaxState(0));
+
+        // windows inside a chunk, across chunks and into the open chunk
+        const double windows[][2] = {{0, 0}, {0.013, 0.047}, {0.2, 5.5}, {-1, 100}};
+
+        for (size_t w = 0; w < 4; w++) {
+            StateSummary a = compressed.getStateSummary(0, windows[w][0], windows[w][1]);
+            StateSummary b = reference.getStateSummary(0, windows[w][0], windows[w][1]);
+
+            CHECK(a.count == b.count);
+
+            if (a.count > 0) {
+                CHECK(a.min == b.min);
+                CHECK(a.max == b.max);
+                CHECK_CLOSE(a.mean, b.mean, 1.e-12);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    testCodec();
+
+    testTrajectory(16, 0);
+    testTrajectory(16, 1);
+    testTrajectory(16, 16);
+    testTrajectory(16, 1000);
+    testTrajectory(1, 50);
+    testTrajectory(1024, 3000);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Consistent initialization and accuracy of a semi-explicit index-1 DAE.
+ */
+
+#include <cmath>
+#include <sys/resource.h>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * y' = -y
+     */
+    class Decay : public Model {
+    public:
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = -y[i];
+            }
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    /**
+     * y0' = -y0, 0 = y1 - y0^2 (M = diag(1, 0)): y0 = exp(-t),
+     * y1 = exp(-2t).
+     */
+    class Dae : public Model {
+    public:
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = -y[0];
+            dydt[1] = y[1] - y[0] * y[0];
+        }
+
+        bool hasMassMatrix() const {
+            return true;
+        }
+
+        bool massMatrix(DVec& M) {
+            M[0] = 1;
+            return true;
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    void testConsistentInitialization(bool algebraicErrorControl) {
+        Dae model;
+        Problem problem(model);
+
+        // y1(0) = 0.3 is inconsistent, the solver has to correct it to 1
+        DVec y0(2);
+        y0[0] = 1;
+        y0[1] = 0.3;
+
+        problem.setInitialValue(y0)
+                .setTimeRange(0, 2)
+                .setPrecision(1.e-8, 1.e-8)
+                .setAlgebraicErrorControl(algebraicErrorControl);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        solver.solve_implicit(problem, trajectory);
+
+        CHECK(trajectory.size() > 1);
+        CHECK_CLOSE(trajectory.getState(0)[0], 1, 0);
+        CHECK_CLOSE(trajectory.getState(0)[1], 1, 1.e-8);
+
+        for (size_t i = 0; i < trajectory.size(); i++) {
+            const DVec& y = trajectory.getState(i);
+            CHECK_CLOSE(y[1], y[0] * y[0], 1.e-6);
+        }
+
+        const DVec& y = trajectory.getState(trajectory.size() - 1);
+        CHECK_CLOSE(y[0], std::exp(-2.), 1.e-6);
+        CHECK_CLOSE(y[1], std::exp(-4.), 1.e-6);
+    }
+
+    /**
+     * y_i' = -y_i for i < n - 1, 0 = y_n-1 - y_n-2^2 with a banded
+     * Jacobian and M = diag(1, ..., 1, 0) in band storage.
+     */
+    class BandedDae : public Model {
+    public:
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            const size_t n = y.size();
+
+            for (size_t i = 0; i + 1 < n; i++) {
+                dydt[i] = -y[i];
+            }
+
+            dydt[n - 1] = y[n - 1] - y[n - 2] * y[n - 2];
+        }
+
+        JacobianStructure getJacobianStructure() {
+            return JacobianStructure::banded(1, 0);
+        }
+
+        bool hasMassMatrix() const {
+            return true;
+        }
+
+        bool massMatrixValues(DVec& values) {
+            // band storage with kl = 1, ku = 0: J(i, i) at 2 i
+            const size_t n = values.size() / 2;
+
+            for (size_t i = 0; i + 1 < n; i++) {
+                values[2 * i] = 1;
+            }
+
+            return true;
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    /**
+     * Large systems: the memory limit is far below n^2 doubles, so neither
+     * the mass matrix probe of the ODE modes nor the banded DAE may
+     * allocate a dense matrix.
+     */
+    void testLarge() {
+        struct rlimit limit;
+        getrlimit(RLIMIT_AS, &limit);
+        struct rlimit reduced = limit;
+        reduced.rlim_cur = (rlim_t) 1 << 30;
+
+        if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < reduced.rlim_cur) {
+            reduced.rlim_cur = limit.rlim_max;
+        }
+
+        setrlimit(RLIMIT_AS, &reduced);
+
+        {
+            const size_t n = 100000;
+            Decay model;
+            Problem problem(model);
+            problem.setInitialValue(DVec(n, 1.0))
+                    .setTimeRange(0, 1)
+                    .setPrecision(1.e-6, 1.e-6);
+
+            ODESolver solver;
+            Trajectory trajectory;
+            solver.solve(problem, trajectory);
+
+            CHECK_CLOSE(trajectory.getState(trajectory.size() - 1)[n - 1], std::exp(-1.), 1.e-5);
+        }
+
+        {
+            const size_t n = 20000;
+            BandedDae model;
+            Problem problem(model);
+            DVec y0(n, 1.0);
+            y0[n - 1] = 0.3;
+
+            problem.setInitialValue(y0)
+                    .setTimeRange(0, 1)
+                    .setPrecision(1.e-8, 1.e-8);
+
+            ODESolver solver;
+            Trajectory trajectory;
+            solver.solve_implicit(problem, trajectory);
+
+            CHECK_CLOSE(trajectory.getState(0)[n - 1], 1, 1.e-8);
+
+            const DVec& y = trajectory.getState(trajectory.size() - 1);
+            CHECK_CLOSE(y[0], std::exp(-1.), 1.e-6);
+            CHECK_CLOSE(y[n - 1], y[n - 2] * y[n - 2], 1.e-6);
+        }
+
+        setrlimit(RLIMIT_AS, &limit);
+    }
+
+    void testUnsupported() {
+        Dae model;
+        Problem problem(model);
+        problem.setInitialValue(DVec(2, 1.0)).setTimeRange(0, 1);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        CHECK_THROWS(solver.solve(problem, trajectory), std::logic_error);
+        CHECK_THROWS(solver.solve_bdf(problem, trajectory), std::logic_error);
+    }
+}
+
+int main(int argc, char** argv) {
+    testConsistentInitialization(true);
+    testConsistentInitialization(false);
+    testUnsupported();
+    testLarge();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Error bound of DecimatingTrajectory: every dropped step is reproduced
+ * within the tolerance by interpolating between the retained steps.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * Damped oscillator x'' = -x - 0.1 x'.
+     */
+    class Oscillator : public Model {
+    public:
+
+        void rhs(const DVec& x, DVec& dxdt, const double t) {
+            dxdt[0] = x[1];
+            dxdt[1] = -x[0] - 0.1 * x[1];
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    /**
+     * Largest deviation of the steps of full from the interpolant through
+     * the retained steps, linear or cubic Hermite with the derivatives
+     * of model.
+     */
+    double deviation(const Trajectory& full, const Trajectory& retained, Model& model, bool hermite) {
+        const size_t n = full.getState(0).size();
+        DVec f0(n), f1(n);
+        double error = 0;
+        size_t k = 0;
+
+        for (size_t i = 0; i < full.size(); i++) {
+            double t = full.getTime(i);
+
+            while (k + 2 < retained.size() && retained.getTime(k + 1) < t) {
+                k++;
+            }
+
+            double t0 = retained.getTime(k);
+            double t1 = retained.getTime(k + 1);
+            const DVec& x0 = retained.getState(k);
+            const DVec& x1 = retained.getState(k + 1);
+
+            model.rhs(x0, f0, t0);
+            model.rhs(x1, f1, t1);
+
+            for (size_t c = 0; c < n; c++) {
+                double x = hermite
+                        ? Interpolation::hermite(t0, x0[c], f0[c], t1, x1[c], f1[c], t)
+                        : Interpolation::linear(t0, x0[c], t1, x1[c], t);
+
+                error = std::max(error, std::fabs(x - full.getState(i)[c]));
+            }
+        }
+
+        return error;
+    }
+
+    void testBound(bool hermite, double tolerance) {
+        Oscillator model;
+        Problem problem(model);
+
+        DVec x0(2);
+        x0[0] = 1;
+        x0[1] = 0;
+
+        problem.setInitialValue(x0)
+                .setTimeRange(0, 30)
+                .setPrecision(1.e-10, 1.e-10, 0.01);
+
+        ODESolver solver;
+        Trajectory full;
+        solver.solve(problem, full);
+
+        // the same solve again, decimated
+        Trajectory retained;
+        Problem derivatives(model);
+        DecimatingTrajectory decimating = hermite
+                ? DecimatingTrajectory(retained, tolerance, derivatives, 64)
+                : DecimatingTrajectory(retained, tolerance);
+
+        solver.solve(problem, decimating);
+
+        CHECK(decimating.getInputCount() == full.size());
+        CHECK(decimating.getRetainedCount() == retained.size());
+        CHECK(decimating.size() == retained.size());
+        CHECK(retained.size() >= 2);
+        CHECK(retained.size() < full.size());
+
+        // the end points are always retained
+        CHECK(retained.getTime(0) == full.getTime(0));
+        CHECK(retained.getTime(retained.size() - 1) == full.getTime(full.size() - 1));
+
+        for (size_t i = 1; i < retained.size(); i++) {
+            CHECK(retained.getTime(i) > retained.getTime(i - 1));
+        }
+
+        double error = deviation(full, retained, model, hermite);
+
+        std::printf("%s tolerance %g: %lu of %lu steps, max deviation %.3g\n",
+                hermite ? "hermite" : "linear", tolerance,
+                (unsigned long) retained.size(), (unsigned long) full.size(), error);
+
+        CHECK(error <= tolerance * (1 + 1.e-9));
+    }
+
+    /**
+     * Tolerance 0 keeps every step that is not exactly on a line.
+     */
+    void testExact() {
+        Trajectory retained;
+        DecimatingTrajectory decimating(retained, 0);
+
+        for (size_t i = 0; i <= 10; i++) {
+            DVec x(1, 2.0 * i);
+            decimating(x, i);
+        }
+
+        DVec bend(1, 19.0);
+        decimating(bend, 11);
+        decimating.finish();
+
+        CHECK(decimating.getInputCount() == 12);
+        CHECK(retained.size() == 3);
+        CHECK(retained.getTime(1) == 10);
+        CHECK(retained.getState(2)[0] == 19);
+    }
+}
+
+int main(int argc, char** argv) {
+    testBound(false, 1.e-2);
+    testBound(false, 1.e-3);
+    testBound(true, 1.e-4);
+    testBound(true, 1.e-6);
+
+    testExact();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Method of steps for y'(t) = -y(t - 1) against its piecewise polynomial
+ * solution.
+ */
+
+#include <cmath>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * y'(t) = -y(t - 1), y(t) = 1 for t <= 0.
+     */
+    class Delay : public DelayModel {
+    public:
+
+        size_t getDelayCount() const {
+            return 1;
+        }
+
+        double getDelay(size_t k, const DVec& y, const double t) {
+            return 1;
+        }
+
+        double getMaxDelay() const {
+            return 1;
+        }
+
+        void rhs(const DVec& y, const DVec& delayed, DVec& dydt, const double t) {
+            dydt[0] = -delayed[0];
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+        /**
+         * Exact solution on [0, 3].
+         */
+        static double exact(double t) {
+            double y = 1 - t;
+
+            if (t > 1) {
+                y += (t - 1) * (t - 1) / 2;
+            }
+
+            if (t > 2) {
+                y -= (t - 2) * (t - 2) * (t - 2) / 6;
+            }
+
+            return y;
+        }
+    };
+
+    void testConstantDelay() {
+        Delay model;
+        Problem problem(model);
+        problem.setInitialValue(DVec(1, 1.0))
+                .setTimeRange(0, 3)
+                .setPrecision(1.e-10, 1.e-10);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        solver.solve_delay(problem, trajectory);
+
+        bool one = false;
+        bool two = false;
+
+        for (size_t i = 0; i < trajectory.size(); i++) {
+            double t = trajectory.getTime(i);
+            CHECK_CLOSE(trajectory.getState(i)[0], Delay::exact(t), 1.e-9);
+
+            // the discontinuities of y'' and y''' are stepped onto
+            one = one || std::fabs(t - 1) < 1.e-12;
+            two = two || std::fabs(t - 2) < 1.e-12;
+        }
+
+        CHECK(one);
+        CHECK(two);
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), 3, 1.e-12);
+    }
+
+    void testNotADelayModel() {
+        class Plain : public Model {
+        public:
+
+            void rhs(const DVec& y, DVec& dydt, const double t) {
+                dydt[0] = -y[0];
+            }
+
+            void step(const DVec& x, double t) {
+            }
+        } model;
+
+        Problem problem(model);
+        problem.setInitialValue(DVec(1, 1.0)).setTimeRange(0, 1);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        CHECK_THROWS(solver.solve_delay(problem, trajectory), std::invalid_argument);
+    }
+}
+
+int main(int argc, char** argv) {
+    testConstantDelay();
+    testNotADelayModel();
+
+    return CHECK_RESULT();
+}
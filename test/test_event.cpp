@@ -0,0 +1,242 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Event location and state resets: a bouncing ball.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    const double gravity = 9.81;
+    const double restitution = 0.9;
+
+    /**
+     * Height x[0] and velocity x[1] of a ball in free fall.
+     */
+    class Ball : public Model {
+    public:
+
+        void rhs(const DVec& x, DVec& dxdt, const double t) {
+            dxdt[0] = x[1];
+            dxdt[1] = -gravity;
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    /**
+     * Contact with the ground, reverses and damps the velocity.
+     */
+    class Bounce : public Event {
+    public:
+
+        Bounce(Direction direction) : Event(direction) {
+        }
+
+        double condition(const DVec& x, double t) {
+            return x[0];
+        }
+
+        bool occurred(DVec& x, double t) {
+            times.push_back(t);
+            x[1] = -restitution * x[1];
+            return true;
+        }
+
+        std::vector<double> times;
+    };
+
+    /**
+     * Impact times of the ball dropped from height h at rest, up to tn.
+     */
+    std::vector<double> impacts(double h, double tn) {
+        std::vector<double> times;
+        double t = std::sqrt(2 * h / gravity);
+        double v = gravity * t;
+
+        while (t < tn) {
+            times.push_back(t);
+            v *= restitution;
+            t += 2 * v / gravity;
+        }
+
+        return times;
+    }
+
+    enum Mode {
+        EXPLICIT, IMPLICIT, BDF, KRYLOV, AUTO
+    };
+
+    SolveStats solve(Mode mode, Problem& problem, Trajectory& trajectory) {
+        ODESolver solver;
+
+        switch (mode) {
+            case IMPLICIT: return solver.solve_implicit(problem, trajectory);
+            case BDF: return solver.solve_bdf(problem, trajectory);
+            case KRYLOV: return solver.solve_krylov(problem, trajectory);
+            case AUTO: return solver.solve_auto(problem, trajectory);
+            default: return solver.solve(problem, trajectory);
+        }
+    }
+
+    void testBouncingBall(Event::Direction direction, Mode mode) {
+        Ball model;
+        Bounce bounce(direction);
+        Problem problem(model);
+
+        DVec x0(2);
+        x0[0] = 1;
+        x0[1] = 0;
+
+        problem.setInitialValue(x0)
+                .setTimeRange(0, 4)
+                .setPrecision(1.e-10, 1.e-10)
+                .addEvent(bounce);
+
+        Trajectory trajectory;
+        SolveStats stats = solve(mode, problem, trajectory);
+
+        std::vector<double> expected = impacts(1, 4);
+
+        CHECK(expected.size() == 6);
+        CHECK(bounce.times.size() == expected.size());
+        CHECK(stats.events == bounce.times.size());
+
+        for (size_t k = 0; k < bounce.times.size() && k < expected.size(); k++) {
+            CHECK_CLOSE(bounce.times[k], expected[k], 1.e-7);
+        }
+
+        // the ball never falls through the ground
+        for (size_t i = 0; i < trajectory.size(); i++) {
+            CHECK(trajectory.getState(i)[0] > -1.e-7);
+        }
+
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), 4, 1.e-12);
+    }
+
+    /**
+     * A terminal event ends the solve at the first crossing.
+     */
+    void testTerminal() {
+        class Ground : public Event {
+        public:
+
+            Ground() : Event(FALLING, true) {
+            }
+
+            double condition(const DVec& x, double t) {
+                return x[0];
+            }
+        } ground;
+
+        Ball model;
+        Problem problem(model);
+        DVec x0(2);
+        x0[0] = 1;
+        x0[1] = 0;
+
+        problem.setInitialValue(x0)
+                .setTimeRange(0, 4)
+                .setPrecision(1.e-10, 1.e-10)
+                .addEvent(ground);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        SolveStats stats = solver.solve(problem, trajectory);
+
+        CHECK(stats.events == 1);
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), impacts(1, 4)[0], 1.e-7);
+        CHECK_CLOSE(trajectory.getState(trajectory.size() - 1)[0], 0, 1.e-9);
+    }
+
+    /**
+     * A crossing that lands exactly on the end of a step (here the end of
+     * the solve) is located there, not inside the step.
+     */
+    void testRootAtStepEnd() {
+        class Deadline : public Event {
+        public:
+
+            Deadline() : Event(RISING, true), time(-1) {
+            }
+
+            double condition(const DVec& x, double t) {
+                return t - 1;
+            }
+
+            bool occurred(DVec& x, double t) {
+                time = t;
+                return false;
+            }
+
+            double time;
+        } deadline;
+
+        Ball model;
+        Problem problem(model);
+        DVec x0(2);
+        x0[0] = 1;
+        x0[1] = 0;
+
+        problem.setInitialValue(x0)
+                .setTimeRange(0, 1)
+                .setPrecision(1.e-10, 1.e-10)
+                .addEvent(deadline);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        SolveStats stats = solver.solve(problem, trajectory);
+
+        CHECK(stats.events == 1);
+        CHECK(deadline.time == 1);
+        CHECK(trajectory.getTime(trajectory.size() - 1) == 1);
+    }
+}
+
+int main(int argc, char** argv) {
+    // the restart after every bounce starts on the event surface
+    for (int mode = EXPLICIT; mode <= AUTO; mode++) {
+        testBouncingBall(Event::BOTH, (Mode) mode);
+        testBouncingBall(Event::FALLING, (Mode) mode);
+    }
+
+    testTerminal();
+    testRootAtStepEnd();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * TrajectoryWriter/TrajectoryReader round trips and rejection of malformed
+ * text and damaged binary files.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    const size_t dimension = 3;
+
+    bool sameBits(double a, double b) {
+        return std::memcmp(&a, &b, sizeof (double)) == 0;
+    }
+
+    /**
+     * Values whose shortest representation is long or unusual: thirds,
+     * -0, subnormals, extremes, infinities and NaN.
+     */
+    void fill(Trajectory& trajectory) {
+        const double special[] = {
+            -0.0, 4.9406564584124654e-324, 2.2250738585072009e-308,
+            1.7976931348623157e308, -1.e-300, 0.1, 1.0 / 3,
+            std::numeric_limits<double>::infinity(),
+            -std::numeric_limits<double>::infinity(),
+            std::numeric_limits<double>::quiet_NaN()
+        };
+        const size_t count = sizeof (special) / sizeof (special[0]);
+
+        DVec x(dimension);
+
+        for (size_t i = 0; i < 200; i++) {
+            for (size_t c = 0; c < dimension; c++) {
+                x[c] = (i + c) % 7 == 0
+                        ? special[(i + c) % count]
+                        : std::sin(0.37 * i + c) * std::pow(10.0, (double) (i % 40) - 20);
+            }
+
+            trajectory(x, i * 0.1 + 1.0 / 7);
+        }
+    }
+
+    void checkEqual(const Trajectory& a, const Trajectory& b) {
+        CHECK(a.size() == b.size());
+
+        for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+            CHECK(sameBits(a.getTime(i), b.getTime(i)));
+            CHECK(a.getState(i).size() == b.getState(i).size());
+
+            for (size_t c = 0; c < a.getState(i).size() && c < b.getState(i).size(); c++) {
+                if (!sameBits(a.getState(i)[c], b.getState(i)[c])) {
+                    std::printf("step %zu component %zu: %.17g vs %.17g\n",
+                            i, c, a.getState(i)[c], b.getState(i)[c]);
+                    CHECK(sameBits(a.getState(i)[c], b.getState(i)[c]));
+                }
+            }
+        }
+    }
+
+    std::string scratchDir() {
+        char dir[] = "/tmp/test_ioXXXXXX";
+
+        if (mkdtemp(dir) == NULL) {
+            std::perror("mkdtemp");
+            std::exit(1);
+        }
+
+        return dir;
+    }
+
+    std::vector<char> load(const std::string& path) {
+        std::vector<char> data;
+        FILE* file = std::fopen(path.c_str(), "rb");
+
+        if (file == NULL) {
+            return data;
+        }
+
+        char buffer[4096];
+        size_t n;
+
+        while ((n = std::fread(buffer, 1, sizeof (buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + n);
+        }
+
+        std::fclose(file);
+
+        return data;
+    }
+
+    void save(const std::string& path, const char* data, size_t size) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite(data, 1, size, file);
+        std::fclose(file);
+    }
+
+    void save(const std::string& path, const std::string& text) {
+        save(path, text.data(), text.size());
+    }
+
+    void testTextRoundTrip(const std::string& dir) {
+        Trajectory original;
+        fill(original);
+
+        std::string csv = dir + "/t.csv";
+        TrajectoryWriter::writeText(csv, original);
+        Trajectory fromCsv;
+        TrajectoryReader::readText(csv, fromCsv);
+        checkEqual(original, fromCsv);
+
+        std::string tsv = dir + "/t.tsv";
+        TrajectoryWriter::writeText(tsv, original, '\t', false);
+        Trajectory fromTsv;
+        TrajectoryReader::readText(tsv, fromTsv, '\t');
+        checkEqual(original, fromTsv);
+
+        std::remove(csv.c_str());
+        std::remove(tsv.c_str());
+    }
+
+    void testTextParsing(const std::string& dir) {
+        std::string path = dir + "/parse.csv";
+
+        // header, CRLF, blank lines, spaces after the delimiter, no final newline
+        save(path, "time,a,b\r\n0,1,2\r\n\r\n0.5, -3e-2,4\n\n1,5,6");
+        Trajectory t;
+        TrajectoryReader::readText(path, t);
+        CHECK(t.size() == 3);
+
+        if (t.size() == 3) {
+            CHECK(t.getTime(1) == 0.5);
+            CHECK(t.getState(1)[0] == -3e-2);
+            CHECK(t.getState(2)[1] == 6);
+        }
+
+        const char* malformed[] = {
+            "0,1,2\n1,2\n", // wrong number of columns
+            "0,1,2\n1,x,3\n", // invalid number
+            "0,1,2\nabc,1,2\n", // invalid time after the first line
+            "0,1;2\n" // wrong delimiter
+        };
+
+        for (size_t i = 0; i < sizeof (malformed) / sizeof (malformed[0]); i++) {
+            save(path, malformed[i]);
+            Trajectory m;
+            CHECK_THROWS(TrajectoryReader::readText(path, m), std::runtime_error);
+        }
+
+        Trajectory missing;
+        CHECK_THROWS(TrajectoryReader::readText(dir + "/missing.csv", missing), std::runtime_error);
+
+        std::remove(path.c_str());
+    }
+
+    void testBinaryRoundTrip(const std::string& dir) {
+        std::string path = dir + "/t.bin";
+
+        Trajectory original;
+        fill(original);
+        TrajectoryWriter::writeBinary(path, original);
+
+        std::vector<char> data = load(path);
+        CHECK(data.size() == 16 + original.size() * (dimension + 1) * sizeof (double));
+
+        Trajectory read;
+        TrajectoryReader::readBinary(path, read);
+        checkEqual(original, read);
+
+        Trajectory empty;
+        TrajectoryWriter::writeBinary(path, empty);
+        Trajectory readEmpty;
+        TrajectoryReader::readBinary(path, readEmpty);
+        CHECK(readEmpty.size() == 0);
+
+        std::remove(path.c_str());
+    }
+
+    void testBinaryRejected(const std::string& dir) {
+        std::string path = dir + "/damaged.bin";
+
+        Trajectory original;
+        fill(original);
+        TrajectoryWriter::writeBinary(path, original);
+        std::vector<char> data = load(path);
+
+        const size_t recordSize = (dimension + 1) * sizeof (double);
+
+        // cut inside the header or inside a record
+        for (size_t size = 0; size < data.size(); size += 5) {
+            if (size >= 16 && (size - 16) % recordSize == 0) {
+                continue;
+            }
+
+            save(path, &data[0], size);
+            Trajectory t;
+            CHECK_THROWS(TrajectoryReader::readBinary(path, t), std::runtime_error);
+        }
+
+        std::vector<char> badMagic = data;
+        badMagic[0] = 'X';
+        save(path, &badMagic[0], badMagic.size());
+        Trajectory t1;
+        CHECK_THROWS(TrajectoryReader::readBinary(path, t1), std::runtime_error);
+
+        std::vector<char> badVersion = data;
+        badVersion[8] = 2;
+        save(path, &badVersion[0], badVersion.size());
+        Trajectory t2;
+        CHECK_THROWS(TrajectoryReader::readBinary(path, t2), std::runtime_error);
+
+        // a dimension that does not divide the payload
+        std::vector<char> badDimension = data;
+        badDimension[12] = (char) (dimension + 2);
+        save(path, &badDimension[0], badDimension.size());
+        Trajectory t3;
+        CHECK_THROWS(TrajectoryReader::readBinary(path, t3), std::runtime_error);
+
+        // dimension 0 with records behind the header
+        std::vector<char> zeroDimension = data;
+        std::memset(&zeroDimension[12], 0, 4);
+        save(path, &zeroDimension[0], zeroDimension.size());
+        Trajectory t4;
+        CHECK_THROWS(TrajectoryReader::readBinary(path, t4), std::runtime_error);
+
+        std::remove(path.c_str());
+    }
+}
+
+int main() {
+    std::string dir = scratchDir();
+
+    testTextRoundTrip(dir);
+    testTextParsing(dir);
+    testBinaryRoundTrip(dir);
+    testBinaryRejected(dir);
+
+    rmdir(dir.c_str());
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * solve_krylov() against closed-form solutions, with and without a
+ * preconditioner.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <sys/resource.h>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * y_i' = -k_i y_i, y_i(0) = 1.
+     */
+    class Decay : public Model {
+    public:
+
+        Decay(const DVec& rates) : _rates(rates) {
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = -_rates[i] * y[i];
+            }
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+        const DVec& getRates() const {
+            return _rates;
+        }
+
+    private:
+        DVec _rates;
+    };
+
+    /**
+     * The exact inverse of I - gamma J for Decay.
+     */
+    class DiagonalPreconditioner : public Preconditioner {
+    public:
+
+        DiagonalPreconditioner(const Decay& model) : _model(model), _gamma(0) {
+        }
+
+        bool setup(const DVec& y, const DVec& f, double t, double gamma) {
+            _gamma = gamma;
+            return true;
+        }
+
+        void solve(const DVec& r, DVec& z) {
+            const DVec& rates = _model.getRates();
+
+            for (size_t i = 0; i < r.size(); i++) {
+                z[i] = r[i] / (1 + _gamma * rates[i]);
+            }
+        }
+
+    private:
+        const Decay& _model;
+        double _gamma;
+    };
+
+    /**
+     * Rates spread over [1, kmax] logarithmically.
+     */
+    DVec rates(size_t n, double kmax) {
+        DVec k(n);
+
+        for (size_t i = 0; i < n; i++) {
+            k[i] = std::pow(kmax, n > 1 ? (double) i / (n - 1) : 0.0);
+        }
+
+        return k;
+    }
+
+    /**
+     * Largest error at t = 2.
+     */
+    double solveError(const DVec& k, double tolerance, Preconditioner* preconditioner,
+            SolveStats& stats) {
+
+        Decay model(k);
+        Problem problem(model);
+        problem.setInitialValue(DVec(k.size(), 1.0))
+                .setTimeRange(0, 2)
+                .setPrecision(tolerance, tolerance, 1.e-4)
+                .setPreconditioner(preconditioner);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        stats = solver.solve_krylov(problem, trajectory);
+
+        CHECK(trajectory.size() > 1);
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), 2, 1.e-12);
+
+        const DVec& y = trajectory.getState(trajectory.size() - 1);
+        double error = 0;
+
+        for (size_t i = 0; i < y.size(); i++) {
+            error = std::max(error, std::fabs(y[i] - std::exp(-2 * k[i])));
+        }
+
+        return error;
+    }
+
+    void testConvergence() {
+        DVec k(2);
+        k[0] = 1;
+        k[1] = 1000;
+
+        SolveStats loose;
+        SolveStats tight;
+        double looseError = solveError(k, 1.e-5, NULL, loose);
+        double tightError = solveError(k, 1.e-8, NULL, tight);
+
+        std::printf("error %.3g at 1e-5 (%lu steps), %.3g at 1e-8 (%lu steps)\n",
+                looseError, (unsigned long) loose.acceptedSteps,
+                tightError, (unsigned long) tight.acceptedSteps);
+
+        // the second order method accumulates more than the tolerance
+        CHECK(looseError < 1.e-3);
+        CHECK(tightError < 1.e-5);
+        CHECK(tightError < 0.1 * looseError);
+        CHECK(tight.acceptedSteps > loose.acceptedSteps);
+        CHECK(tight.newtonIterations > 0);
+        CHECK(tight.linearIterations > 0);
+    }
+
+    void testPreconditioner() {
+        DVec k = rates(200, 1.e4);
+        Decay model(k);
+        DiagonalPreconditioner preconditioner(model);
+
+        SolveStats plain;
+        SolveStats preconditioned;
+        double plainError = solveError(k, 1.e-6, NULL, plain);
+        double preconditionedError = solveError(k, 1.e-6, &preconditioner, preconditioned);
+
+        std::printf("%lu linear iterations, %lu preconditioned\n",
+                (unsigned long) plain.linearIterations,
+                (unsigned long) preconditioned.linearIterations);
+
+        CHECK(plainError < 1.e-4);
+        CHECK(preconditionedError < 1.e-4);
+
+        // an exact preconditioner leaves one iteration per Newton step
+        CHECK(preconditioned.linearIterations < plain.linearIterations);
+        CHECK(preconditioned.linearIterations <= 2 * preconditioned.newtonIterations);
+    }
+
+    /**
+     * Memory linear in n: 100000 states under an address space limit far
+     * below the n^2 doubles of any dense matrix.
+     */
+    void testLarge() {
+        struct rlimit limit;
+        getrlimit(RLIMIT_AS, &limit);
+        struct rlimit reduced = limit;
+        reduced.rlim_cur = (rlim_t) 1 << 30;
+
+        if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < reduced.rlim_cur) {
+            reduced.rlim_cur = limit.rlim_max;
+        }
+
+        setrlimit(RLIMIT_AS, &reduced);
+
+        DVec k = rates(100000, 1.e3);
+        SolveStats stats;
+        CHECK(solveError(k, 1.e-5, NULL, stats) < 1.e-3);
+
+        setrlimit(RLIMIT_AS, &limit);
+    }
+}
+
+int main(int argc, char** argv) {
+    testConvergence();
+    testPreconditioner();
+    testLarge();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Residuals of the LU factorizations for every Jacobian structure.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "DenseLU.h"
+#include "SparseLU.h"
+#include "StructuredLU.h"
+#include "JacobianStructure.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * Deterministic pseudo random numbers in [-1,1] (xorshift64).
+     */
+    class Random {
+    public:
+
+        Random(inULong seed) : _state(seed) {
+        }
+
+        double next() {
+            _state ^= _state << 13;
+            _state ^= _state >> 7;
+            _state ^= _state << 17;
+            return (double) (_state >> 11) / (double) (1ULL << 52) - 1.0;
+        }
+
+    private:
+        inULong _state;
+    };
+
+    /**
+     * Random values for the entries of structure (dimension set); A is the
+     * same matrix dense and column-major. Every diagonal entry is scaled
+     * down, so that the factorizations have to pivot.
+     */
+    void randomMatrix(const JacobianStructure& structure, Random& r, DVec& values, DVec& A) {
+        const size_t n = structure.getDimension();
+
+        values.assign(structure.getValueCount(), 0);
+        A.assign(n * n, 0);
+
+        for (size_t j = 0; j < n; j++) {
+            for (size_t i = 0; i < n; i++) {
+                size_t k = structure.index(i, j);
+
+                if (k != JacobianStructure::npos) {
+                    double v = r.next();
+
+                    if (i == j) {
+                        v *= 1.e-3;
+                    }
+
+                    values[k] = v;
+                    A[j * n + i] = v;
+                }
+            }
+        }
+    }
+
+    /**
+     * max |A x - b| / (max |A| * max |x|) for nrhs right hand sides.
+     */
+    double residual(const DVec& A, const DVec& x, const DVec& b, size_t n, size_t nrhs) {
+        double maxA = 0;
+        double maxX = 0;
+        double maxR = 0;
+
+        for (size_t k = 0; k < A.size(); k++) {
+            maxA = std::max(maxA, std::fabs(A[k]));
+        }
+
+        for (size_t r = 0; r < nrhs; r++) {
+            for (size_t i = 0; i < n; i++) {
+                double sum = -b[r * n + i];
+
+                for (size_t j = 0; j < n; j++) {
+                    sum += A[j * n + i] * x[r * n + j];
+                }
+
+                maxR = std::max(maxR, std::fabs(sum));
+                maxX = std::max(maxX, std::fabs(x[r * n + i]));
+            }
+        }
+
+        return maxR / (maxA * maxX);
+    }
+
+    void checkStructure(JacobianStructure structure, size_t n, inULong seed) {
+        structure.setDimension(n);
+
+        Random r(seed);
+        DVec values;
+        DVec A;
+        randomMatrix(structure, r, values, A);
+
+        const size_t nrhs = 2;
+        DVec b(n * nrhs);
+
+        for (size_t i = 0; i < b.size(); i++) {
+            b[i] = r.next();
+        }
+
+        SolveStats stats;
+        StructuredLU lu(&stats);
+
+        CHECK(lu.factor(structure, values));
+        CHECK(lu.size() == n);
+
+        DVec x = b;
+        lu.solve(&x[0], nrhs);
+
+        CHECK(residual(A, x, b, n, nrhs) < 1.e-12);
+        CHECK(stats.luDecompositions == 1);
+        CHECK(stats.luSolves == nrhs);
+
+        // the factors are reused for another right hand side
+        DVec b2(n, 1.0);
+        DVec x2 = b2;
+        lu.solve(&x2[0]);
+
+        CHECK(residual(A, x2, b2, n, 1) < 1.e-12);
+    }
+
+    void testDense() {
+        const size_t n = 40;
+
+        Random r(1);
+        DVec A(n * n);
+
+        for (size_t k = 0; k < A.size(); k++) {
+            A[k] = r.next();
+        }
+
+        DVec b(n);
+
+        for (size_t i = 0; i < n; i++) {
+            b[i] = r.next();
+        }
+
+        DenseLU lu;
+
+        CHECK(lu.factor(A, n));
+
+        DVec x = b;
+        lu.solve(x);
+
+        CHECK(residual(A, x, b, n, 1) < 1.e-12);
+
+        // singular: two equal columns
+        for (size_t i = 0; i < n; i++) {
+            A[n + i] = A[i];
+        }
+
+        CHECK(!lu.factor(A, n));
+    }
+
+    void testSparse() {
+        // 2-D Laplacian-like pattern on a 10 x 10 grid with random values
+        const size_t m = 10;
+        const size_t n = m * m;
+
+        std::vector<size_t> rowPointers(1, 0);
+        std::vector<size_t> columnIndices;
+
+        for (size_t i = 0; i < n; i++) {
+            size_t x = i % m;
+            size_t y = i / m;
+
+            if (y > 0) columnIndices.push_back(i - m);
+            if (x > 0) columnIndices.push_back(i - 1);
+            columnIndices.push_back(i);
+            if (x + 1 < m) columnIndices.push_back(i + 1);
+            if (y + 1 < m) columnIndices.push_back(i + m);
+
+            rowPointers.push_back(columnIndices.size());
+        }
+
+        JacobianStructure structure = JacobianStructure::sparse(rowPointers, columnIndices);
+        structure.setDimension(n);
+
+        Random r(2);
+        DVec values;
+        DVec A;
+        randomMatrix(structure, r, values, A);
+
+        SparseLU lu;
+        lu.analyze(n, rowPointers, columnIndices);
+
+        CHECK(lu.factor(values));
+        CHECK(lu.getFactorNonzeros() >= values.size() - n);
+
+        DVec b(n);
+
+        for (size_t i = 0; i < n; i++) {
+            b[i] = r.next();
+        }
+
+        DVec x = b;
+        lu.solve(&x[0]);
+
+        CHECK(residual(A, x, b, n, 1) < 1.e-12);
+
+        // new values, same pattern and ordering
+        randomMatrix(structure, r, values, A);
+
+        CHECK(lu.factor(values));
+
+        x = b;
+        lu.solve(&x[0]);
+
+        CHECK(residual(A, x, b, n, 1) < 1.e-12);
+    }
+
+    void testStructures() {
+        checkStructure(JacobianStructure(), 30, 3);
+        checkStructure(JacobianStructure::banded(2, 3), 50, 4);
+        checkStructure(JacobianStructure::banded(0, 1), 20, 5);
+        checkStructure(JacobianStructure::blockDiagonal(1), 10, 6);
+        checkStructure(JacobianStructure::blockDiagonal(3), 30, 7);
+
+        // arrow pattern: tridiagonal plus a dense last row and column
+        const size_t n = 40;
+        std::vector<size_t> rowPointers(1, 0);
+        std::vector<size_t> columnIndices;
+
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                if ((j + 1 >= i && j <= i + 1) || i == n - 1 || j == n - 1) {
+                    columnIndices.push_back(j);
+                }
+            }
+            rowPointers.push_back(columnIndices.size());
+        }
+
+        checkStructure(JacobianStructure::sparse(rowPointers, columnIndices), n, 8);
+    }
+
+    void testSingularBlock() {
+        JacobianStructure structure = JacobianStructure::blockDiagonal(2);
+        structure.setDimension(4);
+
+        // second block has a zero column
+        DVec values(8, 0);
+        values[0] = 1;
+        values[3] = 1;
+        values[4] = 1;
+        values[5] = 2;
+
+        StructuredLU lu;
+
+        CHECK(!lu.factor(structure, values));
+    }
+}
+
+int main(int argc, char** argv) {
+    testDense();
+    testSparse();
+    testStructures();
+    testSingularBlock();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Accuracy of the solve modes against closed-form solutions.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * y_i' = -k_i y_i, y_i(0) = 1.
+     */
+    class Decay : public Model {
+    public:
+
+        Decay(const DVec& rates) : _rates(rates) {
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = -_rates[i] * y[i];
+            }
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+        DVec exact(double t) const {
+            DVec y(_rates.size());
+
+            for (size_t i = 0; i < y.size(); i++) {
+                y[i] = std::exp(-_rates[i] * t);
+            }
+
+            return y;
+        }
+
+    private:
+        DVec _rates;
+    };
+
+    /**
+     * y' = cos(t) exp(-t / 10), y(0) = 0.
+     */
+    class Forced : public Model {
+    public:
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = std::cos(t) * std::exp(-0.1 * t);
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+        double exact(double t) const {
+            const double a = -0.1;
+            return (std::exp(a * t) * (a * std::cos(t) + std::sin(t)) - a) / (a * a + 1);
+        }
+    };
+
+    enum Mode {
+        EXPLICIT, IMPLICIT
+    };
+
+    const char* modeName(Mode mode) {
+        static const char* names[] = {"solve", "solve_implicit"};
+        return names[mode];
+    }
+
+    SolveStats solve(Mode mode, Problem& problem, Trajectory& trajectory) {
+        ODESolver solver;
+
+        switch (mode) {
+            case IMPLICIT: return solver.solve_implicit(problem, trajectory);
+            default: return solver.solve(problem, trajectory);
+        }
+    }
+
+    /**
+     * Largest error at tn of y' = -k y for the given tolerance.
+     */
+    double decayError(Mode mode, const DVec& rates, double tolerance, SolveStats& stats) {
+        Decay model(rates);
+        Problem problem(model);
+        problem.setInitialValue(DVec(rates.size(), 1.0))
+                .setTimeRange(0, 2)
+                .setPrecision(tolerance, tolerance, 1.e-4);
+
+        Trajectory trajectory;
+        stats = solve(mode, problem, trajectory);
+
+        CHECK(trajectory.size() > 1);
+        CHECK(trajectory.getTime(0) == 0);
+        CHECK_CLOSE(trajectory.getTime(trajectory.size() - 1), 2, 1.e-12);
+
+        for (size_t i = 1; i < trajectory.size(); i++) {
+            CHECK(trajectory.getTime(i) > trajectory.getTime(i - 1));
+        }
+
+        const DVec& y = trajectory.getState(trajectory.size() - 1);
+        DVec exact = model.exact(2);
+        double error = 0;
+
+        for (size_t i = 0; i < y.size(); i++) {
+            error = std::max(error, std::fabs(y[i] - exact[i]));
+        }
+
+        return error;
+    }
+
+    void testDecay(Mode mode) {
+        std::printf("%s\n", modeName(mode));
+
+        // one slow and one stiff component
+        DVec rates(2);
+        rates[0] = 1;
+        rates[1] = mode == EXPLICIT ? 10 : 1000;
+
+        SolveStats loose;
+        SolveStats tight;
+        double looseError = decayError(mode, rates, 1.e-5, loose);
+        double tightError = decayError(mode, rates, 1.e-8, tight);
+
+        std::printf("  error %.3g at 1e-5 (%lu steps), %.3g at 1e-8 (%lu steps)\n",
+                looseError, (unsigned long) loose.acceptedSteps,
+                tightError, (unsigned long) tight.acceptedSteps);
+
+        // global errors within a modest multiple of the tolerance,
+        // converging with it
+        CHECK(looseError < 1.e-3);
+        CHECK(tightError < 1.e-5);
+        CHECK(tightError < 0.1 * looseError);
+        CHECK(tight.acceptedSteps > loose.acceptedSteps);
+    }
+
+    /**
+     * A non-autonomous problem, which depends on the stage times of the
+     * explicit method.
+     */
+    void testForced() {
+        Forced model;
+        Problem problem(model);
+        problem.setInitialValue(DVec(1, 0.0))
+                .setTimeRange(0, 10)
+                .setPrecision(1.e-10, 1.e-8);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        SolveStats stats = solver.solve(problem, trajectory);
+
+        CHECK_CLOSE(trajectory.getState(trajectory.size() - 1)[0], model.exact(10), 1.e-7);
+        CHECK(stats.acceptedSteps < 200);
+    }
+}
+
+int main(int argc, char** argv) {
+    testDecay(EXPLICIT);
+    testDecay(IMPLICIT);
+    testForced();
+
+    return CHECK_RESULT();
+}
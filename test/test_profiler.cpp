@@ -0,0 +1,196 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * LatencyHistogram bucketing and percentiles, Profiler aggregation over
+ * threads.
+ */
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "inprofiler.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * Every bucket starts where the previous one ends and maps back to
+     * itself at both of its ends.
+     */
+    void testBuckets() {
+        typedef LatencyHistogram H;
+
+        for (size_t b = 0; b + 1 < H::BUCKETS; b++) {
+            inULong lo = H::lowerBound(b);
+            inULong hi = H::lowerBound(b + 1);
+
+            CHECK(hi > lo);
+            CHECK(H::bucket(lo) == b);
+            CHECK(H::bucket(hi - 1) == b);
+        }
+
+        for (inULong ns = 0; ns < 16; ns++) {
+            CHECK(H::bucket(ns) == ns);
+        }
+
+        CHECK(H::bucket(15) == 15);
+        CHECK(H::bucket(16) == 16);
+        CHECK(H::bucket((inULong) 1 << 47) == H::BUCKETS - 16);
+
+        // everything from 2^48 on goes to the last bucket
+        CHECK(H::bucket((inULong) 1 << 48) == H::BUCKETS - 1);
+        CHECK(H::bucket((inULong) - 1) == H::BUCKETS - 1);
+    }
+
+    void testPercentiles() {
+        LatencyHistogram h;
+
+        CHECK(h.count() == 0);
+        CHECK(h.percentile(0.5) == 0);
+
+        // below 16 ns every value has its own bucket
+        for (inULong ns = 0; ns < 10; ns++) {
+            h.record(ns);
+        }
+
+        CHECK(h.count() == 10);
+        CHECK(h.percentile(0) == 0);
+        CHECK(h.percentile(1) == 9);
+        CHECK(h.percentile(0.5) == 4);
+
+        // out of range quantiles are clamped
+        CHECK(h.percentile(-1) == 0);
+        CHECK(h.percentile(2) == 9);
+
+        // 1 .. 100000 ns: within the 1/16 relative bucket width
+        h.reset();
+        CHECK(h.count() == 0);
+
+        const inULong n = 100000;
+
+        for (inULong ns = 1; ns <= n; ns++) {
+            h.record(ns);
+        }
+
+        const double q[] = {0.01, 0.1, 0.5, 0.9, 0.99, 1};
+
+        for (size_t k = 0; k < sizeof (q) / sizeof (q[0]); k++) {
+            double exact = q[k] * (n - 1) + 1;
+            CHECK_CLOSE(h.percentile(q[k]), exact, exact / 16);
+        }
+
+        LatencyHistogram other;
+        other.record(5);
+        other.record(1000);
+        h.merge(other);
+        CHECK(h.count() == n + 2);
+    }
+
+    void testProfiler() {
+        Profiler& profiler = Profiler::instance();
+
+        inULong region = profiler.region("test/profiler");
+        CHECK(profiler.region("test/profiler") == region);
+
+        // recorded by several threads, some already finished at report()
+        const size_t threads = 4;
+        const size_t samples = 1000;
+        std::vector<std::thread> workers;
+
+        for (size_t i = 0; i < threads; i++) {
+            workers.push_back(std::thread([&profiler, region, i]() {
+                for (size_t k = 1; k <= samples; k++) {
+                    profiler.record(region, 100 * (i + 1) + k);
+                }
+            }));
+        }
+
+        for (size_t i = 0; i < threads; i++) {
+            workers[i].join();
+        }
+
+        {
+            ScopedTimer timer(region);
+        }
+
+        std::vector<TimerStats> total = profiler.report();
+        bool found = false;
+
+        for (size_t i = 0; i < total.size(); i++) {
+            if (total[i].name != "test/profiler") {
+                continue;
+            }
+
+            found = true;
+            CHECK(total[i].thread == -1);
+            CHECK(total[i].count == threads * samples + 1);
+            CHECK(total[i].min * 1.e9 <= 101.5);
+            CHECK(total[i].max * 1.e9 >= 100 * threads + samples - 0.5);
+            CHECK(total[i].p50 <= total[i].p99);
+        }
+
+        CHECK(found);
+
+        std::vector<TimerStats> perThread = profiler.report(true);
+        inULong count = 0;
+        size_t entries = 0;
+
+        for (size_t i = 0; i < perThread.size(); i++) {
+            if (perThread[i].name == "test/profiler" && perThread[i].count > 0) {
+                count += perThread[i].count;
+                entries++;
+            }
+        }
+
+        CHECK(count == threads * samples + 1);
+        CHECK(entries == threads + 1);
+
+        profiler.reset();
+
+        total = profiler.report();
+
+        for (size_t i = 0; i < total.size(); i++) {
+            if (total[i].name == "test/profiler") {
+                CHECK(total[i].count == 0);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    testBuckets();
+    testPercentiles();
+    testProfiler();
+
+    return CHECK_RESULT();
+}
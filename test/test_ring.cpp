@@ -0,0 +1,217 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * RingTrajectory window semantics and torn-read freedom under a
+ * concurrent producer.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    const size_t dimension = 3;
+
+    /**
+     * Step k: t = k, x[c] = k + c, so any mix of two steps is detected.
+     */
+    DVec state(size_t k) {
+        DVec x(dimension);
+
+        for (size_t c = 0; c < dimension; c++) {
+            x[c] = (double) (k + c);
+        }
+
+        return x;
+    }
+
+    bool consistent(double t, const DVec& x) {
+        if (x.size() != dimension || t != std::floor(t)) {
+            return false;
+        }
+
+        for (size_t c = 0; c < dimension; c++) {
+            if (x[c] != t + c) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void testWindow() {
+        RingTrajectory ring(8, dimension);
+
+        CHECK(ring.size() == 0);
+        CHECK(ring.getCapacity() == 8);
+        CHECK(ring.getDimension() == dimension);
+
+        for (size_t k = 0; k < 5; k++) {
+            ring(state(k), (double) k);
+        }
+
+        CHECK(ring.size() == 5);
+        CHECK(ring.getTime(0) == 0);
+        CHECK(ring.getMaxTime() == 4);
+
+        for (size_t k = 5; k < 20; k++) {
+            ring(state(k), (double) k);
+        }
+
+        // the 8 most recent steps, oldest first
+        CHECK(ring.size() == 8);
+        CHECK(ring.getTotalCount() == 20);
+
+        for (size_t i = 0; i < 8; i++) {
+            CHECK(ring.getTime(i) == 12 + i);
+            CHECK(consistent(ring.getTime(i), ring.getState(i)));
+        }
+
+        CHECK(ring.getMinTime() == 12);
+        CHECK(ring.getMaxTime() == 19);
+        CHECK(ring.getMinState(2) == 14);
+        CHECK(ring.getMaxState(2) == 21);
+
+        StateSummary s = ring.getStateSummary(1, 14, 16);
+        CHECK(s.count == 3);
+        CHECK(s.min == 15 && s.max == 17);
+        CHECK_CLOSE(s.mean, 16, 1.e-12);
+
+        std::vector<double> times;
+        std::vector<DVec> states;
+
+        CHECK(ring.snapshot(times, states) == 8);
+        CHECK(times.front() == 12 && times.back() == 19);
+
+        // t >= 19 - 3
+        CHECK(ring.snapshot(times, states, 3) == 4);
+        CHECK(times[0] == 16);
+
+        for (size_t i = 0; i < 4; i++) {
+            CHECK(consistent(times[i], states[i]));
+        }
+
+        CHECK_THROWS(ring(DVec(dimension + 1), 20), std::invalid_argument);
+
+        // getState() buffers belong to the instance
+        RingTrajectory other(4, dimension);
+        other(state(100), 100);
+        const DVec& a = ring.getState(0);
+        const DVec& b = other.getState(0);
+        CHECK(&a != &b);
+        CHECK(a[0] == 12 && b[0] == 100);
+    }
+
+    /**
+     * Readers never see a torn step, a time going backwards or a window
+     * that is out of order while the producer overwrites the ring.
+     */
+    void testConcurrentReaders() {
+        const size_t capacity = 64;
+        const size_t steps = 200000;
+        const size_t readers = 3;
+
+        RingTrajectory ring(capacity, dimension);
+        std::atomic<bool> done(false);
+        std::atomic<size_t> errors(0);
+        std::atomic<size_t> reads(0);
+
+        std::vector<std::thread> threads;
+
+        for (size_t r = 0; r < readers; r++) {
+            threads.push_back(std::thread([&]() {
+                std::vector<double> times;
+                std::vector<DVec> states;
+                double last = -1;
+
+                while (!done.load()) {
+                    size_t n = ring.snapshot(times, states);
+
+                    if (n > capacity) {
+                        errors++;
+                    }
+
+                    for (size_t i = 0; i < n; i++) {
+                        if (!consistent(times[i], states[i]) || (i > 0 && times[i] <= times[i - 1])) {
+                            errors++;
+                        }
+                    }
+
+                    double t = ring.getMaxTime();
+
+                    if (t < last || t != std::floor(t)) {
+                        errors++;
+                    }
+
+                    last = t;
+                    reads++;
+                }
+            }));
+        }
+
+        // start writing once every reader is running
+        while (reads.load() < readers) {
+            std::this_thread::yield();
+        }
+
+        size_t before = reads.load();
+
+        for (size_t k = 0; k < steps; k++) {
+            ring(state(k), (double) k);
+        }
+
+        done = true;
+
+        for (size_t r = 0; r < readers; r++) {
+            threads[r].join();
+        }
+
+        CHECK(errors.load() == 0);
+        CHECK(reads.load() > before);
+        CHECK(ring.getTotalCount() == steps);
+        CHECK(ring.getMaxTime() == steps - 1);
+        CHECK(ring.getTime(0) == steps - capacity);
+    }
+}
+
+int main(int argc, char** argv) {
+    testWindow();
+    testConcurrentReaders();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,332 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Forward sensitivities against central finite differences of the
+ * solution.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * SIR model s' = -b s i, i' = b s i - g i with the parameters (b, g).
+     * With derivatives, the Jacobians are analytic; without, the solver
+     * differences the rhs.
+     */
+    class Sir : public Model {
+    public:
+
+        Sir(bool derivatives) : _derivatives(derivatives) {
+            _p[0] = 2;
+            _p[1] = 1;
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = -_p[0] * y[0] * y[1];
+            dydt[1] = _p[0] * y[0] * y[1] - _p[1] * y[1];
+        }
+
+        bool jacobian(const DVec& y, DVec& J, const double t) {
+            if (!_derivatives) {
+                return false;
+            }
+
+            J[0] = -_p[0] * y[1];
+            J[1] = _p[0] * y[1];
+            J[2] = -_p[0] * y[0];
+            J[3] = _p[0] * y[0] - _p[1];
+            return true;
+        }
+
+        size_t getParameterCount() const {
+            return 2;
+        }
+
+        double getParameter(size_t k) const {
+            return _p[k];
+        }
+
+        void setParameter(size_t k, double value) {
+            _p[k] = value;
+        }
+
+        bool parameterJacobian(const DVec& y, DVec& dfdp, const double t) {
+            if (!_derivatives) {
+                return false;
+            }
+
+            dfdp[0] = -y[0] * y[1];
+            dfdp[1] = y[0] * y[1];
+            dfdp[2] = 0;
+            dfdp[3] = -y[1];
+            return true;
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+    private:
+        bool _derivatives;
+        double _p[2];
+    };
+
+    /**
+     * Decay chain y_0' = -k_0 y_0, y_i' = k_{i-1} y_{i-1} - k_i y_i with
+     * the rates as parameters. J is bidiagonal and left to differences,
+     * df/dp is analytic.
+     */
+    class Chain : public Model {
+    public:
+
+        Chain(size_t n) : _k(n) {
+            for (size_t i = 0; i < n; i++) {
+                _k[i] = 1 + 0.25 * i;
+            }
+        }
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            for (size_t i = 0; i < y.size(); i++) {
+                dydt[i] = -_k[i] * y[i] + (i > 0 ? _k[i - 1] * y[i - 1] : 0);
+            }
+        }
+
+        JacobianStructure getJacobianStructure() {
+            return JacobianStructure::banded(1, 0);
+        }
+
+        size_t getParameterCount() const {
+            return _k.size();
+        }
+
+        double getParameter(size_t k) const {
+            return _k[k];
+        }
+
+        void setParameter(size_t k, double value) {
+            _k[k] = value;
+        }
+
+        bool parameterJacobian(const DVec& y, DVec& dfdp, const double t) {
+            const size_t n = y.size();
+
+            for (size_t k = 0; k < n; k++) {
+                dfdp[k * n + k] = -y[k];
+
+                if (k + 1 < n) {
+                    dfdp[k * n + k + 1] = y[k];
+                }
+            }
+
+            return true;
+        }
+
+        void step(const DVec& x, double t) {
+        }
+
+    private:
+        DVec _k;
+    };
+
+    const double tolerance = 1.e-12;
+
+    DVec initialValue() {
+        DVec y0(2);
+        y0[0] = 0.9;
+        y0[1] = 0.1;
+        return y0;
+    }
+
+    DVec finalState(Model& model, const DVec& y0) {
+        Problem problem(model);
+        problem.setInitialValue(y0)
+                .setTimeRange(0, 5)
+                .setPrecision(tolerance, tolerance);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        solver.solve(problem, trajectory);
+
+        return trajectory.getState(trajectory.size() - 1);
+    }
+
+    /**
+     * Central differences dy(tn)/dp_k, column-major n x p.
+     */
+    DVec parameterDifferences(Model& model) {
+        DVec s(4);
+
+        for (size_t k = 0; k < 2; k++) {
+            double p = model.getParameter(k);
+            double h = 1.e-5 * p;
+
+            model.setParameter(k, p + h);
+            DVec plus = finalState(model, initialValue());
+            model.setParameter(k, p - h);
+            DVec minus = finalState(model, initialValue());
+            model.setParameter(k, p);
+
+            for (size_t i = 0; i < 2; i++) {
+                s[k * 2 + i] = (plus[i] - minus[i]) / (2 * h);
+            }
+        }
+
+        return s;
+    }
+
+    void testForward(bool derivatives, bool implicit) {
+        Sir model(derivatives);
+        DVec expected = parameterDifferences(model);
+
+        Problem problem(model);
+        problem.setInitialValue(initialValue())
+                .setTimeRange(0, 5)
+                .setPrecision(1.e-10, 1.e-10)
+                .setSensitivity(std::vector<size_t>(), true);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        Trajectory sensitivities;
+
+        if (implicit) {
+            solver.solve_implicit(problem, trajectory, sensitivities);
+        } else {
+            solver.solve(problem, trajectory, sensitivities);
+        }
+
+        CHECK(sensitivities.size() == trajectory.size());
+
+        const DVec& s0 = sensitivities.getState(0);
+        const DVec& s = sensitivities.getState(sensitivities.size() - 1);
+        CHECK(s.size() == 4);
+
+        for (size_t k = 0; k < 4; k++) {
+            CHECK_CLOSE(s0[k], 0, 0);
+            CHECK_CLOSE(s[k], expected[k], 1.e-6);
+        }
+    }
+
+    /**
+     * The sensitivities of p parameters cost well under p solves without
+     * them when J is analytic or cheaper to difference than p directions.
+     */
+    void testCost() {
+        const size_t n = 10;
+        Chain model(n);
+
+        DVec y0(n, 0.0);
+        y0[0] = 1;
+
+        Problem problem(model);
+        problem.setInitialValue(y0)
+                .setTimeRange(0, 5)
+                .setPrecision(1.e-8, 1.e-8);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        SolveStats plain = solver.solve(problem, trajectory);
+
+        problem.setSensitivity(std::vector<size_t>(), false);
+
+        Trajectory states;
+        Trajectory sensitivities;
+        SolveStats stats = solver.solve(problem, states, sensitivities);
+
+        std::printf("chain: %lu rhs calls for %lu sensitivities, %lu per solve\n",
+                (unsigned long) stats.rhsCalls, (unsigned long) n, (unsigned long) plain.rhsCalls);
+
+        // state rhs plus two column groups of the bidiagonal J per stage
+        CHECK(stats.rhsCalls < 0.5 * n * plain.rhsCalls);
+
+        // dy_n-1(tn)/dk_0 against central differences
+        const DVec& s = sensitivities.getState(sensitivities.size() - 1);
+        CHECK(s.size() == n * n);
+
+        double k0 = model.getParameter(0);
+        double h = 1.e-5 * k0;
+        Problem fd(model);
+        fd.setInitialValue(y0)
+                .setTimeRange(0, 5)
+                .setPrecision(tolerance, tolerance);
+
+        model.setParameter(0, k0 + h);
+        Trajectory plus;
+        solver.solve(fd, plus);
+        model.setParameter(0, k0 - h);
+        Trajectory minus;
+        solver.solve(fd, minus);
+        model.setParameter(0, k0);
+
+        for (size_t i = 0; i < n; i++) {
+            double expected = (plus.getState(plus.size() - 1)[i] - minus.getState(minus.size() - 1)[i]) / (2 * h);
+            CHECK_CLOSE(s[i], expected, 1.e-6);
+        }
+
+        // an analytic J adds no rhs calls at all
+        Sir sir(true);
+        Problem sirProblem(sir);
+        sirProblem.setInitialValue(initialValue())
+                .setTimeRange(0, 5)
+                .setPrecision(1.e-8, 1.e-8);
+
+        Trajectory sirTrajectory;
+        SolveStats sirPlain = solver.solve(sirProblem, sirTrajectory);
+
+        sirProblem.setSensitivity(std::vector<size_t>(), false);
+
+        Trajectory sirStates;
+        Trajectory sirSensitivities;
+        SolveStats sirStats = solver.solve(sirProblem, sirStates, sirSensitivities);
+
+        std::printf("sir: %lu rhs calls for 2 sensitivities, %lu per solve\n",
+                (unsigned long) sirStats.rhsCalls, (unsigned long) sirPlain.rhsCalls);
+
+        // same steps, the error control is on the states only
+        CHECK(sirStats.rhsCalls == sirPlain.rhsCalls);
+    }
+}
+
+int main(int argc, char** argv) {
+    testForward(true, false);
+    testForward(false, false);
+    testForward(true, true);
+    testForward(false, true);
+
+    testCost();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * SolveStats counters of a solve and their JSON and CSV output.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    class Decay : public Model {
+    public:
+
+        void rhs(const DVec& y, DVec& dydt, const double t) {
+            dydt[0] = -y[0];
+        }
+
+        void step(const DVec& x, double t) {
+        }
+    };
+
+    /**
+     * Value of the first "name": in text, NaN if missing.
+     */
+    double field(const std::string& text, const std::string& name, size_t from = 0) {
+        size_t pos = text.find("\"" + name + "\": ", from);
+
+        if (pos == std::string::npos) {
+            return NAN;
+        }
+
+        return std::strtod(text.c_str() + pos + name.size() + 4, NULL);
+    }
+
+    std::vector<std::string> split(const std::string& line, char separator) {
+        std::vector<std::string> cells;
+        std::stringstream stream(line);
+        std::string cell;
+
+        while (std::getline(stream, cell, separator)) {
+            cells.push_back(cell);
+        }
+
+        return cells;
+    }
+
+    SolveStats solve(double tn) {
+        Decay model;
+        Problem problem(model);
+        problem.setInitialValue(DVec(1, 1.0))
+                .setTimeRange(0, tn)
+                .setPrecision(1.e-8, 1.e-8);
+
+        ODESolver solver;
+        Trajectory trajectory;
+        SolveStats stats = solver.solve(problem, trajectory);
+
+        // one recorded state per accepted step plus the initial value
+        CHECK(trajectory.size() == stats.acceptedSteps + 1);
+
+        return stats;
+    }
+
+    void testCounters() {
+        SolveStats empty;
+        CHECK(empty.acceptedSteps == 0);
+        CHECK(empty.getMeanStep() == 0);
+
+        SolveStats steps;
+        steps.recordStep(0.5);
+        steps.recordStep(0.25);
+        steps.recordStep(1);
+        CHECK(steps.acceptedSteps == 3);
+        CHECK(steps.minStep == 0.25);
+        CHECK(steps.maxStep == 1);
+        CHECK_CLOSE(steps.getMeanStep(), 1.75 / 3, 1.e-15);
+
+        SolveStats stats = solve(2);
+        CHECK(stats.acceptedSteps > 0);
+        CHECK(stats.rhsCalls >= stats.acceptedSteps);
+        CHECK(stats.jacobianCalls == 0);
+        CHECK(stats.minStep <= stats.getMeanStep());
+        CHECK(stats.getMeanStep() <= stats.maxStep);
+        CHECK_CLOSE(stats.stepSum, 2, 1.e-12);
+        CHECK(stats.wallTime >= 0);
+    }
+
+    void testJSON() {
+        SolveStats stats = solve(2);
+        stats.rejectedSteps = 3;
+        stats.events = 7;
+
+        std::ostringstream os;
+        os.precision(3);
+        stats.writeJSON(os);
+        std::string json = os.str();
+
+        CHECK(os.precision() == 3);
+        CHECK(json.front() == '{' && json.back() == '}');
+
+        // 17 digits: doubles survive the round trip
+        CHECK(field(json, "acceptedSteps") == stats.acceptedSteps);
+        CHECK(field(json, "rejectedSteps") == 3);
+        CHECK(field(json, "rhsCalls") == stats.rhsCalls);
+        CHECK(field(json, "events") == 7);
+        CHECK(field(json, "minStep") == stats.minStep);
+        CHECK(field(json, "maxStep") == stats.maxStep);
+        CHECK(field(json, "meanStep") == stats.getMeanStep());
+        CHECK(field(json, "wallTime") == stats.wallTime);
+
+        // no steps: minStep is reported as 0, not as DBL_MAX
+        std::ostringstream empty;
+        SolveStats().writeJSON(empty);
+        CHECK(field(empty.str(), "minStep") == 0);
+    }
+
+    void testEnsemble() {
+        EnsembleStats ensemble;
+        std::vector<SolveStats> members;
+
+        for (size_t i = 0; i < 3; i++) {
+            members.push_back(solve(1 + i));
+            ensemble.add(members.back());
+        }
+
+        CHECK(ensemble.size() == 3);
+        CHECK(ensemble.get(1).acceptedSteps == members[1].acceptedSteps);
+
+        SolveStats total = ensemble.getTotal();
+        CHECK(total.acceptedSteps == members[0].acceptedSteps
+                + members[1].acceptedSteps + members[2].acceptedSteps);
+        CHECK(total.rhsCalls == members[0].rhsCalls + members[1].rhsCalls + members[2].rhsCalls);
+        CHECK(total.minStep == std::min(members[0].minStep, std::min(members[1].minStep, members[2].minStep)));
+        CHECK(total.maxStep == std::max(members[0].maxStep, std::max(members[1].maxStep, members[2].maxStep)));
+
+        // header, one row per member, then min, mean, max and sum
+        std::ostringstream csv;
+        ensemble.writeCSV(csv);
+
+        std::vector<std::string> lines = split(csv.str(), '\n');
+        CHECK(lines.size() == 1 + 3 + 4);
+
+        std::vector<std::string> header = split(lines[0], ',');
+        CHECK(header.size() > 1 && header[0] == "member");
+
+        size_t accepted = 0;
+
+        for (size_t c = 0; c < header.size(); c++) {
+            if (header[c] == "acceptedSteps") {
+                accepted = c;
+            }
+        }
+
+        CHECK(accepted > 0);
+
+        for (size_t l = 1; l < lines.size(); l++) {
+            CHECK(split(lines[l], ',').size() == header.size());
+        }
+
+        for (size_t i = 0; i < 3; i++) {
+            std::vector<std::string> row = split(lines[1 + i], ',');
+            CHECK(std::atoi(row[0].c_str()) == (int) i);
+            CHECK(std::strtod(row[accepted].c_str(), NULL) == members[i].acceptedSteps);
+        }
+
+        const char* aggregates[] = {"min", "mean", "max", "sum"};
+        double expected[] = {
+            (double) std::min(members[0].acceptedSteps, std::min(members[1].acceptedSteps, members[2].acceptedSteps)),
+            total.acceptedSteps / 3.,
+            (double) std::max(members[0].acceptedSteps, std::max(members[1].acceptedSteps, members[2].acceptedSteps)),
+            (double) total.acceptedSteps
+        };
+
+        for (size_t a = 0; a < 4; a++) {
+            std::vector<std::string> row = split(lines[4 + a], ',');
+            CHECK(row[0] == aggregates[a]);
+            CHECK_CLOSE(std::strtod(row[accepted].c_str(), NULL), expected[a], 1.e-12);
+        }
+
+        std::ostringstream json;
+        ensemble.writeJSON(json);
+        std::string text = json.str();
+
+        CHECK(field(text, "runs") == 3);
+        CHECK(field(text, "sum", text.find("\"acceptedSteps\"")) == total.acceptedSteps);
+
+        // the members follow the aggregates in order
+        size_t pos = text.find("\"members\"");
+        CHECK(pos != std::string::npos);
+
+        for (size_t i = 0; i < 3 && pos != std::string::npos; i++) {
+            CHECK(field(text, "acceptedSteps", pos) == members[i].acceptedSteps);
+            pos = text.find("\"acceptedSteps\"", pos) + 1;
+        }
+
+        // an empty ensemble has zero aggregates
+        EnsembleStats none;
+        std::ostringstream emptyCsv;
+        none.writeCSV(emptyCsv);
+        lines = split(emptyCsv.str(), '\n');
+        CHECK(lines.size() == 5);
+        CHECK(std::strtod(split(lines[1], ',')[1].c_str(), NULL) == 0);
+    }
+}
+
+int main(int argc, char** argv) {
+    testCounters();
+    testJSON();
+    testEnsemble();
+
+    return CHECK_RESULT();
+}
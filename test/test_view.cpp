@@ -0,0 +1,269 @@
+/*
+ * Copyright 2012 Michael Hoffer <info@michaelhoffer.de>. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are
+ * permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice, this list of
+ *       conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *       of conditions and the following disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY Michael Hoffer <info@michaelhoffer.de> "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL Michael Hoffer <info@michaelhoffer.de> OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those of the
+ * authors and should not be interpreted as representing official policies, either expressed
+ * or implied, of Michael Hoffer <info@michaelhoffer.de>.
+ */
+
+/*
+ * Index math of the trajectory views against brute-force references.
+ */
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "iNumerics.h"
+
+#include "check.h"
+
+using namespace iNumerics;
+
+namespace {
+
+    /**
+     * n steps at t = step * i with x = (t, 10 - 2t), linear in t so
+     * interpolated values are known.
+     */
+    void fill(Trajectory& trajectory, size_t n, double step = 0.1) {
+        DVec x(2);
+
+        for (size_t i = 0; i < n; i++) {
+            double t = step * i;
+            x[0] = t;
+            x[1] = 10 - 2 * t;
+            trajectory(x, t);
+        }
+    }
+
+    void testStride() {
+        for (size_t n = 0; n < 20; n++) {
+            Trajectory source;
+            fill(source, n);
+
+            for (size_t stride = 1; stride <= 5; stride++) {
+                for (size_t offset = 0; offset <= n + 2; offset++) {
+                    StrideView view(source, stride, offset);
+
+                    size_t expected = 0;
+
+                    for (size_t k = offset; k < n; k += stride) {
+                        CHECK(view.getTime(expected) == source.getTime(k));
+                        CHECK(view.getState(expected, 1) == source.getState(k)[1]);
+                        expected++;
+                    }
+
+                    CHECK(view.size() == expected);
+
+                    if (expected > 0) {
+                        size_t last = offset + (expected - 1) * stride;
+                        CHECK(last < n && last + stride >= n);
+                        CHECK(view.getMaxTime() == source.getTime(last));
+                    }
+                }
+            }
+        }
+
+        Trajectory source;
+        fill(source, 3);
+        CHECK_THROWS(StrideView(source, 0), std::invalid_argument);
+    }
+
+    void testTimeSlice() {
+        Trajectory source;
+        fill(source, 11, 0.5); // t = 0, 0.5, ..., 5, exact in binary
+
+        const double bounds[] = {-1, 0, 0.25, 0.5, 2, 2.75, 4.5, 5, 6};
+        const size_t count = sizeof (bounds) / sizeof (bounds[0]);
+
+        for (size_t a = 0; a < count; a++) {
+            for (size_t b = 0; b < count; b++) {
+                double t0 = bounds[a];
+                double t1 = bounds[b];
+                TimeSliceView view(source, t0, t1);
+
+                // both ends inclusive
+                std::vector<size_t> steps;
+
+                for (size_t k = 0; k < source.size(); k++) {
+                    if (source.getTime(k) >= t0 && source.getTime(k) <= t1) {
+                        steps.push_back(k);
+                    }
+                }
+
+                CHECK(view.size() == steps.size());
+
+                for (size_t i = 0; i < steps.size() && i < view.size(); i++) {
+                    CHECK(view.getTime(i) == source.getTime(steps[i]));
+                    CHECK(view.getState(i, 0) == source.getState(steps[i])[0]);
+                }
+
+                if (!steps.empty()) {
+                    CHECK(view.getMinState(0) == source.getTime(steps.front()));
+                    CHECK(view.getMaxState(0) == source.getTime(steps.back()));
+                }
+            }
+        }
+
+        // repeated times (an event restart records a step twice)
+        Trajectory repeated;
+        DVec x(1, 0.0);
+        const double times[] = {0, 1, 1, 1, 2};
+
+        for (size_t k = 0; k < 5; k++) {
+            x[0] = (double) k;
+            repeated(x, times[k]);
+        }
+
+        TimeSliceView atOne(repeated, 1, 1);
+        CHECK(atOne.size() == 3);
+        CHECK(atOne.getState(0, 0) == 1 && atOne.getState(2, 0) == 3);
+    }
+
+    void testComponents() {
+        Trajectory source;
+        fill(source, 5);
+
+        std::vector<size_t> order;
+        order.push_back(1);
+        order.push_back(0);
+        order.push_back(1);
+
+        ComponentView view(source, order);
+        CHECK(view.size() == 5 && view.getDimension() == 3);
+        CHECK(view.getState(4, 0) == source.getState(4)[1]);
+        CHECK(view.getState(4, 1) == source.getState(4)[0]);
+        CHECK(view.getState(4).size() == 3);
+
+        CHECK_THROWS(ComponentView(source, 2), std::out_of_range);
+
+        Trajectory empty;
+        ComponentView unchecked(empty, 7);
+        CHECK(unchecked.size() == 0);
+    }
+
+    void testResampledSize() {
+        Trajectory source;
+        fill(source, 11); // t = 0 ... 1
+
+        // (t1 - t0) / dt is 2.9999999999999996 for 0.3, similar for 0.6 and 0.7
+        const double ends[] = {0.3, 0.6, 0.7, 1.0};
+        const size_t expected[] = {4, 7, 8, 11};
+
+        for (size_t k = 0; k < 4; k++) {
+            ResampledView view(source, 0, ends[k], 0.1);
+            CHECK(view.size() == expected[k]);
+            CHECK_CLOSE(view.getMaxTime(), ends[k], 1e-15);
+        }
+
+        // a grid point well short of t1 is not rounded up to it
+        CHECK(ResampledView(source, 0, 0.35, 0.1).size() == 4);
+        CHECK(ResampledView(source, 0, 0.399, 0.1).size() == 4);
+
+        // the whole range
+        ResampledView whole(source, 0.25);
+        CHECK(whole.size() == 5);
+        CHECK(whole.getTime(4) == 1.0);
+
+        CHECK(ResampledView(source, 0.5, 0.5, 0.1).size() == 1);
+        CHECK(ResampledView(source, 0.5, 0.4, 0.1).size() == 0);
+
+        Trajectory empty;
+        CHECK(ResampledView(empty, 0.1).size() == 0);
+        CHECK(ResampledView(empty, 0, 1, 0.1).size() == 0);
+
+        CHECK_THROWS(ResampledView(source, 0), std::invalid_argument);
+        CHECK_THROWS(ResampledView(source, 0, 1, -0.1), std::invalid_argument);
+        CHECK_THROWS(ResampledView(source, 0, 1, NAN), std::invalid_argument);
+    }
+
+    void testResampledValues() {
+        Trajectory source;
+        fill(source, 11);
+
+        // clamped outside [0, 1], linear inside
+        ResampledView view(source, -0.5, 1.5, 0.05);
+        CHECK(view.size() == 41);
+
+        std::vector<double> forward(view.size());
+
+        for (size_t i = 0; i < view.size(); i++) {
+            double t = view.getTime(i);
+            double clamped = std::min(1.0, std::max(0.0, t));
+            forward[i] = view.getState(i, 1);
+            CHECK_CLOSE(view.getState(i, 0), clamped, 1e-14);
+            CHECK_CLOSE(forward[i], 10 - 2 * clamped, 1e-13);
+        }
+
+        // random access (backwards) hits the same intervals as sequential
+        for (size_t i = view.size(); i-- > 0;) {
+            CHECK(view.getState(i, 1) == forward[i]);
+        }
+
+        Trajectory single;
+        fill(single, 1);
+        ResampledView constant(single, -1, 1, 0.5);
+        CHECK(constant.size() == 5);
+        CHECK(constant.getState(4, 1) == 10);
+    }
+
+    void testStacked() {
+        Trajectory source;
+        fill(source, 101); // t = 0 ... 10
+
+        TimeSliceView window(source, 2, 8);
+        StrideView every3rd(window, 3, 1);
+        ComponentView second(every3rd, 1);
+        ResampledView resampled(second, 0.5);
+
+        size_t first = 0;
+
+        while (source.getTime(first) < 2) {
+            first++;
+        }
+
+        CHECK(every3rd.size() == (window.size() - 1 + 2) / 3);
+        CHECK(every3rd.getTime(0) == source.getTime(first + 1));
+        CHECK(second.getDimension() == 1);
+        CHECK(resampled.getDimension() == 1);
+        CHECK(resampled.getTime(0) == every3rd.getTime(0));
+
+        for (size_t i = 0; i < resampled.size(); i++) {
+            CHECK_CLOSE(resampled.getState(i, 0), 10 - 2 * resampled.getTime(i), 1e-12);
+        }
+
+        CHECK_THROWS(resampled(DVec(1, 0.0), 11), std::logic_error);
+    }
+}
+
+int main() {
+    testStride();
+    testTimeSlice();
+    testComponents();
+    testResampledSize();
+    testResampledValues();
+    testStacked();
+
+    return CHECK_RESULT();
+}